@@ -0,0 +1,58 @@
+// Skinning with the palettes of animation::Animator and animation::SkinnedInstances.
+//
+// Define SKINNED to read the palette of one Animator from the uniform block it binds, or SKINNED_INSTANCES to read the
+// world space palette of each instance from the buffer texture SkinnedInstances binds. Include before anything but
+// #version. Vertices carry the joints and weights of animation::SkinInfluences.
+
+#if defined(SKINNED)
+
+#extension GL_ARB_shading_language_420pack : require
+
+// Animator::PALETTE_BINDING, rows of Skeleton::MAX_JOINTS transforms
+layout(std140, binding = 0) uniform Palette { vec4 avPaletteRows[3 * 256]; };
+
+vec4 getPaletteRow(uint uJoint, int iRow)
+{
+	return avPaletteRows[uJoint * 3u + uint(iRow)];
+}
+
+#elif defined(SKINNED_INSTANCES)
+
+uniform samplerBuffer sPalette;
+uniform int iNumJoints;
+
+vec4 getPaletteRow(uint uJoint, int iRow)
+{
+	return texelFetch(sPalette, (gl_InstanceID * iNumJoints + int(uJoint)) * 3 + iRow);
+}
+
+#endif
+
+#if defined(SKINNED) || defined(SKINNED_INSTANCES)
+
+// Blend the transforms of the joints influencing a vertex. Each column of the result is a row of the affine transform.
+mat3x4 getSkinTransform(uvec4 uvJoints, vec4 vWeights)
+{
+	mat3x4 m = mat3x4(0.0);
+	for (int i = 0; i < 4; ++i)
+	{
+		m[0] += getPaletteRow(uvJoints[i], 0) * vWeights[i];
+		m[1] += getPaletteRow(uvJoints[i], 1) * vWeights[i];
+		m[2] += getPaletteRow(uvJoints[i], 2) * vWeights[i];
+	}
+	return m;
+}
+
+vec3 skinPosition(mat3x4 m, vec3 vPosition)
+{
+	vec4 v = vec4(vPosition, 1.0);
+	return vec3(dot(m[0], v), dot(m[1], v), dot(m[2], v));
+}
+
+// Assumes the joints don't scale non-uniformly
+vec3 skinNormal(mat3x4 m, vec3 vNormal)
+{
+	return normalize(vec3(dot(m[0].xyz, vNormal), dot(m[1].xyz, vNormal), dot(m[2].xyz, vNormal)));
+}
+
+#endif
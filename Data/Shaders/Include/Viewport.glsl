@@ -0,0 +1,11 @@
+// Convert a position in [0, 1] viewport coordinates, from the bottom left corner, to clip space.
+vec4 normalizedToClip(vec2 vPosNormalized)
+{
+	return vec4(vPosNormalized.x*2.0 - 1.0, vPosNormalized.y*2.0 - 1.0, 0, 1);
+}
+
+// Convert a position in pixels, from the bottom left corner of the viewport, to clip space.
+vec4 pixelsToClip(vec2 vPixels, vec2 vViewportSize)
+{
+	return normalizedToClip(vPixels / vViewportSize);
+}
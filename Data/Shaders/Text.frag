@@ -0,0 +1,12 @@
+#version 400
+
+uniform sampler2D sTexture;
+in vec2 vTexCoordFrag;
+in vec4 vColourFrag;
+out vec4 vColour;
+
+void main() 
+{
+	float fCoverage = texture(sTexture, vTexCoordFrag).r;
+    vColour = vec4(vColourFrag.rgb, vColourFrag.a * fCoverage);
+}
@@ -0,0 +1,26 @@
+#version 400
+#extension GL_ARB_separate_shader_objects : enable
+
+#include "Include/Viewport.glsl"
+
+layout(location=0) in vec2 vPosition;
+layout(location=1) in vec2 vTexCoord;
+layout(location=2) in vec4 vColour;
+
+uniform vec2 vViewportSize;
+
+// Redeclared for separable programs
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+out vec2 vTexCoordFrag;
+out vec4 vColourFrag;
+
+void main() 
+{
+	vTexCoordFrag = vTexCoord;
+	vColourFrag = vColour;
+    gl_Position = pixelsToClip(vPosition, vViewportSize);
+}
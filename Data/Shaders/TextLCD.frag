@@ -0,0 +1,16 @@
+#version 400
+
+uniform sampler2D sTexture;
+in vec2 vTexCoordFrag;
+in vec4 vColourFrag;
+
+// Dual source blending: dst = vColour * vBlendWeights + dst * (1 - vBlendWeights), one weight per LCD subpixel
+layout(location = 0, index = 0) out vec4 vColour;
+layout(location = 0, index = 1) out vec4 vBlendWeights;
+
+void main() 
+{
+	vec3 vCoverage = texture(sTexture, vTexCoordFrag).rgb * vColourFrag.a;
+    vColour = vec4(vColourFrag.rgb, 1.0);
+	vBlendWeights = vec4(vCoverage, max(vCoverage.r, max(vCoverage.g, vCoverage.b)));
+}
@@ -0,0 +1,9 @@
+#version 400
+
+uniform vec4 vTextColour;
+out vec4 vColour;
+
+void main() 
+{
+    vColour = vTextColour;
+}
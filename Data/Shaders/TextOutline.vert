@@ -0,0 +1,14 @@
+#version 400
+
+#include "Include/Viewport.glsl"
+
+layout(location=0) in vec2 vPosition;
+
+uniform vec2 vViewportSize;
+uniform vec2 vOrigin;
+uniform float fScale;
+
+void main() 
+{
+    gl_Position = pixelsToClip(vOrigin + vPosition*fScale, vViewportSize);
+}
@@ -0,0 +1,15 @@
+#version 400
+
+uniform sampler2D sTexture;
+in vec2 vTexCoordFrag;
+in vec4 vColourFrag;
+out vec4 vColour;
+
+void main() 
+{
+	// The outline is at 0.5, smooth over roughly one screen pixel whatever the scale
+	float fDistance = texture(sTexture, vTexCoordFrag).r;
+	float fWidth = fwidth(fDistance) * 0.5;
+	float fCoverage = smoothstep(0.5 - fWidth, 0.5 + fWidth, fDistance);
+    vColour = vec4(vColourFrag.rgb, vColourFrag.a * fCoverage);
+}
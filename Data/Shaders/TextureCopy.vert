@@ -1,5 +1,7 @@
 #version 400
 
+#include "Include/Viewport.glsl"
+
 layout(location=0) in vec3 vPosition;
 layout(location=1) in vec2 vTexCoord;
 
@@ -14,5 +16,5 @@ void main()
 {
 	vTexCoordFrag = vec2(vTexCoord.x*vUVScale.x + vUVOffset.x, vTexCoord.y*vUVScale.y + vUVOffset.y);
 	vec2 vPosNormalized = vec2(vPosition.x*vPosScale.x + vPosOffset.x, vPosition.y*vPosScale.y + vPosOffset.y);
-    gl_Position = vec4(vPosNormalized.x*2.0 - 1.0, vPosNormalized.y*2.0 - 1.0, 0, 1);
+    gl_Position = normalizedToClip(vPosNormalized);
 }
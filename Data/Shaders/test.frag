@@ -7,5 +7,9 @@ out vec4 vColour;
 void main() 
 {
 	vec4 vTex = texture(sTestTexture, vTexCoordFrag);
+#ifdef SINGLE_CHANNEL
+    vColour = vec4(vTex.rrr, 1.0);
+#else
     vColour = vec4(vTex.xyz, 1.0);
+#endif
 }
@@ -1,13 +1,23 @@
 #version 400
 
+#include "Include/Skinning.glsl"
+
 layout(location=0) in vec3 vPosition;
 layout(location=1) in vec3 vNormal;
 layout(location=2) in vec2 vTexCoord;
+#if defined(SKINNED) || defined(SKINNED_INSTANCES)
+layout(location=3) in uvec4 uvJoints;
+layout(location=4) in vec4 vWeights;
+#endif
 
 out vec2 vTexCoordFrag;
 
 void main() 
 {
 	vTexCoordFrag = vTexCoord;
+#if defined(SKINNED) || defined(SKINNED_INSTANCES)
+    gl_Position = vec4(skinPosition(getSkinTransform(uvJoints, vWeights), vPosition), 1);
+#else
     gl_Position = vec4(vPosition, 1);
+#endif
 }
@@ -0,0 +1,693 @@
+#include "AnimationClip.h"
+
+#include <Logging/Log.h>
+#include <Math/SIMD.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace baselib { namespace animation {
+
+	namespace
+	{
+		const char CLIP_MAGIC[4] = { 'B', 'A', 'N', 'M' };
+		const unsigned int CLIP_VERSION = 1;
+
+		// Most bits per quantized component
+		const unsigned int MAX_BITS = 16;
+		// Track headers keep the bits per component in the low bits of the bit offset
+		const unsigned int BITS_SHIFT = 5;
+		const unsigned int BITS_MASK = (1 << BITS_SHIFT) - 1;
+		// Fewest bits per rotation component, below this the error is always too large to be worth trying
+		const unsigned int MIN_ROTATION_BITS = 4;
+		// Rotation keys start with the index of the largest component
+		const unsigned int INDEX_BITS = 2;
+		// The three smallest components of a unit quaternion are within +-1/sqrt(2)
+		const float SMALLEST_THREE_RANGE = 0.70710678f;
+		// Bit streams are padded so that readBits() can always load eight bytes
+		const unsigned int BIT_STREAM_PADDING = 8;
+		// Joints decoded to the stack at a time before they are added to the pose
+		const unsigned int SAMPLE_CHUNK = 64;
+
+		// Start of a clip, followed by the offset of each segment from the start of the clip, then the segments
+		struct ClipHeader
+		{
+			char acMagic[4];
+			unsigned int uVersion;
+			unsigned int uSize;				// Of the whole clip in bytes
+			unsigned int uNumJoints;
+			unsigned int uNumFrames;
+			unsigned int uNumSegments;
+			float fFrameRate;
+		};
+
+		// A segment holds a RotationTrack per joint, a VectorTrack per joint for the translations and another for the
+		// scales, followed by the bit stream of their keys
+		struct RotationTrack
+		{
+			unsigned int uKeys;				// Bit i is set if frame i of the segment has a key, frame 0 always has
+			unsigned int uBitOffset;		// Of the first key in the bit stream, shifted up by BITS_SHIFT, and the bits per component
+		};
+
+		struct VectorTrack
+		{
+			unsigned int uKeys;
+			unsigned int uBitOffset;
+			float afMin[3];					// Value of quantized 0
+			float afStep[3];				// Value of one quantization step
+		};
+
+		// Quantization step of smallest three components for each number of bits
+		struct RotationSteps
+		{
+			RotationSteps()
+			{
+				afSteps[0] = 0.0f;
+				for (unsigned int uBits = 1; uBits <= MAX_BITS; ++uBits)
+					afSteps[uBits] = 2.0f * SMALLEST_THREE_RANGE / ((1u << uBits) - 1);
+			}
+
+			float afSteps[MAX_BITS + 1];
+		};
+		const RotationSteps rotationSteps;
+
+		unsigned int getNumSegments(unsigned int uNumFrames)
+		{
+			const unsigned int uSegmentFrames = AnimationClip::SEGMENT_FRAMES;
+			return std::max(1u, (uNumFrames - 1 + uSegmentFrames - 1) / uSegmentFrames);
+		}
+
+		unsigned int getSegmentSize(unsigned int uNumJoints)
+		{
+			return uNumJoints * (sizeof(RotationTrack) + 2 * sizeof(VectorTrack));
+		}
+
+		unsigned int countBits(unsigned int u)
+		{
+			u = u - ((u >> 1) & 0x55555555);
+			u = (u & 0x33333333) + ((u >> 2) & 0x33333333);
+			return (((u + (u >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+		}
+
+		// Index of the highest set bit, u must not be 0
+		unsigned int highestBit(unsigned int u)
+		{
+#ifdef _MSC_VER
+			unsigned long ulIndex;
+			_BitScanReverse(&ulIndex, u);
+			return ulIndex;
+#else
+			return 31 - __builtin_clz(u);
+#endif
+		}
+
+		// Index of the lowest set bit, u must not be 0
+		unsigned int lowestBit(unsigned int u)
+		{
+#ifdef _MSC_VER
+			unsigned long ulIndex;
+			_BitScanForward(&ulIndex, u);
+			return ulIndex;
+#else
+			return __builtin_ctz(u);
+#endif
+		}
+
+		// Find the key at or before fFrame, its index among the keys in uKeys and how far fFrame is towards the next key,
+		// 0 if there is none
+		void findKeys(unsigned int uKeys, float fFrame, unsigned int& uIndex, float& fAlpha)
+		{
+			unsigned int uUpToFrame = (2u << static_cast<unsigned int>(fFrame)) - 1;
+			unsigned int uBefore = uKeys & uUpToFrame;
+			unsigned int uAfter = uKeys & ~uUpToFrame;
+			unsigned int uPrevious = highestBit(uBefore);
+			uIndex = countBits(uBefore) - 1;
+			fAlpha = uAfter ? (fFrame - uPrevious) / (lowestBit(uAfter) - uPrevious) : 0.0f;
+		}
+
+		unsigned __int64 readBits(const unsigned char* pBits, unsigned int uBitOffset, unsigned int uBits)
+		{
+			unsigned __int64 u;
+			memcpy(&u, pBits + (uBitOffset >> 3), sizeof(u));
+			return (u >> (uBitOffset & 7)) & ((static_cast<unsigned __int64>(1) << uBits) - 1);
+		}
+
+		void writeBits(std::vector<unsigned char>& aucBits, unsigned int& uNumBits, unsigned __int64 uValue, unsigned int uBits)
+		{
+			for (unsigned int i = 0; i < uBits; ++i, ++uNumBits)
+			{
+				if ((uNumBits >> 3) >= aucBits.size())
+					aucBits.push_back(0);
+				if ((uValue >> i) & 1)
+					aucBits[uNumBits >> 3] |= 1 << (uNumBits & 7);
+			}
+		}
+
+		unsigned int quantize(float f, float fMin, float fStep, unsigned int uBits)
+		{
+			if (uBits == 0 || fStep <= 0.0f)
+				return 0;
+			float fMaxLevel = static_cast<float>((1u << uBits) - 1);
+			return static_cast<unsigned int>(std::max(0.0f, std::min(fMaxLevel, std::floor((f - fMin) / fStep + 0.5f))));
+		}
+
+		// Smallest three: the largest component is made positive and dropped, the others are quantized with uBits each
+		unsigned __int64 encodeRotation(const glm::quat& q, unsigned int uBits)
+		{
+			const float* pf = &q.x;
+			unsigned int uLargest = 0;
+			for (unsigned int i = 1; i < 4; ++i)
+			{
+				if (fabs(pf[i]) > fabs(pf[uLargest]))
+					uLargest = i;
+			}
+
+			float fSign = pf[uLargest] < 0.0f ? -1.0f : 1.0f;
+			float fStep = rotationSteps.afSteps[uBits];
+			unsigned __int64 uPacked = uLargest;
+			unsigned int uShift = INDEX_BITS;
+			for (unsigned int i = 0; i < 4; ++i)
+			{
+				if (i == uLargest)
+					continue;
+				uPacked |= static_cast<unsigned __int64>(quantize(pf[i] * fSign, -SMALLEST_THREE_RANGE, fStep, uBits)) << uShift;
+				uShift += uBits;
+			}
+			return uPacked;
+		}
+
+		// The dropped component follows from the unit length, as in calcQuatWComponent()
+		glm::quat decodeRotation(unsigned __int64 uPacked, unsigned int uBits)
+		{
+			// Component of the decoded values to put in x, y, z and w, for each index of the largest component
+			static const unsigned char SHUFFLE[4][4] = { { 3, 0, 1, 2 }, { 0, 3, 1, 2 }, { 0, 1, 3, 2 }, { 0, 1, 2, 3 } };
+
+			unsigned int uLargest = static_cast<unsigned int>(uPacked & 3);
+			unsigned int uMask = (1u << uBits) - 1;
+			float fStep = rotationSteps.afSteps[uBits];
+			uPacked >>= INDEX_BITS;
+
+			// Decode without branching on the largest component, which varies from key to key
+			float af[4];
+			af[0] = static_cast<unsigned int>(uPacked & uMask) * fStep - SMALLEST_THREE_RANGE;
+			af[1] = static_cast<unsigned int>((uPacked >> uBits) & uMask) * fStep - SMALLEST_THREE_RANGE;
+			af[2] = static_cast<unsigned int>((uPacked >> (2 * uBits)) & uMask) * fStep - SMALLEST_THREE_RANGE;
+			af[3] = std::sqrt(std::max(0.0f, 1.0f - af[0] * af[0] - af[1] * af[1] - af[2] * af[2]));
+
+			const unsigned char* puShuffle = SHUFFLE[uLargest];
+			return glm::quat(af[puShuffle[3]], af[puShuffle[0]], af[puShuffle[1]], af[puShuffle[2]]);
+		}
+
+		unsigned __int64 encodeVector(const Vec3& v, const VectorTrack& track, unsigned int uBits)
+		{
+			unsigned __int64 uPacked = 0;
+			for (int i = 0; i < 3; ++i)
+				uPacked |= static_cast<unsigned __int64>(quantize(v[i], track.afMin[i], track.afStep[i], uBits)) << (i * uBits);
+			return uPacked;
+		}
+
+		Vec3 decodeVector(unsigned __int64 uPacked, const VectorTrack& track, unsigned int uBits)
+		{
+			unsigned int uMask = (1u << uBits) - 1;
+			return Vec3(track.afMin[0] + static_cast<unsigned int>(uPacked & uMask) * track.afStep[0],
+						track.afMin[1] + static_cast<unsigned int>((uPacked >> uBits) & uMask) * track.afStep[1],
+						track.afMin[2] + static_cast<unsigned int>((uPacked >> (2 * uBits)) & uMask) * track.afStep[2]);
+		}
+
+		glm::quat interpolate(const glm::quat& a, const glm::quat& b, float fAlpha)
+		{
+			glm::quat bShorter = glm::dot(a, b) < 0.0f ? -b : b;
+			return glm::normalize(a * (1.0f - fAlpha) + bShorter * fAlpha);
+		}
+
+		Vec3 interpolate(const Vec3& a, const Vec3& b, float fAlpha)
+		{
+			return a + (b - a) * fAlpha;
+		}
+
+		// Angle between two unit quaternions' rotations. From the chord rather than acos(dot), which has no precision near 0.
+		float getError(const glm::quat& a, const glm::quat& b)
+		{
+			float fChord = std::min(glm::length(Vec4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w)), glm::length(Vec4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w)));
+			return 4.0f * asin(std::min(1.0f, fChord * 0.5f));
+		}
+
+		float getError(const Vec3& a, const Vec3& b)
+		{
+			Vec3 vDifference = glm::abs(a - b);
+			return std::max(vDifference.x, std::max(vDifference.y, vDifference.z));
+		}
+
+		// Largest error of a track's frames reconstructed from the decoded keys
+		template <class T>
+		float getTrackError(const std::vector<T>& aFrames, unsigned int uKeys, const std::vector<T>& aDecodedKeys)
+		{
+			float fError = 0.0f;
+			for (unsigned int uFrame = 0; uFrame < aFrames.size(); ++uFrame)
+			{
+				unsigned int uIndex;
+				float fAlpha;
+				findKeys(uKeys, static_cast<float>(uFrame), uIndex, fAlpha);
+				T value = fAlpha > 0.0f ? interpolate(aDecodedKeys[uIndex], aDecodedKeys[uIndex + 1], fAlpha) : aDecodedKeys[uIndex];
+				fError = std::max(fError, getError(value, aFrames[uFrame]));
+			}
+			return fError;
+		}
+
+		// Choose the frames of a track that keep a key. Constant tracks keep only the first, otherwise the first and last
+		// are kept and the worst reproduced frame is added until interpolating between keys is within fTolerance.
+		template <class T>
+		unsigned int reduceKeys(const std::vector<T>& aFrames, float fTolerance)
+		{
+			unsigned int uLast = aFrames.size() - 1;
+			bool bConstant = true;
+			for (unsigned int uFrame = 1; uFrame <= uLast && bConstant; ++uFrame)
+				bConstant = getError(aFrames[uFrame], aFrames[0]) <= fTolerance;
+			if (bConstant)
+				return 1;
+
+			unsigned int uKeys = 1u | (1u << uLast);
+			for (;;)
+			{
+				float fWorstError = 0.0f;
+				unsigned int uWorstFrame = 0;
+				for (unsigned int uFrame = 1; uFrame < uLast; ++uFrame)
+				{
+					if ((uKeys >> uFrame) & 1)
+						continue;
+
+					unsigned int uUpToFrame = (2u << uFrame) - 1;
+					unsigned int uPrevious = highestBit(uKeys & uUpToFrame);
+					unsigned int uNext = lowestBit(uKeys & ~uUpToFrame);
+					float fAlpha = static_cast<float>(uFrame - uPrevious) / (uNext - uPrevious);
+					float fError = getError(interpolate(aFrames[uPrevious], aFrames[uNext], fAlpha), aFrames[uFrame]);
+					if (fError > fWorstError)
+					{
+						fWorstError = fError;
+						uWorstFrame = uFrame;
+					}
+				}
+
+				if (fWorstError <= fTolerance)
+					return uKeys;
+				uKeys |= 1u << uWorstFrame;
+			}
+		}
+
+		template <class T>
+		std::vector<T> getKeys(const std::vector<T>& aFrames, unsigned int uKeys)
+		{
+			std::vector<T> aKeys;
+			for (unsigned int uFrame = 0; uFrame < aFrames.size(); ++uFrame)
+			{
+				if ((uKeys >> uFrame) & 1)
+					aKeys.push_back(aFrames[uFrame]);
+			}
+			return aKeys;
+		}
+
+		// Half the tolerance goes to dropping keys, the rest to quantization. Returns the bits per component and the
+		// error they reach in fError, which is above fTolerance only if MAX_BITS isn't enough.
+		unsigned int encodeRotationTrack(const std::vector<glm::quat>& aFrames, float fTolerance, RotationTrack& track, std::vector<unsigned __int64>& auPacked, float& fError)
+		{
+			track.uKeys = reduceKeys(aFrames, fTolerance * 0.5f);
+			std::vector<glm::quat> aKeys = getKeys(aFrames, track.uKeys);
+			std::vector<glm::quat> aDecodedKeys(aKeys.size());
+			auPacked.resize(aKeys.size());
+
+			unsigned int uBits = MIN_ROTATION_BITS;
+			for (; ; ++uBits)
+			{
+				for (unsigned int i = 0; i < aKeys.size(); ++i)
+				{
+					auPacked[i] = encodeRotation(aKeys[i], uBits);
+					aDecodedKeys[i] = decodeRotation(auPacked[i], uBits);
+				}
+				fError = getTrackError(aFrames, track.uKeys, aDecodedKeys);
+				if (uBits == MAX_BITS || fError <= fTolerance)
+					break;
+			}
+			return uBits;
+		}
+
+		unsigned int encodeVectorTrack(const std::vector<Vec3>& aFrames, float fTolerance, VectorTrack& track, std::vector<unsigned __int64>& auPacked, float& fError)
+		{
+			track.uKeys = reduceKeys(aFrames, fTolerance * 0.5f);
+			std::vector<Vec3> aKeys = getKeys(aFrames, track.uKeys);
+			std::vector<Vec3> aDecodedKeys(aKeys.size());
+			auPacked.resize(aKeys.size());
+
+			Vec3 vMin = aKeys[0], vMax = aKeys[0];
+			for (unsigned int i = 1; i < aKeys.size(); ++i)
+			{
+				vMin = glm::min(vMin, aKeys[i]);
+				vMax = glm::max(vMax, aKeys[i]);
+			}
+
+			unsigned int uBits = 0;
+			for (; ; ++uBits)
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					track.afMin[i] = vMin[i];
+					track.afStep[i] = uBits > 0 ? (vMax[i] - vMin[i]) / ((1u << uBits) - 1) : 0.0f;
+				}
+				for (unsigned int i = 0; i < aKeys.size(); ++i)
+				{
+					auPacked[i] = encodeVector(aKeys[i], track, uBits);
+					aDecodedKeys[i] = decodeVector(auPacked[i], track, uBits);
+				}
+				fError = getTrackError(aFrames, track.uKeys, aDecodedKeys);
+				if (uBits == MAX_BITS || fError <= fTolerance)
+					break;
+			}
+			return uBits;
+		}
+
+		glm::quat sampleRotation(const RotationTrack& track, const unsigned char* pBits, float fFrame)
+		{
+			unsigned int uBits = track.uBitOffset & BITS_MASK;
+			unsigned int uKeyBits = INDEX_BITS + 3 * uBits;
+			unsigned int uBitOffset = track.uBitOffset >> BITS_SHIFT;
+			if (track.uKeys == 1)
+				return decodeRotation(readBits(pBits, uBitOffset, uKeyBits), uBits);
+
+			unsigned int uIndex;
+			float fAlpha;
+			findKeys(track.uKeys, fFrame, uIndex, fAlpha);
+			glm::quat q = decodeRotation(readBits(pBits, uBitOffset + uIndex * uKeyBits, uKeyBits), uBits);
+			if (fAlpha == 0.0f)
+				return q;
+
+			// Not normalized, the pose is normalized once every clip has been added
+			glm::quat qNext = decodeRotation(readBits(pBits, uBitOffset + (uIndex + 1) * uKeyBits, uKeyBits), uBits);
+			if (glm::dot(q, qNext) < 0.0f)
+				qNext = -qNext;
+			return q * (1.0f - fAlpha) + qNext * fAlpha;
+		}
+
+		Vec3 sampleVector(const VectorTrack& track, const unsigned char* pBits, float fFrame)
+		{
+			// Constant tracks quantized to a single value don't need the bit stream
+			unsigned int uBits = track.uBitOffset & BITS_MASK;
+			if (track.uKeys == 1 && uBits == 0)
+				return Vec3(track.afMin[0], track.afMin[1], track.afMin[2]);
+
+			unsigned int uKeyBits = 3 * uBits;
+			unsigned int uBitOffset = track.uBitOffset >> BITS_SHIFT;
+			unsigned int uIndex;
+			float fAlpha;
+			findKeys(track.uKeys, fFrame, uIndex, fAlpha);
+			Vec3 v = decodeVector(readBits(pBits, uBitOffset + uIndex * uKeyBits, uKeyBits), track, uBits);
+			if (fAlpha == 0.0f)
+				return v;
+			return interpolate(v, decodeVector(readBits(pBits, uBitOffset + (uIndex + 1) * uKeyBits, uKeyBits), track, uBits), fAlpha);
+		}
+
+		// Checks that the keys of a track are frames of its segment and fit in the uStreamBits bits of the segment's bit
+		// stream. uIndexBits are the bits each key has besides its 3 components.
+		bool isValidTrack(unsigned int uKeys, unsigned int uBitOffset, unsigned int uIndexBits, unsigned int uSegmentFrames, unsigned __int64 uStreamBits)
+		{
+			unsigned int uBits = uBitOffset & BITS_MASK;
+			unsigned int uValidKeys = uSegmentFrames < 32 ? (1u << uSegmentFrames) - 1 : ~0u;
+			if (!(uKeys & 1) || (uKeys & ~uValidKeys) != 0 || uBits > MAX_BITS)
+				return false;
+
+			unsigned __int64 uKeyBits = uIndexBits + 3 * uBits;
+			return (uBitOffset >> BITS_SHIFT) + countBits(uKeys) * uKeyBits <= uStreamBits;
+		}
+
+		// Checks everything sampling relies on
+		bool isValidClip(const unsigned char* pData, unsigned int uSize)
+		{
+			if (uSize < sizeof(ClipHeader))
+				return false;
+
+			const ClipHeader* pHeader = reinterpret_cast<const ClipHeader*>(pData);
+			if (memcmp(pHeader->acMagic, CLIP_MAGIC, sizeof(CLIP_MAGIC)) != 0 ||
+				pHeader->uVersion != CLIP_VERSION ||
+				pHeader->uSize != uSize ||
+				pHeader->uNumJoints > Skeleton::MAX_JOINTS ||
+				pHeader->uNumFrames == 0 ||
+				!(pHeader->fFrameRate > 0.0f) ||
+				pHeader->uNumSegments != getNumSegments(pHeader->uNumFrames) ||
+				uSize < sizeof(ClipHeader) + pHeader->uNumSegments * sizeof(unsigned int))
+				return false;
+
+			// Segments follow each other as create() writes them, so each bit stream ends where the next segment starts
+			unsigned int uNumJoints = pHeader->uNumJoints;
+			unsigned int uSegmentSize = getSegmentSize(uNumJoints);
+			const unsigned int* puSegmentOffsets = reinterpret_cast<const unsigned int*>(pHeader + 1);
+			unsigned int uMinOffset = sizeof(ClipHeader) + pHeader->uNumSegments * sizeof(unsigned int);
+			for (unsigned int i = 0; i < pHeader->uNumSegments; ++i)
+			{
+				unsigned int uOffset = puSegmentOffsets[i];
+				unsigned int uEnd = i + 1 < pHeader->uNumSegments ? puSegmentOffsets[i + 1] : uSize;
+				if (uOffset % 4 != 0 || uOffset < uMinOffset || uEnd > uSize || uEnd < uOffset || uEnd - uOffset < uSegmentSize + BIT_STREAM_PADDING)
+					return false;
+				uMinOffset = uEnd;
+
+				// Sampling reads 8 bytes at a time, the padding keeps reads of the last keys within the segment
+				unsigned __int64 uStreamBits = static_cast<unsigned __int64>(uEnd - uOffset - uSegmentSize - BIT_STREAM_PADDING) * 8;
+				unsigned int uFirstFrame = i * AnimationClip::SEGMENT_FRAMES;
+				unsigned int uSegmentFrames = std::min(uFirstFrame + AnimationClip::SEGMENT_FRAMES, pHeader->uNumFrames - 1) - uFirstFrame + 1;
+				const RotationTrack* pRotations = reinterpret_cast<const RotationTrack*>(pData + uOffset);
+				const VectorTrack* pVectors = reinterpret_cast<const VectorTrack*>(pRotations + uNumJoints);
+				for (unsigned int uJoint = 0; uJoint < uNumJoints; ++uJoint)
+				{
+					if (!isValidTrack(pRotations[uJoint].uKeys, pRotations[uJoint].uBitOffset, INDEX_BITS, uSegmentFrames, uStreamBits))
+						return false;
+				}
+				for (unsigned int uTrack = 0; uTrack < 2 * uNumJoints; ++uTrack)
+				{
+					if (!isValidTrack(pVectors[uTrack].uKeys, pVectors[uTrack].uBitOffset, 0, uSegmentFrames, uStreamBits))
+						return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	boost::shared_ptr<AnimationClip> AnimationClip::create(const std::string& sName, unsigned int uNumJoints, unsigned int uNumFrames, float fFrameRate, const std::vector<JointPose>& aFrames, const Tolerance& tolerance)
+	{
+		if (uNumFrames == 0 || fFrameRate <= 0.0f || uNumJoints > Skeleton::MAX_JOINTS || aFrames.size() != uNumJoints * uNumFrames)
+		{
+			LOG_ERROR << "Animation clip " << sName << " has " << aFrames.size() << " joint poses, expected " << uNumFrames << " frames of " << uNumJoints;
+			return boost::shared_ptr<AnimationClip>();
+		}
+
+		boost::shared_ptr<AnimationClip> spClip(new AnimationClip(sName));
+		std::vector<unsigned char>& aucData = spClip->m_aucData;
+
+		unsigned int uNumSegments = getNumSegments(uNumFrames);
+		aucData.resize(sizeof(ClipHeader) + uNumSegments * sizeof(unsigned int));
+
+		std::vector<glm::quat> aqFrames;
+		std::vector<Vec3> avTranslationFrames, avScaleFrames;
+		std::vector<unsigned __int64> auPacked;
+		for (unsigned int uSegment = 0; uSegment < uNumSegments; ++uSegment)
+		{
+			unsigned int uFirstFrame = uSegment * SEGMENT_FRAMES;
+			unsigned int uLastFrame = std::min(uFirstFrame + SEGMENT_FRAMES, uNumFrames - 1);
+			unsigned int uSegmentFrames = uLastFrame - uFirstFrame + 1;
+
+			std::vector<RotationTrack> aRotations(uNumJoints);
+			std::vector<VectorTrack> aTranslations(uNumJoints), aScales(uNumJoints);
+			std::vector<unsigned char> aucBits;
+			unsigned int uNumBits = 0;
+
+			for (unsigned int uJoint = 0; uJoint < uNumJoints; ++uJoint)
+			{
+				aqFrames.resize(uSegmentFrames);
+				avTranslationFrames.resize(uSegmentFrames);
+				avScaleFrames.resize(uSegmentFrames);
+				for (unsigned int i = 0; i < uSegmentFrames; ++i)
+				{
+					const JointPose& pose = aFrames[(uFirstFrame + i) * uNumJoints + uJoint];
+					aqFrames[i] = glm::normalize(pose.qRotation);
+					avTranslationFrames[i] = pose.vTranslation;
+					avScaleFrames[i] = pose.vScale;
+				}
+
+				float fError;
+				unsigned int uBits = encodeRotationTrack(aqFrames, tolerance.fRotation, aRotations[uJoint], auPacked, fError);
+				if (fError > tolerance.fRotation)
+					LOG_WARNING << "Animation clip " << sName << " joint " << uJoint << " rotation error " << fError << " exceeds tolerance " << tolerance.fRotation;
+				aRotations[uJoint].uBitOffset = uNumBits << BITS_SHIFT | uBits;
+				for (unsigned int i = 0; i < auPacked.size(); ++i)
+					writeBits(aucBits, uNumBits, auPacked[i], INDEX_BITS + 3 * uBits);
+
+				uBits = encodeVectorTrack(avTranslationFrames, tolerance.fTranslation, aTranslations[uJoint], auPacked, fError);
+				if (fError > tolerance.fTranslation)
+					LOG_WARNING << "Animation clip " << sName << " joint " << uJoint << " translation error " << fError << " exceeds tolerance " << tolerance.fTranslation;
+				aTranslations[uJoint].uBitOffset = uNumBits << BITS_SHIFT | uBits;
+				for (unsigned int i = 0; i < auPacked.size(); ++i)
+					writeBits(aucBits, uNumBits, auPacked[i], 3 * uBits);
+
+				uBits = encodeVectorTrack(avScaleFrames, tolerance.fScale, aScales[uJoint], auPacked, fError);
+				if (fError > tolerance.fScale)
+					LOG_WARNING << "Animation clip " << sName << " joint " << uJoint << " scale error " << fError << " exceeds tolerance " << tolerance.fScale;
+				aScales[uJoint].uBitOffset = uNumBits << BITS_SHIFT | uBits;
+				for (unsigned int i = 0; i < auPacked.size(); ++i)
+					writeBits(aucBits, uNumBits, auPacked[i], 3 * uBits);
+			}
+
+			// Keep every segment 4 byte aligned for the track headers
+			aucBits.resize((aucBits.size() + 3) / 4 * 4 + BIT_STREAM_PADDING, 0);
+
+			unsigned int uOffset = aucData.size();
+			reinterpret_cast<unsigned int*>(&aucData[sizeof(ClipHeader)])[uSegment] = uOffset;
+			aucData.resize(uOffset + getSegmentSize(uNumJoints) + aucBits.size());
+			unsigned char* pSegment = &aucData[uOffset];
+			if (uNumJoints > 0)
+			{
+				memcpy(pSegment, &aRotations[0], uNumJoints * sizeof(RotationTrack));
+				memcpy(pSegment + uNumJoints * sizeof(RotationTrack), &aTranslations[0], uNumJoints * sizeof(VectorTrack));
+				memcpy(pSegment + uNumJoints * (sizeof(RotationTrack) + sizeof(VectorTrack)), &aScales[0], uNumJoints * sizeof(VectorTrack));
+			}
+			memcpy(pSegment + getSegmentSize(uNumJoints), &aucBits[0], aucBits.size());
+		}
+
+		ClipHeader* pHeader = reinterpret_cast<ClipHeader*>(&aucData[0]);
+		memcpy(pHeader->acMagic, CLIP_MAGIC, sizeof(CLIP_MAGIC));
+		pHeader->uVersion = CLIP_VERSION;
+		pHeader->uSize = aucData.size();
+		pHeader->uNumJoints = uNumJoints;
+		pHeader->uNumFrames = uNumFrames;
+		pHeader->uNumSegments = uNumSegments;
+		pHeader->fFrameRate = fFrameRate;
+		spClip->setData(&aucData[0]);
+
+		LOG_INFO << "Compressed animation clip " << sName << " to " << spClip->getSize() << " bytes, " << 100.0f * spClip->getSize() / std::max(1u, spClip->getRawSize()) << "% of raw";
+		return spClip;
+	}
+
+	boost::shared_ptr<AnimationClip> AnimationClip::load(const fs::path& fsPath)
+	{
+		namespace ipc = boost::interprocess;
+
+		boost::shared_ptr<ipc::mapped_region> spMapping;
+		try
+		{
+			ipc::file_mapping file(fsPath.string().c_str(), ipc::read_only);
+			spMapping.reset(new ipc::mapped_region(file, ipc::read_only));
+		}
+		catch (const ipc::interprocess_exception& e)
+		{
+			LOG_ERROR << "Failed to map animation clip " << fsPath << ": " << e.what();
+			return boost::shared_ptr<AnimationClip>();
+		}
+
+		const unsigned char* pData = static_cast<const unsigned char*>(spMapping->get_address());
+		if (!isValidClip(pData, static_cast<unsigned int>(spMapping->get_size())))
+		{
+			LOG_ERROR << "Not a valid animation clip: " << fsPath;
+			return boost::shared_ptr<AnimationClip>();
+		}
+
+		boost::shared_ptr<AnimationClip> spClip(new AnimationClip(fsPath.stem().string()));
+		spClip->m_spMapping = spMapping;
+		spClip->setData(pData);
+		return spClip;
+	}
+
+	AnimationClip::AnimationClip(const std::string& sName)
+		: m_sName(sName)
+		, m_pData(NULL)
+		, m_puSegmentOffsets(NULL)
+		, m_uSize(0)
+		, m_uNumJoints(0)
+		, m_uNumFrames(0)
+		, m_uNumSegments(0)
+		, m_fFrameRate(0.0f)
+	{
+		LOG_VERBOSE << "AnimationClip constructor";
+	}
+
+	AnimationClip::~AnimationClip()
+	{
+		LOG_VERBOSE << "AnimationClip destructor";
+	}
+
+	void AnimationClip::setData(const unsigned char* pData)
+	{
+		const ClipHeader* pHeader = reinterpret_cast<const ClipHeader*>(pData);
+		m_pData = pData;
+		m_puSegmentOffsets = reinterpret_cast<const unsigned int*>(pHeader + 1);
+		m_uSize = pHeader->uSize;
+		m_uNumJoints = pHeader->uNumJoints;
+		m_uNumFrames = pHeader->uNumFrames;
+		m_uNumSegments = pHeader->uNumSegments;
+		m_fFrameRate = pHeader->fFrameRate;
+	}
+
+	bool AnimationClip::save(const fs::path& fsPath) const
+	{
+		boost::system::error_code ec;
+		if (fsPath.has_parent_path())
+			fs::create_directories(fsPath.parent_path(), ec);
+
+		// Write to a temporary file and rename it so that a crash never leaves a half written clip behind
+		fs::path fsTempPath = fsPath;
+		fsTempPath += ".tmp";
+		{
+			fs::ofstream file(fsTempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(m_pData), m_uSize);
+			if (!file)
+			{
+				LOG_ERROR << "Failed to write animation clip " << fsTempPath;
+				return false;
+			}
+		}
+
+		fs::rename(fsTempPath, fsPath, ec);
+		if (ec)
+		{
+			LOG_ERROR << "Failed to write animation clip " << fsPath << ": " << ec.message();
+			return false;
+		}
+		return true;
+	}
+
+	void AnimationClip::accumulate(float fTime, float fWeight, Pose& pose) const
+	{
+		assert(pose.aqRotations.size() == m_uNumJoints);
+
+		float fFrame = std::max(0.0f, std::min(fTime * m_fFrameRate, static_cast<float>(m_uNumFrames - 1)));
+		unsigned int uSegment = std::min(static_cast<unsigned int>(fFrame) / SEGMENT_FRAMES, m_uNumSegments - 1);
+		float fSegmentFrame = fFrame - uSegment * SEGMENT_FRAMES;
+
+		const RotationTrack* pRotations = reinterpret_cast<const RotationTrack*>(m_pData + m_puSegmentOffsets[uSegment]);
+		const VectorTrack* pTranslations = reinterpret_cast<const VectorTrack*>(pRotations + m_uNumJoints);
+		const VectorTrack* pScales = pTranslations + m_uNumJoints;
+		const unsigned char* pBits = reinterpret_cast<const unsigned char*>(pScales + m_uNumJoints);
+
+		// Decode a chunk of joints to the stack, then blend it into the pose with SIMD
+		glm::quat aqRotations[SAMPLE_CHUNK];
+		Vec3 avTranslations[SAMPLE_CHUNK];
+		Vec3 avScales[SAMPLE_CHUNK];
+		for (unsigned int uFirst = 0; uFirst < m_uNumJoints; uFirst += SAMPLE_CHUNK)
+		{
+			unsigned int uCount = std::min(m_uNumJoints - uFirst, SAMPLE_CHUNK);
+			for (unsigned int i = 0; i < uCount; ++i)
+			{
+				aqRotations[i] = sampleRotation(pRotations[uFirst + i], pBits, fSegmentFrame);
+				avTranslations[i] = sampleVector(pTranslations[uFirst + i], pBits, fSegmentFrame);
+				avScales[i] = sampleVector(pScales[uFirst + i], pBits, fSegmentFrame);
+			}
+
+			accumulateQuats(aqRotations, fWeight, &pose.aqRotations[uFirst], uCount);
+			accumulateFloats(&avTranslations[0].x, fWeight, &pose.avTranslations[uFirst].x, uCount * 3);
+			accumulateFloats(&avScales[0].x, fWeight, &pose.avScales[uFirst].x, uCount * 3);
+		}
+	}
+
+} }
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <Animation/Skeleton.h>
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace boost
+{
+	namespace interprocess
+	{
+		class mapped_region;
+	}
+}
+
+namespace baselib
+{
+	namespace animation
+	{
+		/*! @brief Compressed joint animation sampled at a fixed frame rate.
+		 *
+		 *  The clip is split into segments of SEGMENT_FRAMES frames, neighbouring segments sharing their boundary frame,
+		 *  so sampling any time reads a single contiguous block. Within a segment every joint has a rotation, a
+		 *  translation and a scale track, each compressed to its own tolerance:
+		 *
+		 *  - Keys that interpolation between their neighbours reproduces are dropped. A bit mask per track marks the
+		 *    frames that kept a key, constant tracks keep only the first.
+		 *  - Rotations are stored as their three smallest components and the index of the largest, which is rebuilt
+		 *    from the unit length, the way calcQuatWComponent() rebuilds w.
+		 *  - Translations and scales are quantized to the range they cover in the segment.
+		 *  - Each track uses the fewest bits per component that keep it within tolerance, and the keys of all tracks are
+		 *    packed into one bit stream per segment.
+		 *
+		 *  The compressed data is a single position independent block, so save() writes it as is and load() maps the
+		 *  file instead of reading it. Clips are immutable once created and shared by every Animator that plays them.
+		 */
+		class AnimationClip
+		{
+		public:
+			//! Frames per segment, not counting the boundary frame shared with the next segment. Keys of a segment are marked in 32 bits.
+			static const unsigned int SEGMENT_FRAMES = 31;
+
+			/*! @brief Largest error compression may introduce in each track, before errors of parent joints add up.
+			 *
+			 *  Best effort: tracks that still exceed it at 16 bits per component are stored at 16 bits and create() logs a warning.
+			 */
+			struct Tolerance
+			{
+				Tolerance() : fRotation(0.001f), fTranslation(0.001f), fScale(0.001f) {}
+
+				float fRotation;	//!< Angle in radians.
+				float fTranslation;	//!< Distance in each axis, in the units of the clip.
+				float fScale;		//!< Scale difference in each axis.
+			};
+
+			/*! @brief Compresses uNumFrames frames of uNumJoints poses each, frame by frame, into a clip.
+			 *
+			 *  Returns null if aFrames doesn't hold exactly uNumFrames * uNumJoints poses.
+			 */
+			static boost::shared_ptr<AnimationClip> create(const std::string& sName, unsigned int uNumJoints, unsigned int uNumFrames, float fFrameRate, const std::vector<JointPose>& aFrames, const Tolerance& tolerance = Tolerance());
+			//! Maps a clip written by save(). The clip is named after the file. Returns null if the file isn't a valid clip.
+			static boost::shared_ptr<AnimationClip> load(const fs::path& fsPath);
+
+			//! Destructor.
+			virtual ~AnimationClip();
+
+			//! Write the compressed clip to a file. Returns false on failure.
+			bool save(const fs::path& fsPath) const;
+
+			/*! @brief Sample the clip at fTime and add fWeight times the result to pose.
+			 *
+			 *  Once every clip has been added, normalize the rotations with normalizeQuats(). Weights of all clips
+			 *  should add up to one.
+			 */
+			void accumulate(float fTime, float fWeight, Pose& pose) const;
+
+			//! Get the name.
+			const std::string& getName() const { return m_sName; }
+			//! Get the number of joints in each frame.
+			unsigned int getNumJoints() const { return m_uNumJoints; }
+			//! Get the number of frames.
+			unsigned int getNumFrames() const { return m_uNumFrames; }
+			//! Get the number of frames per second.
+			float getFrameRate() const { return m_fFrameRate; }
+			//! Get the duration in seconds, from the first frame to the last.
+			float getDuration() const { return (m_uNumFrames - 1) / m_fFrameRate; }
+
+			//! Get the size of the compressed data in bytes.
+			unsigned int getSize() const { return m_uSize; }
+			//! Get the size the clip would take uncompressed, a float quaternion and two float vectors per joint per frame.
+			unsigned int getRawSize() const { return m_uNumFrames * m_uNumJoints * (sizeof(glm::quat) + 2 * sizeof(Vec3)); }
+
+		protected:
+			//! Protected constructor - must be created by static create() or load().
+			AnimationClip(const std::string& sName);
+
+		private:
+			//! Point the clip at compressed data owned by m_aucData or m_spMapping.
+			void setData(const unsigned char* pData);
+
+			std::string m_sName;												//!< Clip name.
+			std::vector<unsigned char> m_aucData;								//!< Compressed data of clips created in memory.
+			boost::shared_ptr<boost::interprocess::mapped_region> m_spMapping;	//!< Mapped file of loaded clips.
+			const unsigned char* m_pData;										//!< Compressed data.
+			const unsigned int* m_puSegmentOffsets;								//!< Offset of each segment in m_pData.
+			unsigned int m_uSize;												//!< Size of m_pData in bytes.
+			unsigned int m_uNumJoints;											//!< Joints per frame.
+			unsigned int m_uNumFrames;											//!< Number of frames.
+			unsigned int m_uNumSegments;										//!< Number of segments.
+			float m_fFrameRate;													//!< Frames per second.
+
+		};
+	}
+}
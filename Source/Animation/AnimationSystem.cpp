@@ -0,0 +1,167 @@
+#include "AnimationSystem.h"
+
+#include <Logging/Log.h>
+#include <Animation/Animator.h>
+#include <Graphics/Renderer.h>
+#include <Graphics/Buffer.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <string.h>
+
+namespace baselib { namespace animation {
+
+	namespace
+	{
+		// Below this many animators per thread starting the thread costs more than it saves
+		const unsigned int MIN_ANIMATORS_PER_THREAD = 16;
+
+		// Every bound range covers the whole uniform block, even when the skeleton has fewer joints
+		const unsigned int PALETTE_BLOCK_SIZE = Skeleton::MAX_JOINTS * sizeof(Transform);
+
+		// Update every uStride'th animator starting at uFirst
+		void updateAnimators(const std::vector<boost::shared_ptr<Animator>>& aspAnimators, float fDeltaTime, unsigned int uFirst, unsigned int uStride)
+		{
+			for (unsigned int i = uFirst; i < aspAnimators.size(); i += uStride)
+				aspAnimators[i]->update(fDeltaTime);
+		}
+	}
+
+	boost::shared_ptr<AnimationSystem> AnimationSystem::create(const boost::shared_ptr<graphics::Renderer>& spRenderer)
+	{
+		return boost::shared_ptr<AnimationSystem>(new AnimationSystem(spRenderer));
+	}
+
+	AnimationSystem::AnimationSystem(const boost::shared_ptr<graphics::Renderer>& spRenderer)
+		: m_spRenderer(spRenderer)
+		, m_uNumWorkers(0)
+		, m_uGeneration(0)
+		, m_uNumThreads(1)
+		, m_uNumBusy(0)
+		, m_fDeltaTime(0.0f)
+		, m_bStop(false)
+	{
+		LOG_VERBOSE << "AnimationSystem constructor";
+	}
+
+	AnimationSystem::~AnimationSystem()
+	{
+		LOG_VERBOSE << "AnimationSystem destructor";
+
+		{
+			boost::lock_guard<boost::mutex> lock(m_Mutex);
+			m_bStop = true;
+		}
+		m_WorkReady.notify_all();
+		m_Workers.join_all();
+	}
+
+	void AnimationSystem::add(const boost::shared_ptr<Animator>& spAnimator)
+	{
+		if (std::find(m_aspAnimators.begin(), m_aspAnimators.end(), spAnimator) == m_aspAnimators.end())
+			m_aspAnimators.push_back(spAnimator);
+	}
+
+	void AnimationSystem::remove(const boost::shared_ptr<Animator>& spAnimator)
+	{
+		auto it = std::find(m_aspAnimators.begin(), m_aspAnimators.end(), spAnimator);
+		if (it == m_aspAnimators.end())
+			return;
+
+		(*it)->m_spPalettes.reset();
+		m_aspAnimators.erase(it);
+	}
+
+	void AnimationSystem::update(float fDeltaTime, unsigned int uMaxThreads)
+	{
+		unsigned int uNumThreads = uMaxThreads > 0 ? uMaxThreads : std::max(1u, boost::thread::hardware_concurrency());
+		uNumThreads = std::max(1u, std::min(uNumThreads, (unsigned int)m_aspAnimators.size() / MIN_ANIMATORS_PER_THREAD));
+
+		if (uNumThreads == 1)
+		{
+			updateAnimators(m_aspAnimators, fDeltaTime, 0, 1);
+			return;
+		}
+
+		// Starting threads every frame would cost more than updating many animators, so the workers are kept
+		for (; m_uNumWorkers < uNumThreads - 1; ++m_uNumWorkers)
+			m_Workers.create_thread(boost::bind(&AnimationSystem::runWorker, this, m_uNumWorkers, m_uGeneration));
+
+		// Animators share only immutable skeletons and clips, every thread writes its own animators
+		{
+			boost::lock_guard<boost::mutex> lock(m_Mutex);
+			m_fDeltaTime = fDeltaTime;
+			m_uNumThreads = uNumThreads;
+			m_uNumBusy = uNumThreads - 1;
+			++m_uGeneration;
+		}
+		m_WorkReady.notify_all();
+
+		updateAnimators(m_aspAnimators, fDeltaTime, 0, uNumThreads);
+
+		boost::unique_lock<boost::mutex> lock(m_Mutex);
+		while (m_uNumBusy > 0)
+			m_WorkDone.wait(lock);
+	}
+
+	void AnimationSystem::runWorker(unsigned int uWorker, unsigned int uGeneration)
+	{
+		boost::unique_lock<boost::mutex> lock(m_Mutex);
+		for (;;)
+		{
+			while (!m_bStop && m_uGeneration == uGeneration)
+				m_WorkReady.wait(lock);
+			if (m_bStop)
+				return;
+
+			// Workers beyond the threads this update asked for sit it out
+			uGeneration = m_uGeneration;
+			unsigned int uThread = uWorker + 1;
+			if (uThread >= m_uNumThreads)
+				continue;
+
+			unsigned int uNumThreads = m_uNumThreads;
+			float fDeltaTime = m_fDeltaTime;
+			lock.unlock();
+			updateAnimators(m_aspAnimators, fDeltaTime, uThread, uNumThreads);
+			lock.lock();
+
+			if (--m_uNumBusy == 0)
+				m_WorkDone.notify_one();
+		}
+	}
+
+	void AnimationSystem::upload()
+	{
+		if (m_aspAnimators.empty())
+			return;
+
+		// Pack the palettes at offsets bindRange() accepts for uniform buffers. The last range still has to cover a whole block.
+		unsigned int uAlignment = m_spRenderer->getUniformBufferOffsetAlignment();
+		unsigned int uOffset = 0;
+		for (auto it = m_aspAnimators.begin(); it != m_aspAnimators.end(); ++it)
+		{
+			(*it)->m_uPaletteOffset = uOffset;
+			unsigned int uSize = (*it)->getPalette().size() * sizeof(Transform);
+			uOffset += (uSize + uAlignment - 1) / uAlignment * uAlignment;
+		}
+		unsigned int uSize = m_aspAnimators.back()->m_uPaletteOffset + PALETTE_BLOCK_SIZE;
+
+		m_aucStaging.resize(uSize);
+		for (auto it = m_aspAnimators.begin(); it != m_aspAnimators.end(); ++it)
+		{
+			const std::vector<Transform>& aPalette = (*it)->getPalette();
+			if (!aPalette.empty())
+				memcpy(&m_aucStaging[(*it)->m_uPaletteOffset], &aPalette[0], aPalette.size() * sizeof(Transform));
+		}
+
+		if (!m_spPalettes)
+			m_spPalettes = m_spRenderer->createBuffer(uSize, graphics::Buffer::USAGE_DYNAMIC);
+		else if (m_spPalettes->getSize() < uSize)
+			m_spPalettes->resize(uSize);
+		m_spPalettes->update(0, uSize, &m_aucStaging[0]);
+
+		for (auto it = m_aspAnimators.begin(); it != m_aspAnimators.end(); ++it)
+			(*it)->m_spPalettes = m_spPalettes;
+	}
+
+} }
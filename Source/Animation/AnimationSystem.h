@@ -0,0 +1,80 @@
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <vector>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		class Renderer;
+		class Buffer;
+	}
+
+	namespace animation
+	{
+		class Animator;
+	}
+}
+
+namespace baselib
+{
+	namespace animation
+	{
+		/*! @brief Updates many Animators in parallel and uploads their palettes to the GPU.
+		 *
+		 *  update() spreads the animators over worker threads, interleaved so that each thread gets a similar mix of
+		 *  small and large skeletons. The calling thread takes a share too and returns once all are done. The workers are
+		 *  started by the first update() that needs them and sleep between updates until the system is destroyed. upload() then
+		 *  packs every palette into one uniform buffer with a single upload, and each Animator binds its own range of it
+		 *  when its Visuals are drawn.
+		 */
+		class AnimationSystem
+		{
+		public:
+			//! Creates an AnimationSystem.
+			static boost::shared_ptr<AnimationSystem> create(const boost::shared_ptr<graphics::Renderer>& spRenderer);
+
+			//! Destructor.
+			virtual ~AnimationSystem();
+
+			//! Add an animator. Adding it twice has no effect.
+			void add(const boost::shared_ptr<Animator>& spAnimator);
+			//! Remove an animator.
+			void remove(const boost::shared_ptr<Animator>& spAnimator);
+			//! Get the number of animators.
+			unsigned int getNumAnimators() const { return m_aspAnimators.size(); }
+
+			//! Update every animator by fDeltaTime seconds on up to uMaxThreads threads, 0 uses one per hardware thread.
+			void update(float fDeltaTime, unsigned int uMaxThreads = 0);
+			//! Upload the palettes of every animator. Call from the GL thread after update().
+			void upload();
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			AnimationSystem(const boost::shared_ptr<graphics::Renderer>& spRenderer);
+
+		private:
+			//! Worker thread loop, updates its share of the animators every time update() signals a generation after uGeneration.
+			void runWorker(unsigned int uWorker, unsigned int uGeneration);
+
+			boost::shared_ptr<graphics::Renderer> m_spRenderer;		//!< Creates the palette buffer.
+			std::vector<boost::shared_ptr<Animator>> m_aspAnimators;	//!< Animators to update.
+			boost::shared_ptr<graphics::Buffer> m_spPalettes;			//!< Palettes of every animator.
+			std::vector<unsigned char> m_aucStaging;					//!< Palettes packed for upload.
+
+			boost::thread_group m_Workers;								//!< Worker threads, kept between updates.
+			unsigned int m_uNumWorkers;									//!< Number of threads in m_Workers.
+			boost::mutex m_Mutex;										//!< Guards the fields below.
+			boost::condition_variable m_WorkReady;						//!< Signalled when update() hands out work or on shutdown.
+			boost::condition_variable m_WorkDone;						//!< Signalled when the last busy worker finishes.
+			unsigned int m_uGeneration;									//!< Incremented by every update() that uses the workers.
+			unsigned int m_uNumThreads;									//!< Threads sharing the current update, the calling one included.
+			unsigned int m_uNumBusy;									//!< Workers still updating their share.
+			float m_fDeltaTime;											//!< Time step of the current update.
+			bool m_bStop;												//!< Tells the workers to exit.
+
+		};
+	}
+}
@@ -0,0 +1,139 @@
+#include "Animator.h"
+
+#include <Logging/Log.h>
+#include <Animation/AnimationClip.h>
+#include <Graphics/Buffer.h>
+#include <Math/SIMD.h>
+#include <algorithm>
+
+namespace baselib { namespace animation {
+
+	namespace
+	{
+		// Layers that were never set
+		const Animator::Layer EMPTY_LAYER = { boost::shared_ptr<AnimationClip>(), 0.0f, 1.0f, 0.0f, true };
+	}
+
+	boost::shared_ptr<Animator> Animator::create(const boost::shared_ptr<Skeleton>& spSkeleton)
+	{
+		return boost::shared_ptr<Animator>(new Animator(spSkeleton));
+	}
+
+	Animator::Animator(const boost::shared_ptr<Skeleton>& spSkeleton)
+		: m_spSkeleton(spSkeleton)
+		, m_uPaletteOffset(0)
+	{
+		LOG_VERBOSE << "Animator constructor";
+
+		unsigned int uNumJoints = m_spSkeleton->getNumJoints();
+		m_Pose = m_spSkeleton->getBindPose();
+		m_aLocal.resize(uNumJoints);
+		m_aModel.resize(uNumJoints);
+		m_aPalette.resize(uNumJoints);
+		update(0.0f);
+	}
+
+	Animator::~Animator()
+	{
+		LOG_VERBOSE << "Animator destructor";
+	}
+
+	void Animator::setLayer(unsigned int uLayer, const boost::shared_ptr<AnimationClip>& spClip, float fWeight, float fSpeed, bool bLoop)
+	{
+		if (spClip && spClip->getNumJoints() != m_spSkeleton->getNumJoints())
+		{
+			LOG_ERROR << "Animation clip " << spClip->getName() << " animates " << spClip->getNumJoints() << " joints, the skeleton has " << m_spSkeleton->getNumJoints();
+			return;
+		}
+
+		if (uLayer >= m_aLayers.size())
+			m_aLayers.resize(uLayer + 1, EMPTY_LAYER);
+
+		Layer& layer = m_aLayers[uLayer];
+		layer.spClip = spClip;
+		layer.fTime = 0.0f;
+		layer.fSpeed = fSpeed;
+		layer.fWeight = fWeight;
+		layer.bLoop = bLoop;
+	}
+
+	void Animator::clearLayer(unsigned int uLayer)
+	{
+		if (uLayer < m_aLayers.size())
+			m_aLayers[uLayer].spClip.reset();
+	}
+
+	void Animator::setLayerWeight(unsigned int uLayer, float fWeight)
+	{
+		if (uLayer < m_aLayers.size())
+			m_aLayers[uLayer].fWeight = fWeight;
+	}
+
+	void Animator::setLayerTime(unsigned int uLayer, float fTime)
+	{
+		if (uLayer < m_aLayers.size())
+			m_aLayers[uLayer].fTime = fTime;
+	}
+
+	const Animator::Layer& Animator::getLayer(unsigned int uLayer) const
+	{
+		return uLayer < m_aLayers.size() ? m_aLayers[uLayer] : EMPTY_LAYER;
+	}
+
+	void Animator::update(float fDeltaTime)
+	{
+		unsigned int uNumJoints = m_spSkeleton->getNumJoints();
+		if (uNumJoints == 0)
+			return;
+
+		float fTotalWeight = 0.0f;
+		for (auto it = m_aLayers.begin(); it != m_aLayers.end(); ++it)
+		{
+			if (!it->spClip)
+				continue;
+
+			float fDuration = it->spClip->getDuration();
+			it->fTime += fDeltaTime * it->fSpeed;
+			if (it->bLoop && fDuration > 0.0f)
+			{
+				it->fTime = fmod(it->fTime, fDuration);
+				if (it->fTime < 0.0f)
+					it->fTime += fDuration;
+			}
+			else
+				it->fTime = std::max(0.0f, std::min(it->fTime, fDuration));
+
+			if (it->fWeight > 0.0f)
+				fTotalWeight += it->fWeight;
+		}
+
+		// Sample every layer into one pose. Interpolation between frames and blending between clips both add weighted
+		// keys, so the rotations are normalized once at the end.
+		if (fTotalWeight > 0.0f)
+		{
+			m_Pose.clear();
+			for (auto it = m_aLayers.begin(); it != m_aLayers.end(); ++it)
+			{
+				if (it->spClip && it->fWeight > 0.0f)
+					it->spClip->accumulate(it->fTime, it->fWeight / fTotalWeight, m_Pose);
+			}
+			normalizeQuats(&m_Pose.aqRotations[0], uNumJoints);
+		}
+		else
+			m_Pose = m_spSkeleton->getBindPose();
+
+		quatsToTransforms(&m_Pose.aqRotations[0], &m_Pose.avTranslations[0], &m_Pose.avScales[0], &m_aLocal[0], uNumJoints);
+		m_spSkeleton->localToModel(&m_aLocal[0], &m_aModel[0]);
+
+		const std::vector<Transform>& aInverseBind = m_spSkeleton->getInverseBindTransforms();
+		for (unsigned int i = 0; i < uNumJoints; ++i)
+			multiplyTransform(m_aModel[i], aInverseBind[i], m_aPalette[i]);
+	}
+
+	void Animator::bindPalette() const
+	{
+		if (m_spPalettes)
+			m_spPalettes->bindRange(graphics::Buffer::UNIFORM, PALETTE_BINDING, m_uPaletteOffset, Skeleton::MAX_JOINTS * sizeof(Transform));
+	}
+
+} }
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Animation/Skeleton.h>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		class Buffer;
+	}
+
+	namespace animation
+	{
+		class AnimationClip;
+	}
+}
+
+namespace baselib
+{
+	namespace animation
+	{
+		/*! @brief Plays and blends animation clips on one instance of a skeleton and builds its skinning palette.
+		 *
+		 *  Every layer plays one clip at its own time, speed and weight. update() samples all layers into a single pose,
+		 *  the weights normalized so that they add up to one, converts it to model space and multiplies each joint by its
+		 *  inverse bind transform, giving the palette meshes are skinned with.
+		 *
+		 *  update() only touches the animator's own data, so different animators can be updated on different threads,
+		 *  see AnimationSystem. Attach an animator to the Visuals it deforms with Visual::setAnimator().
+		 */
+		class Animator
+		{
+		public:
+			friend class AnimationSystem;
+
+			//! Uniform block binding of the palette, read as vec4 rows[3 * Skeleton::MAX_JOINTS] with row i of joint j at 3 * j + i.
+			static const unsigned int PALETTE_BINDING = 0;
+
+			//! One clip being played.
+			struct Layer
+			{
+				boost::shared_ptr<AnimationClip> spClip;	//!< Clip, null if the layer is unused.
+				float fTime;								//!< Current time in seconds.
+				float fSpeed;								//!< Playback speed, negative plays backwards.
+				float fWeight;								//!< Blend weight, relative to the other layers.
+				bool bLoop;									//!< Wrap around at the ends, otherwise hold the first or last frame.
+			};
+
+			//! Creates an Animator in the bind pose of spSkeleton.
+			static boost::shared_ptr<Animator> create(const boost::shared_ptr<Skeleton>& spSkeleton);
+
+			//! Destructor.
+			virtual ~Animator();
+
+			//! Play spClip on layer uLayer from the start. The clip must animate as many joints as the skeleton has.
+			void setLayer(unsigned int uLayer, const boost::shared_ptr<AnimationClip>& spClip, float fWeight = 1.0f, float fSpeed = 1.0f, bool bLoop = true);
+			//! Stop the clip on layer uLayer.
+			void clearLayer(unsigned int uLayer);
+			//! Set the blend weight of layer uLayer, e.g. to cross fade. Ignored if the layer was never set.
+			void setLayerWeight(unsigned int uLayer, float fWeight);
+			//! Set the time of layer uLayer. Ignored if the layer was never set.
+			void setLayerTime(unsigned int uLayer, float fTime);
+			//! Get a layer, an unused one without a clip if uLayer was never set.
+			const Layer& getLayer(unsigned int uLayer) const;
+			//! Get the number of layers.
+			unsigned int getNumLayers() const { return m_aLayers.size(); }
+
+			//! Advance every layer by fDeltaTime seconds and rebuild the pose and the palette. Plays the bind pose if no layer has weight.
+			void update(float fDeltaTime);
+
+			//! Get the skeleton.
+			const boost::shared_ptr<Skeleton>& getSkeleton() const { return m_spSkeleton; }
+			//! Get the blended local pose of the last update().
+			const Pose& getPose() const { return m_Pose; }
+			//! Get the model space transform of each joint, e.g. to attach objects to joints.
+			const std::vector<Transform>& getModelTransforms() const { return m_aModel; }
+			//! Get the skinning palette, model space joint transforms times inverse bind transforms.
+			const std::vector<Transform>& getPalette() const { return m_aPalette; }
+
+			//! Bind the palette to PALETTE_BINDING. No-op until the palette has been uploaded by an AnimationSystem.
+			void bindPalette() const;
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			Animator(const boost::shared_ptr<Skeleton>& spSkeleton);
+
+		private:
+			boost::shared_ptr<Skeleton> m_spSkeleton;			//!< Skeleton being animated.
+			std::vector<Layer> m_aLayers;						//!< Layers, unused ones have no clip.
+			Pose m_Pose;										//!< Blended local pose.
+			std::vector<Transform> m_aLocal;					//!< Local joint transforms built from m_Pose.
+			std::vector<Transform> m_aModel;					//!< Model space joint transforms.
+			std::vector<Transform> m_aPalette;					//!< Skinning palette.
+			boost::shared_ptr<graphics::Buffer> m_spPalettes;	//!< Uniform buffer holding the palette, shared between the animators of an AnimationSystem.
+			unsigned int m_uPaletteOffset;						//!< Offset of the palette in m_spPalettes.
+
+		};
+	}
+}
@@ -0,0 +1,91 @@
+#include "Skeleton.h"
+
+#include <Logging/Log.h>
+#include <Math/SIMD.h>
+#include <algorithm>
+
+namespace baselib { namespace animation {
+
+	void Pose::clear()
+	{
+		std::fill(aqRotations.begin(), aqRotations.end(), glm::quat(0.0f, 0.0f, 0.0f, 0.0f));
+		std::fill(avTranslations.begin(), avTranslations.end(), Vec3(0.0f));
+		std::fill(avScales.begin(), avScales.end(), Vec3(0.0f));
+	}
+
+	boost::shared_ptr<Skeleton> Skeleton::create(const std::vector<Joint>& aJoints)
+	{
+		if (aJoints.size() > MAX_JOINTS)
+		{
+			LOG_ERROR << "Skeleton has " << aJoints.size() << " joints, at most " << MAX_JOINTS << " are supported";
+			return boost::shared_ptr<Skeleton>();
+		}
+
+		for (unsigned int i = 0; i < aJoints.size(); ++i)
+		{
+			if (aJoints[i].iParent >= static_cast<int>(i) || aJoints[i].iParent < NO_PARENT)
+			{
+				LOG_ERROR << "Skeleton joint " << aJoints[i].sName << " doesn't come after its parent";
+				return boost::shared_ptr<Skeleton>();
+			}
+		}
+
+		return boost::shared_ptr<Skeleton>(new Skeleton(aJoints));
+	}
+
+	Skeleton::Skeleton(const std::vector<Joint>& aJoints)
+		: m_aJoints(aJoints)
+	{
+		LOG_VERBOSE << "Skeleton constructor";
+
+		unsigned int uNumJoints = m_aJoints.size();
+		m_aiParents.resize(uNumJoints);
+		m_BindPose.resize(uNumJoints);
+		for (unsigned int i = 0; i < uNumJoints; ++i)
+		{
+			m_aiParents[i] = m_aJoints[i].iParent;
+			m_BindPose.aqRotations[i] = glm::normalize(m_aJoints[i].bindPose.qRotation);
+			m_BindPose.avTranslations[i] = m_aJoints[i].bindPose.vTranslation;
+			m_BindPose.avScales[i] = m_aJoints[i].bindPose.vScale;
+		}
+
+		if (uNumJoints == 0)
+			return;
+
+		std::vector<Transform> aLocal(uNumJoints), aModel(uNumJoints);
+		quatsToTransforms(&m_BindPose.aqRotations[0], &m_BindPose.avTranslations[0], &m_BindPose.avScales[0], &aLocal[0], uNumJoints);
+		localToModel(&aLocal[0], &aModel[0]);
+
+		m_aInverseBind.resize(uNumJoints);
+		for (unsigned int i = 0; i < uNumJoints; ++i)
+			m_aInverseBind[i] = aModel[i].inverse();
+	}
+
+	Skeleton::~Skeleton()
+	{
+		LOG_VERBOSE << "Skeleton destructor";
+	}
+
+	int Skeleton::findJoint(const std::string& sName) const
+	{
+		for (unsigned int i = 0; i < m_aJoints.size(); ++i)
+		{
+			if (m_aJoints[i].sName == sName)
+				return i;
+		}
+		return NO_PARENT;
+	}
+
+	void Skeleton::localToModel(const Transform* pLocal, Transform* pModel) const
+	{
+		for (unsigned int i = 0; i < m_aiParents.size(); ++i)
+		{
+			int iParent = m_aiParents[i];
+			if (iParent == NO_PARENT)
+				pModel[i] = pLocal[i];
+			else
+				multiplyTransform(pModel[iParent], pLocal[i], pModel[i]);
+		}
+	}
+
+} }
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <Math/Transform.h>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+namespace baselib
+{
+	namespace animation
+	{
+		//! Local transform of one joint, relative to its parent.
+		struct JointPose
+		{
+			JointPose() : vTranslation(0.0f), vScale(1.0f) {}
+			JointPose(const glm::quat& q, const Vec3& vT, const Vec3& vS = Vec3(1.0f)) : qRotation(q), vTranslation(vT), vScale(vS) {}
+
+			glm::quat qRotation;	//!< Rotation, a unit quaternion.
+			Vec3 vTranslation;		//!< Translation.
+			Vec3 vScale;			//!< Scale, applied before the rotation.
+		};
+
+		/*! @brief Local transforms of every joint of a skeleton, as parallel arrays.
+		 *
+		 *  Structure of arrays so that sampling and blending run over all joints of a component at once, see
+		 *  AnimationClip::accumulate().
+		 */
+		struct Pose
+		{
+			//! Resize for uNumJoints joints.
+			void resize(unsigned int uNumJoints) { aqRotations.resize(uNumJoints); avTranslations.resize(uNumJoints); avScales.resize(uNumJoints); }
+			//! Set everything to zero, ready for AnimationClip::accumulate().
+			void clear();
+
+			std::vector<glm::quat> aqRotations;	//!< Joint rotations.
+			std::vector<Vec3> avTranslations;	//!< Joint translations.
+			std::vector<Vec3> avScales;			//!< Joint scales.
+		};
+
+		/*! @brief A hierarchy of joints and the bind pose meshes are skinned in.
+		 *
+		 *  Joints are stored parents first, so a single pass over them converts a Pose from local to model space.
+		 *  Skeletons are immutable once created and shared by every Animator that plays them.
+		 */
+		class Skeleton
+		{
+		public:
+			//! Maximum number of joints, the largest palette that fits the minimum uniform block size.
+			static const unsigned int MAX_JOINTS = 256;
+			//! Parent of root joints.
+			static const int NO_PARENT = -1;
+
+			//! One joint.
+			struct Joint
+			{
+				std::string sName;	//!< Name, e.g. to attach objects.
+				int iParent;		//!< Index of the parent joint, lower than this joint's, or NO_PARENT.
+				JointPose bindPose;	//!< Local transform in the bind pose.
+			};
+
+			/*! @brief Creates a Skeleton from joints sorted parents first.
+			 *
+			 *  Returns null if a parent comes after its child or there are more than MAX_JOINTS joints.
+			 */
+			static boost::shared_ptr<Skeleton> create(const std::vector<Joint>& aJoints);
+
+			//! Destructor.
+			virtual ~Skeleton();
+
+			//! Get the number of joints.
+			unsigned int getNumJoints() const { return m_aJoints.size(); }
+			//! Get a joint.
+			const Joint& getJoint(unsigned int uJoint) const { return m_aJoints[uJoint]; }
+			//! Get the parent of each joint.
+			const std::vector<int>& getParents() const { return m_aiParents; }
+			//! Find a joint by name. Returns NO_PARENT if there is none.
+			int findJoint(const std::string& sName) const;
+
+			//! Get the bind pose.
+			const Pose& getBindPose() const { return m_BindPose; }
+			//! Get the inverse of each joint's model space bind transform, i.e. from model space to joint space.
+			const std::vector<Transform>& getInverseBindTransforms() const { return m_aInverseBind; }
+
+			//! Convert local joint transforms to model space. Parents must come first, as they do in the skeleton.
+			void localToModel(const Transform* pLocal, Transform* pModel) const;
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			Skeleton(const std::vector<Joint>& aJoints);
+
+		private:
+			std::vector<Joint> m_aJoints;				//!< Joints, parents first.
+			std::vector<int> m_aiParents;				//!< Parent of each joint, copied out of m_aJoints for the update loops.
+			Pose m_BindPose;							//!< Local bind pose.
+			std::vector<Transform> m_aInverseBind;		//!< Inverse model space bind transforms.
+
+		};
+	}
+}
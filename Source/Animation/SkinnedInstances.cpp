@@ -0,0 +1,149 @@
+#include "SkinnedInstances.h"
+
+#include <Logging/Log.h>
+#include <Animation/Animator.h>
+#include <Graphics/Renderer.h>
+#include <Graphics/Buffer.h>
+#include <Graphics/Texture.h>
+#include <Graphics/Geometry.h>
+#include <Graphics/VertexList.h>
+#include <Graphics/Material.h>
+#include <Graphics/Shader.h>
+#include <Graphics/Spatial.h>
+#include <Graphics/Camera.h>
+#include <Math/SIMD.h>
+#include <algorithm>
+
+namespace baselib { namespace animation {
+
+	namespace
+	{
+		// Texels per joint, one RGBA32F texel per row of its transform
+		const unsigned int TEXELS_PER_JOINT = sizeof(Transform) / sizeof(Vec4);
+	}
+
+	boost::shared_ptr<SkinnedInstances> SkinnedInstances::create(const boost::shared_ptr<graphics::Renderer>& spRenderer,
+																 const boost::shared_ptr<graphics::Geometry>& spGeometry,
+																 const boost::shared_ptr<graphics::Material>& spMaterial,
+																 const boost::shared_ptr<Skeleton>& spSkeleton)
+	{
+		return boost::shared_ptr<SkinnedInstances>(new SkinnedInstances(spRenderer, spGeometry, spMaterial, spSkeleton));
+	}
+
+	SkinnedInstances::SkinnedInstances(const boost::shared_ptr<graphics::Renderer>& spRenderer,
+									   const boost::shared_ptr<graphics::Geometry>& spGeometry,
+									   const boost::shared_ptr<graphics::Material>& spMaterial,
+									   const boost::shared_ptr<Skeleton>& spSkeleton)
+		: m_spRenderer(spRenderer)
+		, m_spGeometry(spGeometry)
+		, m_spMaterial(spMaterial)
+		, m_spSkeleton(spSkeleton)
+		, m_fBoundsMargin(0.0f)
+		, m_uNumVisible(0)
+		, m_uNumDraws(0)
+	{
+		LOG_VERBOSE << "SkinnedInstances constructor";
+		assert(m_spGeometry && m_spMaterial && m_spSkeleton);
+	}
+
+	SkinnedInstances::~SkinnedInstances()
+	{
+		LOG_VERBOSE << "SkinnedInstances destructor";
+	}
+
+	void SkinnedInstances::add(const boost::shared_ptr<Animator>& spAnimator, const boost::shared_ptr<graphics::Spatial>& spSpatial)
+	{
+		assert(spAnimator && spSpatial);
+		assert(spAnimator->getSkeleton() == m_spSkeleton);
+
+		Instance instance;
+		instance.spAnimator = spAnimator;
+		instance.spSpatial = spSpatial;
+		m_aInstances.push_back(instance);
+	}
+
+	void SkinnedInstances::remove(const boost::shared_ptr<Animator>& spAnimator)
+	{
+		for (auto it = m_aInstances.begin(); it != m_aInstances.end(); ++it)
+		{
+			if (it->spAnimator == spAnimator)
+			{
+				m_aInstances.erase(it);
+				return;
+			}
+		}
+	}
+
+	unsigned int SkinnedInstances::getInstancesPerDraw() const
+	{
+		unsigned int uTexelsPerInstance = std::max(1u, m_spSkeleton->getNumJoints()) * TEXELS_PER_JOINT;
+		return std::max(1u, std::min(MAX_INSTANCES_PER_DRAW, m_spRenderer->getMaxTextureBufferSize() / uTexelsPerInstance));
+	}
+
+	void SkinnedInstances::render(const graphics::Frustum& frustum)
+	{
+		m_uNumVisible = 0;
+		m_uNumDraws = 0;
+		if (m_aInstances.empty() || m_spSkeleton->getNumJoints() == 0 || !m_spMaterial->isReady())
+			return;
+
+		// Gather the world space palettes of the visible instances
+		unsigned int uNumJoints = m_spSkeleton->getNumJoints();
+		Vec3 vMargin(m_fBoundsMargin);
+		AABB bounds = m_spGeometry->getBounds();
+		bounds = AABB(bounds.vMin - vMargin, bounds.vMax + vMargin);
+
+		m_aStaging.resize(m_aInstances.size() * uNumJoints);
+		for (auto it = m_aInstances.begin(); it != m_aInstances.end(); ++it)
+		{
+			const Transform& world = it->spSpatial->getWorld();
+			if (!frustum.intersects(transformAABB(bounds, world)))
+				continue;
+
+			const std::vector<Transform>& aPalette = it->spAnimator->getPalette();
+			Transform* pPalette = &m_aStaging[m_uNumVisible * uNumJoints];
+			for (unsigned int i = 0; i < uNumJoints; ++i)
+				multiplyTransform(world, aPalette[i], pPalette[i]);
+			++m_uNumVisible;
+		}
+		if (m_uNumVisible == 0)
+			return;
+
+		// Upload them in draw sized pieces, every draw has a buffer of its own so uploads don't wait for earlier draws
+		unsigned int uInstancesPerDraw = getInstancesPerDraw();
+		unsigned int uPaletteSize = uNumJoints * sizeof(Transform);
+		unsigned int uNumDraws = (m_uNumVisible + uInstancesPerDraw - 1) / uInstancesPerDraw;
+		for (unsigned int uDraw = 0; uDraw < uNumDraws; ++uDraw)
+		{
+			if (uDraw == m_aspPalettes.size() || m_aspPalettes[uDraw]->getSize() != uInstancesPerDraw * uPaletteSize)
+			{
+				m_aspPalettes.resize(std::max<size_t>(m_aspPalettes.size(), uDraw + 1));
+				m_aspPaletteTextures.resize(m_aspPalettes.size());
+				m_aspPalettes[uDraw] = m_spRenderer->createBuffer(uInstancesPerDraw * uPaletteSize, graphics::Buffer::USAGE_DYNAMIC);
+				m_aspPaletteTextures[uDraw] = graphics::Texture::create(m_aspPalettes[uDraw], graphics::Texture::FORMAT_RGBA32F);
+			}
+
+			unsigned int uFirst = uDraw * uInstancesPerDraw;
+			unsigned int uCount = std::min(uInstancesPerDraw, m_uNumVisible - uFirst);
+			m_aspPalettes[uDraw]->update(0, uCount * uPaletteSize, &m_aStaging[uFirst * uNumJoints]);
+		}
+
+		// Draw
+		m_spMaterial->bind();
+		const boost::shared_ptr<graphics::Shader>& spShader = m_spMaterial->getShader();
+		spShader->setUniform(spShader->getUniform("sPalette"), static_cast<int>(PALETTE_UNIT));
+		spShader->setUniform(spShader->getUniform("iNumJoints"), static_cast<int>(uNumJoints));
+
+		m_spGeometry->bind();
+		unsigned int uNumIndices = m_spGeometry->getVertexList()->getNumIndices();
+		for (unsigned int uDraw = 0; uDraw < uNumDraws; ++uDraw)
+		{
+			unsigned int uCount = std::min(uInstancesPerDraw, m_uNumVisible - uDraw * uInstancesPerDraw);
+			m_aspPaletteTextures[uDraw]->bind(PALETTE_UNIT);
+			m_spRenderer->drawIndexedInstanced(m_spGeometry->getPrimitiveType(), uNumIndices, 0, uCount);
+			++m_uNumDraws;
+		}
+		m_spGeometry->unbind();
+	}
+
+} }
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Math/Transform.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		class Renderer;
+		class Geometry;
+		class Material;
+		class Spatial;
+		class Frustum;
+		class Buffer;
+		class Texture;
+	}
+
+	namespace animation
+	{
+		class Skeleton;
+		class Animator;
+	}
+}
+
+namespace baselib
+{
+	namespace animation
+	{
+		/*! @brief Draws many animated copies of one skinned mesh with a few instanced draws.
+		 *
+		 *  Every instance is an Animator of the same skeleton, placed in the world by a Spatial. render() culls the
+		 *  instances against the frustum, bakes each world transform into its palette and uploads the palettes of the
+		 *  visible ones to buffer textures, then draws up to MAX_INSTANCES_PER_DRAW instances per draw.
+		 *
+		 *  Palettes are bound as a samplerBuffer to texture unit PALETTE_UNIT, with the number of joints in the uniform
+		 *  iNumJoints. Row i of the world space transform of joint j is texel (gl_InstanceID * iNumJoints + j) * 3 + i.
+		 *  Data/Shaders/Include/Skinning.glsl reads it when SKINNED_INSTANCES is defined.
+		 *
+		 *  The animators are updated elsewhere, e.g. by an AnimationSystem, before render().
+		 */
+		class SkinnedInstances
+		{
+		public:
+			//! Texture unit the palettes are bound to.
+			static const unsigned int PALETTE_UNIT = 1;
+			//! Most instances per draw. Fewer if the palettes don't fit Renderer::getMaxTextureBufferSize().
+			static const unsigned int MAX_INSTANCES_PER_DRAW = 256;
+
+			//! Creates SkinnedInstances of spGeometry skinned by joints of spSkeleton and drawn with spMaterial.
+			static boost::shared_ptr<SkinnedInstances> create(const boost::shared_ptr<graphics::Renderer>& spRenderer,
+															  const boost::shared_ptr<graphics::Geometry>& spGeometry,
+															  const boost::shared_ptr<graphics::Material>& spMaterial,
+															  const boost::shared_ptr<Skeleton>& spSkeleton);
+
+			//! Destructor.
+			virtual ~SkinnedInstances();
+
+			//! Add an instance animated by spAnimator at the world transform of spSpatial. The animator must use the batch's skeleton.
+			void add(const boost::shared_ptr<Animator>& spAnimator, const boost::shared_ptr<graphics::Spatial>& spSpatial);
+			//! Remove the instance animated by spAnimator.
+			void remove(const boost::shared_ptr<Animator>& spAnimator);
+			//! Get the number of instances.
+			unsigned int getNumInstances() const { return m_aInstances.size(); }
+
+			//! Set how far, in model space, animation can move vertices out of the geometry bounds. Used for culling.
+			void setBoundsMargin(float fMargin) { m_fBoundsMargin = fMargin; }
+			//! Getter for setBoundsMargin().
+			float getBoundsMargin() const { return m_fBoundsMargin; }
+
+			//! Upload the palettes of the instances in the frustum and draw them. Call from the GL thread.
+			void render(const graphics::Frustum& frustum);
+
+			//! Get the number of instances drawn by the last render().
+			unsigned int getNumVisible() const { return m_uNumVisible; }
+			//! Get the number of draws made by the last render().
+			unsigned int getNumDraws() const { return m_uNumDraws; }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			SkinnedInstances(const boost::shared_ptr<graphics::Renderer>& spRenderer,
+							 const boost::shared_ptr<graphics::Geometry>& spGeometry,
+							 const boost::shared_ptr<graphics::Material>& spMaterial,
+							 const boost::shared_ptr<Skeleton>& spSkeleton);
+
+		private:
+			//! One animated copy of the mesh.
+			struct Instance
+			{
+				boost::shared_ptr<Animator> spAnimator;			//!< Animates the instance.
+				boost::shared_ptr<graphics::Spatial> spSpatial;	//!< Places the instance in the world.
+			};
+
+			//! Get the number of instances drawn at a time.
+			unsigned int getInstancesPerDraw() const;
+
+			boost::shared_ptr<graphics::Renderer> m_spRenderer;							//!< Creates the palette buffers.
+			boost::shared_ptr<graphics::Geometry> m_spGeometry;							//!< Skinned mesh.
+			boost::shared_ptr<graphics::Material> m_spMaterial;							//!< Material with a skinned instancing shader.
+			boost::shared_ptr<Skeleton> m_spSkeleton;									//!< Skeleton of every instance.
+			std::vector<Instance> m_aInstances;											//!< Instances.
+			float m_fBoundsMargin;														//!< Growth of the geometry bounds for culling.
+			std::vector<Transform> m_aStaging;											//!< World space palettes of the visible instances.
+			std::vector<boost::shared_ptr<graphics::Buffer>> m_aspPalettes;				//!< Palettes of each draw.
+			std::vector<boost::shared_ptr<graphics::Texture>> m_aspPaletteTextures;		//!< Buffer textures reading m_aspPalettes.
+			unsigned int m_uNumVisible;													//!< Instances drawn by the last render().
+			unsigned int m_uNumDraws;													//!< Draws made by the last render().
+
+		};
+	}
+}
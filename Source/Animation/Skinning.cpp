@@ -0,0 +1,74 @@
+#include "Skinning.h"
+
+#include <Animation/Skeleton.h>
+#include <Graphics/VertexList.h>
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+namespace baselib { namespace animation {
+
+	SkinInfluences packInfluences(const unsigned int* puJoints, const float* pfWeights, unsigned int uCount)
+	{
+		// Pick the largest weights, sorted by insertion as there are at most a handful
+		unsigned int auJoints[MAX_INFLUENCES] = { 0 };
+		float afWeights[MAX_INFLUENCES] = { 0.0f };
+		for (unsigned int i = 0; i < uCount; ++i)
+		{
+			assert(puJoints[i] < Skeleton::MAX_JOINTS);
+			if (pfWeights[i] <= afWeights[MAX_INFLUENCES - 1])
+				continue;
+
+			unsigned int j = MAX_INFLUENCES - 1;
+			for (; j > 0 && pfWeights[i] > afWeights[j - 1]; --j)
+			{
+				auJoints[j] = auJoints[j - 1];
+				afWeights[j] = afWeights[j - 1];
+			}
+			auJoints[j] = puJoints[i];
+			afWeights[j] = pfWeights[i];
+		}
+
+		SkinInfluences influences;
+		float fSum = afWeights[0] + afWeights[1] + afWeights[2] + afWeights[3];
+		if (fSum <= 0.0f)
+		{
+			memset(&influences, 0, sizeof(influences));
+			influences.aucWeights[0] = 255;
+			return influences;
+		}
+
+		// Round down, then give the bytes still missing from 255 to the weights that lost the most
+		float afRemainders[MAX_INFLUENCES];
+		unsigned int uTotal = 0;
+		for (unsigned int i = 0; i < MAX_INFLUENCES; ++i)
+		{
+			float fScaled = afWeights[i] / fSum * 255.0f;
+			unsigned int uWeight = std::min(static_cast<unsigned int>(fScaled), 255u);
+			afRemainders[i] = fScaled - uWeight;
+			influences.aucJoints[i] = static_cast<unsigned char>(auJoints[i]);
+			influences.aucWeights[i] = static_cast<unsigned char>(uWeight);
+			uTotal += uWeight;
+		}
+		for (; uTotal < 255; ++uTotal)
+		{
+			unsigned int uLargest = 0;
+			for (unsigned int i = 1; i < MAX_INFLUENCES; ++i)
+			{
+				if (afRemainders[i] > afRemainders[uLargest])
+					uLargest = i;
+			}
+			++influences.aucWeights[uLargest];
+			afRemainders[uLargest] -= 1.0f;
+		}
+		return influences;
+	}
+
+	void addSkinAttributes(const boost::shared_ptr<graphics::VertexLayout>& spVertexLayout, int iJointsIndex, int iWeightsIndex, int iOffset)
+	{
+		using namespace graphics;
+		spVertexLayout->add(VertexAttribute("joints", iJointsIndex, MAX_INFLUENCES, TYPE_UNSIGNED_BYTE, iOffset));
+		spVertexLayout->add(VertexAttribute("weights", iWeightsIndex, MAX_INFLUENCES, TYPE_UNSIGNED_BYTE, iOffset + MAX_INFLUENCES, true));
+	}
+
+} }
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		class VertexLayout;
+	}
+}
+
+namespace baselib
+{
+	namespace animation
+	{
+		//! Most joints influencing one skinned vertex.
+		const unsigned int MAX_INFLUENCES = 4;
+
+		/*! @brief Joints influencing a skinned vertex and their weights, packed into 8 bytes of the vertex.
+		 *
+		 *  Joint indices are bytes, which covers Skeleton::MAX_JOINTS. Weights are bytes normalized to [0, 1] that add up to
+		 *  exactly 255, so the rigid parts of a mesh stay rigid. Unused influences have weight 0.
+		 */
+		struct SkinInfluences
+		{
+			unsigned char aucJoints[MAX_INFLUENCES];	//!< Joint indices, read by shaders as a uvec4.
+			unsigned char aucWeights[MAX_INFLUENCES];	//!< Weights, read by shaders as a normalized vec4.
+		};
+
+		/*! @brief Pack uCount joint influences of a vertex into SkinInfluences.
+		 *
+		 *  Keeps the MAX_INFLUENCES largest weights and rescales them to add up to one. A vertex without any weight
+		 *  follows joint 0.
+		 */
+		SkinInfluences packInfluences(const unsigned int* puJoints, const float* pfWeights, unsigned int uCount);
+
+		/*! @brief Add the attributes of SkinInfluences at iOffset in the vertex to a vertex layout.
+		 *
+		 *  "joints" is read by shaders as a uvec4 at index iJointsIndex, "weights" as a vec4 at index iWeightsIndex.
+		 */
+		void addSkinAttributes(const boost::shared_ptr<graphics::VertexLayout>& spVertexLayout, int iJointsIndex, int iWeightsIndex, int iOffset);
+	}
+}
@@ -5,6 +5,8 @@
 #include <Graphics/Renderer.h>
 #include <Graphics/ShaderObject.h>
 #include <Graphics/ShaderPipeline.h>
+#include <Graphics/ShaderPermutations.h>
+#include <Graphics/ShaderWatcher.h>
 #include <Graphics/Shader.h>
 #include <Graphics/StaticGeometry.h>
 #include <Graphics/VertexList.h>
@@ -17,19 +19,28 @@
 #include <Graphics/VisualCollector.h>
 #include <Graphics/FrameBuffer.h>
 #include <Graphics/RenderJob.h>
+#include <Graphics/Helpers/ParallelShaderCompile.h>
 
 #include <Font/FontLoader.h>
 #include <Font/Font.h>
+#include <Font/TextBatch.h>
+#include <Font/GlyphMeshCache.h>
+#include <Font/TextLayout.h>
+#include <Font/TextLayoutCache.h>
+
+#include <Animation/AnimationSystem.h>
 
 #include <Helpers/NullPtr.h>
 
 using namespace baselib::graphics;
 using namespace baselib::font;
+using namespace baselib::animation;
 
 namespace baselib {
 	
 	BaseApp::BaseApp(int iWidth, int iHeight, bool bFullscreen, int iMajorVersion, int iMinorVersion, const std::string& sWindowTitle)
 		: GLFWApp(iWidth, iHeight, bFullscreen, iMajorVersion, iMinorVersion, sWindowTitle)
+		, m_uFrameCount(0)
 	{
 		LOG_VERBOSE << "BaseApp constructor";
 		init();
@@ -43,13 +54,32 @@ namespace baselib {
 
 	void BaseApp::onUpdate(double dDeltaTime)
 	{
-		m_spRootNode->update(Mat4());
+		m_spShaderWatcher->update();
+		m_spAnimationSystem->update(static_cast<float>(dDeltaTime));
+		m_spRootNode->update(Transform());
 	}
 
 	void BaseApp::onRender()
 	{
 		assert(m_spRenderer);
+		m_spTextBatch->clear();
+		m_spTextBatch->addLayout(*m_spTextLayoutCache->get(m_spFont, "The quick brown fox jumps over the lazy dog", 400.0f, TextLayout::ALIGN_CENTER), Vec2(10.0f, 200.0f), Vec4(1.0f));
+		m_spTextBatch->addText(m_spFont, "Distance field text scales", Vec2(10.0f, 400.0f), Vec4(1.0f), 2.0f);
+		m_spTextBatch->addText(m_spUIFont, "Small LCD text at quarter pixel positions", Vec2(10.0f, 100.0f), Vec4(1.0f));
+		m_spTextBatch->addText(m_spHeadlineMeshes, "Outlines", Vec2(10.0f, 500.0f), Vec4(1.0f), 4.0f);
+
+		std::stringstream ss;
+		ss << "Frame " << ++m_uFrameCount;
+		m_spFrameCounter->setText(ss.str());
+		m_spTextBatch->addLayout(*m_spFrameCounter, Vec2(10.0f, 20.0f), Vec4(1.0f), 0.5f);
+
+		m_spFont->update();
+		m_spUIFont->update();
+		m_spHeadlineMeshes->update();
+		m_spAnimationSystem->upload();
 		m_spRenderJob->execute(m_spRootNode, m_spVisualCollector, m_spFrameBuffer, m_spCamera);
+		m_spTextBatch->render();
+		m_spTextLayoutCache->update();
 	}
 
 	// Test vertex
@@ -72,23 +102,34 @@ namespace baselib {
 		// Create test renderer
 		m_spRenderer = Renderer::create();
 
-		// Create shader objects
-		auto spVertexShader = ShaderObject::load("../Data/Shaders/test.vert");
-		auto spFragmentShader = ShaderObject::load("../Data/Shaders/test.frag");
+		// Create shader objects. Linked programs are cached so later runs skip the GLSL compiler,
+		// otherwise pipelines compile in the background and the test material appears once it's ready.
+		ShaderPipeline::setCacheDirectory("../Cache/Shaders");
+		setMaxShaderCompilerThreads(0xFFFFFFFF);
+		m_spShaderWatcher = ShaderWatcher::create("../Data/Shaders");
+		std::vector<fs::path> afsShaders;
+		afsShaders.push_back("../Data/Shaders/test.vert");
+		afsShaders.push_back("../Data/Shaders/test.frag");
 
-		std::vector<boost::shared_ptr<ShaderObject>> aspShaders;
-		aspShaders.push_back(spVertexShader);
-		aspShaders.push_back(spFragmentShader);
+		std::vector<std::string> aKeywords;
+		aKeywords.push_back("SINGLE_CHANNEL");
+		aKeywords.push_back("SKINNED");
+		aKeywords.push_back("SKINNED_INSTANCES");
 
-		m_spShaderPipeline = ShaderPipeline::create("TestPipeline", aspShaders);
-		auto spShader = m_spShaderPipeline->createInstance();
+		m_spShaderPermutations = ShaderPermutations::create("TestPipeline", afsShaders, aKeywords);
+		m_spShaderPermutations->precompile("../Data/Shaders/test.variants");
 
 		// Create test font
 		m_spFontLoader = FontLoader::create();
-		m_spFont = m_spFontLoader->loadFont("C:/Windows/Fonts/times.ttf", m_spRenderer, Vec2(512, 512));
-		std::string sString = "abdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ123456789,.!?;+-*";
-		for (unsigned int i = 0; i < sString.length(); ++i)
-			m_spFont->getGlyph(sString[i]);
+		m_spFontLoader->setCacheDirectory("../Cache/Fonts");
+		m_spFont = m_spFontLoader->loadFont("C:/Windows/Fonts/times.ttf", 48, Font::RENDER_SDF, Vec2(512, 512));
+		m_spFont->prewarm(0x20, 0x7E); // Printable ASCII, no-op if the font cache was loaded
+		m_spFont->saveCache();
+		m_spUIFont = m_spFontLoader->loadFont("C:/Windows/Fonts/segoeui.ttf", 13, Font::RENDER_LCD, Vec2(256, 256), 2, true);
+		m_spTextBatch = TextBatch::create(m_spRenderer);
+		m_spHeadlineMeshes = GlyphMeshCache::create(m_spRenderer, m_spFont);
+		m_spTextLayoutCache = TextLayoutCache::create();
+		m_spFrameCounter = TextLayout::create(m_spFont, 0.0f, TextLayout::ALIGN_LEFT);
 
 		// Create test VertexList
 		auto spVL = VertexLayout::create();
@@ -117,9 +158,9 @@ namespace baselib {
 		// Create test texture
 		auto spTexture = Texture::create(spImage);
 
-		// Create test material
-		//m_spMaterial = Material::create(spShader, spTexture, null_ptr);
-		m_spMaterial = Material::create(spShader, m_spFont->getAtlas(), null_ptr);
+		// Create test material. The font atlas only has a red channel.
+		//m_spMaterial = Material::create(m_spShaderPermutations, 0, spTexture, null_ptr);
+		m_spMaterial = Material::create(m_spShaderPermutations, m_spShaderPermutations->getFeatures("SINGLE_CHANNEL"), m_spFont->getAtlas(), null_ptr);
 
 		// Create test visual
 		auto spVisual = Visual::create(m_spStaticGeom, m_spMaterial);
@@ -143,6 +184,9 @@ namespace baselib {
 
 		// Create test render job
 		m_spRenderJob = RenderJob::create(m_spRenderer);
+
+		// Create animation system, skinned visuals register their animators with it
+		m_spAnimationSystem = AnimationSystem::create(m_spRenderer);
 	}
 
 	void BaseApp::destroy()
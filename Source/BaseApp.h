@@ -8,7 +8,8 @@ namespace baselib
 	namespace graphics
 	{
 		class Renderer;
-		class ShaderPipeline;
+		class ShaderPermutations;
+		class ShaderWatcher;
 		class StaticGeometry;
 		class Material;
 		class Node;
@@ -22,6 +23,15 @@ namespace baselib
 	{
 		class FontLoader;
 		class Font;
+		class TextBatch;
+		class GlyphMeshCache;
+		class TextLayout;
+		class TextLayoutCache;
+	}
+
+	namespace animation
+	{
+		class AnimationSystem;
 	}
 }
 
@@ -52,7 +62,8 @@ namespace baselib
 		virtual void onWindowResize(int iWidth, int iHeight);
 
 		boost::shared_ptr<graphics::Renderer> m_spRenderer; //!< Main renderer
-		boost::shared_ptr<graphics::ShaderPipeline> m_spShaderPipeline; //!< Test shader pipeline
+		boost::shared_ptr<graphics::ShaderPermutations> m_spShaderPermutations; //!< Test shader variants
+		boost::shared_ptr<graphics::ShaderWatcher> m_spShaderWatcher; //!< Reloads edited shaders
 		boost::shared_ptr<graphics::StaticGeometry> m_spStaticGeom; //!< Test geometry
 		boost::shared_ptr<graphics::Material> m_spMaterial; //!< Test material
 		boost::shared_ptr<graphics::Node> m_spRootNode; //!< Test node
@@ -60,8 +71,15 @@ namespace baselib
 		boost::shared_ptr<graphics::VisualCollector> m_spVisualCollector; //!< Test visual collector
 		boost::shared_ptr<graphics::FrameBuffer> m_spFrameBuffer; //!< Test frame buffer
 		boost::shared_ptr<graphics::RenderJob> m_spRenderJob; //!< Test render job
+		boost::shared_ptr<animation::AnimationSystem> m_spAnimationSystem; //!< Updates skinned visuals
 
 		boost::shared_ptr<font::FontLoader> m_spFontLoader; //!< Test font loader
 		boost::shared_ptr<font::Font> m_spFont; //!< Test font
+		boost::shared_ptr<font::Font> m_spUIFont; //!< Test LCD font with subpixel positioning
+		boost::shared_ptr<font::TextBatch> m_spTextBatch; //!< Test text batch
+		boost::shared_ptr<font::GlyphMeshCache> m_spHeadlineMeshes; //!< Test tessellated glyphs for very large text
+		boost::shared_ptr<font::TextLayoutCache> m_spTextLayoutCache; //!< Test text layout cache
+		boost::shared_ptr<font::TextLayout> m_spFrameCounter; //!< Test incrementally updated text
+		unsigned int m_uFrameCount; //!< Number of frames rendered
 	};
 }
\ No newline at end of file
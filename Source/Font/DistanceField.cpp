@@ -0,0 +1,125 @@
+#include "DistanceField.h"
+
+#include <Logging/Log.h>
+#include <algorithm>
+#include <math.h>
+
+namespace baselib { namespace font {
+
+	namespace
+	{
+		const float INF = 1e20f;
+
+		// Scratch buffers for the 1D transform, sized to the longest row or column.
+		struct Scratch
+		{
+			std::vector<float> aF;	//!< Input squared distances.
+			std::vector<float> aD;	//!< Output squared distances.
+			std::vector<int> aV;	//!< Locations of the parabolas in the lower envelope.
+			std::vector<float> aZ;	//!< Boundaries between the parabolas.
+
+			void resize(int n) 
+			{ 
+				aF.resize(n); 
+				aD.resize(n); 
+				aV.resize(n); 
+				aZ.resize(n + 1); 
+			}
+		};
+
+		// 1D squared distance transform of n samples starting at pGrid with the given stride.
+		void transform1D(float* pGrid, int iOffset, int iStride, int n, Scratch& s)
+		{
+			for (int q = 0; q < n; ++q)
+				s.aF[q] = pGrid[iOffset + q*iStride];
+
+			// Lower envelope of the parabolas rooted at each sample
+			int k = 0;
+			s.aV[0] = 0;
+			s.aZ[0] = -INF;
+			s.aZ[1] = INF;
+			for (int q = 1; q < n; ++q)
+			{
+				float fS = 0.0f;
+				do
+				{
+					int r = s.aV[k];
+					fS = ((s.aF[q] + q*q) - (s.aF[r] + r*r)) / (2.0f*(q - r));
+				} while (fS <= s.aZ[k] && --k >= 0);
+
+				++k;
+				s.aV[k] = q;
+				s.aZ[k] = fS;
+				s.aZ[k + 1] = INF;
+			}
+
+			k = 0;
+			for (int q = 0; q < n; ++q)
+			{
+				while (s.aZ[k + 1] < q)
+					++k;
+				int r = s.aV[k];
+				pGrid[iOffset + q*iStride] = s.aF[r] + (q - r)*(q - r);
+			}
+		}
+
+		// 2D squared distance transform, columns then rows.
+		void transform2D(std::vector<float>& aGrid, int iWidth, int iHeight, Scratch& s)
+		{
+			for (int x = 0; x < iWidth; ++x)
+				transform1D(&aGrid[0], x, iWidth, iHeight, s);
+			for (int y = 0; y < iHeight; ++y)
+				transform1D(&aGrid[0], y*iWidth, 1, iWidth, s);
+		}
+	}
+
+	void createDistanceField(const unsigned char* pBitmap, int iWidth, int iHeight, int iPitch, int iSpread, std::vector<unsigned char>& aDistanceField)
+	{
+		assert(iSpread > 0);
+
+		int iFieldWidth = iWidth + 2*iSpread;
+		int iFieldHeight = iHeight + 2*iSpread;
+		int iSize = iFieldWidth * iFieldHeight;
+
+		// Squared distance to the outline from outside (aOuter) and inside (aInner). 
+		// The border added around the bitmap is empty space.
+		std::vector<float> aOuter(iSize, INF);
+		std::vector<float> aInner(iSize, 0.0f);
+		for (int y = 0; y < iHeight; ++y)
+		{
+			for (int x = 0; x < iWidth; ++x)
+			{
+				float fCoverage = pBitmap[y*iPitch + x] / 255.0f;
+				int i = (y + iSpread)*iFieldWidth + x + iSpread;
+				if (fCoverage >= 1.0f)
+				{
+					aOuter[i] = 0.0f;
+					aInner[i] = INF;
+				}
+				else if (fCoverage > 0.0f)
+				{
+					// Partially covered pixels lie on the outline - estimate how far their centre is from it
+					float fOut = std::max(0.0f, 0.5f - fCoverage);
+					float fIn = std::max(0.0f, fCoverage - 0.5f);
+					aOuter[i] = fOut*fOut;
+					aInner[i] = fIn*fIn;
+				}
+			}
+		}
+
+		Scratch scratch;
+		scratch.resize(std::max(iFieldWidth, iFieldHeight));
+		transform2D(aOuter, iFieldWidth, iFieldHeight, scratch);
+		transform2D(aInner, iFieldWidth, iFieldHeight, scratch);
+
+		aDistanceField.resize(iSize);
+		for (int i = 0; i < iSize; ++i)
+		{
+			// Positive outside the glyph
+			float fDistance = sqrt(aOuter[i]) - sqrt(aInner[i]);
+			float fValue = 128.0f - fDistance*127.0f/iSpread;
+			aDistanceField[i] = (unsigned char)std::min(255.0f, std::max(0.0f, fValue + 0.5f));
+		}
+	}
+
+} }
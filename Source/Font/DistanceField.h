@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+namespace baselib
+{
+	namespace font
+	{
+		/*! @brief Convert an 8 bit coverage bitmap into a single channel signed distance field.
+		 *
+		 *  The field is iSpread pixels larger than the bitmap on every side so the outline can be moved
+		 *  outwards (outlines, glow) without clipping. Rows are stored top to bottom like the input.
+		 *  128 lies on the outline, larger values are inside the glyph and distances beyond iSpread
+		 *  pixels are clamped to 0 or 255.
+		 *
+		 *  Uses the exact linear time euclidean distance transform by Felzenszwalb and Huttenlocher.
+		 *  Anti-aliased edge pixels are seeded with a sub-pixel distance estimate from their coverage,
+		 *  which keeps the outline smooth without rasterizing at a higher resolution.
+		 */
+		void createDistanceField(const unsigned char* pBitmap, int iWidth, int iHeight, int iPitch, int iSpread, std::vector<unsigned char>& aDistanceField);
+	}
+}
@@ -1,43 +1,57 @@
 #include "Font.h"
 
 #include <Helpers/NullPtr.h>
-#include <Graphics/Renderer.h>
 #include <Graphics/Texture.h>
-#include <Graphics/Image.h>
-#include <Graphics/ShaderObject.h>
-#include <Graphics/ShaderPipeline.h>
-#include <Graphics/Shader.h>
-#include <Graphics/Helpers/TextureUpdateHelper.h>
 #include <Logging/Log.h>
 #include <Font/Glyph.h>
-#include <ft2build.h>
-#include FT_FREETYPE_H
+#include <Font/FontAtlas.h>
+#include <Helpers/Utf8.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/range/algorithm/for_each.hpp>
+#include <string.h>
+#include <algorithm>
 
 using namespace baselib::graphics;
 
 namespace baselib { namespace font {
 
-	Font::Font(FT_FaceRec_ *ftFace, const boost::shared_ptr<Renderer>& spRenderer, const Vec2& vAtlasSize)
-		: m_FTFace(ftFace)
-		, m_spRenderer(spRenderer)
-		, m_vNextGlyphBottomLeft(Vec2(0.0f, 0.0f))
-		, m_fMaxHeight(0.0f)
+	namespace
 	{
-		LOG_VERBOSE << "Font constructor";
-		init(vAtlasSize);
+		// Codepoint lookup table layout
+		const unsigned int MAX_CODEPOINT = 0x10FFFF;
+		const unsigned int LOOKUP_PAGE_BITS = 8;
+		const unsigned int LOOKUP_PAGE_SIZE = 1 << LOOKUP_PAGE_BITS;
+		const unsigned int LOOKUP_PAGE_MASK = LOOKUP_PAGE_SIZE - 1;
+		const unsigned int NUM_LOOKUP_PAGES = (MAX_CODEPOINT >> LOOKUP_PAGE_BITS) + 1;
+
+		// With subpixel positioning the bin is stored in the low bits of the lookup key, so the table is four times larger
+		const unsigned int SUBPIXEL_BIN_BITS = 2;
 
-		/*
-		// Kerning
-		bool bHasKerning = false;
-		if (FT_HAS_KERNING(m_FTFace))
-			bHasKerning = true;
+		// Enough for the variants of a few screens of small UI text
+		const unsigned int DEFAULT_MAX_SUBPIXEL_VARIANTS = 1024;
+
+		// Shared by every lookup page that doesn't contain a glyph. Never written to.
+		unsigned int g_aEmptyLookupPage[LOOKUP_PAGE_SIZE] = { 0 };
+	}
 
-		FT_Vector ftKerning;
-		unsigned int uIndexLeft = 0;
-		unsigned int uIndexRight = 1;
-		// When uIndexLeft is 0 then the kerning is always 0
-		FT_Get_Kerning(m_FTFace, uIndexLeft, uIndexRight, FT_KERNING_DEFAULT, &ftKerning);  // FT_KERNING_DEFAULT - kerning is in units of 1/64th of a pixel width
-		*/
+	Font::Font(const boost::shared_ptr<GlyphRasterizer>& spRasterizer, RenderMode eRenderMode, const Vec2& vAtlasSize, int iMaxAtlasPages)
+		: m_spRasterizer(spRasterizer)
+		, m_spAtlas(FontAtlas::create(int(vAtlasSize.x), int(vAtlasSize.y), iMaxAtlasPages, eRenderMode == RENDER_SDF, eRenderMode == RENDER_LCD ? 3 : 1))
+		, m_eRenderMode(eRenderMode)
+		, m_uFontHash(0)
+		, m_bCacheDirty(false)
+		, m_uSubpixelBits((spRasterizer->getFlags() & GlyphRasterizer::FLAG_SUBPIXEL_POSITIONING) ? SUBPIXEL_BIN_BITS : 0)
+		, m_uMaxSubpixelVariants(DEFAULT_MAX_SUBPIXEL_VARIANTS)
+		, m_uNumSubpixelVariants(0)
+		, m_apLookup(NUM_LOOKUP_PAGES << m_uSubpixelBits, g_aEmptyLookupPage)
+	{
+		LOG_VERBOSE << "Font constructor";
+		assert((1u << SUBPIXEL_BIN_BITS) == GlyphRasterizer::NUM_SUBPIXEL_BINS);
+		assert((eRenderMode == RENDER_LCD) == ((spRasterizer->getFlags() & GlyphRasterizer::FLAG_LCD) != 0));
+		m_spAtlas->setEvictionCallback(boost::bind(&Font::onAtlasPageEvicted, this, _1));
 	}
 
 	Font::~Font()
@@ -45,138 +59,513 @@ namespace baselib { namespace font {
 		LOG_VERBOSE << "Font destructor";
 	}
 
-	void Font::init(const Vec2& vAtlasSize)
+	boost::shared_ptr<Texture> Font::getAtlas(int iPage) const
 	{
-		auto spImage = Image::create(int(vAtlasSize.x), int(vAtlasSize.y), 8, 0);
-		m_spAtlas = Texture::create(spImage);
-		m_spTextureUpdateHelper = TextureUpdateHelper::create(m_spRenderer);
+		return m_spAtlas->getTexture(iPage);
+	}
 
-		std::vector<boost::shared_ptr<ShaderObject>> aShaderObjects;
-		aShaderObjects.push_back(ShaderObject::load("../Data/Shaders/TextureCopy.vert"));
-		aShaderObjects.push_back(ShaderObject::load("../Data/Shaders/TextureCopy.frag"));
-		m_spTextureCopyPipeline = ShaderPipeline::create("TextureCopy", aShaderObjects);
-		m_spTextureCopyShader = m_spTextureCopyPipeline->createInstance();
+	int Font::getNumAtlasPages() const
+	{
+		return m_spAtlas->getNumPages();
 	}
 
-	namespace
+	float Font::getKerning(unsigned int uLeftIndex, unsigned int uRightIndex) const
+	{
+		return m_spRasterizer->getKerning(uLeftIndex, uRightIndex);
+	}
+
+	bool Font::getOutline(unsigned int uCodepoint, float fTolerance, GlyphOutline& outline) const
+	{
+		if (uCodepoint > MAX_CODEPOINT)
+			uCodepoint = UTF8_REPLACEMENT_CHARACTER;
+		return m_spRasterizer->decompose(uCodepoint, fTolerance, outline);
+	}
+
+	float Font::getLineHeight() const
+	{
+		return m_spRasterizer->getLineHeight();
+	}
+
+	float Font::getAscender() const
 	{
-		// Render the bitmap for uChar and store in FT_Face slot i.e. bitmap data for uChar is rendered to m_FTFace->glyph->bitmap
-		void fillBitmap(FT_Face ftFace, unsigned char uChar)
+		return m_spRasterizer->getAscender();
+	}
+
+	int Font::getPixelSize() const
+	{
+		return m_spRasterizer->getPixelSize();
+	}
+
+	int Font::getSpread() const
+	{
+		return m_spRasterizer->getSpread();
+	}
+
+	void Font::setLookupSlot(unsigned int uKey, unsigned int uSlot) const
+	{
+		unsigned int uPage = uKey >> LOOKUP_PAGE_BITS;
+		if (m_apLookup[uPage] == g_aEmptyLookupPage)
 		{
-			FT_UInt uIndex = FT_Get_Char_Index(ftFace, uChar);
-			if (uIndex == 0)
+			if (uSlot == 0)
+				return;
+
+			boost::shared_array<unsigned int> aPage(new unsigned int[LOOKUP_PAGE_SIZE]);
+			std::fill(aPage.get(), aPage.get() + LOOKUP_PAGE_SIZE, 0);
+			m_aLookupPages.push_back(aPage);
+			m_apLookup[uPage] = aPage.get();
+		}
+		m_apLookup[uPage][uKey & LOOKUP_PAGE_MASK] = uSlot;
+	}
+
+	void Font::onAtlasPageEvicted(int iPage)
+	{
+		// Compact the glyph array, eviction is rare so the lookup entries of the moved glyphs are simply rewritten
+		unsigned int uKept = 0;
+		for (unsigned int i = 0; i < m_aGlyphs.size(); ++i)
+		{
+			const Glyph& glyph = m_aGlyphs[i];
+			if (glyph.getPage() == iPage)
 			{
-				LOG_ERROR << "Glyph not found for character: " << uChar;
-				assert(false);
+				setLookupSlot(getLookupKey(glyph.getCodepoint(), glyph.getSubpixelBin()), 0);
+				if (glyph.getSubpixelBin() != 0)
+					--m_uNumSubpixelVariants;
+				continue;
 			}
 
-			int iFlags = FT_LOAD_DEFAULT;
-			FT_Error ftError = FT_Load_Glyph(ftFace, uIndex, iFlags); // This loads the glyph into ftFace->glyph (i.e. only the last loaded glyph is stored)
-			if (ftError)
+			if (uKept != i)
+				m_aGlyphs[uKept] = glyph;
+			setLookupSlot(getLookupKey(m_aGlyphs[uKept].getCodepoint(), m_aGlyphs[uKept].getSubpixelBin()), uKept + 1);
+			++uKept;
+		}
+		m_aGlyphs.erase(m_aGlyphs.begin() + uKept, m_aGlyphs.end());
+		m_bCacheDirty = true;
+	}
+
+	void Font::update()
+	{
+		m_spAtlas->upload();
+	}
+
+	const Glyph& Font::getGlyph(unsigned int uCodepoint, unsigned int uSubpixelBin) const
+	{
+		assert(uSubpixelBin < GlyphRasterizer::NUM_SUBPIXEL_BINS && (uSubpixelBin == 0 || hasSubpixelPositioning()));
+		if (uCodepoint > MAX_CODEPOINT)
+			uCodepoint = UTF8_REPLACEMENT_CHARACTER;
+
+		unsigned int uKey = getLookupKey(uCodepoint, uSubpixelBin);
+		unsigned int uSlot = m_apLookup[uKey >> LOOKUP_PAGE_BITS][uKey & LOOKUP_PAGE_MASK];
+		if (uSlot != 0)
+		{
+			const Glyph& glyph = m_aGlyphs[uSlot - 1];
+			m_spAtlas->touch(glyph.getPage());
+			return glyph;
+		}
+
+		if (uSubpixelBin != 0 && m_uNumSubpixelVariants >= m_uMaxSubpixelVariants)
+			return getGlyph(uCodepoint, 0);
+
+		return createGlyph(uCodepoint, uSubpixelBin);
+	}
+
+	const Glyph& Font::createGlyph(unsigned int uCodepoint, unsigned int uSubpixelBin) const
+	{
+		LOG_VERBOSE << "Creating new glyph: U+" << std::hex << uCodepoint << std::dec << " bin " << uSubpixelBin;
+
+		if (!m_spRasterizer->rasterize(uCodepoint, m_Bitmap, uSubpixelBin))
+			assert(false);
+
+		const Glyph* pGlyph = addGlyph(m_Bitmap);
+		if (!pGlyph)
+		{
+			LOG_ERROR << "Font atlas is full";
+			assert(false);
+		}
+		return *pGlyph;
+	}
+
+	const Glyph* Font::addGlyph(const GlyphBitmap& bitmap) const
+	{
+		// Pack bitmap into the atlas
+		int iPage = 0;
+		Vec2 vUVMin(0.0f, 0.0f);
+		Vec2 vUVMax(0.0f, 0.0f);
+		const unsigned char* pData = bitmap.aData.empty() ? NULL : &bitmap.aData[0];
+		assert(bitmap.iBytesPerPixel == m_spAtlas->getBytesPerPixel());
+		if (!m_spAtlas->add(bitmap.iWidth, bitmap.iHeight, bitmap.iWidth * bitmap.iBytesPerPixel, pData, iPage, vUVMin, vUVMax))
+			return NULL;
+
+		// Add to glyph cache
+		m_aGlyphs.push_back(Glyph(bitmap.uCodepoint, bitmap.uIndex, bitmap.iWidth, bitmap.iHeight, bitmap.fAdvance, bitmap.iBearingX, bitmap.iBearingY, bitmap.uSubpixelBin, iPage, vUVMin, vUVMax));
+		setLookupSlot(getLookupKey(bitmap.uCodepoint, bitmap.uSubpixelBin), m_aGlyphs.size());
+		if (bitmap.uSubpixelBin != 0)
+			++m_uNumSubpixelVariants;
+		m_bCacheDirty = true;
+		return &m_aGlyphs.back();
+	}
+
+	void Font::prewarm(unsigned int uFirstCodepoint, unsigned int uLastCodepoint, unsigned int uMaxThreads)
+	{
+		std::vector<unsigned int> aCodepoints;
+		uLastCodepoint = std::min(uLastCodepoint, MAX_CODEPOINT);
+		for (unsigned int uCodepoint = uFirstCodepoint; uCodepoint <= uLastCodepoint; ++uCodepoint)
+			aCodepoints.push_back(uCodepoint);
+		prewarm(aCodepoints, uMaxThreads);
+	}
+
+	void Font::prewarm(const std::string& sCharacters, unsigned int uMaxThreads)
+	{
+		std::vector<unsigned int> aCodepoints;
+		for (unsigned int uPos = 0; uPos < sCharacters.length(); )
+			aCodepoints.push_back(decodeUtf8(sCharacters, uPos));
+		prewarm(aCodepoints, uMaxThreads);
+	}
+
+	namespace
+	{
+		// Below this many glyphs per thread the cost of creating a freetype library and face outweighs the parallelism
+		const unsigned int MIN_GLYPHS_PER_THREAD = 32;
+
+		// Rasterize every uStride'th codepoint starting at uFirst with a rasterizer owned by this thread
+		void rasterizeGlyphs(const GlyphRasterizer::FontData& spFontData, int iPixelSize, int iSpread, unsigned int uFlags, const std::vector<unsigned int>& aCodepoints, unsigned int uFirst, unsigned int uStride, std::vector<GlyphBitmap>& aBitmaps)
+		{
+			auto spRasterizer = GlyphRasterizer::create(spFontData, iPixelSize, iSpread, uFlags);
+			if (!spRasterizer)
+				return;
+
+			for (unsigned int i = uFirst; i < aCodepoints.size(); i += uStride)
 			{
-				LOG_ERROR << "Error loading Glyph with index: " << uIndex;
-				assert(false);
+				if (!spRasterizer->rasterize(aCodepoints[i], aBitmaps[i]))
+					aBitmaps[i].uCodepoint = ~0u;
 			}
+		}
+	}
+
+	void Font::prewarm(std::vector<unsigned int>& aCodepoints, unsigned int uMaxThreads)
+	{
+		// Skip cached glyphs and duplicates
+		std::sort(aCodepoints.begin(), aCodepoints.end());
+		aCodepoints.erase(std::unique(aCodepoints.begin(), aCodepoints.end()), aCodepoints.end());
+		aCodepoints.erase(std::remove_if(aCodepoints.begin(), aCodepoints.end(), [this](unsigned int uCodepoint) {
+			unsigned int uKey = getLookupKey(uCodepoint, 0);
+			return uCodepoint > MAX_CODEPOINT || m_apLookup[uKey >> LOOKUP_PAGE_BITS][uKey & LOOKUP_PAGE_MASK] != 0;
+		}), aCodepoints.end());
+
+		if (aCodepoints.empty())
+			return;
 
-			//FT_Glyph_Format ftGF = ftFace->glyph->format;
+		unsigned int uNumThreads = uMaxThreads > 0 ? uMaxThreads : std::max(1u, boost::thread::hardware_concurrency());
+		uNumThreads = std::max(1u, std::min(uNumThreads, (unsigned int)aCodepoints.size() / MIN_GLYPHS_PER_THREAD));
 
-			// Check FT_Render_Mode for available modes (anti-aliased, mono etc.)
-			ftError = FT_Render_Glyph(ftFace->glyph, FT_RENDER_MODE_NORMAL); // This renders the glyph into glyph->bitmap
-			if (ftError)
+		LOG_INFO << "Prewarming " << aCodepoints.size() << " glyphs on " << uNumThreads << " threads";
+
+		// Interleave the codepoints between threads so that each gets a similar mix of simple and complex glyphs.
+		// Every thread writes only its own elements of aBitmaps.
+		std::vector<GlyphBitmap> aBitmaps(aCodepoints.size());
+		int iPixelSize = m_spRasterizer->getPixelSize();
+		int iSpread = m_spRasterizer->getSpread();
+		unsigned int uFlags = m_spRasterizer->getFlags();
+		const GlyphRasterizer::FontData& spFontData = m_spRasterizer->getFontData();
+		if (uNumThreads == 1)
+		{
+			for (unsigned int i = 0; i < aCodepoints.size(); ++i)
 			{
-				LOG_ERROR << "Error rendering glyph bitmap";
-				assert(false);
+				if (!m_spRasterizer->rasterize(aCodepoints[i], aBitmaps[i]))
+					aBitmaps[i].uCodepoint = ~0u;
 			}
 		}
-
-		// Create a texture from a FT_Bitmap
-		boost::shared_ptr<Texture> createGlyphTexture(const FT_Bitmap& ftBitmap)
+		else
 		{
-			int iWidth = ftBitmap.width;
-			int iHeight = ftBitmap.rows;
-			unsigned char *pData = new unsigned char[iWidth * iHeight]; // 1 byte per pixel
+			boost::thread_group threads;
+			for (unsigned int uThread = 0; uThread < uNumThreads; ++uThread)
+				threads.create_thread(boost::bind(&rasterizeGlyphs, boost::cref(spFontData), iPixelSize, iSpread, uFlags, boost::cref(aCodepoints), uThread, uNumThreads, boost::ref(aBitmaps)));
+			threads.join_all();
+		}
+
+		// Tallest first packs the skyline more tightly
+		std::vector<unsigned int> aOrder(aBitmaps.size());
+		for (unsigned int i = 0; i < aOrder.size(); ++i)
+			aOrder[i] = i;
+		std::sort(aOrder.begin(), aOrder.end(), [&aBitmaps](unsigned int a, unsigned int b) {
+			return aBitmaps[a].iHeight > aBitmaps[b].iHeight;
+		});
 
-			for (int y = 0; y < iHeight; ++y)
+		for (unsigned int i = 0; i < aOrder.size(); ++i)
+		{
+			const GlyphBitmap& bitmap = aBitmaps[aOrder[i]];
+			if (bitmap.uCodepoint != aCodepoints[aOrder[i]])
 			{
-				for (int x = 0; x < iWidth; ++x)
-				{
-					pData[y*iWidth + x] = ftBitmap.buffer[(iHeight - y - 1)*iWidth + x];
-				}
+				LOG_ERROR << "Failed to rasterize glyph for codepoint: U+" << std::hex << aCodepoints[aOrder[i]] << std::dec;
+				continue;
 			}
 
-			auto spImage = Image::create(iWidth, iHeight, 8, pData);
-			return Texture::create(spImage);
+			if (!addGlyph(bitmap))
+			{
+				LOG_WARNING << "Font atlas is full, prewarmed " << i << " of " << aOrder.size() << " glyphs";
+				break;
+			}
 		}
+	}
+
+	namespace
+	{
+		// Cache file layout: CacheHeader, CacheGlyph[uNumGlyphs], then for each page CachePage, 
+		// SkylinePacker::Node[iNumNodes] and FontAtlas::getPageSize() bytes of pixels.
+		// Written and read with the same compiler so plain structs are fine. Bump the version when anything changes.
+		const char CACHE_MAGIC[4] = { 'G', 'L', 'Y', 'C' };
+		const unsigned int CACHE_VERSION = 2;
+
+		struct CacheHeader
+		{
+			char acMagic[4];
+			unsigned int uVersion;
+			unsigned __int64 uFontHash;
+			int iPixelSize;
+			int iRenderMode;
+			int iSpread;
+			unsigned int uRasterizerFlags;
+			int iPageWidth;
+			int iPageHeight;
+			int iNumPages;
+			unsigned int uNumGlyphs;
+		};
 
+		struct CacheGlyph
+		{
+			unsigned int uCodepoint;
+			unsigned int uIndex;
+			int iWidth;
+			int iHeight;
+			float fAdvance;
+			int iBearingX;
+			int iBearingY;
+			unsigned int uSubpixelBin;
+			int iPage;
+			float afUV[4];
+		};
+
+		struct CachePage
+		{
+			int iNumNodes;
+			int iUsedArea;
+		};
+
+		// Copy the next T out of the mapped file. Returns false if the file is too short.
+		template <class T>
+		bool readCache(const char*& p, const char* pEnd, T* pOut, size_t uCount = 1)
+		{
+			size_t uSize = sizeof(T) * uCount;
+			if (size_t(pEnd - p) < uSize)
+				return false;
+			memcpy(pOut, p, uSize);
+			p += uSize;
+			return true;
+		}
 	}
 
-	boost::shared_ptr<Glyph> Font::getGlyph(unsigned char uChar) const
+	bool Font::loadCache(const fs::path& fsPath, unsigned __int64 uFontHash)
 	{
-		auto iter = m_GlyphMap.find(uChar);
-		if (iter != m_GlyphMap.end())
+		m_fsCachePath = fsPath;
+		m_uFontHash = uFontHash;
+		m_bCacheDirty = true;
+
+		boost::system::error_code ec;
+		if (!fs::exists(fsPath, ec))
+			return false;
+
+		boost::iostreams::mapped_file_source file;
+		try
 		{
-			LOG_VERBOSE << "Returning cached glyph: " << uChar;
-			return iter->second;
+			file.open(fsPath.string());
+		}
+		catch (const std::exception& e)
+		{
+			LOG_WARNING << "Failed to map font cache " << fsPath << ": " << e.what();
+			return false;
 		}
 
-		LOG_VERBOSE << "Creating new glyph: " << uChar;
+		const char* p = file.data();
+		const char* pEnd = p + file.size();
 
-		// Render bitmap
-		fillBitmap(m_FTFace, uChar);
+		CacheHeader header;
+		if (!readCache(p, pEnd, &header) ||
+			memcmp(header.acMagic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+			header.uVersion != CACHE_VERSION ||
+			header.uFontHash != uFontHash ||
+			header.iPixelSize != getPixelSize() ||
+			header.iRenderMode != m_eRenderMode ||
+			header.iSpread != getSpread() ||
+			header.uRasterizerFlags != m_spRasterizer->getFlags() ||
+			header.iPageWidth != m_spAtlas->getPageWidth() ||
+			header.iPageHeight != m_spAtlas->getPageHeight() ||
+			header.iNumPages > m_spAtlas->getMaxPages())
+		{
+			LOG_INFO << "Font cache doesn't match, ignoring " << fsPath;
+			return false;
+		}
 
-		// Create texture from bitmap
-		FT_Bitmap& ftBitmap = m_FTFace->glyph->bitmap;
-		auto spGlyphTexture = createGlyphTexture(ftBitmap);
-		m_spTextTex = spGlyphTexture;
+		// Validate everything before touching the atlas or the glyph table, so a corrupt cache leaves the font as it was
+		if (header.iNumPages < 0 || header.uNumGlyphs > size_t(pEnd - p) / sizeof(CacheGlyph))
+		{
+			LOG_WARNING << "Font cache is truncated: " << fsPath;
+			return false;
+		}
 
-		// Render this texture into the atlas
-		Vec2 vUVMin(0.0f, 0.0f);
-		Vec2 vUVMax(1.0f, 1.0f);
-		if (!addToAtlas(m_vNextGlyphBottomLeft, m_fMaxHeight, vUVMin, vUVMax, spGlyphTexture, m_spAtlas))
+		std::vector<CacheGlyph> aCacheGlyphs(header.uNumGlyphs);
+		if (header.uNumGlyphs > 0)
+			readCache(p, pEnd, &aCacheGlyphs[0], aCacheGlyphs.size());
+
+		for (auto it = aCacheGlyphs.begin(); it != aCacheGlyphs.end(); ++it)
 		{
-			LOG_ERROR << "Font atlas is full";
-			assert(false);
+			if (it->uCodepoint > MAX_CODEPOINT ||
+				it->iPage < 0 || it->iPage >= header.iNumPages ||
+				it->uSubpixelBin >= GlyphRasterizer::NUM_SUBPIXEL_BINS ||
+				(it->uSubpixelBin != 0 && !hasSubpixelPositioning()))
+			{
+				LOG_WARNING << "Font cache has an invalid glyph: " << fsPath;
+				return false;
+			}
 		}
-		
-		// Create glyph
-		FT_Glyph_Metrics ftGM = m_FTFace->glyph->metrics;
-		// All metrics measured in 1/64th of a pixel i.e. iWidth * 64 = width in pixels - unless FT_LOAD_NO_SCALE is used (check freetype docs)
-		unsigned int uWidth = unsigned int(ftGM.width) * 64;
-		unsigned int uHeight = unsigned int(ftGM.height) * 64;
-		unsigned int uAdvance = unsigned int(ftGM.horiAdvance) * 64;
-		unsigned int uBearingX = unsigned int(ftGM.horiBearingX) * 64;
-		unsigned int uBearingY = unsigned int(ftGM.horiBearingY) * 64;
-		auto spGlyph = boost::shared_ptr<Glyph>(new Glyph(uChar, uWidth, uHeight, uAdvance, uBearingX, uBearingY, vUVMin, vUVMax));
 
-		// Add to glyph cache
-		m_GlyphMap[uChar] = spGlyph;
-		return spGlyph;
+		// Pages are restored straight from the mapped file once all of them are known to be valid
+		int iPageWidth = m_spAtlas->getPageWidth();
+		int iPageHeight = m_spAtlas->getPageHeight();
+		int iPageSize = m_spAtlas->getPageSize();
+		std::vector<CachePage> aPages(header.iNumPages);
+		std::vector<std::vector<SkylinePacker::Node>> aaNodes(header.iNumPages);
+		std::vector<const unsigned char*> apPixels(header.iNumPages);
+		for (int iPage = 0; iPage < header.iNumPages; ++iPage)
+		{
+			CachePage& page = aPages[iPage];
+			if (!readCache(p, pEnd, &page) || page.iNumNodes <= 0 || size_t(page.iNumNodes) > size_t(pEnd - p) / sizeof(SkylinePacker::Node))
+			{
+				LOG_WARNING << "Font cache is truncated: " << fsPath;
+				return false;
+			}
+
+			std::vector<SkylinePacker::Node>& aNodes = aaNodes[iPage];
+			aNodes.assign(page.iNumNodes, SkylinePacker::Node(0, 0, 0));
+			readCache(p, pEnd, &aNodes[0], aNodes.size());
+			if (pEnd - p < iPageSize)
+			{
+				LOG_WARNING << "Font cache is truncated: " << fsPath;
+				return false;
+			}
+
+			// The skyline must cover the page width without gaps and stay within its height
+			int iX = 0;
+			bool bValid = page.iUsedArea >= 0 && page.iUsedArea <= iPageWidth * iPageHeight;
+			for (auto it = aNodes.begin(); bValid && it != aNodes.end(); ++it)
+			{
+				bValid = it->iX == iX && it->iWidth > 0 && it->iWidth <= iPageWidth - iX && it->iY >= 0 && it->iY <= iPageHeight;
+				iX += it->iWidth;
+			}
+			if (!bValid || iX != iPageWidth)
+			{
+				LOG_WARNING << "Font cache has an invalid atlas page: " << fsPath;
+				return false;
+			}
+
+			apPixels[iPage] = reinterpret_cast<const unsigned char*>(p);
+			p += iPageSize;
+		}
+
+		for (int iPage = 0; iPage < header.iNumPages; ++iPage)
+			m_spAtlas->restorePage(iPage, apPixels[iPage], aaNodes[iPage], aPages[iPage].iUsedArea);
+
+		m_aGlyphs.clear();
+		m_aGlyphs.reserve(aCacheGlyphs.size());
+		m_uNumSubpixelVariants = 0;
+		boost::for_each(aCacheGlyphs, [this](const CacheGlyph& g) {
+			m_aGlyphs.push_back(Glyph(g.uCodepoint, g.uIndex, g.iWidth, g.iHeight, g.fAdvance, g.iBearingX, g.iBearingY, g.uSubpixelBin, g.iPage, Vec2(g.afUV[0], g.afUV[1]), Vec2(g.afUV[2], g.afUV[3])));
+			setLookupSlot(getLookupKey(g.uCodepoint, g.uSubpixelBin), m_aGlyphs.size());
+			if (g.uSubpixelBin != 0)
+				++m_uNumSubpixelVariants;
+		});
+
+		LOG_INFO << "Loaded " << m_aGlyphs.size() << " glyphs from font cache " << fsPath;
+		m_bCacheDirty = false;
+		return true;
 	}
 
-	bool Font::addToAtlas(Vec2& vNextGlyphBottomLeft, float& fMaxHeight, Vec2& vUVMin, Vec2& vUVMax, const boost::shared_ptr<Texture>& spTexture, const boost::shared_ptr<Texture>& spAtlas) const
+	bool Font::saveCache() const
 	{
-		// Check if glyph will fit horizontally
-		if (vNextGlyphBottomLeft.x + spTexture->getWidth() > spAtlas->getWidth())
-			vNextGlyphBottomLeft = Vec2(0.0f, fMaxHeight);
+		if (m_fsCachePath.empty() || !m_bCacheDirty)
+			return true;
 
-		// Check max height for this row of glyphs 
-		if (vNextGlyphBottomLeft.y + spTexture->getHeight() > fMaxHeight)
-			fMaxHeight = vNextGlyphBottomLeft.y + spTexture->getHeight();
+		boost::system::error_code ec;
+		fs::create_directories(m_fsCachePath.parent_path(), ec);
 
-		// Get UV coordinates of next open spot in the atlas
-		vUVMin = Vec2(vNextGlyphBottomLeft.x / spAtlas->getWidth(), vNextGlyphBottomLeft.y / spAtlas->getHeight());
-		vUVMax = Vec2((vNextGlyphBottomLeft.x + spTexture->getWidth()) / spAtlas->getWidth(), (vNextGlyphBottomLeft.y + spTexture->getHeight()) / spAtlas->getHeight());
+		// Write to a temporary file and rename it so that a crash never leaves a half written cache behind
+		fs::path fsTempPath = m_fsCachePath;
+		fsTempPath += ".tmp";
+		{
+			fs::ofstream file(fsTempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				LOG_WARNING << "Failed to write font cache " << fsTempPath;
+				return false;
+			}
 
-		// Set next horizontal available position
-		vNextGlyphBottomLeft.x += spTexture->getWidth();
+			CacheHeader header;
+			memcpy(header.acMagic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+			header.uVersion = CACHE_VERSION;
+			header.uFontHash = m_uFontHash;
+			header.iPixelSize = getPixelSize();
+			header.iRenderMode = m_eRenderMode;
+			header.iSpread = getSpread();
+			header.uRasterizerFlags = m_spRasterizer->getFlags();
+			header.iPageWidth = m_spAtlas->getPageWidth();
+			header.iPageHeight = m_spAtlas->getPageHeight();
+			header.iNumPages = m_spAtlas->getNumPages();
+			header.uNumGlyphs = m_aGlyphs.size();
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
-		// Check if glyph will fit in atlas
-		if (vUVMax.x > 1.0 || vUVMax.y > 1.0)
-			return false;
+			boost::for_each(m_aGlyphs, [&file](const Glyph& glyph) {
+				CacheGlyph g;
+				g.uCodepoint = glyph.getCodepoint();
+				g.uIndex = glyph.getIndex();
+				g.iWidth = glyph.getWidth();
+				g.iHeight = glyph.getHeight();
+				g.fAdvance = glyph.getAdvance();
+				g.iBearingX = glyph.getBearingX();
+				g.iBearingY = glyph.getBearingY();
+				g.uSubpixelBin = glyph.getSubpixelBin();
+				g.iPage = glyph.getPage();
+				g.afUV[0] = glyph.getUVMin().x;
+				g.afUV[1] = glyph.getUVMin().y;
+				g.afUV[2] = glyph.getUVMax().x;
+				g.afUV[3] = glyph.getUVMax().y;
+				file.write(reinterpret_cast<const char*>(&g), sizeof(g));
+			});
+
+			for (int iPage = 0; iPage < header.iNumPages; ++iPage)
+			{
+				const std::vector<SkylinePacker::Node>& aNodes = m_spAtlas->getPacker(iPage).getNodes();
+				CachePage page;
+				page.iNumNodes = aNodes.size();
+				page.iUsedArea = m_spAtlas->getPacker(iPage).getUsedArea();
+				file.write(reinterpret_cast<const char*>(&page), sizeof(page));
+				file.write(reinterpret_cast<const char*>(&aNodes[0]), sizeof(SkylinePacker::Node) * aNodes.size());
+				file.write(reinterpret_cast<const char*>(m_spAtlas->getPageData(iPage)), m_spAtlas->getPageSize());
+			}
 
-		// Render glyph into atlas
-		m_spTextureUpdateHelper->updateRegion(spTexture, vUVMin, vUVMax, spAtlas, m_spTextureCopyShader);
+			if (!file)
+			{
+				LOG_WARNING << "Failed to write font cache " << fsTempPath;
+				return false;
+			}
+		}
+
+		fs::rename(fsTempPath, m_fsCachePath, ec);
+		if (ec)
+		{
+			LOG_WARNING << "Failed to write font cache " << m_fsCachePath << ": " << ec.message();
+			fs::remove(fsTempPath, ec);
+			return false;
+		}
 
+		LOG_INFO << "Saved " << m_aGlyphs.size() << " glyphs to font cache " << m_fsCachePath;
+		m_bCacheDirty = false;
 		return true;
 	}
 
@@ -1,25 +1,26 @@
 #pragma once
 
 #include <Math/Math.h>
+#include <Font/Glyph.h>
+#include <Font/GlyphRasterizer.h>
 #include <boost/shared_ptr.hpp>
-#include <boost/unordered_map.hpp>
+#include <boost/shared_array.hpp>
+#include <boost/filesystem.hpp>
+#include <vector>
+#include <string>
 
-struct FT_FaceRec_;
+namespace fs = boost::filesystem;
 
 namespace baselib
 {
 	namespace font
 	{
-		class Glyph;
+		class FontAtlas;
 	}
 
 	namespace graphics
 	{
-		class Renderer;
-		class Shader;
-		class ShaderPipeline;
 		class Texture;
-		class TextureUpdateHelper;
 	}
 }
 
@@ -29,44 +30,141 @@ namespace baselib
 	{
 		/*! @brief Font encapsulates a font face i.e. contains information about every glyph/symbol/character in the font.
 		 *
-		 *  Font has an atlas texture which is updated on demand. When a new glyph is requested it is rendered into
-		 *  the font atlas and its texture coordinates are stored.
+		 *  Font has an atlas texture which is updated on demand. When a new glyph is requested its bitmap is packed
+		 *  into a CPU-side copy of the atlas and its texture coordinates are stored. Glyphs added during a frame are
+		 *  uploaded to the atlas texture in one go by update().
+		 *
+		 *  The atlas grows by a page at a time up to a page budget. After that the least recently used page
+		 *  is evicted and its glyphs are rasterized again when next requested.
+		 *
+		 *  Glyphs are stored by value in a contiguous array and found through a two level table indexed by
+		 *  codepoint (codepoint / 256 selects a page of 256 slots), so a cache hit is two loads with no hashing.
+		 *  Pages without any cached glyph share a single empty page. The reference returned by getGlyph() is
+		 *  only valid until the next glyph is created.
+		 *
+		 *  In RENDER_SDF mode each glyph is rasterized once at the loaded pixel size and stored as a signed
+		 *  distance field, so the same atlas can be drawn sharply at any scale with the TextSDF shader.
+		 *  Glyph bitmaps and bearings then include the distance field spread on every side. In RENDER_LCD mode the atlas
+		 *  is RGB and stores separate coverage for each LCD subpixel, drawn with the TextLCD shader.
+		 *
+		 *  Fonts loaded with subpixel positioning use fractional advances and kerning. A glyph can be cached in up to
+		 *  four variants, each rendered shifted right by a quarter pixel more, and the text batch picks the variant
+		 *  nearest to the pen position. Variants are keyed by (codepoint, bin) in the same lookup table. To stop rarely
+		 *  reused variants from filling the atlas the number of variants other than bin 0 is capped, past the cap
+		 *  getGlyph() returns the bin 0 glyph and text falls back to whole pixel positions.
+		 *
+		 *  prewarm() rasterizes many glyphs up front on worker threads, each with its own freetype library and face,
+		 *  and packs the results into the atlas on the calling thread.
+		 *
+		 *  If FontLoader has a cache directory the atlas pages and glyph metrics are restored from a cache file when the
+		 *  font is loaded. The file name and header contain a hash of the font file contents, the pixel size and the
+		 *  render mode so a stale cache is never used. saveCache() writes the file.
 		 */
 		class Font
 		{
 		public:
 			friend class FontLoader;
 
+			//! How glyphs are stored in the atlas.
+			enum RenderMode
+			{
+				RENDER_BITMAP,	//!< Anti-aliased coverage, only sharp at the loaded pixel size.
+				RENDER_SDF,		//!< Signed distance field, can be scaled freely.
+				RENDER_LCD		//!< RGB coverage for horizontal RGB LCD subpixels, only sharp at the loaded pixel size.
+			};
+
 			//! Destructor.
 			~Font();
 		
-			//! Get the glyph for a character.
-			boost::shared_ptr<Glyph> getGlyph(unsigned char uChar) const;
+			/*! @brief Get the glyph for a Unicode codepoint. Codepoints missing from the face get the face's .notdef glyph.
+			 *
+			 *  uSubpixelBin selects the variant rendered uSubpixelBin quarter pixels to the right, it must be 0 unless the
+			 *  font has subpixel positioning. If the variant cap is reached the returned glyph may be a different bin.
+			 */
+			const Glyph& getGlyph(unsigned int uCodepoint, unsigned int uSubpixelBin = 0) const;
+
+			/*! @brief Create the glyphs for a range of codepoints (inclusive) in parallel.
+			 *
+			 *  Glyphs are rasterized on up to uMaxThreads worker threads (0 uses one per hardware thread) and packed into
+			 *  the atlas on the calling thread, which must be the GL thread. Glyphs that are already cached are skipped.
+			 *  Only bin 0 glyphs are created. Call update() afterwards to upload the atlas.
+			 */
+			void prewarm(unsigned int uFirstCodepoint, unsigned int uLastCodepoint, unsigned int uMaxThreads = 0);
+			//! Create the glyphs for every character in a UTF-8 string in parallel. See prewarm() above.
+			void prewarm(const std::string& sCharacters, unsigned int uMaxThreads = 0);
 
-			//! Get the texture atlas.
-			boost::shared_ptr<graphics::Texture> getAtlas() const { return m_spAtlas; }
+			//! Get the flattened outline of a glyph in pixels at the loaded pixel size, see GlyphRasterizer::decompose(). Not cached.
+			bool getOutline(unsigned int uCodepoint, float fTolerance, GlyphOutline& outline) const;
+
+			//! Get the horizontal kerning adjustment between two freetype glyph indices in pixels.
+			float getKerning(unsigned int uLeftIndex, unsigned int uRightIndex) const;
+			//! Get the horizontal kerning adjustment between two glyphs in pixels.
+			float getKerning(const Glyph& left, const Glyph& right) const { return getKerning(left.getIndex(), right.getIndex()); }
+			//! Get the distance between two consecutive baselines in pixels.
+			float getLineHeight() const;
+			//! Get the distance from the baseline to the top of the tallest glyph in pixels.
+			float getAscender() const;
+
+			//! Get the render mode glyphs are created with.
+			RenderMode getRenderMode() const { return m_eRenderMode; }
+			//! Get the pixel size the font was loaded at.
+			int getPixelSize() const;
+			//! Get the distance in pixels covered by the distance field on each side of the outline. 0 in RENDER_BITMAP mode.
+			int getSpread() const;
+			//! Returns true if glyphs can be placed at quarter pixel positions.
+			bool hasSubpixelPositioning() const { return m_uSubpixelBits != 0; }
+
+			//! Set the maximum number of cached glyph variants in subpixel bins other than 0.
+			void setMaxSubpixelVariants(unsigned int uMaxVariants) { m_uMaxSubpixelVariants = uMaxVariants; }
+			//! Get the maximum number of cached glyph variants in subpixel bins other than 0.
+			unsigned int getMaxSubpixelVariants() const { return m_uMaxSubpixelVariants; }
+			//! Get the number of cached glyph variants in subpixel bins other than 0.
+			unsigned int getNumSubpixelVariants() const { return m_uNumSubpixelVariants; }
+
+			//! Get a texture atlas page.
+			boost::shared_ptr<graphics::Texture> getAtlas(int iPage = 0) const;
+			//! Get the number of texture atlas pages currently allocated.
+			int getNumAtlasPages() const;
+
+			//! Upload glyphs created since the last update to the atlas texture. Call once per frame before rendering text.
+			void update();
+
+			//! Write the atlas and glyphs to the cache file if they changed since the font was loaded. Returns false on failure.
+			bool saveCache() const;
 
 		protected:
 			//! Protected constructor - must be created by FontLoader.
-			Font(FT_FaceRec_ *ftFace, const boost::shared_ptr<graphics::Renderer>& spRenderer, const Vec2& vAtlasSize);
+			Font(const boost::shared_ptr<GlyphRasterizer>& spRasterizer, RenderMode eRenderMode, const Vec2& vAtlasSize, int iMaxAtlasPages);
 
 		private:
-			//! Initialize the Font and create texture atlas.
-			void init(const Vec2& vAtlasSize);
-			//! Add a texture to the atlas and calculate the UV coordinates
-			bool addToAtlas(Vec2& vNextGlyphBottomLeft, float& fMaxHeight, Vec2& vUVMin, Vec2& vUVMax, const boost::shared_ptr<graphics::Texture>& spTexture, const boost::shared_ptr<graphics::Texture>& spAtlas) const;
-
-			FT_FaceRec_ *m_FTFace;															  //!< Freetype face pointer.
-			boost::shared_ptr<graphics::Renderer> m_spRenderer;								  //!< Renderer used to render into font atlas.
-			boost::shared_ptr<graphics::TextureUpdateHelper> m_spTextureUpdateHelper;		  //!< Helper to render glyphs into atlas.
-			boost::shared_ptr<graphics::ShaderPipeline> m_spTextureCopyPipeline;			  //!< Shader pipeline used to copy glyp texture into atlas.
-			boost::shared_ptr<graphics::Shader> m_spTextureCopyShader;						  //!< Shader instance used to copy glyph texture into atlas.
-			boost::shared_ptr<graphics::Texture> m_spAtlas;									  //!< Texture atlas containing cached glyphs for this font.
-			mutable boost::unordered_map<unsigned char, boost::shared_ptr<Glyph>> m_GlyphMap; //!< Glyph cache.
-			mutable Vec2 m_vNextGlyphBottomLeft;											  //!< The next avaiable position in the texture atlas. The next requested glyph's bottom left corner will be placed here.
-			mutable float m_fMaxHeight;														  //!< The height at which to start the next row of glyphs in the atlas.
-
-			mutable boost::shared_ptr<graphics::Texture> m_spTextTex;
+			//! Rasterize a glyph, pack it into the atlas and add it to the cache.
+			const Glyph& createGlyph(unsigned int uCodepoint, unsigned int uSubpixelBin) const;
+			//! Pack a rasterized glyph into the atlas and add it to the cache. Returns null if the atlas is full.
+			const Glyph* addGlyph(const GlyphBitmap& bitmap) const;
+			//! Rasterize the codepoints that aren't cached yet in parallel and add them to the cache.
+			void prewarm(std::vector<unsigned int>& aCodepoints, unsigned int uMaxThreads);
+			//! Get the lookup table key of a glyph variant.
+			unsigned int getLookupKey(unsigned int uCodepoint, unsigned int uSubpixelBin) const { return (uCodepoint << m_uSubpixelBits) | uSubpixelBin; }
+			//! Set the lookup table entry for a key. uSlot is the glyph array index + 1, 0 removes the entry.
+			void setLookupSlot(unsigned int uKey, unsigned int uSlot) const;
+			//! Forget the glyphs stored on an atlas page that is being evicted.
+			void onAtlasPageEvicted(int iPage);
+			//! Set the cache file and restore the atlas and glyphs from it if it exists and matches. Returns true if the cache was used.
+			bool loadCache(const fs::path& fsPath, unsigned __int64 uFontHash);
+
+			boost::shared_ptr<GlyphRasterizer> m_spRasterizer;								  //!< Renders glyphs on the main thread and provides face metrics.
+			boost::shared_ptr<FontAtlas> m_spAtlas;											  //!< Atlas containing cached glyphs for this font.
+			RenderMode m_eRenderMode;														  //!< How glyphs are stored in the atlas.
+			mutable GlyphBitmap m_Bitmap;													  //!< Scratch bitmap for glyphs created on demand.
+			fs::path m_fsCachePath;														  //!< Cache file, empty if caching is disabled.
+			unsigned __int64 m_uFontHash;													  //!< Hash of the font file contents.
+			mutable bool m_bCacheDirty;														  //!< Glyphs were added or evicted since the cache was loaded or saved.
+			unsigned int m_uSubpixelBits;													  //!< Lookup key bits used by the subpixel bin, 0 without subpixel positioning.
+			unsigned int m_uMaxSubpixelVariants;											  //!< Cap on cached glyphs in bins other than 0.
+			mutable unsigned int m_uNumSubpixelVariants;									  //!< Cached glyphs in bins other than 0.
+			mutable std::vector<Glyph> m_aGlyphs;											  //!< Glyph cache.
+			mutable std::vector<unsigned int*> m_apLookup;									  //!< Lookup key / 256 to lookup page. Entries are glyph index + 1, 0 if not cached.
+			mutable std::vector<boost::shared_array<unsigned int>> m_aLookupPages;			  //!< Lookup pages that contain at least one glyph.
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "FontAtlas.h"
+
+#include <Logging/Log.h>
+#include <Graphics/Image.h>
+#include <Graphics/Texture.h>
+#include <boost/range/algorithm/for_each.hpp>
+#include <algorithm>
+#include <string.h>
+
+using namespace baselib::graphics;
+
+namespace baselib { namespace font {
+
+	namespace
+	{
+		// Empty texels left between glyphs so that filtering doesn't bleed neighbouring glyphs into each other.
+		const int GLYPH_PADDING = 1;
+	}
+
+	FontAtlas::Page::Page(int iWidth, int iHeight, bool bLinearFilter, int iBytesPerPixel)
+		: packer(iWidth, iHeight)
+		, uLastUsedFrame(0)
+	{
+		// Image takes ownership of the staging buffer
+		unsigned char* pData = new unsigned char[iWidth * iHeight * iBytesPerPixel];
+		memset(pData, 0, iWidth * iHeight * iBytesPerPixel);
+		spImage = Image::create(iWidth, iHeight, 8 * iBytesPerPixel, pData);
+		spTexture = Texture::create(spImage);
+		if (bLinearFilter)
+			spTexture->setFilter(Texture::FILTER_LINEAR);
+		clearDirty();
+	}
+
+	void FontAtlas::Page::markDirty(int iX, int iY, int iWidth, int iHeight)
+	{
+		if (iWidth <= 0 || iHeight <= 0)
+			return;
+
+		iDirtyMinX = std::min(iDirtyMinX, iX);
+		iDirtyMinY = std::min(iDirtyMinY, iY);
+		iDirtyMaxX = std::max(iDirtyMaxX, iX + iWidth);
+		iDirtyMaxY = std::max(iDirtyMaxY, iY + iHeight);
+	}
+
+	void FontAtlas::Page::clearDirty()
+	{
+		iDirtyMinX = spImage->getWidth();
+		iDirtyMinY = spImage->getHeight();
+		iDirtyMaxX = 0;
+		iDirtyMaxY = 0;
+	}
+
+	boost::shared_ptr<FontAtlas> FontAtlas::create(int iPageWidth, int iPageHeight, int iMaxPages, bool bLinearFilter, int iBytesPerPixel)
+	{
+		assert(iPageWidth > 0 && iPageHeight > 0 && iMaxPages > 0);
+		assert(iBytesPerPixel == 1 || iBytesPerPixel == 3);
+		return boost::shared_ptr<FontAtlas>(new FontAtlas(iPageWidth, iPageHeight, iMaxPages, bLinearFilter, iBytesPerPixel));
+	}
+
+	FontAtlas::FontAtlas(int iPageWidth, int iPageHeight, int iMaxPages, bool bLinearFilter, int iBytesPerPixel)
+		: m_iPageWidth(iPageWidth)
+		, m_iPageHeight(iPageHeight)
+		, m_iMaxPages(iMaxPages)
+		, m_bLinearFilter(bLinearFilter)
+		, m_iBytesPerPixel(iBytesPerPixel)
+		, m_uFrame(1)
+	{
+		LOG_VERBOSE << "FontAtlas constructor";
+		m_aPages.reserve(iMaxPages);
+		m_aPages.push_back(Page(iPageWidth, iPageHeight, bLinearFilter, iBytesPerPixel));
+	}
+
+	FontAtlas::~FontAtlas()
+	{
+		LOG_VERBOSE << "FontAtlas destructor";
+	}
+
+	bool FontAtlas::add(int iWidth, int iHeight, int iPitch, const unsigned char* pData, int& iPage, Vec2& vUVMin, Vec2& vUVMax)
+	{
+		int iPaddedWidth = iWidth + GLYPH_PADDING;
+		int iPaddedHeight = iHeight + GLYPH_PADDING;
+		int iX = 0;
+		int iY = 0;
+
+		if (!findSpace(iPaddedWidth, iPaddedHeight, iPage, iX, iY))
+		{
+			if (getNumPages() < m_iMaxPages)
+			{
+				LOG_INFO << "Adding font atlas page " << getNumPages();
+				m_aPages.push_back(Page(m_iPageWidth, m_iPageHeight, m_bLinearFilter, m_iBytesPerPixel));
+				iPage = getNumPages() - 1;
+			}
+			else
+			{
+				iPage = evict();
+				if (iPage < 0)
+					return false;
+			}
+
+			if (!m_aPages[iPage].packer.pack(iPaddedWidth, iPaddedHeight, iX, iY))
+				return false; // Bitmap is larger than a page
+		}
+
+		// Copy the bitmap into the staging image. Freetype rows are top-down, texture rows are bottom-up.
+		Page& page = m_aPages[iPage];
+		unsigned char* pAtlas = page.spImage->getData();
+		for (int y = 0; y < iHeight; ++y)
+			memcpy(pAtlas + ((iY + y)*m_iPageWidth + iX)*m_iBytesPerPixel, pData + (iHeight - y - 1)*iPitch, iWidth*m_iBytesPerPixel);
+
+		page.markDirty(iX, iY, iWidth, iHeight);
+		page.uLastUsedFrame = m_uFrame;
+
+		vUVMin = Vec2(float(iX) / m_iPageWidth, float(iY) / m_iPageHeight);
+		vUVMax = Vec2(float(iX + iWidth) / m_iPageWidth, float(iY + iHeight) / m_iPageHeight);
+		return true;
+	}
+
+	bool FontAtlas::findSpace(int iWidth, int iHeight, int& iPage, int& iX, int& iY)
+	{
+		// Prefer the most recently added pages, older ones are likely to be full
+		for (int i = getNumPages() - 1; i >= 0; --i)
+		{
+			if (m_aPages[i].packer.pack(iWidth, iHeight, iX, iY))
+			{
+				iPage = i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	int FontAtlas::evict()
+	{
+		int iOldest = -1;
+		for (int i = 0; i < getNumPages(); ++i)
+		{
+			if (m_aPages[i].uLastUsedFrame == m_uFrame)
+				continue;
+			if (iOldest < 0 || m_aPages[i].uLastUsedFrame < m_aPages[iOldest].uLastUsedFrame)
+				iOldest = i;
+		}
+
+		if (iOldest < 0)
+		{
+			LOG_WARNING << "All font atlas pages are in use this frame, can't evict";
+			return -1;
+		}
+
+		LOG_INFO << "Evicting font atlas page " << iOldest;
+		if (m_EvictionCallback)
+			m_EvictionCallback(iOldest);
+
+		// Clear the whole page so that stale texels don't show up in the padding around new glyphs
+		Page& page = m_aPages[iOldest];
+		page.packer.reset();
+		memset(page.spImage->getData(), 0, getPageSize());
+		page.markDirty(0, 0, m_iPageWidth, m_iPageHeight);
+		return iOldest;
+	}
+
+	bool FontAtlas::restorePage(int iPage, const unsigned char* pPixels, const std::vector<SkylinePacker::Node>& aNodes, int iUsedArea)
+	{
+		assert(pPixels);
+		if (iPage < 0 || iPage >= m_iMaxPages)
+			return false;
+
+		while (getNumPages() <= iPage)
+			m_aPages.push_back(Page(m_iPageWidth, m_iPageHeight, m_bLinearFilter, m_iBytesPerPixel));
+
+		Page& page = m_aPages[iPage];
+		page.packer.restore(aNodes, iUsedArea);
+		memcpy(page.spImage->getData(), pPixels, getPageSize());
+		page.markDirty(0, 0, m_iPageWidth, m_iPageHeight);
+		page.uLastUsedFrame = m_uFrame;
+		return true;
+	}
+
+	const unsigned char* FontAtlas::getPageData(int iPage) const
+	{
+		return m_aPages[iPage].spImage->getData();
+	}
+
+	void FontAtlas::upload()
+	{
+		boost::for_each(m_aPages, [this](Page& page) {
+			if (!page.isDirty())
+				return;
+
+			const unsigned char* pFirstPixel = page.spImage->getData() + (page.iDirtyMinY*m_iPageWidth + page.iDirtyMinX)*m_iBytesPerPixel;
+			page.spTexture->updateRegion(page.iDirtyMinX, page.iDirtyMinY, page.iDirtyMaxX - page.iDirtyMinX, page.iDirtyMaxY - page.iDirtyMinY, m_iPageWidth, pFirstPixel);
+			page.clearDirty();
+		});
+
+		++m_uFrame;
+	}
+
+} }
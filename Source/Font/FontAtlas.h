@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <Font/SkylinePacker.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <vector>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		class Image;
+		class Texture;
+	}
+}
+
+namespace baselib
+{
+	namespace font
+	{
+		/*! @brief A glyph atlas that is packed on the CPU and uploaded to the GPU in bulk.
+		 *
+		 *  Glyph bitmaps are copied into a CPU-side staging image and the region they cover is
+		 *  accumulated into a dirty rectangle. upload() sends each page's dirty rectangle to its
+		 *  texture with a single glTexSubImage2D, so adding glyphs never creates GL objects
+		 *  or touches render state.
+		 *
+		 *  The atlas is made up of pages that are added on demand, up to a budget. Once the budget is
+		 *  reached and a bitmap doesn't fit anywhere the least recently used page is cleared and reused.
+		 *  The eviction callback is called before this happens so that the owner can forget the glyphs
+		 *  stored on that page. Pages used during the current frame are never evicted.
+		 */
+		class FontAtlas
+		{
+		public:
+			//! Called with the page index when a page is about to be cleared.
+			typedef boost::function<void(int iPage)> EvictionCallback;
+
+			/*! @brief Creates an empty FontAtlas with pages of the given size.
+			 *
+			 *  Distance field atlases need bLinearFilter. iBytesPerPixel is 1 for single channel coverage or distance values
+			 *  and 3 for RGB LCD coverage.
+			 */
+			static boost::shared_ptr<FontAtlas> create(int iPageWidth, int iPageHeight, int iMaxPages, bool bLinearFilter = false, int iBytesPerPixel = 1);
+
+			//! Destructor.
+			~FontAtlas();
+
+			/*! @brief Pack a bitmap into the staging image and calculate its page and UV coordinates.
+			 *
+			 *  pData rows are stored top to bottom with iPitch bytes per row (i.e. freetype bitmap layout) and 
+			 *  getBytesPerPixel() bytes per pixel.
+			 *  Returns false if the bitmap can't be placed even after evicting a page.
+			 */
+			bool add(int iWidth, int iHeight, int iPitch, const unsigned char* pData, int& iPage, Vec2& vUVMin, Vec2& vUVMax);
+
+			//! Mark a page as used this frame.
+			void touch(int iPage) { m_aPages[iPage].uLastUsedFrame = m_uFrame; }
+
+			//! Upload the regions modified since the last upload to the page textures and start a new frame.
+			void upload();
+
+			/*! @brief Replace a page's contents with previously saved pixels and packer state.
+			 *
+			 *  Pages up to iPage are added if needed. pPixels must hold a full page. The whole page is uploaded
+			 *  by the next upload(). Returns false if iPage is outside the page budget.
+			 */
+			bool restorePage(int iPage, const unsigned char* pPixels, const std::vector<SkylinePacker::Node>& aNodes, int iUsedArea);
+			//! Get a page's staging pixels, rows stored bottom to top.
+			const unsigned char* getPageData(int iPage) const;
+			//! Get a page's packer.
+			const SkylinePacker& getPacker(int iPage) const { return m_aPages[iPage].packer; }
+
+			//! Set the function called when a page is evicted.
+			void setEvictionCallback(const EvictionCallback& f) { m_EvictionCallback = f; }
+
+			//! Get a page texture.
+			boost::shared_ptr<graphics::Texture> getTexture(int iPage) const { return m_aPages[iPage].spTexture; }
+			//! Get the number of pages currently allocated.
+			int getNumPages() const { return int(m_aPages.size()); }
+			//! Get the maximum number of pages.
+			int getMaxPages() const { return m_iMaxPages; }
+			//! Get page width.
+			int getPageWidth() const { return m_iPageWidth; }
+			//! Get page height.
+			int getPageHeight() const { return m_iPageHeight; }
+			//! Get the number of bytes per pixel.
+			int getBytesPerPixel() const { return m_iBytesPerPixel; }
+			//! Get the size of a page's pixels in bytes.
+			int getPageSize() const { return m_iPageWidth * m_iPageHeight * m_iBytesPerPixel; }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			FontAtlas(int iPageWidth, int iPageHeight, int iMaxPages, bool bLinearFilter, int iBytesPerPixel);
+
+		private:
+			//! A single atlas texture with its staging image and packer.
+			struct Page
+			{
+				Page(int iWidth, int iHeight, bool bLinearFilter, int iBytesPerPixel);
+
+				//! Grow the dirty rectangle to include the given region.
+				void markDirty(int iX, int iY, int iWidth, int iHeight);
+				//! Reset the dirty rectangle.
+				void clearDirty();
+				//! Returns true if the page was modified since the last upload.
+				bool isDirty() const { return iDirtyMaxX > iDirtyMinX; }
+
+				SkylinePacker packer;							//!< Allocates space on the page.
+				boost::shared_ptr<graphics::Image> spImage;		//!< CPU-side staging copy of the page.
+				boost::shared_ptr<graphics::Texture> spTexture;	//!< Page texture.
+				unsigned int uLastUsedFrame;					//!< Last frame a glyph on this page was used.
+				int iDirtyMinX;									//!< Dirty rectangle left edge (inclusive).
+				int iDirtyMinY;									//!< Dirty rectangle bottom edge (inclusive).
+				int iDirtyMaxX;									//!< Dirty rectangle right edge (exclusive).
+				int iDirtyMaxY;									//!< Dirty rectangle top edge (exclusive).
+			};
+
+			//! Try to place a rectangle on an existing page.
+			bool findSpace(int iWidth, int iHeight, int& iPage, int& iX, int& iY);
+			//! Clear the least recently used page. Returns -1 if every page is in use this frame.
+			int evict();
+
+			int m_iPageWidth;					//!< Page width in pixels.
+			int m_iPageHeight;					//!< Page height in pixels.
+			int m_iMaxPages;					//!< Page budget.
+			bool m_bLinearFilter;				//!< Page textures use linear filtering.
+			int m_iBytesPerPixel;				//!< Bytes per pixel, 1 or 3.
+			unsigned int m_uFrame;				//!< Frame counter, advanced by upload().
+			std::vector<Page> m_aPages;			//!< Allocated pages.
+			EvictionCallback m_EvictionCallback; //!< Called when a page is evicted.
+		};
+	}
+}
@@ -3,14 +3,19 @@
 #include <Helpers/NullPtr.h>
 #include <Logging/Log.h>
 #include <Font/Font.h>
-#include <ft2build.h>
-#include FT_FREETYPE_H
+#include <Font/GlyphRasterizer.h>
+#include <Helpers/Hash.h>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <sstream>
 
 namespace baselib { namespace font {
 
 	namespace
 	{
-		FT_Library g_FTLib;
+		// Distance field spread as a fraction of the pixel size. Large enough for a thin outline effect.
+		const int SDF_SPREAD_DIVISOR = 8;
+		const int SDF_MIN_SPREAD = 2;
 	}
 
 	boost::shared_ptr<FontLoader> FontLoader::create()
@@ -21,64 +26,69 @@ namespace baselib { namespace font {
 	FontLoader::FontLoader()
 	{
 		LOG_VERBOSE << "FontLoader constructor";
-		init();
 	}
 
 	FontLoader::~FontLoader()
 	{
 		LOG_VERBOSE << "FontLoader destructor";
-		destroy();
 	}
 
-	void FontLoader::init()
+	boost::shared_ptr<Font> FontLoader::loadFont(const fs::path& fsPath, int iPixelSize, Font::RenderMode eRenderMode, const Vec2& vAtlasSize, int iMaxAtlasPages, bool bSubpixelPositioning)
 	{
-		FT_Error ftError = FT_Init_FreeType(&g_FTLib);
-		if (ftError)
-		{
-			LOG_ERROR << "Failed to initialize freetype";
-			assert(false);
-		}
-	}
-
-	void FontLoader::destroy()
-	{
-		// TODO: Destroy freetype lib
-	}
+		assert(iPixelSize > 0);
 
-	boost::shared_ptr<Font> FontLoader::loadFont(const fs::path& fsPath, const boost::shared_ptr<graphics::Renderer>& spRenderer, const Vec2& vAtlasSize)
-	{
 		// Check if font file exists
 		if (!fs::exists(fsPath))
 		{
 			LOG_ERROR << "Cannot find font file: " << fsPath;
 			assert(false);
+			return null_ptr;
 		}
-		std::string sCanonicalPath = fs::canonical(fsPath).string();
 
-		// Load font from file
-		FT_Face ftFace;
-		FT_Error ftError = FT_New_Face(g_FTLib, sCanonicalPath.c_str(), 0, &ftFace);
-		if (ftError == FT_Err_Unknown_File_Format)
+		// Read the whole file, freetype faces for every thread are created from this copy
+		fs::ifstream file(fsPath, std::ios::in | std::ios::binary);
+		auto spFontData = boost::shared_ptr<std::vector<unsigned char>>(new std::vector<unsigned char>((size_t)fs::file_size(fsPath)));
+		if (spFontData->empty() || !file.read(reinterpret_cast<char*>(&(*spFontData)[0]), spFontData->size()))
 		{
-			LOG_ERROR << "Unknown font file format: " << fsPath;
+			LOG_ERROR << "Failed to read font file: " << fsPath;
 			assert(false);
+			return null_ptr;
 		}
-		else if (ftError)
+
+		int iSpread = eRenderMode == Font::RENDER_SDF ? std::max(SDF_MIN_SPREAD, iPixelSize / SDF_SPREAD_DIVISOR) : 0;
+		unsigned int uFlags = 0;
+		if (bSubpixelPositioning && eRenderMode != Font::RENDER_SDF)
+			uFlags |= GlyphRasterizer::FLAG_SUBPIXEL_POSITIONING;
+		if (eRenderMode == Font::RENDER_LCD)
+			uFlags |= GlyphRasterizer::FLAG_LCD;
+
+		auto spRasterizer = GlyphRasterizer::create(spFontData, iPixelSize, iSpread, uFlags);
+		if (!spRasterizer)
 		{
 			LOG_ERROR << "Freetype failed to load font: " << fsPath;
 			assert(false);
+			return null_ptr;
 		}
 
-		// Check freetype tutorial on how to use other character maps
-		if (!ftFace->charmap)
+		auto spFont = boost::shared_ptr<Font>(new Font(spRasterizer, eRenderMode, vAtlasSize, iMaxAtlasPages));
+
+		// The cache is keyed by the file contents rather than its path so an updated font is never matched with an old atlas
+		if (!m_fsCacheDirectory.empty())
 		{
-			LOG_ERROR << "Font doesn't contain Unicode character map";
-			assert(false);
+			unsigned __int64 uFontHash = hashFNV1a(&(*spFontData)[0], spFontData->size());
+			std::stringstream ss;
+			ss << hashToString(uFontHash) << "_" << iPixelSize;
+			if (eRenderMode == Font::RENDER_SDF)
+				ss << "_sdf";
+			else if (eRenderMode == Font::RENDER_LCD)
+				ss << "_lcd";
+			if (uFlags & GlyphRasterizer::FLAG_SUBPIXEL_POSITIONING)
+				ss << "_subpixel";
+			ss << "_" << int(vAtlasSize.x) << "x" << int(vAtlasSize.y) << ".glyphcache";
+			spFont->loadCache(m_fsCacheDirectory / ss.str(), uFontHash);
 		}
 
-		FT_Set_Char_Size(ftFace, 50*64, 0, 100, 0);
-
-		return boost::shared_ptr<Font>(new Font(ftFace, spRenderer, vAtlasSize));
+		return spFont;
 	}
 
-} }
\ No newline at end of file
+} }
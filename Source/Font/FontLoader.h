@@ -3,6 +3,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/filesystem.hpp>
 #include <Math/Math.h>
+#include <Font/Font.h>
 
 namespace fs = boost::filesystem;
 
@@ -12,10 +13,6 @@ namespace baselib
 	{
 		class Font;
 	}
-	namespace graphics
-	{
-		class Renderer;
-	}
 }
 
 namespace baselib
@@ -24,6 +21,8 @@ namespace baselib
 	{
 		/*! @brief Loads and creates fonts from file.
 		 *
+		 *  Each font keeps the file contents in memory and owns its freetype objects, so fonts don't depend on 
+		 *  the loader and can outlive it.
 		 */
 		class FontLoader
 		{
@@ -34,19 +33,28 @@ namespace baselib
 			//! Destructor.
 			~FontLoader();
 		
-			//! Load and create a font.
-			boost::shared_ptr<Font> loadFont(const fs::path& fsPath, const boost::shared_ptr<graphics::Renderer>& spRenderer, const Vec2& vAtlasSize);
+			/*! @brief Load and create a font. 
+			 *
+			 *  Glyphs are rasterized at iPixelSize pixels per em. In RENDER_SDF mode this is the base size the distance 
+			 *  field is generated from and the font can be drawn at any size. The glyph atlas grows a page of vAtlasSize 
+			 *  at a time up to iMaxAtlasPages.
+			 *
+			 *  bSubpixelPositioning enables quarter pixel glyph placement for RENDER_BITMAP and RENDER_LCD fonts, see Font.
+			 *  Distance field fonts are positioned freely anyway and ignore it.
+			 */
+			boost::shared_ptr<Font> loadFont(const fs::path& fsPath, int iPixelSize, Font::RenderMode eRenderMode, const Vec2& vAtlasSize, int iMaxAtlasPages = 4, bool bSubpixelPositioning = false);
+
+			//! Set the directory glyph atlas caches are stored in. Fonts loaded afterwards restore their atlas from it. Empty disables caching.
+			void setCacheDirectory(const fs::path& fsDirectory) { m_fsCacheDirectory = fsDirectory; }
+			//! Get the glyph atlas cache directory.
+			const fs::path& getCacheDirectory() const { return m_fsCacheDirectory; }
 
 		protected:
 			//! Protected constructor - must be created by static create().
 			FontLoader();
 
 		private:
-			//! Initialize freetype library.
-			void init();
-			//! Destroy the freetype library.
-			void destroy();
-		
+			fs::path m_fsCacheDirectory; //!< Glyph atlas cache directory, empty if caching is disabled.
 		};
 	}
 }
\ No newline at end of file
@@ -1,27 +1,20 @@
 #include "Glyph.h"
 
-#include <Logging/Log.h>
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
 namespace baselib { namespace font {
 
-	Glyph::Glyph(unsigned char uChar, unsigned int uWidth, unsigned int uHeight, unsigned int uAdvance, unsigned int uBearingX, unsigned int uBearingY, const Vec2& vUVMin, const Vec2& vUVMax)
-		: m_uChar(uChar)
-		, m_uWidth(uWidth)
-		, m_uHeight(uHeight)
-		, m_uAdvance(uAdvance)
-		, m_uBearingX(uBearingX)
-		, m_uBearingY(uBearingY)
+	Glyph::Glyph(unsigned int uCodepoint, unsigned int uIndex, int iWidth, int iHeight, float fAdvance, int iBearingX, int iBearingY, unsigned int uSubpixelBin, int iPage, const Vec2& vUVMin, const Vec2& vUVMax)
+		: m_uCodepoint(uCodepoint)
+		, m_uIndex(uIndex)
+		, m_iWidth(iWidth)
+		, m_iHeight(iHeight)
+		, m_fAdvance(fAdvance)
+		, m_iBearingX(iBearingX)
+		, m_iBearingY(iBearingY)
+		, m_uSubpixelBin(uSubpixelBin)
+		, m_iPage(iPage)
 		, m_vUVMin(vUVMin)
 		, m_vUVMax(vUVMax)
 	{
-		LOG_VERBOSE << "Glyph constructor";
-	}
-
-	Glyph::~Glyph()
-	{
-		LOG_VERBOSE << "Glyph destructor";
 	}
 
 } }
\ No newline at end of file
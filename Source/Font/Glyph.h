@@ -8,26 +8,50 @@ namespace baselib
 	{
 		/*! @brief A Glyph represents a single character.
 		 *
+		 *  Glyphs are small value types that Font stores contiguously.
 		 */
 		class Glyph
 		{
 		public:
 			friend class Font;
 
-			//! Destructor.
-			~Glyph();
+			//! Get the Unicode codepoint represented by this glyph.
+			unsigned int getCodepoint() const { return m_uCodepoint; }
+			//! Get the freetype glyph index.
+			unsigned int getIndex() const { return m_uIndex; }
+			//! Get glyph bitmap width in pixels.
+			int getWidth() const { return m_iWidth; }
+			//! Get glyph bitmap height in pixels.
+			int getHeight() const { return m_iHeight; }
+			//! Get the distance to move the cursor after this glyph in pixels.
+			float getAdvance() const { return m_fAdvance; }
+			//! Get the horizontal bearing in pixels.
+			int getBearingX() const { return m_iBearingX; }
+			//! Get the vertical bearing in pixels.
+			int getBearingY() const { return m_iBearingY; }
+			//! Get the horizontal offset the glyph was rendered at in quarter pixels, see Font::getGlyph().
+			unsigned int getSubpixelBin() const { return m_uSubpixelBin; }
+			//! Get the font atlas page the glyph is stored on.
+			int getPage() const { return m_iPage; }
+			//! Get the glyph's bottom left UV coordinates in the font atlas page.
+			const Vec2& getUVMin() const { return m_vUVMin; }
+			//! Get the glyph's top right UV coordinates in the font atlas page.
+			const Vec2& getUVMax() const { return m_vUVMax; }
 		
 		protected:
 			//! Protected constructor - must be created by Font.
-			Glyph(unsigned char uChar, unsigned int uWidth, unsigned int uHeight, unsigned int uAdvance, unsigned int uBearingX, unsigned int uBearingY, const Vec2& vUVMin, const Vec2& vUVMax);
+			Glyph(unsigned int uCodepoint, unsigned int uIndex, int iWidth, int iHeight, float fAdvance, int iBearingX, int iBearingY, unsigned int uSubpixelBin, int iPage, const Vec2& vUVMin, const Vec2& vUVMax);
 		
 		private:
-			unsigned char m_uChar;	  //!< The character represented by this glyph.
-			unsigned int m_uWidth;    //!< Glyph bitmap width in pixels.
-			unsigned int m_uHeight;   //!< Glyph bitmap height in pixels.
-			unsigned int m_uAdvance;  //!< The width this character takes up on the baseline (in pixels) without kerning.
-			unsigned int m_uBearingX; //!< The horizontal bearing - distance from cursor to left border of glyph.
-			unsigned int m_uBearingY; //!< The vertical bearing - distance from baseline to top border of glyph.
+			unsigned int m_uCodepoint; //!< The Unicode codepoint represented by this glyph.
+			unsigned int m_uIndex;	  //!< The freetype glyph index, used for kerning lookups.
+			int m_iWidth;			  //!< Glyph bitmap width in pixels.
+			int m_iHeight;			  //!< Glyph bitmap height in pixels.
+			float m_fAdvance;		  //!< The width this character takes up on the baseline (in pixels) without kerning.
+			int m_iBearingX;		  //!< The horizontal bearing - distance from cursor to left border of glyph.
+			int m_iBearingY;		  //!< The vertical bearing - distance from baseline to top border of glyph.
+			unsigned int m_uSubpixelBin; //!< Horizontal offset the glyph was rendered at in quarter pixels.
+			int m_iPage;			  //!< The font atlas page the glyph is stored on.
 			Vec2 m_vUVMin;			  //!< The glyph's bottom left UV coordinates in the font atlas texture.
 			Vec2 m_vUVMax;			  //!< The glyph's top right UV coordinates in the font atlas texture.
 
@@ -0,0 +1,97 @@
+#include "GlyphMeshCache.h"
+
+#include <Logging/Log.h>
+#include <Font/Font.h>
+#include <Font/Tessellation.h>
+#include <Graphics/Renderer.h>
+#include <Graphics/DynamicGeometry.h>
+
+using namespace baselib::graphics;
+
+namespace baselib { namespace font {
+
+	namespace
+	{
+		// Largest distance between a flattened curve and the true curve in screen pixels at the maximum scale
+		const float OUTLINE_TOLERANCE = 0.2f;
+	}
+
+	boost::shared_ptr<GlyphMeshCache> GlyphMeshCache::create(const boost::shared_ptr<Renderer>& spRenderer, const boost::shared_ptr<Font>& spFont, float fMaxScale)
+	{
+		assert(spRenderer && spFont);
+		assert(fMaxScale > 0.0f);
+		return boost::shared_ptr<GlyphMeshCache>(new GlyphMeshCache(spRenderer, spFont, fMaxScale));
+	}
+
+	GlyphMeshCache::GlyphMeshCache(const boost::shared_ptr<Renderer>& spRenderer, const boost::shared_ptr<Font>& spFont, float fMaxScale)
+		: m_spFont(spFont)
+		, m_fMaxScale(fMaxScale)
+		, m_bDirty(false)
+	{
+		LOG_VERBOSE << "GlyphMeshCache constructor";
+
+		auto spVL = VertexLayout::create();
+		spVL->add(VertexAttribute("position", 0, 2, TYPE_FLOAT, 0));
+
+		m_spVertexList = boost::shared_ptr<VertexList<Vec2>>(new VertexList<Vec2>(spVL));
+		m_spGeometry = spRenderer->createDynamicGeometry(m_spVertexList, Geometry::TRIANGLES);
+	}
+
+	GlyphMeshCache::~GlyphMeshCache()
+	{
+		LOG_VERBOSE << "GlyphMeshCache destructor";
+	}
+
+	const GlyphMesh& GlyphMeshCache::getMesh(unsigned int uCodepoint)
+	{
+		auto it = m_Meshes.find(uCodepoint);
+		if (it != m_Meshes.end())
+			return it->second;
+
+		return createMesh(uCodepoint);
+	}
+
+	const GlyphMesh& GlyphMeshCache::createMesh(unsigned int uCodepoint)
+	{
+		LOG_VERBOSE << "Creating glyph mesh: U+" << std::hex << uCodepoint << std::dec;
+
+		GlyphMesh& mesh = m_Meshes[uCodepoint];
+		mesh.uCodepoint = uCodepoint;
+		mesh.uIndex = 0;
+		mesh.fAdvance = 0.0f;
+		mesh.uFirstIndex = m_spVertexList->getNumIndices();
+		mesh.uNumIndices = 0;
+
+		if (!m_spFont->getOutline(uCodepoint, OUTLINE_TOLERANCE / m_fMaxScale, m_Outline))
+			return mesh;
+
+		mesh.uIndex = m_Outline.uIndex;
+		mesh.fAdvance = m_Outline.fAdvance;
+
+		m_aTriangles.clear();
+		if (!tessellate(m_Outline.aPoints, m_Outline.aContourEnds, m_aTriangles))
+			LOG_WARNING << "Glyph outline for U+" << std::hex << uCodepoint << std::dec << " intersects itself, the mesh may have gaps";
+
+		// Triangles index the outline points directly, so the points are appended as they are
+		unsigned int uBase = m_spVertexList->getNumVertices();
+		std::vector<Vec2>& aVertices = m_spVertexList->modifyVertices();
+		std::vector<unsigned int>& aIndices = m_spVertexList->modifyIndices();
+		aVertices.insert(aVertices.end(), m_Outline.aPoints.begin(), m_Outline.aPoints.end());
+		for (unsigned int i = 0; i < m_aTriangles.size(); ++i)
+			aIndices.push_back(uBase + m_aTriangles[i]);
+
+		mesh.uNumIndices = m_aTriangles.size();
+		m_bDirty = true;
+		return mesh;
+	}
+
+	void GlyphMeshCache::update()
+	{
+		if (!m_bDirty)
+			return;
+
+		m_spGeometry->update();
+		m_bDirty = false;
+	}
+
+} }
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <Font/GlyphRasterizer.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <Graphics/VertexList.h>
+#include <vector>
+
+namespace baselib
+{
+	namespace font
+	{
+		class Font;
+	}
+
+	namespace graphics
+	{
+		class Renderer;
+		class DynamicGeometry;
+	}
+}
+
+namespace baselib
+{
+	namespace font
+	{
+		//! The triangles of one glyph in a GlyphMeshCache.
+		struct GlyphMesh
+		{
+			unsigned int uCodepoint;	//!< Unicode codepoint.
+			unsigned int uIndex;		//!< Freetype glyph index, used for kerning.
+			float fAdvance;				//!< Unhinted horizontal advance in pixels at the font's pixel size.
+			unsigned int uFirstIndex;	//!< First index of the glyph's triangles in the shared index buffer.
+			unsigned int uNumIndices;	//!< Number of indices, 0 for glyphs without an outline (e.g. space).
+		};
+
+		/*! @brief Caches glyphs as triangle meshes for text that is too large for the glyph atlas.
+		 *
+		 *  A glyph's outline is flattened with a tolerance that keeps curves smooth up to fMaxScale times the font's pixel
+		 *  size and tessellated into triangles, see tessellate(). The triangles of every glyph are appended to one shared
+		 *  vertex list so all outline text can be drawn from a single vertex array, with one indexed draw per glyph.
+		 *  Large text therefore costs vertices instead of atlas texels, and stays sharp at any scale.
+		 *
+		 *  Vertices are in pixels at the font's pixel size with the pen position at the origin. Edges are not
+		 *  anti-aliased, the frame buffer needs multisampling for smooth edges.
+		 *
+		 *  Meshes are never evicted, the cache is meant for the limited set of characters used by headlines. Meshes
+		 *  created since the last update() are uploaded by update(), call it once per frame before rendering.
+		 */
+		class GlyphMeshCache
+		{
+		public:
+			//! Creates an empty GlyphMeshCache for a font.
+			static boost::shared_ptr<GlyphMeshCache> create(const boost::shared_ptr<graphics::Renderer>& spRenderer, const boost::shared_ptr<Font>& spFont, float fMaxScale = 16.0f);
+
+			//! Destructor.
+			~GlyphMeshCache();
+
+			//! Get the mesh for a Unicode codepoint, tessellating it if it isn't cached. The reference stays valid.
+			const GlyphMesh& getMesh(unsigned int uCodepoint);
+
+			//! Upload the meshes created since the last update.
+			void update();
+
+			//! Get the font.
+			const boost::shared_ptr<Font>& getFont() const { return m_spFont; }
+			//! Get the geometry containing every cached mesh.
+			const boost::shared_ptr<graphics::DynamicGeometry>& getGeometry() const { return m_spGeometry; }
+			//! Get the largest scale curves stay smooth at.
+			float getMaxScale() const { return m_fMaxScale; }
+			//! Get the number of cached meshes.
+			unsigned int getNumMeshes() const { return m_Meshes.size(); }
+			//! Get the number of vertices of all cached meshes.
+			unsigned int getNumVertices() const { return m_spVertexList->getNumVertices(); }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			GlyphMeshCache(const boost::shared_ptr<graphics::Renderer>& spRenderer, const boost::shared_ptr<Font>& spFont, float fMaxScale);
+
+		private:
+			//! Tessellate a glyph and append it to the vertex list.
+			const GlyphMesh& createMesh(unsigned int uCodepoint);
+
+			boost::shared_ptr<Font> m_spFont;									//!< Font the outlines come from.
+			float m_fMaxScale;													//!< Largest scale curves stay smooth at.
+			boost::shared_ptr<graphics::VertexList<Vec2>> m_spVertexList;		//!< Vertices and indices of all meshes.
+			boost::shared_ptr<graphics::DynamicGeometry> m_spGeometry;			//!< Hardware buffers the vertex list is uploaded to.
+			boost::unordered_map<unsigned int, GlyphMesh> m_Meshes;			//!< Cached meshes by codepoint.
+			GlyphOutline m_Outline;												//!< Scratch outline.
+			std::vector<unsigned int> m_aTriangles;								//!< Scratch triangle indices.
+			bool m_bDirty;														//!< Meshes were added since the last update.
+		};
+	}
+}
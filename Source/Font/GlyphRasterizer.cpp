@@ -0,0 +1,344 @@
+#include "GlyphRasterizer.h"
+
+#include <Logging/Log.h>
+#include <Helpers/NullPtr.h>
+#include <Font/DistanceField.h>
+#include <string.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_LCD_FILTER_H
+#include FT_OUTLINE_H
+#include <algorithm>
+#include <math.h>
+
+namespace baselib { namespace font {
+
+	boost::shared_ptr<GlyphRasterizer> GlyphRasterizer::create(const FontData& spFontData, int iPixelSize, int iSpread, unsigned int uFlags)
+	{
+		assert(spFontData && !spFontData->empty());
+		assert(iPixelSize > 0 && iSpread >= 0);
+		assert(iSpread == 0 || (uFlags & FLAG_LCD) == 0);
+
+		boost::shared_ptr<GlyphRasterizer> spRasterizer(new GlyphRasterizer(spFontData, iPixelSize, iSpread, uFlags));
+		if (!spRasterizer->init())
+			return null_ptr;
+		return spRasterizer;
+	}
+
+	GlyphRasterizer::GlyphRasterizer(const FontData& spFontData, int iPixelSize, int iSpread, unsigned int uFlags)
+		: m_spFontData(spFontData)
+		, m_iPixelSize(iPixelSize)
+		, m_iSpread(iSpread)
+		, m_uFlags(uFlags)
+		, m_FTLib(NULL)
+		, m_FTFace(NULL)
+		, m_bHasKerning(false)
+	{
+		LOG_VERBOSE << "GlyphRasterizer constructor";
+	}
+
+	GlyphRasterizer::~GlyphRasterizer()
+	{
+		LOG_VERBOSE << "GlyphRasterizer destructor";
+		if (m_FTFace)
+			FT_Done_Face(m_FTFace);
+		if (m_FTLib)
+			FT_Done_FreeType(m_FTLib);
+	}
+
+	bool GlyphRasterizer::init()
+	{
+		FT_Error ftError = FT_Init_FreeType(&m_FTLib);
+		if (ftError)
+		{
+			LOG_ERROR << "Failed to initialize freetype";
+			m_FTLib = NULL;
+			return false;
+		}
+
+		ftError = FT_New_Memory_Face(m_FTLib, &(*m_spFontData)[0], FT_Long(m_spFontData->size()), 0, &m_FTFace);
+		if (ftError == FT_Err_Unknown_File_Format)
+		{
+			LOG_ERROR << "Unknown font file format";
+			m_FTFace = NULL;
+			return false;
+		}
+		else if (ftError)
+		{
+			LOG_ERROR << "Freetype failed to load font";
+			m_FTFace = NULL;
+			return false;
+		}
+
+		// Check freetype tutorial on how to use other character maps
+		if (!m_FTFace->charmap)
+		{
+			LOG_ERROR << "Font doesn't contain Unicode character map";
+			return false;
+		}
+
+		ftError = FT_Set_Pixel_Sizes(m_FTFace, 0, m_iPixelSize);
+		if (ftError)
+		{
+			LOG_ERROR << "Font doesn't support pixel size " << m_iPixelSize;
+			return false;
+		}
+
+		// Without the filter LCD glyphs show strong colour fringes. Freetype builds without subpixel rendering still
+		// produce usable LCD bitmaps, just unfiltered.
+		if (m_uFlags & FLAG_LCD)
+		{
+			ftError = FT_Library_SetLcdFilter(m_FTLib, FT_LCD_FILTER_DEFAULT);
+			if (ftError)
+				LOG_WARNING << "Freetype LCD filter not available, LCD glyphs will have colour fringes";
+		}
+
+		m_bHasKerning = FT_HAS_KERNING(m_FTFace) != 0;
+		return true;
+	}
+
+	bool GlyphRasterizer::rasterize(unsigned int uCodepoint, GlyphBitmap& bitmap, unsigned int uSubpixelBin)
+	{
+		assert(uSubpixelBin < NUM_SUBPIXEL_BINS);
+		assert(uSubpixelBin == 0 || (m_uFlags & FLAG_SUBPIXEL_POSITIONING));
+		bool bLCD = (m_uFlags & FLAG_LCD) != 0;
+
+		// Index 0 is the .notdef glyph (usually an empty box) which is what we want to draw for missing characters
+		FT_UInt uIndex = FT_Get_Char_Index(m_FTFace, uCodepoint);
+		if (uIndex == 0)
+			LOG_WARNING << "Glyph not found for codepoint: U+" << std::hex << uCodepoint << std::dec;
+
+		// Subpixel positioned glyphs are only hinted vertically, horizontal hinting would snap the shifted outline back to the pixel grid
+		FT_Int32 iLoadFlags = FT_LOAD_DEFAULT;
+		if (m_uFlags & FLAG_SUBPIXEL_POSITIONING)
+			iLoadFlags |= FT_LOAD_TARGET_LIGHT;
+		else if (bLCD)
+			iLoadFlags |= FT_LOAD_TARGET_LCD;
+
+		// The delta is in 26.6 fixed point and applied to the outline when it's loaded
+		FT_Vector ftDelta;
+		ftDelta.x = uSubpixelBin * 64 / NUM_SUBPIXEL_BINS;
+		ftDelta.y = 0;
+		FT_Set_Transform(m_FTFace, NULL, &ftDelta);
+
+		FT_Error ftError = FT_Load_Glyph(m_FTFace, uIndex, iLoadFlags); // This loads the glyph into m_FTFace->glyph (i.e. only the last loaded glyph is stored)
+		if (ftError)
+		{
+			LOG_ERROR << "Error loading Glyph with index: " << uIndex;
+			return false;
+		}
+
+		// Check FT_Render_Mode for available modes (anti-aliased, mono etc.)
+		ftError = FT_Render_Glyph(m_FTFace->glyph, bLCD ? FT_RENDER_MODE_LCD : FT_RENDER_MODE_NORMAL); // This renders the glyph into glyph->bitmap
+		if (ftError)
+		{
+			LOG_ERROR << "Error rendering glyph bitmap";
+			return false;
+		}
+
+		// The bitmap size and offsets are in whole pixels.
+		// The advance is measured in 1/64th of a pixel (26.6 fixed point) - unless FT_LOAD_NO_SCALE is used (check freetype docs).
+		// The hinted advance is rounded to whole pixels, subpixel positioning uses the unhinted one (16.16 fixed point).
+		// LCD bitmaps have three bytes per pixel stored as three times as many columns.
+		FT_GlyphSlot ftSlot = m_FTFace->glyph;
+		const FT_Bitmap& ftBitmap = ftSlot->bitmap;
+		bitmap.uCodepoint = uCodepoint;
+		bitmap.uIndex = uIndex;
+		bitmap.iBytesPerPixel = bLCD ? 3 : 1;
+		bitmap.iWidth = ftBitmap.width / bitmap.iBytesPerPixel;
+		bitmap.iHeight = ftBitmap.rows;
+		bitmap.fAdvance = (m_uFlags & FLAG_SUBPIXEL_POSITIONING) ? ftSlot->linearHoriAdvance / 65536.0f : ftSlot->advance.x / 64.0f;
+		bitmap.iBearingX = ftSlot->bitmap_left;
+		bitmap.iBearingY = ftSlot->bitmap_top;
+		bitmap.uSubpixelBin = uSubpixelBin;
+
+		// Glyphs without a bitmap (e.g. space) stay empty
+		if (bitmap.iWidth <= 0 || bitmap.iHeight <= 0)
+		{
+			bitmap.aData.clear();
+			return true;
+		}
+
+		if (m_iSpread > 0)
+		{
+			createDistanceField(ftBitmap.buffer, bitmap.iWidth, bitmap.iHeight, ftBitmap.pitch, m_iSpread, bitmap.aData);
+			bitmap.iWidth += 2*m_iSpread;
+			bitmap.iHeight += 2*m_iSpread;
+			bitmap.iBearingX -= m_iSpread;
+			bitmap.iBearingY += m_iSpread;
+		}
+		else
+		{
+			int iRowSize = bitmap.iWidth * bitmap.iBytesPerPixel;
+			bitmap.aData.resize(iRowSize * bitmap.iHeight);
+			for (int y = 0; y < bitmap.iHeight; ++y)
+				memcpy(&bitmap.aData[y*iRowSize], ftBitmap.buffer + y*ftBitmap.pitch, iRowSize);
+		}
+
+		return true;
+	}
+
+	namespace
+	{
+		// Upper bound on the segments a single curve is split into
+		const int MAX_CURVE_SEGMENTS = 64;
+
+		// State passed through FT_Outline_Decompose
+		struct OutlineBuilder
+		{
+			GlyphOutline* pOutline;
+			float fTolerance;
+			Vec2 vLast;
+
+			void closeContour()
+			{
+				std::vector<unsigned int>& aEnds = pOutline->aContourEnds;
+				if (pOutline->aPoints.size() > (aEnds.empty() ? 0 : aEnds.back()))
+					aEnds.push_back(pOutline->aPoints.size());
+			}
+
+			void addPoint(const Vec2& v)
+			{
+				pOutline->aPoints.push_back(v);
+				vLast = v;
+			}
+
+			// Flattening a curve with n uniform steps is off by at most max|B''| / (8 n^2), so the segment count
+			// follows from the second differences of the control points.
+			int getNumSegments(float fMaxSecondDerivative) const
+			{
+				int iSegments = int(ceil(sqrt(fMaxSecondDerivative / (8.0f * fTolerance))));
+				return std::max(1, std::min(iSegments, MAX_CURVE_SEGMENTS));
+			}
+		};
+
+		Vec2 toVec2(const FT_Vector* v)
+		{
+			return Vec2(v->x / 64.0f, v->y / 64.0f); // 26.6 fixed point
+		}
+
+		int moveTo(const FT_Vector* to, void* user)
+		{
+			OutlineBuilder& builder = *static_cast<OutlineBuilder*>(user);
+			builder.closeContour();
+			builder.addPoint(toVec2(to));
+			return 0;
+		}
+
+		int lineTo(const FT_Vector* to, void* user)
+		{
+			static_cast<OutlineBuilder*>(user)->addPoint(toVec2(to));
+			return 0;
+		}
+
+		int conicTo(const FT_Vector* control, const FT_Vector* to, void* user)
+		{
+			OutlineBuilder& builder = *static_cast<OutlineBuilder*>(user);
+			Vec2 p0 = builder.vLast;
+			Vec2 p1 = toVec2(control);
+			Vec2 p2 = toVec2(to);
+			int iSegments = builder.getNumSegments(2.0f * glm::length(p0 - 2.0f*p1 + p2));
+			for (int i = 1; i <= iSegments; ++i)
+			{
+				float t = float(i) / iSegments;
+				float u = 1.0f - t;
+				builder.addPoint(u*u*p0 + 2.0f*u*t*p1 + t*t*p2);
+			}
+			return 0;
+		}
+
+		int cubicTo(const FT_Vector* control1, const FT_Vector* control2, const FT_Vector* to, void* user)
+		{
+			OutlineBuilder& builder = *static_cast<OutlineBuilder*>(user);
+			Vec2 p0 = builder.vLast;
+			Vec2 p1 = toVec2(control1);
+			Vec2 p2 = toVec2(control2);
+			Vec2 p3 = toVec2(to);
+			float fMaxSecondDifference = std::max(glm::length(p0 - 2.0f*p1 + p2), glm::length(p1 - 2.0f*p2 + p3));
+			int iSegments = builder.getNumSegments(6.0f * fMaxSecondDifference);
+			for (int i = 1; i <= iSegments; ++i)
+			{
+				float t = float(i) / iSegments;
+				float u = 1.0f - t;
+				builder.addPoint(u*u*u*p0 + 3.0f*u*u*t*p1 + 3.0f*u*t*t*p2 + t*t*t*p3);
+			}
+			return 0;
+		}
+	}
+
+	bool GlyphRasterizer::decompose(unsigned int uCodepoint, float fTolerance, GlyphOutline& outline)
+	{
+		assert(fTolerance > 0.0f);
+
+		FT_UInt uIndex = FT_Get_Char_Index(m_FTFace, uCodepoint);
+		if (uIndex == 0)
+			LOG_WARNING << "Glyph not found for codepoint: U+" << std::hex << uCodepoint << std::dec;
+
+		// The outline is scaled freely so hinting would only distort it
+		FT_Set_Transform(m_FTFace, NULL, NULL);
+		FT_Error ftError = FT_Load_Glyph(m_FTFace, uIndex, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP);
+		if (ftError || m_FTFace->glyph->format != FT_GLYPH_FORMAT_OUTLINE)
+		{
+			LOG_ERROR << "Error loading outline of glyph with index: " << uIndex;
+			return false;
+		}
+
+		outline.uCodepoint = uCodepoint;
+		outline.uIndex = uIndex;
+		outline.fAdvance = m_FTFace->glyph->linearHoriAdvance / 65536.0f;
+		outline.aPoints.clear();
+		outline.aContourEnds.clear();
+
+		FT_Outline_Funcs funcs;
+		funcs.move_to = &moveTo;
+		funcs.line_to = &lineTo;
+		funcs.conic_to = &conicTo;
+		funcs.cubic_to = &cubicTo;
+		funcs.shift = 0;
+		funcs.delta = 0;
+
+		OutlineBuilder builder;
+		builder.pOutline = &outline;
+		builder.fTolerance = fTolerance;
+		ftError = FT_Outline_Decompose(&m_FTFace->glyph->outline, &funcs, &builder);
+		if (ftError)
+		{
+			LOG_ERROR << "Error decomposing outline of glyph with index: " << uIndex;
+			return false;
+		}
+		builder.closeContour();
+
+		// Truetype fills clockwise contours, postscript counter-clockwise ones
+		if (FT_Outline_Get_Orientation(&m_FTFace->glyph->outline) == FT_ORIENTATION_TRUETYPE)
+		{
+			unsigned int uStart = 0;
+			for (unsigned int i = 0; i < outline.aContourEnds.size(); uStart = outline.aContourEnds[i++])
+				std::reverse(outline.aPoints.begin() + uStart, outline.aPoints.begin() + outline.aContourEnds[i]);
+		}
+		return true;
+	}
+
+	float GlyphRasterizer::getKerning(unsigned int uLeftIndex, unsigned int uRightIndex) const
+	{
+		if (!m_bHasKerning)
+			return 0.0f;
+
+		// When the left index is 0 then the kerning is always 0. 
+		// Both modes return 1/64th of a pixel, FT_KERNING_DEFAULT rounds to whole pixels.
+		FT_Vector ftKerning;
+		FT_UInt uMode = (m_uFlags & FLAG_SUBPIXEL_POSITIONING) ? FT_KERNING_UNFITTED : FT_KERNING_DEFAULT;
+		FT_Get_Kerning(m_FTFace, uLeftIndex, uRightIndex, uMode, &ftKerning);
+		return ftKerning.x / 64.0f;
+	}
+
+	float GlyphRasterizer::getLineHeight() const
+	{
+		return m_FTFace->size->metrics.height / 64.0f;
+	}
+
+	float GlyphRasterizer::getAscender() const
+	{
+		return m_FTFace->size->metrics.ascender / 64.0f;
+	}
+
+} }
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
+namespace baselib
+{
+	namespace font
+	{
+		//! A rasterized glyph bitmap and its metrics, ready to be packed into an atlas.
+		struct GlyphBitmap
+		{
+			GlyphBitmap()
+				: uCodepoint(0)
+				, uIndex(0)
+				, iWidth(0)
+				, iHeight(0)
+				, fAdvance(0.0f)
+				, iBearingX(0)
+				, iBearingY(0)
+				, uSubpixelBin(0)
+				, iBytesPerPixel(1) {}
+
+			unsigned int uCodepoint;			//!< Unicode codepoint.
+			unsigned int uIndex;				//!< Freetype glyph index.
+			int iWidth;							//!< Bitmap width in pixels.
+			int iHeight;						//!< Bitmap height in pixels.
+			float fAdvance;						//!< Horizontal advance in pixels.
+			int iBearingX;						//!< Distance from the pen position to the left edge of the bitmap.
+			int iBearingY;						//!< Distance from the baseline to the top edge of the bitmap.
+			unsigned int uSubpixelBin;			//!< Horizontal offset the glyph was rendered at in quarter pixels.
+			int iBytesPerPixel;					//!< 1 for coverage and distance fields, 3 for RGB LCD coverage.
+			std::vector<unsigned char> aData;	//!< iWidth * iHeight * iBytesPerPixel bytes, rows stored top to bottom.
+		};
+
+		//! A glyph outline flattened into closed polygons, in pixels at the rasterizer's pixel size with y up.
+		struct GlyphOutline
+		{
+			GlyphOutline()
+				: uCodepoint(0)
+				, uIndex(0)
+				, fAdvance(0.0f) {}
+
+			unsigned int uCodepoint;				//!< Unicode codepoint.
+			unsigned int uIndex;					//!< Freetype glyph index.
+			float fAdvance;							//!< Unhinted horizontal advance in pixels.
+			std::vector<Vec2> aPoints;				//!< Points of all contours, the last point of a contour connects back to its first.
+													//!< Filled contours are counter-clockwise and holes clockwise whatever the font format.
+			std::vector<unsigned int> aContourEnds;	//!< One past the last point of each contour.
+		};
+
+		/*! @brief Renders glyph bitmaps from an in-memory font file.
+		 *
+		 *  Each rasterizer owns its own FT_Library and FT_Face. Freetype objects must not be shared between threads,
+		 *  so several rasterizers created from the same font data can render glyphs in parallel, one per thread.
+		 *  The library and face are released by the destructor.
+		 *
+		 *  With FLAG_SUBPIXEL_POSITIONING glyphs are only hinted vertically and advances and kerning keep their fractional 
+		 *  part, so text can be placed at quarter pixel offsets by rendering a glyph once per subpixel bin. With FLAG_LCD 
+		 *  glyphs are rendered with freetype's LCD filter into separate red, green and blue coverage values.
+		 */
+		class GlyphRasterizer
+		{
+		public:
+			//! Font file contents shared by every rasterizer of a font. Must stay alive as long as the rasterizers.
+			typedef boost::shared_ptr<const std::vector<unsigned char>> FontData;
+
+			//! Number of horizontal subpixel offsets a glyph can be rendered at.
+			static const unsigned int NUM_SUBPIXEL_BINS = 4;
+
+			//! Rendering options.
+			enum Flags
+			{
+				FLAG_SUBPIXEL_POSITIONING = 1 << 0,	//!< Fractional metrics and no horizontal hinting.
+				FLAG_LCD = 1 << 1					//!< RGB subpixel coverage with the LCD filter applied.
+			};
+
+			/*! @brief Creates a rasterizer for face 0 of the font data at iPixelSize pixels per em. 
+			 *
+			 *  If iSpread is greater than 0 glyphs are converted to signed distance fields reaching iSpread pixels 
+			 *  beyond the outline. uFlags is a combination of Flags, FLAG_LCD can't be used with distance fields. 
+			 *  Returns null if freetype can't load the font.
+			 */
+			static boost::shared_ptr<GlyphRasterizer> create(const FontData& spFontData, int iPixelSize, int iSpread, unsigned int uFlags = 0);
+
+			//! Destructor.
+			~GlyphRasterizer();
+
+			/*! @brief Render the glyph for a codepoint. Codepoints missing from the face render the .notdef glyph.
+			 *
+			 *  The outline is shifted right by uSubpixelBin / NUM_SUBPIXEL_BINS pixels before rendering, bins other than 0 
+			 *  need FLAG_SUBPIXEL_POSITIONING. Returns false on freetype errors.
+			 */
+			bool rasterize(unsigned int uCodepoint, GlyphBitmap& bitmap, unsigned int uSubpixelBin = 0);
+			/*! @brief Get the unhinted outline of the glyph for a codepoint with its curves flattened into line segments.
+			 *
+			 *  Curves are split into just enough segments to stay within fTolerance pixels of the true curve, so flat 
+			 *  parts cost few points and tight curves more. Returns false on freetype errors or for bitmap-only fonts.
+			 */
+			bool decompose(unsigned int uCodepoint, float fTolerance, GlyphOutline& outline);
+
+			//! Returns true if the face contains kerning information.
+			bool hasKerning() const { return m_bHasKerning; }
+			//! Get the horizontal kerning adjustment between two glyph indices in pixels.
+			float getKerning(unsigned int uLeftIndex, unsigned int uRightIndex) const;
+			//! Get the distance between two consecutive baselines in pixels.
+			float getLineHeight() const;
+			//! Get the distance from the baseline to the top of the tallest glyph in pixels.
+			float getAscender() const;
+
+			//! Get the font data the rasterizer was created from.
+			const FontData& getFontData() const { return m_spFontData; }
+			//! Get the pixel size glyphs are rendered at.
+			int getPixelSize() const { return m_iPixelSize; }
+			//! Get the distance field spread in pixels. 0 if glyphs are plain coverage bitmaps.
+			int getSpread() const { return m_iSpread; }
+			//! Get the rendering flags.
+			unsigned int getFlags() const { return m_uFlags; }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			GlyphRasterizer(const FontData& spFontData, int iPixelSize, int iSpread, unsigned int uFlags);
+
+		private:
+			//! Create the freetype library and face. Returns false on failure.
+			bool init();
+
+			FontData m_spFontData;		//!< Font file contents, freetype reads from this directly.
+			int m_iPixelSize;			//!< Pixel size glyphs are rendered at.
+			int m_iSpread;				//!< Distance field spread, 0 for coverage bitmaps.
+			unsigned int m_uFlags;		//!< Rendering flags.
+			FT_LibraryRec_* m_FTLib;	//!< Freetype library owned by this rasterizer.
+			FT_FaceRec_* m_FTFace;		//!< Freetype face owned by this rasterizer.
+			bool m_bHasKerning;			//!< True if the face contains kerning information.
+		};
+	}
+}
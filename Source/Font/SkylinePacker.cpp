@@ -0,0 +1,139 @@
+#include "SkylinePacker.h"
+
+#include <Logging/Log.h>
+#include <algorithm>
+#include <limits.h>
+
+namespace baselib { namespace font {
+
+	SkylinePacker::SkylinePacker(int iWidth, int iHeight)
+		: m_iWidth(iWidth)
+		, m_iHeight(iHeight)
+		, m_iUsedArea(0)
+	{
+		assert(iWidth > 0 && iHeight > 0);
+		reset();
+	}
+
+	SkylinePacker::~SkylinePacker()
+	{
+	}
+
+	void SkylinePacker::reset()
+	{
+		m_aNodes.clear();
+		m_aNodes.push_back(Node(0, 0, m_iWidth));
+		m_iUsedArea = 0;
+	}
+
+	void SkylinePacker::restore(const std::vector<Node>& aNodes, int iUsedArea)
+	{
+		assert(!aNodes.empty() && aNodes.front().iX == 0 && aNodes.back().iX + aNodes.back().iWidth == m_iWidth);
+		m_aNodes = aNodes;
+		m_iUsedArea = iUsedArea;
+	}
+
+	bool SkylinePacker::pack(int iWidth, int iHeight, int& iX, int& iY)
+	{
+		int iBestY = INT_MAX;
+		int iBestWaste = INT_MAX;
+		int iBestIndex = -1;
+
+		for (unsigned int i = 0; i < m_aNodes.size(); ++i)
+		{
+			int iWaste = 0;
+			int y = fit(i, iWidth, iHeight, iWaste);
+			if (y < 0)
+				continue;
+
+			// Bottom-left: lowest top edge first, then least wasted area underneath
+			if (y + iHeight < iBestY || (y + iHeight == iBestY && iWaste < iBestWaste))
+			{
+				iBestY = y + iHeight;
+				iBestWaste = iWaste;
+				iBestIndex = int(i);
+				iX = m_aNodes[i].iX;
+				iY = y;
+			}
+		}
+
+		if (iBestIndex < 0)
+			return false;
+
+		addLevel((unsigned int)iBestIndex, iX, iY, iWidth, iHeight);
+		m_iUsedArea += iWidth * iHeight;
+		return true;
+	}
+
+	int SkylinePacker::fit(unsigned int uIndex, int iWidth, int iHeight, int& iWastedArea) const
+	{
+		int iX = m_aNodes[uIndex].iX;
+		if (iX + iWidth > m_iWidth)
+			return -1;
+
+		// The rectangle rests on the highest segment it spans
+		int y = 0;
+		int iWidthLeft = iWidth;
+		unsigned int i = uIndex;
+		while (iWidthLeft > 0)
+		{
+			assert(i < m_aNodes.size());
+			y = std::max(y, m_aNodes[i].iY);
+			if (y + iHeight > m_iHeight)
+				return -1;
+			iWidthLeft -= m_aNodes[i].iWidth;
+			++i;
+		}
+
+		// Area trapped between the rectangle and the spanned segments
+		iWastedArea = 0;
+		iWidthLeft = iWidth;
+		for (i = uIndex; iWidthLeft > 0; ++i)
+		{
+			int iSpan = std::min(iWidthLeft, m_aNodes[i].iWidth);
+			iWastedArea += (y - m_aNodes[i].iY) * iSpan;
+			iWidthLeft -= iSpan;
+		}
+
+		return y;
+	}
+
+	void SkylinePacker::addLevel(unsigned int uIndex, int iX, int iY, int iWidth, int iHeight)
+	{
+		m_aNodes.insert(m_aNodes.begin() + uIndex, Node(iX, iY + iHeight, iWidth));
+
+		// Shrink or remove the segments now covered by the new one
+		for (unsigned int i = uIndex + 1; i < m_aNodes.size(); )
+		{
+			Node& prev = m_aNodes[i - 1];
+			Node& node = m_aNodes[i];
+			int iOverlap = prev.iX + prev.iWidth - node.iX;
+			if (iOverlap <= 0)
+				break;
+
+			if (iOverlap < node.iWidth)
+			{
+				node.iX += iOverlap;
+				node.iWidth -= iOverlap;
+				break;
+			}
+
+			m_aNodes.erase(m_aNodes.begin() + i);
+		}
+
+		// Merge neighbouring segments at the same height
+		for (unsigned int i = 1; i < m_aNodes.size(); )
+		{
+			if (m_aNodes[i - 1].iY == m_aNodes[i].iY)
+			{
+				m_aNodes[i - 1].iWidth += m_aNodes[i].iWidth;
+				m_aNodes.erase(m_aNodes.begin() + i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+} }
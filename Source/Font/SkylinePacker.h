@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+namespace baselib
+{
+	namespace font
+	{
+		/*! @brief Rectangle bin packer using the skyline bottom-left heuristic.
+		 *
+		 *  The packer keeps track of the top edge ("skyline") of everything packed so far as a list of
+		 *  horizontal segments. A new rectangle is placed where its top edge ends up lowest, ties broken
+		 *  by least wasted area below it. Unlike a shelf packer rows of mixed heights don't waste the
+		 *  space above the shorter rectangles.
+		 */
+		class SkylinePacker
+		{
+		public:
+			//! A horizontal segment of the skyline.
+			struct Node
+			{
+				Node(int _iX, int _iY, int _iWidth)
+					: iX(_iX)
+					, iY(_iY)
+					, iWidth(_iWidth) {}
+
+				int iX;		//!< Left edge of the segment.
+				int iY;		//!< Height of the skyline along the segment.
+				int iWidth;	//!< Segment width.
+			};
+
+			//! Constructor.
+			SkylinePacker(int iWidth, int iHeight);
+			//! Destructor.
+			~SkylinePacker();
+
+			//! Find space for a iWidth x iHeight rectangle. Returns false if it doesn't fit.
+			bool pack(int iWidth, int iHeight, int& iX, int& iY);
+			//! Remove all packed rectangles.
+			void reset();
+			//! Restore a state previously read with getNodes() and getUsedArea().
+			void restore(const std::vector<Node>& aNodes, int iUsedArea);
+
+			//! Get bin width.
+			int getWidth() const { return m_iWidth; }
+			//! Get bin height.
+			int getHeight() const { return m_iHeight; }
+			//! Get the area covered by packed rectangles.
+			int getUsedArea() const { return m_iUsedArea; }
+			//! Get the skyline segments.
+			const std::vector<Node>& getNodes() const { return m_aNodes; }
+
+		private:
+			//! Find the lowest y at which a iWidth x iHeight rectangle fits starting at node uIndex. Returns -1 if it doesn't fit.
+			int fit(unsigned int uIndex, int iWidth, int iHeight, int& iWastedArea) const;
+			//! Raise the skyline over the newly placed rectangle at node uIndex.
+			void addLevel(unsigned int uIndex, int iX, int iY, int iWidth, int iHeight);
+
+			int m_iWidth;				//!< Bin width.
+			int m_iHeight;				//!< Bin height.
+			int m_iUsedArea;			//!< Area covered by packed rectangles.
+			std::vector<Node> m_aNodes;	//!< Skyline segments ordered from left to right.
+		};
+	}
+}
@@ -0,0 +1,362 @@
+#include "Tessellation.h"
+
+#include <Logging/Log.h>
+#include <algorithm>
+
+namespace baselib { namespace font {
+
+	namespace
+	{
+		// Twice the signed area of triangle abc, positive if the corners are counter-clockwise.
+		float cross(const Vec2& a, const Vec2& b, const Vec2& c)
+		{
+			return (b.x - a.x)*(c.y - a.y) - (b.y - a.y)*(c.x - a.x);
+		}
+
+		// Inclusive test for a counter-clockwise triangle.
+		bool isInTriangle(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p)
+		{
+			return cross(a, b, p) >= 0.0f && cross(b, c, p) >= 0.0f && cross(c, a, p) >= 0.0f;
+		}
+
+		// A contour as indices into the point array.
+		struct Contour
+		{
+			std::vector<unsigned int> aPoints;	// Point indices.
+			float fArea;						// Twice the signed area, positive if counter-clockwise.
+			unsigned int uRightmost;			// Position of the vertex with the largest x in aPoints.
+		};
+
+		// Even-odd point in contour test.
+		bool isInside(const std::vector<Vec2>& aPoints, const Contour& contour, const Vec2& p)
+		{
+			bool bInside = false;
+			unsigned int uNumPoints = contour.aPoints.size();
+			for (unsigned int i = 0, j = uNumPoints - 1; i < uNumPoints; j = i++)
+			{
+				const Vec2& a = aPoints[contour.aPoints[i]];
+				const Vec2& b = aPoints[contour.aPoints[j]];
+				if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x)*(p.y - a.y)/(b.y - a.y) + a.x)
+					bInside = !bInside;
+			}
+			return bInside;
+		}
+
+		// Vertex of the circular list a polygon is clipped on. Bridges visit their two end points twice.
+		struct Node
+		{
+			unsigned int uPoint;
+			unsigned int uPrev;
+			unsigned int uNext;
+		};
+
+		// Append a contour as a circular list. Returns the node of vertex uFirst.
+		unsigned int addRing(std::vector<Node>& aNodes, const Contour& contour, unsigned int uFirst)
+		{
+			unsigned int uBase = aNodes.size();
+			unsigned int uNumPoints = contour.aPoints.size();
+			for (unsigned int i = 0; i < uNumPoints; ++i)
+			{
+				Node node;
+				node.uPoint = contour.aPoints[i];
+				node.uPrev = uBase + (i + uNumPoints - 1) % uNumPoints;
+				node.uNext = uBase + (i + 1) % uNumPoints;
+				aNodes.push_back(node);
+			}
+			return uBase + uFirst;
+		}
+
+		// Returns true if the diagonal from node a towards point b starts inside the polygon.
+		bool isLocallyInside(const std::vector<Node>& aNodes, const std::vector<Vec2>& aPoints, unsigned int a, const Vec2& b)
+		{
+			const Vec2& p = aPoints[aNodes[aNodes[a].uPrev].uPoint];
+			const Vec2& v = aPoints[aNodes[a].uPoint];
+			const Vec2& n = aPoints[aNodes[aNodes[a].uNext].uPoint];
+			if (cross(p, v, n) >= 0.0f)
+				return cross(v, n, b) >= 0.0f && cross(v, b, p) >= 0.0f;
+			return cross(v, n, b) >= 0.0f || cross(v, b, p) >= 0.0f;
+		}
+
+		// Join a clockwise hole to the counter-clockwise polygon starting at uOuter with a pair of coincident edges
+		// from the hole's rightmost vertex uHole to a visible polygon vertex. Returns false if no vertex was found.
+		bool bridgeHole(std::vector<Node>& aNodes, const std::vector<Vec2>& aPoints, unsigned int uOuter, unsigned int uHole)
+		{
+			// Cast a ray towards +x and find the closest edge it hits. The edge's right end point is a bridge candidate.
+			const Vec2 m = aPoints[aNodes[uHole].uPoint];
+			float fHitX = 0.0f;
+			unsigned int uBridge = ~0u;
+			unsigned int uNode = uOuter;
+			do
+			{
+				const Vec2& a = aPoints[aNodes[uNode].uPoint];
+				const Vec2& b = aPoints[aNodes[aNodes[uNode].uNext].uPoint];
+				if (a.y != b.y && (a.y <= m.y) == (m.y <= b.y))
+				{
+					float x = a.x + (m.y - a.y)*(b.x - a.x)/(b.y - a.y);
+					if (x >= m.x && (uBridge == ~0u || x < fHitX))
+					{
+						fHitX = x;
+						uBridge = a.x > b.x ? uNode : aNodes[uNode].uNext;
+					}
+				}
+				uNode = aNodes[uNode].uNext;
+			} while (uNode != uOuter);
+
+			if (uBridge == ~0u)
+				return false;
+
+			// Vertices inside the triangle between the hole vertex, the hit and the candidate could block the bridge.
+			// The one at the smallest angle to the ray is visible.
+			if (fHitX != m.x)
+			{
+				const Vec2 hit(fHitX, m.y);
+				const Vec2 candidate = aPoints[aNodes[uBridge].uPoint];
+				bool bAbove = candidate.y > m.y;
+				float fBestTan = std::abs(candidate.y - m.y) / std::max(candidate.x - m.x, 1e-6f);
+				uNode = uOuter;
+				do
+				{
+					const Vec2& r = aPoints[aNodes[uNode].uPoint];
+					bool bInTriangle = bAbove ? isInTriangle(m, hit, candidate, r) : isInTriangle(m, candidate, hit, r);
+					if (uNode != uBridge && r.x > m.x && bInTriangle && isLocallyInside(aNodes, aPoints, uNode, m))
+					{
+						float fTan = std::abs(r.y - m.y) / (r.x - m.x);
+						if (fTan < fBestTan || (fTan == fBestTan && r.x < aPoints[aNodes[uBridge].uPoint].x))
+						{
+							fBestTan = fTan;
+							uBridge = uNode;
+						}
+					}
+					uNode = aNodes[uNode].uNext;
+				} while (uNode != uOuter);
+			}
+
+			// Earlier bridges leave two nodes at the same point, only one of them faces the hole
+			if (!isLocallyInside(aNodes, aPoints, uBridge, m))
+			{
+				const Vec2 bridge = aPoints[aNodes[uBridge].uPoint];
+				uNode = uOuter;
+				do
+				{
+					if (aPoints[aNodes[uNode].uPoint] == bridge && isLocallyInside(aNodes, aPoints, uNode, m))
+					{
+						uBridge = uNode;
+						break;
+					}
+					uNode = aNodes[uNode].uNext;
+				} while (uNode != uOuter);
+			}
+
+			// bridge -> hole ... hole -> hole copy -> bridge copy -> old bridge next
+			Node holeCopy = aNodes[uHole];
+			Node bridgeCopy = aNodes[uBridge];
+			unsigned int uHoleCopy = aNodes.size();
+			unsigned int uBridgeCopy = uHoleCopy + 1;
+			unsigned int uBridgeNext = aNodes[uBridge].uNext;
+			unsigned int uHolePrev = aNodes[uHole].uPrev;
+
+			holeCopy.uPrev = uHolePrev;
+			holeCopy.uNext = uBridgeCopy;
+			bridgeCopy.uPrev = uHoleCopy;
+			bridgeCopy.uNext = uBridgeNext;
+			aNodes.push_back(holeCopy);
+			aNodes.push_back(bridgeCopy);
+
+			aNodes[uBridge].uNext = uHole;
+			aNodes[uHole].uPrev = uBridge;
+			aNodes[uHolePrev].uNext = uHoleCopy;
+			aNodes[uBridgeNext].uPrev = uBridgeCopy;
+			return true;
+		}
+
+		// Returns true if no other vertex of the polygon lies in the convex corner at uEar.
+		bool isEar(const std::vector<Node>& aNodes, const std::vector<Vec2>& aPoints, unsigned int uEar)
+		{
+			const Node& ear = aNodes[uEar];
+			const Vec2& a = aPoints[aNodes[ear.uPrev].uPoint];
+			const Vec2& b = aPoints[ear.uPoint];
+			const Vec2& c = aPoints[aNodes[ear.uNext].uPoint];
+			if (cross(a, b, c) <= 0.0f)
+				return false;
+
+			// Only reflex vertices can block an ear, if a convex one is inside the corner so is a reflex one.
+			// Bridge vertices coincide with the corners, they don't block the ear.
+			for (unsigned int uNode = aNodes[ear.uNext].uNext; uNode != ear.uPrev; uNode = aNodes[uNode].uNext)
+			{
+				const Node& node = aNodes[uNode];
+				const Vec2& p = aPoints[node.uPoint];
+				if (p != a && p != b && p != c && isInTriangle(a, b, c, p) && cross(aPoints[aNodes[node.uPrev].uPoint], p, aPoints[aNodes[node.uNext].uPoint]) <= 0.0f)
+					return false;
+			}
+			return true;
+		}
+
+		// Unlink a node.
+		void removeNode(std::vector<Node>& aNodes, unsigned int uNode)
+		{
+			aNodes[aNodes[uNode].uPrev].uNext = aNodes[uNode].uNext;
+			aNodes[aNodes[uNode].uNext].uPrev = aNodes[uNode].uPrev;
+		}
+
+		// Ear clip the polygon starting at uStart. Returns false if the polygon had to be forced apart.
+		bool clipEars(std::vector<Node>& aNodes, const std::vector<Vec2>& aPoints, unsigned int uStart, unsigned int uNumNodes, std::vector<unsigned int>& aIndices)
+		{
+			bool bClean = true;
+			unsigned int uEar = uStart;
+			unsigned int uStop = uStart;
+			while (uNumNodes > 3)
+			{
+				const Node& ear = aNodes[uEar];
+				unsigned int uNext = ear.uNext;
+				if (isEar(aNodes, aPoints, uEar))
+				{
+					aIndices.push_back(aNodes[ear.uPrev].uPoint);
+					aIndices.push_back(ear.uPoint);
+					aIndices.push_back(aNodes[uNext].uPoint);
+					removeNode(aNodes, uEar);
+					--uNumNodes;
+					uEar = uStop = uNext;
+					continue;
+				}
+
+				uEar = uNext;
+				if (uEar != uStop)
+					continue;
+
+				// A whole loop without finding an ear. Zero area corners (collinear or repeated points) can be
+				// dropped without losing anything, otherwise the outline intersects itself and a corner is cut anyway.
+				unsigned int uNode = uEar;
+				do
+				{
+					const Node& node = aNodes[uNode];
+					if (cross(aPoints[aNodes[node.uPrev].uPoint], aPoints[node.uPoint], aPoints[aNodes[node.uNext].uPoint]) == 0.0f)
+						break;
+					uNode = node.uNext;
+				} while (uNode != uEar);
+
+				const Node& node = aNodes[uNode];
+				if (cross(aPoints[aNodes[node.uPrev].uPoint], aPoints[node.uPoint], aPoints[aNodes[node.uNext].uPoint]) != 0.0f)
+				{
+					aIndices.push_back(aNodes[node.uPrev].uPoint);
+					aIndices.push_back(node.uPoint);
+					aIndices.push_back(aNodes[node.uNext].uPoint);
+					bClean = false;
+				}
+				uEar = uStop = node.uNext;
+				removeNode(aNodes, uNode);
+				--uNumNodes;
+			}
+
+			const Node& last = aNodes[uEar];
+			if (cross(aPoints[aNodes[last.uPrev].uPoint], aPoints[last.uPoint], aPoints[aNodes[last.uNext].uPoint]) > 0.0f)
+			{
+				aIndices.push_back(aNodes[last.uPrev].uPoint);
+				aIndices.push_back(last.uPoint);
+				aIndices.push_back(aNodes[last.uNext].uPoint);
+			}
+			return bClean;
+		}
+	}
+
+	bool tessellate(const std::vector<Vec2>& aPoints, const std::vector<unsigned int>& aContourEnds, std::vector<unsigned int>& aIndices)
+	{
+		// Collect the contours, skipping repeated points and anything too small to have an area
+		std::vector<Contour> aContours;
+		unsigned int uStart = 0;
+		for (unsigned int i = 0; i < aContourEnds.size(); uStart = aContourEnds[i++])
+		{
+			Contour contour;
+			for (unsigned int uPoint = uStart; uPoint < aContourEnds[i]; ++uPoint)
+			{
+				if (contour.aPoints.empty() || aPoints[uPoint] != aPoints[contour.aPoints.back()])
+					contour.aPoints.push_back(uPoint);
+			}
+			while (contour.aPoints.size() > 1 && aPoints[contour.aPoints.back()] == aPoints[contour.aPoints.front()])
+				contour.aPoints.pop_back();
+			if (contour.aPoints.size() < 3)
+				continue;
+
+			contour.fArea = 0.0f;
+			contour.uRightmost = 0;
+			for (unsigned int j = 0; j < contour.aPoints.size(); ++j)
+			{
+				const Vec2& a = aPoints[contour.aPoints[j]];
+				const Vec2& b = aPoints[contour.aPoints[(j + 1) % contour.aPoints.size()]];
+				contour.fArea += a.x*b.y - b.x*a.y;
+				if (a.x > aPoints[contour.aPoints[contour.uRightmost]].x)
+					contour.uRightmost = j;
+			}
+			if (contour.fArea != 0.0f)
+				aContours.push_back(contour);
+		}
+
+		// Give each hole to the smallest filled contour around it
+		bool bClean = true;
+		std::vector<int> aiParents(aContours.size(), -1);
+		for (unsigned int i = 0; i < aContours.size(); ++i)
+		{
+			if (aContours[i].fArea > 0.0f)
+				continue;
+
+			const Vec2& p = aPoints[aContours[i].aPoints[0]];
+			for (unsigned int j = 0; j < aContours.size(); ++j)
+			{
+				if (aContours[j].fArea > 0.0f && isInside(aPoints, aContours[j], p) && (aiParents[i] < 0 || aContours[j].fArea < aContours[aiParents[i]].fArea))
+					aiParents[i] = j;
+			}
+
+			if (aiParents[i] < 0)
+			{
+				LOG_WARNING << "Outline hole isn't inside a filled contour";
+				bClean = false;
+			}
+		}
+
+		std::vector<Node> aNodes;
+		std::vector<unsigned int> aHoles;
+		for (unsigned int uOuter = 0; uOuter < aContours.size(); ++uOuter)
+		{
+			const Contour& outer = aContours[uOuter];
+			if (outer.fArea < 0.0f)
+				continue;
+
+			// Rightmost hole first so earlier bridges never cross later holes
+			aHoles.clear();
+			for (unsigned int i = 0; i < aContours.size(); ++i)
+			{
+				if (aiParents[i] == int(uOuter))
+					aHoles.push_back(i);
+			}
+			std::sort(aHoles.begin(), aHoles.end(), [&](unsigned int a, unsigned int b) {
+				return aPoints[aContours[a].aPoints[aContours[a].uRightmost]].x > aPoints[aContours[b].aPoints[aContours[b].uRightmost]].x;
+			});
+
+			aNodes.clear();
+			unsigned int uStartNode = addRing(aNodes, outer, 0);
+			for (unsigned int i = 0; i < aHoles.size(); ++i)
+			{
+				const Contour& hole = aContours[aHoles[i]];
+				unsigned int uHoleNode = addRing(aNodes, hole, hole.uRightmost);
+				if (!bridgeHole(aNodes, aPoints, uStartNode, uHoleNode))
+				{
+					LOG_WARNING << "Failed to bridge outline hole";
+					bClean = false;
+				}
+			}
+
+			// Count what is reachable from the start, a failed bridge leaves its hole out
+			unsigned int uNumNodes = 0;
+			unsigned int uNode = uStartNode;
+			do
+			{
+				++uNumNodes;
+				uNode = aNodes[uNode].uNext;
+			} while (uNode != uStartNode);
+
+			bClean = clipEars(aNodes, aPoints, uStartNode, uNumNodes, aIndices) && bClean;
+		}
+
+		return bClean;
+	}
+
+} }
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <vector>
+
+namespace baselib
+{
+	namespace font
+	{
+		/*! @brief Triangulate a polygon made of closed contours, e.g. a flattened glyph outline.
+		 *
+		 *  Contour i is made of the points from aContourEnds[i - 1] (or 0) up to, but not including, aContourEnds[i].
+		 *  Counter-clockwise contours are filled and clockwise contours are holes in the smallest filled contour around
+		 *  them. Filled contours may overlap (e.g. the accent and base of a composite glyph), the overlap is covered
+		 *  twice. Holes must not cross their filled contour.
+		 *
+		 *  Each outer contour and its holes are joined into one simple polygon by bridging every hole to a visible
+		 *  outer vertex, which is then ear clipped. Triangles are appended to aIndices as indices into aPoints,
+		 *  counter-clockwise. Returns false if a contour couldn't be triangulated cleanly; the triangles that were
+		 *  found are still added.
+		 */
+		bool tessellate(const std::vector<Vec2>& aPoints, const std::vector<unsigned int>& aContourEnds, std::vector<unsigned int>& aIndices);
+	}
+}
@@ -0,0 +1,351 @@
+#include "TextBatch.h"
+
+#include <Logging/Log.h>
+#include <Font/Glyph.h>
+#include <Font/GlyphRasterizer.h>
+#include <Font/GlyphMeshCache.h>
+#include <Font/TextLayout.h>
+#include <Graphics/Renderer.h>
+#include <Graphics/Shader.h>
+#include <Graphics/ShaderObject.h>
+#include <Graphics/ShaderPipeline.h>
+#include <Graphics/Texture.h>
+#include <Graphics/DynamicGeometry.h>
+#include <Helpers/Utf8.h>
+#include <boost/range/algorithm/for_each.hpp>
+
+using namespace baselib::graphics;
+
+namespace baselib { namespace font {
+
+	boost::shared_ptr<TextBatch> TextBatch::create(const boost::shared_ptr<Renderer>& spRenderer)
+	{
+		assert(spRenderer);
+		return boost::shared_ptr<TextBatch>(new TextBatch(spRenderer));
+	}
+
+	TextBatch::TextBatch(const boost::shared_ptr<Renderer>& spRenderer)
+		: m_spRenderer(spRenderer)
+		, m_uLastGroup(0)
+	{
+		LOG_VERBOSE << "TextBatch constructor";
+		init();
+	}
+
+	TextBatch::~TextBatch()
+	{
+		LOG_VERBOSE << "TextBatch destructor";
+	}
+
+	void TextBatch::init()
+	{
+		// The quad shaders share Text.vert, so they are separable pipelines that link it only once.
+		// The outline pipeline compiles in parallel and is waited for when text is first rendered.
+		std::vector<boost::shared_ptr<ShaderObject>> aShaderObjects;
+		aShaderObjects.push_back(ShaderObject::load("../Data/Shaders/Text.vert"));
+		aShaderObjects.push_back(ShaderObject::load("../Data/Shaders/Text.frag"));
+		m_spTextPipeline = ShaderPipeline::createSeparable("Text", aShaderObjects);
+		m_spTextShader = m_spTextPipeline->createInstance();
+
+		std::vector<boost::shared_ptr<ShaderObject>> aSDFShaderObjects;
+		aSDFShaderObjects.push_back(ShaderObject::load("../Data/Shaders/Text.vert"));
+		aSDFShaderObjects.push_back(ShaderObject::load("../Data/Shaders/TextSDF.frag"));
+		m_spTextSDFPipeline = ShaderPipeline::createSeparable("TextSDF", aSDFShaderObjects);
+		m_spTextSDFShader = m_spTextSDFPipeline->createInstance();
+
+		std::vector<boost::shared_ptr<ShaderObject>> aLCDShaderObjects;
+		aLCDShaderObjects.push_back(ShaderObject::load("../Data/Shaders/Text.vert"));
+		aLCDShaderObjects.push_back(ShaderObject::load("../Data/Shaders/TextLCD.frag"));
+		m_spTextLCDPipeline = ShaderPipeline::createSeparable("TextLCD", aLCDShaderObjects);
+		m_spTextLCDShader = m_spTextLCDPipeline->createInstance();
+
+		std::vector<boost::shared_ptr<ShaderObject>> aOutlineShaderObjects;
+		aOutlineShaderObjects.push_back(ShaderObject::load("../Data/Shaders/TextOutline.vert"));
+		aOutlineShaderObjects.push_back(ShaderObject::load("../Data/Shaders/TextOutline.frag"));
+		m_spTextOutlinePipeline = ShaderPipeline::createAsync("TextOutline", aOutlineShaderObjects);
+		m_spTextOutlineShader = m_spTextOutlinePipeline->createInstance();
+
+		auto spVL = VertexLayout::create();
+		spVL->add(VertexAttribute("position", 0, 2, TYPE_FLOAT, 0));
+		spVL->add(VertexAttribute("texcoord", 1, 2, TYPE_FLOAT, 2*sizeof(float), true));
+		spVL->add(VertexAttribute("colour", 2, 4, TYPE_FLOAT, 4*sizeof(float)));
+
+		m_spVertexList = boost::shared_ptr<VertexList<TextVertex>>(new VertexList<TextVertex>(spVL));
+		m_spGeometry = m_spRenderer->createDynamicGeometry(m_spVertexList, Geometry::TRIANGLES);
+	}
+
+	void TextBatch::addText(const boost::shared_ptr<Font>& spFont, const std::string& sText, const Vec2& vPosition, const Vec4& vColour, float fScale)
+	{
+		assert(spFont);
+
+		// sText is UTF-8. Glyph references are only valid until the next glyph is created, so just the
+		// previous glyph's index is kept for kerning and the metrics are read before addGlyph() may create a variant.
+		Vec2 vPen = vPosition;
+		unsigned int uPreviousIndex = 0;
+		for (unsigned int uPos = 0; uPos < sText.length(); )
+		{
+			unsigned int uCodepoint = decodeUtf8(sText, uPos);
+			if (uCodepoint == '\n')
+			{
+				vPen = Vec2(vPosition.x, vPen.y - spFont->getLineHeight()*fScale);
+				uPreviousIndex = 0;
+				continue;
+			}
+
+			const Glyph& glyph = spFont->getGlyph(uCodepoint);
+			if (uPreviousIndex != 0)
+				vPen.x += spFont->getKerning(uPreviousIndex, glyph.getIndex())*fScale;
+
+			float fAdvance = glyph.getAdvance();
+			uPreviousIndex = glyph.getIndex();
+			addGlyph(*spFont, glyph, vPen, vColour, fScale);
+			vPen.x += fAdvance*fScale;
+		}
+	}
+
+	void TextBatch::addText(const boost::shared_ptr<GlyphMeshCache>& spMeshCache, const std::string& sText, const Vec2& vPosition, const Vec4& vColour, float fScale)
+	{
+		assert(spMeshCache);
+
+		// Outline glyphs are resolution independent so the pen position isn't snapped
+		const Font& font = *spMeshCache->getFont();
+		Vec2 vPen = vPosition;
+		unsigned int uPreviousIndex = 0;
+		for (unsigned int uPos = 0; uPos < sText.length(); )
+		{
+			unsigned int uCodepoint = decodeUtf8(sText, uPos);
+			if (uCodepoint == '\n')
+			{
+				vPen = Vec2(vPosition.x, vPen.y - font.getLineHeight()*fScale);
+				uPreviousIndex = 0;
+				continue;
+			}
+
+			const GlyphMesh& mesh = spMeshCache->getMesh(uCodepoint);
+			if (uPreviousIndex != 0)
+				vPen.x += font.getKerning(uPreviousIndex, mesh.uIndex)*fScale;
+			uPreviousIndex = mesh.uIndex;
+
+			if (mesh.uNumIndices > 0)
+			{
+				OutlineGlyph glyph;
+				glyph.spMeshCache = spMeshCache;
+				glyph.uFirstIndex = mesh.uFirstIndex;
+				glyph.uNumIndices = mesh.uNumIndices;
+				glyph.vOrigin = vPen;
+				glyph.fScale = fScale;
+				glyph.vColour = vColour;
+				m_aOutlineGlyphs.push_back(glyph);
+			}
+			vPen.x += mesh.fAdvance*fScale;
+		}
+	}
+
+	void TextBatch::addLayout(const TextLayout& layout, const Vec2& vPosition, const Vec4& vColour, float fScale)
+	{
+		const Font& font = *layout.getFont();
+		const std::vector<TextLayout::PositionedGlyph>& aGlyphs = layout.getGlyphs();
+		boost::for_each(layout.getLines(), [&](const TextLayout::Line& line) {
+			Vec2 vLineStart = vPosition + Vec2(line.fOffsetX, line.fBaselineY)*fScale;
+			for (unsigned int i = line.uFirstGlyph; i < line.uFirstGlyph + line.uNumGlyphs; ++i)
+				addGlyph(font, font.getGlyph(aGlyphs[i].uCodepoint), Vec2(vLineStart.x + aGlyphs[i].fX*fScale, vLineStart.y), vColour, fScale);
+		});
+	}
+
+	void TextBatch::addGlyph(const Font& font, const Glyph& glyph, const Vec2& vPen, const Vec4& vColour, float fScale)
+	{
+		if (glyph.getWidth() <= 0 || glyph.getHeight() <= 0)
+			return;
+
+		// Bitmap glyphs are snapped to whole pixels so glyph texels map 1:1 to screen pixels
+		Font::RenderMode eRenderMode = font.getRenderMode();
+		if (eRenderMode == Font::RENDER_SDF || fScale != 1.0f)
+		{
+			addQuad(font, glyph, vPen, vColour, fScale);
+			return;
+		}
+
+		Vec2 vOrigin(floor(vPen.x + 0.5f), floor(vPen.y + 0.5f));
+		if (!font.hasSubpixelPositioning())
+		{
+			addQuad(font, glyph, vOrigin, vColour, 1.0f);
+			return;
+		}
+
+		// Round to the nearest quarter pixel and use the variant rendered at that offset. If the variant cap is
+		// reached a different bin comes back and the glyph is rounded to the nearest whole pixel instead.
+		const float fBins = float(GlyphRasterizer::NUM_SUBPIXEL_BINS);
+		float fQuarters = floor(vPen.x*fBins + 0.5f);
+		unsigned int uBin = (unsigned int)(fQuarters - floor(fQuarters / fBins)*fBins);
+		const Glyph& variant = uBin == glyph.getSubpixelBin() ? glyph : font.getGlyph(glyph.getCodepoint(), uBin);
+		vOrigin.x = floor((fQuarters - variant.getSubpixelBin()) / fBins + 0.5f);
+		addQuad(font, variant, vOrigin, vColour, 1.0f);
+	}
+
+	void TextBatch::addQuad(const Font& font, const Glyph& glyph, const Vec2& vOrigin, const Vec4& vColour, float fScale)
+	{
+		Vec2 vMin(vOrigin.x + glyph.getBearingX()*fScale, vOrigin.y + (glyph.getBearingY() - glyph.getHeight())*fScale);
+		Vec2 vMax(vMin.x + glyph.getWidth()*fScale, vMin.y + glyph.getHeight()*fScale);
+		addQuad(font.getAtlas(glyph.getPage()), font.getRenderMode(), vMin, vMax, glyph.getUVMin(), glyph.getUVMax(), vColour);
+	}
+
+	void TextBatch::addQuad(const boost::shared_ptr<Texture>& spTexture, Font::RenderMode eRenderMode, const Vec2& vPosMin, const Vec2& vPosMax, const Vec2& vUVMin, const Vec2& vUVMax, const Vec4& vColour)
+	{
+		std::vector<TextVertex>& aVertices = getGroup(spTexture, eRenderMode).aVertices;
+		aVertices.push_back(TextVertex(vPosMin, vUVMin, vColour));
+		aVertices.push_back(TextVertex(Vec2(vPosMax.x, vPosMin.y), Vec2(vUVMax.x, vUVMin.y), vColour));
+		aVertices.push_back(TextVertex(vPosMax, vUVMax, vColour));
+		aVertices.push_back(TextVertex(Vec2(vPosMin.x, vPosMax.y), Vec2(vUVMin.x, vUVMax.y), vColour));
+	}
+
+	TextBatch::Group& TextBatch::getGroup(const boost::shared_ptr<Texture>& spTexture, Font::RenderMode eRenderMode)
+	{
+		if (m_uLastGroup < m_aGroups.size() && m_aGroups[m_uLastGroup].spTexture == spTexture)
+			return m_aGroups[m_uLastGroup];
+
+		for (unsigned int i = 0; i < m_aGroups.size(); ++i)
+		{
+			if (m_aGroups[i].spTexture == spTexture)
+			{
+				m_uLastGroup = i;
+				return m_aGroups[i];
+			}
+		}
+
+		Group group;
+		group.spTexture = spTexture;
+		group.eRenderMode = eRenderMode;
+		group.uFirstIndex = 0;
+		m_aGroups.push_back(group);
+		m_uLastGroup = m_aGroups.size() - 1;
+		return m_aGroups.back();
+	}
+
+	void TextBatch::clear()
+	{
+		// Keep the groups and their storage around, the same pages are very likely to be used next frame
+		boost::for_each(m_aGroups, [](Group& group) {
+			group.aVertices.clear();
+		});
+		m_aOutlineGlyphs.clear();
+	}
+
+	unsigned int TextBatch::getNumQuads() const
+	{
+		unsigned int uNumQuads = 0;
+		boost::for_each(m_aGroups, [&uNumQuads](const Group& group) {
+			uNumQuads += group.aVertices.size() / 4;
+		});
+		return uNumQuads;
+	}
+
+	void TextBatch::render()
+	{
+		// Write all groups into a single vertex list
+		std::vector<TextVertex>& aVertices = m_spVertexList->modifyVertices();
+		std::vector<unsigned int>& aIndices = m_spVertexList->modifyIndices();
+		aVertices.clear();
+		aIndices.clear();
+		boost::for_each(m_aGroups, [&aVertices, &aIndices](Group& group) {
+			group.uFirstIndex = aIndices.size();
+			unsigned int uBase = aVertices.size();
+			for (unsigned int uQuad = 0; uQuad < group.aVertices.size() / 4; ++uQuad)
+			{
+				unsigned int uFirst = uBase + uQuad*4;
+				aIndices.push_back(uFirst);
+				aIndices.push_back(uFirst + 1);
+				aIndices.push_back(uFirst + 2);
+				aIndices.push_back(uFirst);
+				aIndices.push_back(uFirst + 2);
+				aIndices.push_back(uFirst + 3);
+			}
+			aVertices.insert(aVertices.end(), group.aVertices.begin(), group.aVertices.end());
+		});
+
+		if (aIndices.empty() && m_aOutlineGlyphs.empty())
+			return;
+
+		if (!aIndices.empty())
+			m_spGeometry->update();
+
+		// Text is blended over the scene and not depth tested
+		Renderer::RenderStateValue eBlend = m_spRenderer->getRenderState(Renderer::STATE_BLEND);
+		Renderer::RenderStateValue eBlendSrc = m_spRenderer->getRenderState(Renderer::STATE_BLEND_SRC);
+		Renderer::RenderStateValue eBlendDst = m_spRenderer->getRenderState(Renderer::STATE_BLEND_DST);
+		Renderer::RenderStateValue eDepthTest = m_spRenderer->getRenderState(Renderer::STATE_DEPTH_TEST);
+		m_spRenderer->setRenderState(Renderer::STATE_BLEND, Renderer::TRUE);
+		m_spRenderer->setRenderState(Renderer::STATE_DEPTH_TEST, Renderer::FALSE);
+
+		// One draw per atlas page
+		Vec2 vViewportSize(m_spRenderer->getViewportSize().z, m_spRenderer->getViewportSize().w);
+		boost::shared_ptr<Shader> spBoundShader;
+		if (!aIndices.empty())
+			m_spGeometry->bind();
+		boost::for_each(m_aGroups, [this, &vViewportSize, &spBoundShader](const Group& group) {
+			if (group.aVertices.empty())
+				return;
+
+			// LCD text outputs a blend weight per colour channel as the second fragment shader output
+			bool bLCD = group.eRenderMode == Font::RENDER_LCD;
+			m_spRenderer->setRenderState(Renderer::STATE_BLEND_SRC, bLCD ? Renderer::SRC1 : Renderer::SRC_ALPHA);
+			m_spRenderer->setRenderState(Renderer::STATE_BLEND_DST, bLCD ? Renderer::ONE_MINUS_SRC1 : Renderer::ONE_MINUS_SRC_ALPHA);
+
+			auto spShader = bLCD ? m_spTextLCDShader : group.eRenderMode == Font::RENDER_SDF ? m_spTextSDFShader : m_spTextShader;
+			if (spShader != spBoundShader)
+			{
+				spShader->bind();
+				spShader->setUniform(spShader->getUniform("vViewportSize"), vViewportSize);
+				spShader->setUniform(spShader->getUniform("sTexture"), 0); // TODO: Get active unit from texture - just using 0 for everything at the moment.
+				spBoundShader = spShader;
+			}
+
+			group.spTexture->bind();
+			m_spRenderer->drawIndexed(m_spGeometry->getPrimitiveType(), group.aVertices.size() / 4 * 6, group.uFirstIndex);
+		});
+		if (!aIndices.empty())
+			m_spGeometry->unbind();
+
+		renderOutlines(vViewportSize);
+
+		m_spRenderer->setRenderState(Renderer::STATE_BLEND, eBlend == Renderer::TRUE ? Renderer::TRUE : Renderer::FALSE);
+		m_spRenderer->setRenderState(Renderer::STATE_BLEND_SRC, eBlendSrc);
+		m_spRenderer->setRenderState(Renderer::STATE_BLEND_DST, eBlendDst);
+		m_spRenderer->setRenderState(Renderer::STATE_DEPTH_TEST, eDepthTest == Renderer::TRUE ? Renderer::TRUE : Renderer::FALSE);
+	}
+
+	void TextBatch::renderOutlines(const Vec2& vViewportSize)
+	{
+		if (m_aOutlineGlyphs.empty())
+			return;
+
+		m_spRenderer->setRenderState(Renderer::STATE_BLEND_SRC, Renderer::SRC_ALPHA);
+		m_spRenderer->setRenderState(Renderer::STATE_BLEND_DST, Renderer::ONE_MINUS_SRC_ALPHA);
+
+		auto spShader = m_spTextOutlineShader;
+		spShader->bind();
+		spShader->setUniform(spShader->getUniform("vViewportSize"), vViewportSize);
+		int iOrigin = spShader->getUniform("vOrigin");
+		int iScale = spShader->getUniform("fScale");
+		int iColour = spShader->getUniform("vTextColour");
+
+		// The glyphs of a string share a cache, so the geometry is only rebound when the cache changes
+		boost::shared_ptr<DynamicGeometry> spBoundGeometry;
+		boost::for_each(m_aOutlineGlyphs, [&](const OutlineGlyph& glyph) {
+			const boost::shared_ptr<DynamicGeometry>& spGeometry = glyph.spMeshCache->getGeometry();
+			if (spGeometry != spBoundGeometry)
+			{
+				if (spBoundGeometry)
+					spBoundGeometry->unbind();
+				spGeometry->bind();
+				spBoundGeometry = spGeometry;
+			}
+
+			spShader->setUniform(iOrigin, glyph.vOrigin);
+			spShader->setUniform(iScale, glyph.fScale);
+			spShader->setUniform(iColour, glyph.vColour);
+			m_spRenderer->drawIndexed(spGeometry->getPrimitiveType(), glyph.uNumIndices, glyph.uFirstIndex);
+		});
+		spBoundGeometry->unbind();
+	}
+
+} }
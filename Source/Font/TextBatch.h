@@ -0,0 +1,148 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <boost/shared_ptr.hpp>
+#include <Graphics/VertexList.h>
+#include <Font/Font.h>
+#include <string>
+#include <vector>
+
+namespace baselib
+{
+	namespace font
+	{
+		class Glyph;
+		class GlyphMeshCache;
+		class TextLayout;
+	}
+
+	namespace graphics
+	{
+		class Renderer;
+		class Shader;
+		class ShaderPipeline;
+		class Texture;
+		class DynamicGeometry;
+	}
+}
+
+namespace baselib
+{
+	namespace font
+	{
+		//! Vertex used for text quads. Positions are in pixels from the bottom left corner of the viewport.
+		struct TextVertex
+		{
+			TextVertex(const Vec2& _vPos, const Vec2& _vUV, const Vec4& _vColour)
+				: vPos(_vPos)
+				, vUV(_vUV)
+				, vColour(_vColour) {}
+
+			Vec2 vPos;
+			Vec2 vUV;
+			Vec4 vColour;
+		};
+
+		/*! @brief Collects the quads for any number of strings and draws them with as few draw calls as possible.
+		 *
+		 *  Quads are grouped by the atlas page their glyphs live on. At render time all groups are written
+		 *  into one dynamic vertex buffer and each group is drawn with a single draw call, so a frame's worth
+		 *  of text costs one draw per atlas page used rather than one per string.
+		 *
+		 *  Unscaled bitmap and LCD glyphs are snapped to the pixel grid. For fonts with subpixel positioning the pen
+		 *  position is rounded to the nearest quarter pixel instead and the glyph variant rendered at that offset is used.
+		 *  LCD glyphs are drawn with dual source blending so each colour channel is blended with its own coverage.
+		 *
+		 *  Text added from a GlyphMeshCache is drawn as triangles after the quads, with one draw per glyph. It is meant
+		 *  for very large text, which would need huge atlas glyphs, and is only anti-aliased with multisampling.
+		 */
+		class TextBatch
+		{
+		public:
+			//! Creates a TextBatch.
+			static boost::shared_ptr<TextBatch> create(const boost::shared_ptr<graphics::Renderer>& spRenderer);
+
+			//! Destructor.
+			~TextBatch();
+
+			/*! @brief Add a string to the batch. 
+			 *
+			 *  sText is UTF-8 encoded. vPosition is the start of the first baseline in pixels from the bottom left corner of the viewport.
+			 *  fScale is relative to the pixel size the font was loaded at. Only distance field fonts stay sharp when scaled.
+			 */
+			void addText(const boost::shared_ptr<Font>& spFont, const std::string& sText, const Vec2& vPosition, const Vec4& vColour, float fScale = 1.0f);
+			//! Add a string drawn with tessellated glyph outlines. Call GlyphMeshCache::update() before render(). See addText() for the parameters.
+			void addText(const boost::shared_ptr<GlyphMeshCache>& spMeshCache, const std::string& sText, const Vec2& vPosition, const Vec4& vColour, float fScale = 1.0f);
+			//! Add a laid out block of text to the batch. vPosition is the start of the first line's baseline, see addText() for the rest.
+			void addLayout(const TextLayout& layout, const Vec2& vPosition, const Vec4& vColour, float fScale = 1.0f);
+			//! Add a single glyph quad to the batch. Positions are in pixels. eRenderMode is the atlas contents and selects the shader used to draw the quad.
+			void addQuad(const boost::shared_ptr<graphics::Texture>& spTexture, Font::RenderMode eRenderMode, const Vec2& vPosMin, const Vec2& vPosMax, const Vec2& vUVMin, const Vec2& vUVMax, const Vec4& vColour);
+
+			//! Remove all text from the batch.
+			void clear();
+
+			/*! @brief Draw everything in the batch.
+			 *
+			 *  Glyphs are rasterized while text is added, so Font::update() has to be called for the
+			 *  fonts used after the last addText() and before render().
+			 */
+			void render();
+
+			//! Get the number of quads in the batch.
+			unsigned int getNumQuads() const;
+			//! Get the number of glyphs drawn from outline meshes.
+			unsigned int getNumOutlineGlyphs() const { return m_aOutlineGlyphs.size(); }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			TextBatch(const boost::shared_ptr<graphics::Renderer>& spRenderer);
+
+		private:
+			//! Quads that share an atlas texture.
+			struct Group
+			{
+				boost::shared_ptr<graphics::Texture> spTexture;	//!< Atlas page texture.
+				Font::RenderMode eRenderMode;					//!< What the texture contains.
+				std::vector<TextVertex> aVertices;				//!< Four vertices per quad.
+				unsigned int uFirstIndex;						//!< First index of the group in the index buffer. Set by render().
+			};
+
+			//! A glyph drawn from a GlyphMeshCache.
+			struct OutlineGlyph
+			{
+				boost::shared_ptr<GlyphMeshCache> spMeshCache;	//!< Cache containing the glyph's triangles.
+				unsigned int uFirstIndex;						//!< First index of the glyph's triangles.
+				unsigned int uNumIndices;						//!< Number of indices.
+				Vec2 vOrigin;									//!< Pen position in pixels.
+				float fScale;									//!< Scale relative to the font's pixel size.
+				Vec4 vColour;									//!< Text colour.
+			};
+
+			//! Draw the outline glyphs. Blending must already be set up.
+			void renderOutlines(const Vec2& vViewportSize);
+			//! Create the shader and geometry buffers.
+			void init();
+			//! Add the quad for a glyph with its pen position at vPen. May create a subpixel variant, which invalidates glyph.
+			void addGlyph(const Font& font, const Glyph& glyph, const Vec2& vPen, const Vec4& vColour, float fScale);
+			//! Add the quad for a glyph with its pen position at vOrigin, without any snapping.
+			void addQuad(const Font& font, const Glyph& glyph, const Vec2& vOrigin, const Vec4& vColour, float fScale);
+			//! Find or add the group for an atlas texture.
+			Group& getGroup(const boost::shared_ptr<graphics::Texture>& spTexture, Font::RenderMode eRenderMode);
+
+			boost::shared_ptr<graphics::Renderer> m_spRenderer;						//!< Renderer used to draw the batch.
+			boost::shared_ptr<graphics::ShaderPipeline> m_spTextPipeline;			//!< Text shader pipeline.
+			boost::shared_ptr<graphics::Shader> m_spTextShader;						//!< Text shader instance.
+			boost::shared_ptr<graphics::ShaderPipeline> m_spTextSDFPipeline;		//!< Distance field text shader pipeline.
+			boost::shared_ptr<graphics::Shader> m_spTextSDFShader;					//!< Distance field text shader instance.
+			boost::shared_ptr<graphics::ShaderPipeline> m_spTextLCDPipeline;		//!< LCD text shader pipeline.
+			boost::shared_ptr<graphics::Shader> m_spTextLCDShader;					//!< LCD text shader instance.
+			boost::shared_ptr<graphics::ShaderPipeline> m_spTextOutlinePipeline;	//!< Outline text shader pipeline.
+			boost::shared_ptr<graphics::Shader> m_spTextOutlineShader;				//!< Outline text shader instance.
+			boost::shared_ptr<graphics::VertexList<TextVertex>> m_spVertexList;	//!< Vertex and index data for all groups.
+			boost::shared_ptr<graphics::DynamicGeometry> m_spGeometry;				//!< Hardware buffers the vertex list is streamed into.
+			std::vector<Group> m_aGroups;											//!< Quads grouped by atlas texture.
+			std::vector<OutlineGlyph> m_aOutlineGlyphs;								//!< Glyphs drawn from outline meshes, in the order they were added.
+			unsigned int m_uLastGroup;												//!< Group used by the previous quad - consecutive glyphs usually share a page.
+		};
+	}
+}
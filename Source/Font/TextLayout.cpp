@@ -0,0 +1,179 @@
+#include "TextLayout.h"
+
+#include <Logging/Log.h>
+#include <Font/Font.h>
+#include <Font/Glyph.h>
+#include <Helpers/Utf8.h>
+#include <algorithm>
+#include <math.h>
+
+namespace baselib { namespace font {
+
+	boost::shared_ptr<TextLayout> TextLayout::create(const boost::shared_ptr<Font>& spFont, float fMaxWidth, Alignment eAlignment)
+	{
+		assert(spFont);
+		assert(fMaxWidth >= 0.0f);
+		return boost::shared_ptr<TextLayout>(new TextLayout(spFont, fMaxWidth, eAlignment));
+	}
+
+	TextLayout::TextLayout(const boost::shared_ptr<Font>& spFont, float fMaxWidth, Alignment eAlignment)
+		: m_spFont(spFont)
+		, m_fMaxWidth(fMaxWidth)
+		, m_eAlignment(eAlignment)
+		, m_uNumGlyphsLaidOut(0)
+	{
+		LOG_VERBOSE << "TextLayout constructor";
+		layoutFrom(0, 0);
+	}
+
+	TextLayout::~TextLayout()
+	{
+		LOG_VERBOSE << "TextLayout destructor";
+	}
+
+	void TextLayout::setText(const std::string& sText)
+	{
+		// Everything up to the first modified byte is unchanged
+		unsigned int uPrefix = 0;
+		unsigned int uLength = std::min(sText.length(), m_sText.length());
+		while (uPrefix < uLength && sText[uPrefix] == m_sText[uPrefix])
+			++uPrefix;
+
+		if (uPrefix == uLength && sText.length() == m_sText.length())
+		{
+			m_uNumGlyphsLaidOut = 0;
+			return;
+		}
+
+		m_sText = sText;
+
+		// Find the line containing the first modified byte
+		unsigned int uLine = 0;
+		while (uLine + 1 < m_aLines.size() && m_aLines[uLine + 1].uFirstByte <= uPrefix)
+			++uLine;
+
+		// When wrapping, the first word of the modified line may now fit on the previous line or the other way around
+		if (uLine > 0 && m_fMaxWidth > 0.0f)
+			--uLine;
+
+		layoutFrom(uLine, m_aLines[uLine].uFirstByte);
+	}
+
+	void TextLayout::layoutFrom(unsigned int uFirstLine, unsigned int uFirstByte)
+	{
+		unsigned int uLineStart = uFirstLine < m_aLines.size() ? m_aLines[uFirstLine].uFirstGlyph : m_aGlyphs.size();
+		m_aLines.erase(m_aLines.begin() + std::min(uFirstLine, (unsigned int)m_aLines.size()), m_aLines.end());
+		m_aGlyphs.erase(m_aGlyphs.begin() + uLineStart, m_aGlyphs.end());
+		m_aGlyphBytes.erase(m_aGlyphBytes.begin() + uLineStart, m_aGlyphBytes.end());
+		m_uNumGlyphsLaidOut = 0;
+
+		unsigned int uLineByte = uFirstByte;
+		unsigned int uPreviousIndex = 0;
+		float fPen = 0.0f;
+		float fWidth = 0.0f;			// Line width without trailing spaces
+		int iBreakGlyph = -1;			// Last glyph the line can be broken after
+		float fBreakWidth = 0.0f;		// Line width if broken after iBreakGlyph
+
+		for (unsigned int uPos = uFirstByte; uPos < m_sText.length(); )
+		{
+			unsigned int uByte = uPos;
+			unsigned int uCodepoint = decodeUtf8(m_sText, uPos);
+			if (uCodepoint == '\n')
+			{
+				addLine(uLineStart, uLineByte, fWidth);
+				uLineStart = m_aGlyphs.size();
+				uLineByte = uPos;
+				uPreviousIndex = 0;
+				fPen = fWidth = 0.0f;
+				iBreakGlyph = -1;
+				continue;
+			}
+
+			const Glyph& glyph = m_spFont->getGlyph(uCodepoint);
+			if (uPreviousIndex != 0)
+				fPen += m_spFont->getKerning(uPreviousIndex, glyph.getIndex());
+
+			// Wrap if the glyph doesn't fit. Spaces never cause a wrap, they hang past the edge instead.
+			bool bSpace = uCodepoint == ' ';
+			if (m_fMaxWidth > 0.0f && !bSpace && fPen + glyph.getAdvance() > m_fMaxWidth && m_aGlyphs.size() > uLineStart)
+			{
+				// Move the partial word after the last break opportunity to the next line, or break the word here if there is none
+				unsigned int uBreak = m_aGlyphs.size();
+				float fLineWidth = fWidth;
+				if (iBreakGlyph >= 0)
+				{
+					uBreak = iBreakGlyph + 1;
+					fLineWidth = fBreakWidth;
+				}
+
+				uPos = uBreak < m_aGlyphs.size() ? m_aGlyphBytes[uBreak] : uByte;
+				m_uNumGlyphsLaidOut -= m_aGlyphs.size() - uBreak;
+				m_aGlyphs.erase(m_aGlyphs.begin() + uBreak, m_aGlyphs.end());
+				m_aGlyphBytes.erase(m_aGlyphBytes.begin() + uBreak, m_aGlyphBytes.end());
+
+				addLine(uLineStart, uLineByte, fLineWidth);
+				uLineStart = m_aGlyphs.size();
+				uLineByte = uPos;
+				uPreviousIndex = 0;
+				fPen = fWidth = 0.0f;
+				iBreakGlyph = -1;
+				continue;
+			}
+
+			m_aGlyphs.push_back(PositionedGlyph(uCodepoint, fPen));
+			m_aGlyphBytes.push_back(uByte);
+			++m_uNumGlyphsLaidOut;
+
+			fPen += glyph.getAdvance();
+			if (!bSpace)
+				fWidth = fPen;
+			if (bSpace || uCodepoint == '-')
+			{
+				iBreakGlyph = m_aGlyphs.size() - 1;
+				fBreakWidth = fWidth;
+			}
+			uPreviousIndex = glyph.getIndex();
+		}
+
+		// There is always a last line, even if the text is empty or ends with '\n'
+		addLine(uLineStart, uLineByte, fWidth);
+		align();
+	}
+
+	void TextLayout::addLine(unsigned int uFirstGlyph, unsigned int uFirstByte, float fWidth)
+	{
+		Line line;
+		line.uFirstGlyph = uFirstGlyph;
+		line.uNumGlyphs = m_aGlyphs.size() - uFirstGlyph;
+		line.uFirstByte = uFirstByte;
+		line.fWidth = fWidth;
+		line.fOffsetX = 0.0f;
+		line.fBaselineY = -(float)m_aLines.size() * m_spFont->getLineHeight();
+		m_aLines.push_back(line);
+	}
+
+	void TextLayout::align()
+	{
+		// Without a wrapping width lines are aligned to the widest line, so every offset may change
+		float fAlignWidth = m_fMaxWidth > 0.0f ? m_fMaxWidth : getSize().x;
+		for (unsigned int i = 0; i < m_aLines.size(); ++i)
+		{
+			Line& line = m_aLines[i];
+			if (m_eAlignment == ALIGN_CENTER)
+				line.fOffsetX = floor((fAlignWidth - line.fWidth) * 0.5f);
+			else if (m_eAlignment == ALIGN_RIGHT)
+				line.fOffsetX = fAlignWidth - line.fWidth;
+			else
+				line.fOffsetX = 0.0f;
+		}
+	}
+
+	Vec2 TextLayout::getSize() const
+	{
+		float fWidth = 0.0f;
+		for (unsigned int i = 0; i < m_aLines.size(); ++i)
+			fWidth = std::max(fWidth, m_aLines[i].fWidth);
+		return Vec2(fWidth, m_aLines.size() * m_spFont->getLineHeight());
+	}
+
+} }
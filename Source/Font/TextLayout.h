@@ -0,0 +1,114 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+namespace baselib
+{
+	namespace font
+	{
+		class Font;
+	}
+}
+
+namespace baselib
+{
+	namespace font
+	{
+		/*! @brief Lays out a UTF-8 string as lines of positioned glyphs.
+		 *
+		 *  Applies kerning, breaks lines at '\n' and, if a maximum width is set, wraps greedily after spaces and
+		 *  hyphens. Words wider than the maximum width are broken between characters. Each line is aligned
+		 *  within the maximum width, or within the widest line if there is no maximum width.
+		 *
+		 *  The layout only stores codepoints and pen positions, never atlas coordinates, so it stays valid when
+		 *  the font atlas evicts pages. TextBatch::addLayout() looks the glyphs up when drawing.
+		 *
+		 *  setText() only lays out what changed: lines before the first modified character are kept, apart
+		 *  from the line just before it whose last word may now fit or no longer fit. Updating a counter at the
+		 *  end of a label therefore costs a single line.
+		 */
+		class TextLayout
+		{
+		public:
+			//! Horizontal line alignment.
+			enum Alignment
+			{
+				ALIGN_LEFT,
+				ALIGN_CENTER,
+				ALIGN_RIGHT
+			};
+
+			//! A glyph and its pen position on the baseline, relative to the start of its line.
+			struct PositionedGlyph
+			{
+				PositionedGlyph(unsigned int _uCodepoint, float _fX)
+					: uCodepoint(_uCodepoint)
+					, fX(_fX) {}
+
+				unsigned int uCodepoint;	//!< Unicode codepoint.
+				float fX;					//!< Pen position in pixels.
+			};
+
+			//! A line of glyphs.
+			struct Line
+			{
+				unsigned int uFirstGlyph;	//!< Index of the first glyph in getGlyphs().
+				unsigned int uNumGlyphs;	//!< Number of glyphs on the line, including trailing spaces.
+				unsigned int uFirstByte;	//!< Offset of the line's first character in the text.
+				float fWidth;				//!< Width without trailing spaces in pixels.
+				float fOffsetX;				//!< Alignment offset added to every glyph's position.
+				float fBaselineY;			//!< Baseline position. The first baseline is at 0 and lines go down (negative y).
+			};
+
+			//! Creates an empty layout. fMaxWidth is the wrapping width in pixels at the font's pixel size, 0 disables wrapping.
+			static boost::shared_ptr<TextLayout> create(const boost::shared_ptr<Font>& spFont, float fMaxWidth, Alignment eAlignment);
+
+			//! Destructor.
+			~TextLayout();
+
+			//! Set the UTF-8 text. Only the lines affected by the change are laid out again.
+			void setText(const std::string& sText);
+
+			//! Get the text.
+			const std::string& getText() const { return m_sText; }
+			//! Get the font.
+			const boost::shared_ptr<Font>& getFont() const { return m_spFont; }
+			//! Get the wrapping width, 0 if wrapping is disabled.
+			float getMaxWidth() const { return m_fMaxWidth; }
+			//! Get the alignment.
+			Alignment getAlignment() const { return m_eAlignment; }
+			//! Get the glyphs of all lines.
+			const std::vector<PositionedGlyph>& getGlyphs() const { return m_aGlyphs; }
+			//! Get the lines.
+			const std::vector<Line>& getLines() const { return m_aLines; }
+			//! Get the size of the laid out text in pixels. Width is the widest line, height is number of lines times line height.
+			Vec2 getSize() const;
+			//! Get the number of glyphs positioned by the last setText(). Useful to check that updates stay incremental.
+			unsigned int getNumGlyphsLaidOut() const { return m_uNumGlyphsLaidOut; }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			TextLayout(const boost::shared_ptr<Font>& spFont, float fMaxWidth, Alignment eAlignment);
+
+		private:
+			//! Lay out the text starting at line uFirstLine, which must start at byte uFirstByte.
+			void layoutFrom(unsigned int uFirstLine, unsigned int uFirstByte);
+			//! Add a line made of the glyphs from uFirstGlyph to the end of the glyph array.
+			void addLine(unsigned int uFirstGlyph, unsigned int uFirstByte, float fWidth);
+			//! Calculate the alignment offsets of all lines.
+			void align();
+
+			boost::shared_ptr<Font> m_spFont;				//!< Font used for glyph metrics.
+			float m_fMaxWidth;								//!< Wrapping width, 0 disables wrapping.
+			Alignment m_eAlignment;							//!< Line alignment.
+			std::string m_sText;							//!< UTF-8 text.
+			std::vector<PositionedGlyph> m_aGlyphs;			//!< Glyphs of all lines.
+			std::vector<Line> m_aLines;						//!< Lines.
+			std::vector<unsigned int> m_aGlyphBytes;		//!< Text offset of every glyph, used to restart wrapping.
+			unsigned int m_uNumGlyphsLaidOut;				//!< Glyphs positioned by the last setText().
+		};
+	}
+}
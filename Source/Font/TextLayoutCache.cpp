@@ -0,0 +1,59 @@
+#include "TextLayoutCache.h"
+
+#include <Logging/Log.h>
+#include <Font/Font.h>
+#include <Helpers/Hash.h>
+
+namespace baselib { namespace font {
+
+	boost::shared_ptr<TextLayoutCache> TextLayoutCache::create(unsigned int uMaxUnusedFrames)
+	{
+		return boost::shared_ptr<TextLayoutCache>(new TextLayoutCache(uMaxUnusedFrames));
+	}
+
+	TextLayoutCache::TextLayoutCache(unsigned int uMaxUnusedFrames)
+		: m_uMaxUnusedFrames(uMaxUnusedFrames)
+		, m_uFrame(0)
+	{
+		LOG_VERBOSE << "TextLayoutCache constructor";
+	}
+
+	TextLayoutCache::~TextLayoutCache()
+	{
+		LOG_VERBOSE << "TextLayoutCache destructor";
+	}
+
+	boost::shared_ptr<const TextLayout> TextLayoutCache::get(const boost::shared_ptr<Font>& spFont, const std::string& sText, float fMaxWidth, TextLayout::Alignment eAlignment)
+	{
+		assert(spFont);
+
+		Key key;
+		key.uTextHash = hashFNV1a(sText);
+		key.pFont = spFont.get();
+		key.fMaxWidth = fMaxWidth;
+		key.iAlignment = eAlignment;
+
+		Entry& entry = m_LayoutMap[key];
+		entry.uLastUsedFrame = m_uFrame;
+		if (entry.spLayout && entry.spLayout->getText() == sText)
+			return entry.spLayout;
+
+		// New text, or a hash collision in which case the old layout is replaced
+		entry.spLayout = TextLayout::create(spFont, fMaxWidth, eAlignment);
+		entry.spLayout->setText(sText);
+		return entry.spLayout;
+	}
+
+	void TextLayoutCache::update()
+	{
+		++m_uFrame;
+		for (auto iter = m_LayoutMap.begin(); iter != m_LayoutMap.end(); )
+		{
+			if (m_uFrame - iter->second.uLastUsedFrame > m_uMaxUnusedFrames)
+				iter = m_LayoutMap.erase(iter);
+			else
+				++iter;
+		}
+	}
+
+} }
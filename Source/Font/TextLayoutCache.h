@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Font/TextLayout.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <string>
+
+namespace baselib
+{
+	namespace font
+	{
+		class Font;
+	}
+}
+
+namespace baselib
+{
+	namespace font
+	{
+		/*! @brief Keeps the layouts of recently drawn strings so that unchanged text isn't laid out every frame.
+		 *
+		 *  Layouts are keyed by a hash of the text, the font, the wrapping width and the alignment. A layout
+		 *  that hasn't been requested for a number of frames is dropped by update(). Text that changes often
+		 *  (counters, timers) should use its own TextLayout and setText() instead, which relayouts incrementally.
+		 */
+		class TextLayoutCache
+		{
+		public:
+			//! Creates a TextLayoutCache. Layouts unused for more than uMaxUnusedFrames frames are dropped.
+			static boost::shared_ptr<TextLayoutCache> create(unsigned int uMaxUnusedFrames = 60);
+
+			//! Destructor.
+			~TextLayoutCache();
+
+			//! Get the layout of a UTF-8 string, creating it if it isn't cached.
+			boost::shared_ptr<const TextLayout> get(const boost::shared_ptr<Font>& spFont, const std::string& sText, float fMaxWidth, TextLayout::Alignment eAlignment);
+
+			//! Start a new frame and drop layouts that haven't been used recently. Call once per frame.
+			void update();
+
+			//! Remove all layouts.
+			void clear() { m_LayoutMap.clear(); }
+			//! Get the number of cached layouts.
+			unsigned int getNumLayouts() const { return m_LayoutMap.size(); }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			TextLayoutCache(unsigned int uMaxUnusedFrames);
+
+		private:
+			//! Cache key. The text itself is compared on lookup so hash collisions can't return the wrong layout.
+			struct Key
+			{
+				unsigned __int64 uTextHash;	//!< Hash of the text.
+				const Font* pFont;			//!< Font the text is laid out with.
+				float fMaxWidth;			//!< Wrapping width.
+				int iAlignment;				//!< Line alignment.
+
+				bool operator==(const Key& other) const
+				{
+					return uTextHash == other.uTextHash && pFont == other.pFont && fMaxWidth == other.fMaxWidth && iAlignment == other.iAlignment;
+				}
+
+				friend std::size_t hash_value(const Key& key) { return std::size_t(key.uTextHash ^ (key.uTextHash >> 32)); }
+			};
+
+			//! A cached layout.
+			struct Entry
+			{
+				boost::shared_ptr<TextLayout> spLayout;	//!< The layout.
+				unsigned int uLastUsedFrame;			//!< Last frame the layout was requested.
+			};
+
+			unsigned int m_uMaxUnusedFrames;				//!< Frames a layout is kept without being used.
+			unsigned int m_uFrame;							//!< Frame counter, advanced by update().
+			boost::unordered_map<Key, Entry> m_LayoutMap;	//!< Cached layouts.
+		};
+	}
+}
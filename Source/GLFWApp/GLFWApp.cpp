@@ -303,4 +303,9 @@ namespace baselib {
 		return glfwGetTime();
 	}
 
+	void GLFWApp::getWindowSize(int& iWidth, int& iHeight) const
+	{
+		glfwGetWindowSize(m_pWindow, &iWidth, &iHeight);
+	}
+
 }
\ No newline at end of file
@@ -34,6 +34,13 @@ namespace baselib
 		//! Return time elapsed from application start.
 		double GetTime() const;
 
+		//! Get the X coordinate of the mouse in pixels relative to the left of the window.
+		int getMouseX() const { return m_iMouseX; }
+		//! Get the Y coordinate of the mouse in pixels relative to the top of the window.
+		int getMouseY() const { return m_iMouseY; }
+		//! Get the size of the window in the coordinates of the mouse, which can differ from the frame buffer size.
+		void getWindowSize(int& iWidth, int& iHeight) const;
+
 		//! Set window title text.
 		//void setWindowTitle(const std::string& s) { }
 		//! Getter for setWindowTitle().
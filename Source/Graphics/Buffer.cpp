@@ -0,0 +1,99 @@
+#include "Buffer.h"
+
+#include <GL/glew.h>
+#include <Logging/Log.h>
+
+namespace baselib { namespace graphics {
+
+	namespace
+	{
+		unsigned int getGLTarget(Buffer::Target eTarget)
+		{
+			switch (eTarget)
+			{
+			case Buffer::SHADER_STORAGE: return GL_SHADER_STORAGE_BUFFER; break;
+			case Buffer::UNIFORM: return GL_UNIFORM_BUFFER; break;
+			case Buffer::ATOMIC_COUNTER: return GL_ATOMIC_COUNTER_BUFFER; break;
+			case Buffer::DRAW_INDIRECT: return GL_DRAW_INDIRECT_BUFFER; break;
+			case Buffer::DISPATCH_INDIRECT: return GL_DISPATCH_INDIRECT_BUFFER; break;
+			case Buffer::PARAMETER: return GL_PARAMETER_BUFFER_ARB; break;
+			default: LOG_ERROR << "Invalid buffer target."; assert(false); return 0; break;
+			}
+		}
+
+		bool isIndexedTarget(Buffer::Target eTarget)
+		{
+			return eTarget != Buffer::DRAW_INDIRECT && eTarget != Buffer::DISPATCH_INDIRECT && eTarget != Buffer::PARAMETER;
+		}
+
+		unsigned int getGLBufferUsage(Buffer::Usage eUsage)
+		{
+			switch (eUsage)
+			{
+			case Buffer::USAGE_STATIC: return GL_STATIC_DRAW; break;
+			case Buffer::USAGE_DYNAMIC: return GL_DYNAMIC_DRAW; break;
+			case Buffer::USAGE_GPU_ONLY: return GL_DYNAMIC_COPY; break;
+			case Buffer::USAGE_READBACK: return GL_DYNAMIC_READ; break;
+			default: LOG_ERROR << "Invalid buffer usage."; assert(false); return 0; break;
+			}
+		}
+	}
+
+	Buffer::Buffer(unsigned int uID, unsigned int uSize, Usage eUsage)
+		: m_uID(uID)
+		, m_uSize(uSize)
+		, m_eUsage(eUsage)
+	{
+		LOG_VERBOSE << "Buffer constructor";
+	}
+
+	Buffer::~Buffer()
+	{
+		LOG_VERBOSE << "Buffer destructor";
+		glDeleteBuffers(1, &m_uID);
+	}
+
+	void Buffer::bindBase(Target eTarget, unsigned int uIndex)
+	{
+		if (isIndexedTarget(eTarget))
+			glBindBufferBase(getGLTarget(eTarget), uIndex, m_uID);
+		else
+			glBindBuffer(getGLTarget(eTarget), m_uID);
+	}
+
+	void Buffer::bindRange(Target eTarget, unsigned int uIndex, unsigned int uOffset, unsigned int uSize)
+	{
+		assert(uOffset + uSize <= m_uSize);
+		assert(isIndexedTarget(eTarget));
+		glBindBufferRange(getGLTarget(eTarget), uIndex, m_uID, uOffset, uSize);
+	}
+
+	void Buffer::update(unsigned int uOffset, unsigned int uSize, const void* pData)
+	{
+		assert(uOffset + uSize <= m_uSize);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_uID);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, uOffset, uSize, pData);
+	}
+
+	void Buffer::clear(unsigned int uValue)
+	{
+		assert(m_uSize % sizeof(unsigned int) == 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_uID);
+		glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &uValue);
+	}
+
+	void Buffer::resize(unsigned int uSize)
+	{
+		m_uSize = uSize;
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_uID);
+		glBufferData(GL_COPY_WRITE_BUFFER, uSize, NULL, getGLBufferUsage(m_eUsage));
+	}
+
+	void Buffer::read(unsigned int uOffset, unsigned int uSize, void* pData) const
+	{
+		assert(uOffset + uSize <= m_uSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, m_uID);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, uOffset, uSize, pData);
+	}
+
+} }
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		/*! @brief Wrapper for a hardware buffer that shaders read and write directly.
+		 *
+		 *  Used for shader storage buffers, uniform buffers, atomic counters and the arguments of indirect
+		 *  draws and dispatches. Contents are uploaded with update() and read back with read(), both go
+		 *  through the copy binding points so they never disturb the buffers bound for rendering.
+		 *
+		 *  Writes made by a shader are only visible to later commands after Renderer::memoryBarrier() with
+		 *  the bit matching how the buffer is used next.
+		 */
+		class Buffer
+		{
+		public:
+			friend class Renderer;
+
+			//! How the contents are expected to be used, a hint for where the driver places the buffer.
+			enum Usage
+			{
+				USAGE_STATIC,	//!< Uploaded once, read by shaders.
+				USAGE_DYNAMIC,	//!< Uploaded often, read by shaders.
+				USAGE_GPU_ONLY,	//!< Written and read by shaders only.
+				USAGE_READBACK	//!< Written by shaders, read back by the CPU.
+			};
+
+			//! Indexed binding points a buffer can be bound to with bindBase().
+			enum Target
+			{
+				SHADER_STORAGE,		//!< GLSL buffer blocks.
+				UNIFORM,			//!< GLSL uniform blocks.
+				ATOMIC_COUNTER,		//!< GLSL atomic_uint counters.
+				DRAW_INDIRECT,		//!< Arguments of indirect draws. Not indexed, uIndex is ignored.
+				DISPATCH_INDIRECT,	//!< Arguments of Renderer::dispatchIndirect(). Not indexed, uIndex is ignored.
+				PARAMETER			//!< Draw count of indirect draws. Not indexed, uIndex is ignored.
+			};
+
+			//! Destructor.
+			virtual ~Buffer();
+
+			//! Bind the whole buffer to an indexed binding point, e.g. the binding of a GLSL buffer block.
+			void bindBase(Target eTarget, unsigned int uIndex);
+			//! Bind part of the buffer to an indexed binding point. uOffset must be aligned as the target requires.
+			void bindRange(Target eTarget, unsigned int uIndex, unsigned int uOffset, unsigned int uSize);
+
+			//! Upload uSize bytes from pData at uOffset.
+			void update(unsigned int uOffset, unsigned int uSize, const void* pData);
+			//! Set every 32 bit word of the buffer to uValue, without a round trip through client memory.
+			void clear(unsigned int uValue = 0);
+			//! Reallocate the buffer with a new size. The contents are lost.
+			void resize(unsigned int uSize);
+
+			//! Read uSize bytes at uOffset into pData. Waits for the GPU to finish writing the buffer.
+			void read(unsigned int uOffset, unsigned int uSize, void* pData) const;
+
+			//! Get the buffer object ID.
+			unsigned int getID() const { return m_uID; }
+			//! Get the size in bytes.
+			unsigned int getSize() const { return m_uSize; }
+			//! Get the usage hint.
+			Usage getUsage() const { return m_eUsage; }
+
+		protected:
+			//! Protected constructor - must be created by Renderer.
+			Buffer(unsigned int uID, unsigned int uSize, Usage eUsage);
+
+		private:
+			unsigned int m_uID;		//!< Buffer object ID.
+			unsigned int m_uSize;	//!< Size in bytes.
+			Usage m_eUsage;			//!< Usage hint the storage was allocated with.
+		};
+	}
+}
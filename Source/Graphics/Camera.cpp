@@ -4,6 +4,78 @@
 
 namespace baselib { namespace graphics {
 
+	Frustum::Frustum()
+	{
+		set(Mat4());
+	}
+
+	Frustum::Frustum(const Mat4& mViewProjection)
+	{
+		set(mViewProjection);
+	}
+
+	void Frustum::set(const Mat4& mViewProjection)
+	{
+		// Gribb/Hartmann: each plane is the last row of the matrix plus or minus one of the others.
+		// glm matrices are column major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+		m_mViewProjection = mViewProjection;
+		const Mat4& m = mViewProjection;
+		Vec4 avRows[4];
+		for (int i = 0; i < 4; ++i)
+			avRows[i] = Vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+		m_avPlanes[PLANE_LEFT] = avRows[3] + avRows[0];
+		m_avPlanes[PLANE_RIGHT] = avRows[3] - avRows[0];
+		m_avPlanes[PLANE_BOTTOM] = avRows[3] + avRows[1];
+		m_avPlanes[PLANE_TOP] = avRows[3] - avRows[1];
+		m_avPlanes[PLANE_NEAR] = avRows[3] + avRows[2];
+		m_avPlanes[PLANE_FAR] = avRows[3] - avRows[2];
+
+		for (int i = 0; i < NUM_PLANES; ++i)
+		{
+			float fLength = glm::length(Vec3(m_avPlanes[i]));
+			if (fLength > EPSILON)
+				m_avPlanes[i] /= fLength;
+		}
+	}
+
+	bool Frustum::intersects(const AABB& bounds) const
+	{
+		if (bounds.isEmpty())
+			return false;
+
+		// The box is outside if it is completely behind any plane. Cull.comp does the same test on the GPU.
+		Vec3 vCenter = bounds.getCenter();
+		Vec3 vExtents = bounds.getExtents();
+		for (int i = 0; i < NUM_PLANES; ++i)
+		{
+			Vec3 vNormal(m_avPlanes[i]);
+			float fDistance = glm::dot(vNormal, vCenter) + m_avPlanes[i].w;
+			float fRadius = glm::dot(glm::abs(vNormal), vExtents);
+			if (fDistance + fRadius < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	bool Frustum::contains(const AABB& bounds) const
+	{
+		if (bounds.isEmpty())
+			return false;
+
+		Vec3 vCenter = bounds.getCenter();
+		Vec3 vExtents = bounds.getExtents();
+		for (int i = 0; i < NUM_PLANES; ++i)
+		{
+			Vec3 vNormal(m_avPlanes[i]);
+			float fDistance = glm::dot(vNormal, vCenter) + m_avPlanes[i].w;
+			float fRadius = glm::dot(glm::abs(vNormal), vExtents);
+			if (fDistance - fRadius < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
 	boost::shared_ptr<Camera> Camera::create()
 	{
 		return boost::shared_ptr<Camera>(new Camera());
@@ -21,4 +93,32 @@ namespace baselib { namespace graphics {
 		LOG_VERBOSE << "Camera destructor";
 	}
 
+	void Camera::setViewMatrix(const Mat4& mView)
+	{
+		m_mView = mView;
+		m_Frustum.set(m_mProjection * m_mView);
+	}
+
+	void Camera::setProjectionMatrix(const Mat4& mProjection)
+	{
+		m_mProjection = mProjection;
+		m_Frustum.set(m_mProjection * m_mView);
+	}
+
+	Ray Camera::getRay(int iX, int iY, int iWidth, int iHeight) const
+	{
+		// Window coordinates start at the top left, NDC at the bottom left
+		Vec2 vNDC((iX + 0.5f) / iWidth * 2.0f - 1.0f, 1.0f - (iY + 0.5f) / iHeight * 2.0f);
+		return getRay(vNDC);
+	}
+
+	Ray Camera::getRay(const Vec2& vNDC) const
+	{
+		Mat4 mInverse = glm::inverse(m_mProjection * m_mView);
+		Vec4 vNear = mInverse * Vec4(vNDC, -1.0f, 1.0f);
+		Vec4 vFar = mInverse * Vec4(vNDC, 1.0f, 1.0f);
+		Vec3 vOrigin = Vec3(vNear) / vNear.w;
+		return Ray(vOrigin, glm::normalize(Vec3(vFar) / vFar.w - vOrigin));
+	}
+
 } }
\ No newline at end of file
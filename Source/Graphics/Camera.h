@@ -1,20 +1,56 @@
 #pragma once
 
 #include <Math/Math.h>
+#include <Math/AABB.h>
+#include <Math/Ray.h>
 #include <Graphics/Spatial.h>
 
 namespace baselib 
 {
 	namespace graphics
 	{
-		/*! @brief Frustum  
+		/*! @brief The six planes bounding the volume a camera sees.
 		 *
+		 *  Planes are extracted from a view projection matrix and point inwards, so a point p is inside
+		 *  a plane if dot(plane.xyz, p) + plane.w >= 0.
 		 */
 		class Frustum
 		{
 		public:
-			Frustum() {}
+			//! Frustum planes.
+			enum Plane
+			{
+				PLANE_LEFT,
+				PLANE_RIGHT,
+				PLANE_BOTTOM,
+				PLANE_TOP,
+				PLANE_NEAR,
+				PLANE_FAR,
+				NUM_PLANES
+			};
+
+			//! Constructs the frustum of an identity view projection, i.e. the clip space cube.
+			Frustum();
+			//! Constructs the frustum of a view projection matrix.
+			explicit Frustum(const Mat4& mViewProjection);
 			~Frustum() {}
+
+			//! Extract the planes from a view projection matrix.
+			void set(const Mat4& mViewProjection);
+
+			//! Does the box intersect the frustum? Conservative, boxes near the corners may pass although they are outside.
+			bool intersects(const AABB& bounds) const;
+			//! Is the box completely inside the frustum?
+			bool contains(const AABB& bounds) const;
+
+			//! Get a plane.
+			const Vec4& getPlane(Plane ePlane) const { return m_avPlanes[ePlane]; }
+			//! Get the view projection matrix the planes were extracted from.
+			const Mat4& getViewProjection() const { return m_mViewProjection; }
+
+		private:
+			Vec4 m_avPlanes[NUM_PLANES];	//!< Normalized planes, normals point inwards.
+			Mat4 m_mViewProjection;			//!< View projection matrix.
 		};
 
 		/*! @brief Camera 
@@ -29,13 +65,22 @@ namespace baselib
 			//! Destructor.
 			virtual ~Camera();
 
+			//! Set the view matrix.
+			void setViewMatrix(const Mat4& mView);
 			//! Get the view matrix.
 			const Mat4& getViewMatrix() const { return m_mView; }
+			//! Set the projection matrix.
+			void setProjectionMatrix(const Mat4& mProjection);
 			//! Get the projection matrix.
 			const Mat4& getProjectionMatrix() const { return m_mProjection; }
 			//! Get the camera frustum.
 			const Frustum& getFrustum() const { return m_Frustum; }
 
+			//! Get the world space ray through a pixel, e.g. under the mouse. The origin is on the near plane, the direction normalized.
+			Ray getRay(int iX, int iY, int iWidth, int iHeight) const;
+			//! Get the world space ray through a point in normalized device coordinates.
+			Ray getRay(const Vec2& vNDC) const;
+
 		protected:
 			//! Protected constructor - must be created by static create().
 			Camera();
@@ -0,0 +1,221 @@
+#include "ComputeCuller.h"
+
+#include <Logging/Log.h>
+#include <Graphics/Renderer.h>
+#include <Graphics/Buffer.h>
+#include <Graphics/Camera.h>
+#include <Graphics/Visual.h>
+#include <Graphics/Material.h>
+#include <Graphics/Shader.h>
+#include <Graphics/ShaderObject.h>
+#include <Graphics/ShaderPipeline.h>
+#include <Graphics/VertexList.h>
+#include <Animation/Animator.h>
+#include <algorithm>
+#include <iterator>
+
+namespace baselib { namespace graphics {
+
+	namespace
+	{
+		// Must match local_size_x in Cull.comp
+		const unsigned int CULL_GROUP_SIZE = 64;
+
+		const char* PLANE_UNIFORMS[Frustum::NUM_PLANES] = { "avPlanes[0]", "avPlanes[1]", "avPlanes[2]", "avPlanes[3]", "avPlanes[4]", "avPlanes[5]" };
+	}
+
+	boost::shared_ptr<ComputeCuller> ComputeCuller::create(const boost::shared_ptr<Renderer>& spRenderer)
+	{
+		assert(spRenderer);
+		if (!spRenderer->hasComputeShaders())
+		{
+			LOG_ERROR << "GPU culling requires compute shaders";
+			assert(false);
+		}
+		return boost::shared_ptr<ComputeCuller>(new ComputeCuller(spRenderer));
+	}
+
+	ComputeCuller::ComputeCuller(const boost::shared_ptr<Renderer>& spRenderer)
+		: m_spRenderer(spRenderer)
+		, m_bCompact(spRenderer->hasIndirectDrawCount())
+	{
+		LOG_VERBOSE << "ComputeCuller constructor";
+
+		std::vector<boost::shared_ptr<ShaderObject>> aShaderObjects;
+		aShaderObjects.push_back(ShaderObject::load("../Data/Shaders/Cull.comp"));
+		m_spCullPipeline = ShaderPipeline::create("Cull", aShaderObjects);
+		m_spCullShader = m_spCullPipeline->createInstance();
+
+		for (unsigned int i = 0; i < Frustum::NUM_PLANES; ++i)
+			m_aiPlaneUniforms[i] = m_spCullShader->getUniform(PLANE_UNIFORMS[i]);
+		m_iNumObjectsUniform = m_spCullShader->getUniform("iNumObjects");
+		m_iCompactUniform = m_spCullShader->getUniform("iCompact");
+
+		if (!m_bCompact)
+			LOG_INFO << "GL_ARB_indirect_parameters isn't supported, culled draws are submitted with an instance count of 0";
+	}
+
+	ComputeCuller::~ComputeCuller()
+	{
+		LOG_VERBOSE << "ComputeCuller destructor";
+	}
+
+	void ComputeCuller::setVisuals(const std::vector<Visual*>& apVisuals)
+	{
+		// Visuals of a batch must be adjacent, their commands share a range of the command buffer.
+		// Skinned visuals are batched by animator too, a draw can only have one palette bound.
+		m_apVisuals = apVisuals;
+		std::stable_sort(m_apVisuals.begin(), m_apVisuals.end(), [](const Visual* pLHS, const Visual* pRHS) {
+			if (pLHS->getGeometry() != pRHS->getGeometry())
+				return pLHS->getGeometry() < pRHS->getGeometry();
+			if (pLHS->getMaterial() != pRHS->getMaterial())
+				return pLHS->getMaterial() < pRHS->getMaterial();
+			return pLHS->getAnimator() < pRHS->getAnimator();
+		});
+
+		m_aBatches.clear();
+		m_aObjects.resize(m_apVisuals.size());
+		for (unsigned int i = 0; i < m_apVisuals.size(); ++i)
+		{
+			const Visual* pVisual = m_apVisuals[i];
+			if (m_aBatches.empty() || m_aBatches.back().spGeometry != pVisual->getGeometry() || m_aBatches.back().spMaterial != pVisual->getMaterial() ||
+				m_aBatches.back().spAnimator != pVisual->getAnimator())
+			{
+				Batch batch;
+				batch.spGeometry = pVisual->getGeometry();
+				batch.spMaterial = pVisual->getMaterial();
+				batch.spAnimator = pVisual->getAnimator();
+				batch.uFirst = i;
+				batch.uCount = 0;
+				m_aBatches.push_back(batch);
+			}
+			Batch& batch = m_aBatches.back();
+			batch.uCount += 1;
+
+			const AABB& bounds = batch.spGeometry->getBounds();
+			Object& object = m_aObjects[i];
+			object.mWorld = pVisual->getWorldMatrix();
+			object.vBoundsMin = Vec4(bounds.vMin, 1.0f);
+			object.vBoundsMax = Vec4(bounds.vMax, 1.0f);
+			object.uBatch = m_aBatches.size() - 1;
+			object.uFirstCommand = batch.uFirst;
+			object.uCount = batch.spGeometry->getVertexList()->getNumIndices();
+			object.uFirstIndex = 0;
+		}
+
+		LOG_INFO << "GPU culling " << m_apVisuals.size() << " visuals in " << m_aBatches.size() << " batches";
+		if (m_apVisuals.empty())
+			return;
+
+		m_spObjects = m_spRenderer->createBuffer(m_aObjects.size() * sizeof(Object), Buffer::USAGE_DYNAMIC, &m_aObjects[0]);
+		m_spCommands = m_spRenderer->createBuffer(m_apVisuals.size() * sizeof(DrawIndexedIndirectCommand), Buffer::USAGE_GPU_ONLY);
+		m_spCounts = m_spRenderer->createBuffer(m_aBatches.size() * sizeof(unsigned int), Buffer::USAGE_GPU_ONLY);
+	}
+
+	void ComputeCuller::updateTransforms()
+	{
+		if (m_apVisuals.empty())
+			return;
+
+		for (unsigned int i = 0; i < m_apVisuals.size(); ++i)
+			m_aObjects[i].mWorld = m_apVisuals[i]->getWorldMatrix();
+		m_spObjects->update(0, m_aObjects.size() * sizeof(Object), &m_aObjects[0]);
+	}
+
+	void ComputeCuller::cull(const Frustum& frustum)
+	{
+		if (m_apVisuals.empty())
+			return;
+
+		if (m_bCompact)
+			m_spCounts->clear(0);
+
+		m_spCullShader->bind();
+		for (unsigned int i = 0; i < Frustum::NUM_PLANES; ++i)
+			m_spCullShader->setUniform(m_aiPlaneUniforms[i], frustum.getPlane(Frustum::Plane(i)));
+		m_spCullShader->setUniform(m_iNumObjectsUniform, int(m_apVisuals.size()));
+		m_spCullShader->setUniform(m_iCompactUniform, m_bCompact ? 1 : 0);
+
+		m_spObjects->bindBase(Buffer::SHADER_STORAGE, OBJECT_BINDING);
+		m_spCommands->bindBase(Buffer::SHADER_STORAGE, COMMAND_BINDING);
+		m_spCounts->bindBase(Buffer::SHADER_STORAGE, COUNT_BINDING);
+
+		m_spRenderer->dispatch((m_apVisuals.size() + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE);
+
+		// The commands and counts are read as indirect draw arguments next
+		m_spRenderer->memoryBarrier(Renderer::BARRIER_COMMAND);
+	}
+
+	void ComputeCuller::render()
+	{
+		for (unsigned int i = 0; i < m_aBatches.size(); ++i)
+		{
+			const Batch& batch = m_aBatches[i];
+			if (!batch.spMaterial->isReady())
+				continue;
+
+			batch.spMaterial->bind();
+			if (batch.spAnimator)
+				batch.spAnimator->bindPalette();
+			batch.spGeometry->bind();
+			if (m_bCompact)
+				m_spRenderer->drawIndexedIndirect(batch.spGeometry->getPrimitiveType(), m_spCommands, batch.uFirst, batch.uCount, m_spCounts, i * sizeof(unsigned int));
+			else
+				m_spRenderer->drawIndexedIndirect(batch.spGeometry->getPrimitiveType(), m_spCommands, batch.uFirst, batch.uCount);
+			batch.spGeometry->unbind();
+		}
+	}
+
+	void ComputeCuller::getVisible(std::vector<Visual*>& apVisible) const
+	{
+		apVisible.clear();
+		if (m_apVisuals.empty())
+			return;
+
+		m_spRenderer->memoryBarrier(Renderer::BARRIER_BUFFER_UPDATE);
+
+		std::vector<DrawIndexedIndirectCommand> aCommands(m_apVisuals.size());
+		m_spCommands->read(0, aCommands.size() * sizeof(DrawIndexedIndirectCommand), &aCommands[0]);
+		std::vector<unsigned int> auCounts(m_aBatches.size());
+		m_spCounts->read(0, auCounts.size() * sizeof(unsigned int), &auCounts[0]);
+
+		for (unsigned int i = 0; i < m_aBatches.size(); ++i)
+		{
+			const Batch& batch = m_aBatches[i];
+			unsigned int uNumDraws = m_bCompact ? std::min(auCounts[i], batch.uCount) : batch.uCount;
+			for (unsigned int j = batch.uFirst; j < batch.uFirst + uNumDraws; ++j)
+			{
+				if (aCommands[j].uInstanceCount > 0)
+					apVisible.push_back(m_apVisuals[aCommands[j].uBaseInstance]);
+			}
+		}
+	}
+
+	bool ComputeCuller::validate(const Frustum& frustum) const
+	{
+		std::vector<Visual*> apVisible;
+		getVisible(apVisible);
+
+		std::vector<Visual*> apReference;
+		for (unsigned int i = 0; i < m_apVisuals.size(); ++i)
+		{
+			if (frustum.intersects(m_apVisuals[i]->getWorldBounds()))
+				apReference.push_back(m_apVisuals[i]);
+		}
+
+		// Compaction order depends on thread scheduling
+		std::sort(apVisible.begin(), apVisible.end());
+		std::sort(apReference.begin(), apReference.end());
+		if (apVisible == apReference)
+			return true;
+
+		// Boxes touching a plane may be classified differently due to floating point differences
+		std::vector<Visual*> apDifferent;
+		std::set_symmetric_difference(apVisible.begin(), apVisible.end(), apReference.begin(), apReference.end(), std::back_inserter(apDifferent));
+		LOG_WARNING << "GPU culling differs from the CPU reference for " << apDifferent.size() << " visuals (GPU: " << apVisible.size() << " visible, CPU: " << apReference.size() << ")";
+		for (unsigned int i = 0; i < apDifferent.size(); ++i)
+			LOG_VERBOSE << "Culling mismatch: " << apDifferent[i]->getName();
+		return false;
+	}
+
+} }
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		class Renderer;
+		class Buffer;
+		class Geometry;
+		class Material;
+		class Shader;
+		class ShaderPipeline;
+		class Visual;
+		class Frustum;
+	}
+
+	namespace animation
+	{
+		class Animator;
+	}
+}
+
+namespace baselib
+{
+	namespace graphics
+	{
+		/*! @brief Frustum culls visuals on the GPU and draws the visible ones with indirect draws.
+		 *
+		 *  setVisuals() groups the visuals that share geometry, material and animator into batches and uploads each visual's world
+		 *  matrix, geometry bounds and draw arguments to a shader storage buffer. cull() runs Cull.comp with one thread
+		 *  per visual, which transforms the bounds, tests them against the frustum and appends the draws of visible
+		 *  visuals to their batch's range of an indirect command buffer, counting them with atomics. render() submits
+		 *  each batch with a single indirect draw, taking the number of draws from the GPU when GL_ARB_indirect_parameters
+		 *  is supported. Without it culled draws keep their slot with an instance count of 0.
+		 *
+		 *  The CPU doesn't touch the visuals per frame. Call updateTransforms() after they moved and setVisuals() when the
+		 *  set of visuals changes. The base instance of each draw is the visual's index in the object buffer, which stays
+		 *  bound to OBJECT_BINDING, so vertex shaders can fetch the world matrix with gl_BaseInstanceARB.
+		 *  Skinned visuals only share a batch with visuals of the same Animator, whose palette render() binds before the draw.
+		 *
+		 *  validate() reads the result back and compares it with Frustum::intersects(), which VisualCollector uses on the
+		 *  CPU. Visuals are referenced by raw pointer, as in VisualCollector, and must outlive the culler or the next setVisuals().
+		 */
+		class ComputeCuller
+		{
+		public:
+			//! Shader storage binding of the per visual data.
+			static const unsigned int OBJECT_BINDING = 0;
+			//! Shader storage binding of the indirect draw commands.
+			static const unsigned int COMMAND_BINDING = 1;
+			//! Shader storage binding of the per batch draw counts.
+			static const unsigned int COUNT_BINDING = 2;
+
+			//! Creates a ComputeCuller. The renderer must support compute shaders.
+			static boost::shared_ptr<ComputeCuller> create(const boost::shared_ptr<Renderer>& spRenderer);
+
+			//! Destructor.
+			~ComputeCuller();
+
+			//! Set the visuals to cull and upload their data.
+			void setVisuals(const std::vector<Visual*>& apVisuals);
+			//! Upload the world matrices of the visuals again.
+			void updateTransforms();
+
+			//! Cull the visuals against a frustum, writing the draw commands for render().
+			void cull(const Frustum& frustum);
+			//! Draw the visuals that passed the last cull(). Batches whose material isn't ready are skipped.
+			void render();
+
+			//! Read back the visuals that passed the last cull(). Stalls until the GPU has finished culling.
+			void getVisible(std::vector<Visual*>& apVisible) const;
+			//! Compare the result of the last cull() with culling on the CPU and log the differences. Returns true if they match.
+			bool validate(const Frustum& frustum) const;
+
+			//! Get the number of visuals.
+			unsigned int getNumVisuals() const { return m_apVisuals.size(); }
+			//! Get the number of batches, i.e. indirect draws per frame.
+			unsigned int getNumBatches() const { return m_aBatches.size(); }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			ComputeCuller(const boost::shared_ptr<Renderer>& spRenderer);
+
+		private:
+			//! Visuals sharing geometry, material and animator, drawn with one indirect draw.
+			struct Batch
+			{
+				boost::shared_ptr<Geometry> spGeometry;				//!< Geometry of every visual in the batch.
+				boost::shared_ptr<Material> spMaterial;				//!< Material of every visual in the batch.
+				boost::shared_ptr<animation::Animator> spAnimator;	//!< Animator skinning every visual in the batch, null if rigid.
+				unsigned int uFirst;								//!< Index of the batch's first visual and command slot.
+				unsigned int uCount;								//!< Number of visuals.
+			};
+
+			//! Per visual data as Cull.comp reads it (std430).
+			struct Object
+			{
+				Mat4 mWorld;				//!< World transform.
+				Vec4 vBoundsMin;			//!< Geometry bounds minimum.
+				Vec4 vBoundsMax;			//!< Geometry bounds maximum.
+				unsigned int uBatch;		//!< Batch index, selects the draw counter.
+				unsigned int uFirstCommand;	//!< First command slot of the batch.
+				unsigned int uCount;		//!< Number of indices to draw.
+				unsigned int uFirstIndex;	//!< First index to draw.
+			};
+
+			boost::shared_ptr<Renderer> m_spRenderer;				//!< Renderer used to dispatch and draw.
+			boost::shared_ptr<ShaderPipeline> m_spCullPipeline;		//!< Cull.comp pipeline.
+			boost::shared_ptr<Shader> m_spCullShader;				//!< Cull.comp instance.
+			int m_aiPlaneUniforms[6];								//!< Frustum plane uniforms.
+			int m_iNumObjectsUniform;								//!< Number of visuals uniform.
+			int m_iCompactUniform;									//!< Compaction switch uniform.
+			bool m_bCompact;										//!< Compact the draws and read the count from the GPU?
+			std::vector<Visual*> m_apVisuals;						//!< Visuals sorted by batch.
+			std::vector<Batch> m_aBatches;							//!< Batches in command buffer order.
+			std::vector<Object> m_aObjects;							//!< CPU copy of the object buffer.
+			boost::shared_ptr<Buffer> m_spObjects;					//!< Per visual data.
+			boost::shared_ptr<Buffer> m_spCommands;					//!< Indirect draw commands, one slot per visual.
+			boost::shared_ptr<Buffer> m_spCounts;					//!< Number of visible draws per batch.
+		};
+	}
+}
@@ -0,0 +1,60 @@
+#include "DynamicGeometry.h"
+
+#include <GL/glew.h>
+#include <Logging/Log.h>
+#include <Graphics/VertexList.h>
+
+namespace baselib { namespace graphics {
+
+	DynamicGeometry::DynamicGeometry(unsigned int uVAO, unsigned int uVBO, unsigned int uIB, PrimitiveType ePrimitiveType, const boost::shared_ptr<VertexListInterface>& spVertexList)
+		: Geometry(uVAO, ePrimitiveType, spVertexList)
+		, m_uVBO(uVBO)
+		, m_uIB(uIB)
+		, m_uVertexCapacity(0)
+		, m_uIndexCapacity(0)
+	{
+		LOG_VERBOSE << "DynamicGeometry constructor";
+	}
+
+	DynamicGeometry::~DynamicGeometry()
+	{
+		LOG_VERBOSE << "DynamicGeometry destructor";
+		glDeleteBuffers(1, &m_uVBO);
+		glDeleteBuffers(1, &m_uIB);
+	}
+
+	namespace
+	{
+		// Stream data into a buffer, growing the storage if required and orphaning it otherwise.
+		void streamBuffer(unsigned int uTarget, unsigned int uBuffer, unsigned int uSize, const void* pData, unsigned int& uCapacity)
+		{
+			if (uSize == 0)
+				return;
+
+			glBindBuffer(uTarget, uBuffer);
+			if (uSize > uCapacity)
+			{
+				uCapacity = uSize + uSize/2;
+				glBufferData(uTarget, uCapacity, NULL, GL_STREAM_DRAW);
+			}
+			else
+			{
+				glBufferData(uTarget, uCapacity, NULL, GL_STREAM_DRAW); // Orphan
+			}
+			glBufferSubData(uTarget, 0, uSize, pData);
+		}
+	}
+
+	void DynamicGeometry::update()
+	{
+		auto spVertexList = getVertexList();
+
+		// The element array binding is VAO state so bind the VAO before touching the index buffer
+		bind();
+		streamBuffer(GL_ARRAY_BUFFER, m_uVBO, spVertexList->getVertexBufferSize(), spVertexList->getVertexBufferData(), m_uVertexCapacity);
+		streamBuffer(GL_ELEMENT_ARRAY_BUFFER, m_uIB, spVertexList->getIndexBufferSize(), spVertexList->getIndexBufferData(), m_uIndexCapacity);
+		unbind();
+		invalidateBounds();
+	}
+
+} }
\ No newline at end of file
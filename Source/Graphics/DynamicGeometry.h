@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Graphics/Geometry.h>
+
+namespace baselib 
+{
+	namespace graphics
+	{
+		/*! @brief Contains the hardware buffers for geometry that is rewritten frequently (e.g. every frame).
+		 *
+		 *  The vertex list is modified in place and update() streams it to the GPU. The buffers only 
+		 *  grow; when the data fits in the existing storage the old storage is orphaned so the driver 
+		 *  doesn't have to wait for draws that still use it.
+		 */
+		class DynamicGeometry : public Geometry
+		{
+		public:
+			friend class Renderer;
+
+			//! Destructor.
+			virtual ~DynamicGeometry();
+
+			//! Upload the current contents of the vertex list.
+			void update();
+		
+			//! Get the vertex buffer i.e. VBO.
+			unsigned int getVBO() const { return m_uVBO; }
+			//! Get the index buffer.
+			unsigned int getIB() const { return m_uIB; }
+
+		protected:
+			//! Protected constructor - must be created by Renderer.
+			DynamicGeometry(unsigned int uVAO, unsigned int uVBO, unsigned int uIB, PrimitiveType ePrimitiveType, const boost::shared_ptr<VertexListInterface>& spVertexList);
+
+		private:
+			unsigned int m_uVBO;				 //!< The geometry VBO - Vertex buffer object
+			unsigned int m_uIB;					 //!< The geometry index buffer.
+			unsigned int m_uVertexCapacity;		 //!< Size of the vertex buffer storage in bytes.
+			unsigned int m_uIndexCapacity;		 //!< Size of the index buffer storage in bytes.
+
+		};
+	}
+}
\ No newline at end of file
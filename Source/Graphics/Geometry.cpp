@@ -2,6 +2,9 @@
 
 #include <GL/glew.h>
 #include <Logging/Log.h>
+#include <boost/shared_ptr.hpp>
+#include <Graphics/VertexList.h>
+#include <Graphics/MeshBVH.h>
 
 namespace baselib { namespace graphics {
 
@@ -9,6 +12,7 @@ namespace baselib { namespace graphics {
 		: m_uVAO(uVAO)
 		, m_ePrimitiveType(ePrimitiveType)
 		, m_spVertexList(spVertexList)
+		, m_bBoundsValid(false)
 	{
 		LOG_VERBOSE << "Geometry constructor";
 	}
@@ -29,4 +33,61 @@ namespace baselib { namespace graphics {
 		glBindVertexArray(0);
 	}
 
+	const AABB& Geometry::getBounds() const
+	{
+		if (m_bBoundsValid)
+			return m_Bounds;
+		m_bBoundsValid = true;
+
+		std::vector<Vec3> avPositions;
+		getPositions(avPositions);
+
+		m_Bounds = AABB();
+		for (unsigned int i = 0; i < avPositions.size(); ++i)
+			m_Bounds.expand(avPositions[i]);
+		return m_Bounds;
+	}
+
+	bool Geometry::getPositions(std::vector<Vec3>& avPositions) const
+	{
+		avPositions.clear();
+
+		// Find the position attribute
+		const VertexAttribute* pPosition = NULL;
+		const auto& aAttributes = m_spVertexList->getVertexLayout()->getAttributes();
+		for (unsigned int i = 0; i < aAttributes.size(); ++i)
+		{
+			if (aAttributes[i].sName == "position")
+				pPosition = &aAttributes[i];
+		}
+
+		if (!pPosition || pPosition->eType != TYPE_FLOAT || pPosition->iNumElements < 2)
+			return false;
+
+		const unsigned char* pVertices = reinterpret_cast<const unsigned char*>(m_spVertexList->getVertexBufferData());
+		int iVertexSize = m_spVertexList->getVertexSize();
+		avPositions.resize(m_spVertexList->getNumVertices());
+		for (unsigned int i = 0; i < avPositions.size(); ++i)
+		{
+			const float* pf = reinterpret_cast<const float*>(pVertices + i * iVertexSize + pPosition->iOffset);
+			avPositions[i] = Vec3(pf[0], pf[1], pPosition->iNumElements > 2 ? pf[2] : 0.0f);
+		}
+		return true;
+	}
+
+	boost::shared_ptr<MeshBVH> Geometry::getTriangleBVH() const
+	{
+		if (m_spTriangleBVH || m_ePrimitiveType != TRIANGLES)
+			return m_spTriangleBVH;
+
+		std::vector<Vec3> avPositions;
+		const unsigned int* puIndices = reinterpret_cast<const unsigned int*>(m_spVertexList->getIndexBufferData());
+		if (!puIndices || !getPositions(avPositions))
+			return m_spTriangleBVH;
+
+		std::vector<unsigned int> auIndices(puIndices, puIndices + m_spVertexList->getNumIndices());
+		m_spTriangleBVH = MeshBVH::create(avPositions, auIndices);
+		return m_spTriangleBVH;
+	}
+
 } }
\ No newline at end of file
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <boost/shared_ptr.hpp>
+#include <Math/AABB.h>
+#include <vector>
 
 namespace baselib 
 {
 	namespace graphics
 	{
 		class VertexListInterface;
+		class MeshBVH;
 	}
 }
 
@@ -55,15 +58,27 @@ namespace baselib
 			PrimitiveType getPrimitiveType() const { return m_ePrimitiveType; }
 			//! Get the vertex list.
 			boost::shared_ptr<VertexListInterface> getVertexList() const { return m_spVertexList; }
+			//! Get the bounds of the vertex attribute named "position", computed when first needed. Empty if there is no float position.
+			const AABB& getBounds() const;
+			//! Copy the vertex positions out of the vertex list. Returns false if there is no float attribute named "position".
+			bool getPositions(std::vector<Vec3>& avPositions) const;
+			//! Get the triangle BVH used for exact ray hits, built when first needed. NULL unless the geometry is indexed TRIANGLES with a float position.
+			boost::shared_ptr<MeshBVH> getTriangleBVH() const;
 
 		protected:
 			//! Protected constructor - derived classes must be created by Renderer.
 			Geometry(unsigned int uVAO, PrimitiveType ePrimitiveType, const boost::shared_ptr<VertexListInterface>& spVertexList);
 
+			//! The vertex list changed, compute the bounds and the triangle BVH again the next time they are needed.
+			void invalidateBounds() { m_bBoundsValid = false; m_spTriangleBVH.reset(); }
+
 		private:
 			unsigned int m_uVAO;  //!< The geometry VAO - Vertex array object.
 			PrimitiveType m_ePrimitiveType; //!< The type of primitive shapes the geometry is composed of.
 			boost::shared_ptr<VertexListInterface> m_spVertexList; //!< The vertex list used to create this goemetry buffer.
+			mutable AABB m_Bounds; //!< Bounds of the vertex positions.
+			mutable bool m_bBoundsValid; //!< Are m_Bounds up to date?
+			mutable boost::shared_ptr<MeshBVH> m_spTriangleBVH; //!< Triangle BVH, NULL until first needed.
 
 		};
 	}
@@ -0,0 +1,97 @@
+#include "ParallelShaderCompile.h"
+
+#include <Logging/Log.h>
+#include <GL/glew.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <GL/glxew.h>
+#endif
+
+namespace baselib { namespace graphics {
+
+	namespace
+	{
+		// GL_KHR_parallel_shader_compile, shared with GL_ARB_parallel_shader_compile
+		const GLenum GL_COMPLETION_STATUS_KHR = 0x91B1;
+		typedef void (GLAPIENTRY * PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+		bool bInitialized = false;
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC pfnMaxShaderCompilerThreads = NULL;
+
+		void* getProcAddress(const char* szName)
+		{
+			#ifdef _WIN32
+			return reinterpret_cast<void*>(wglGetProcAddress(szName));
+			#else
+			return reinterpret_cast<void*>(glXGetProcAddressARB(reinterpret_cast<const GLubyte*>(szName)));
+			#endif
+		}
+
+		bool isExtensionSupported(const char* szName)
+		{
+			int iNumExtensions = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &iNumExtensions);
+			for (int i = 0; i < iNumExtensions; ++i)
+			{
+				const char* szExtension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+				if (szExtension && strcmp(szExtension, szName) == 0)
+					return true;
+			}
+			return false;
+		}
+
+		// Load the entry point the first time the extension is used. Needs a current context.
+		void init()
+		{
+			if (bInitialized)
+				return;
+			bInitialized = true;
+
+			if (isExtensionSupported("GL_KHR_parallel_shader_compile"))
+				pfnMaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(getProcAddress("glMaxShaderCompilerThreadsKHR"));
+			else if (isExtensionSupported("GL_ARB_parallel_shader_compile"))
+				pfnMaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(getProcAddress("glMaxShaderCompilerThreadsARB"));
+
+			if (pfnMaxShaderCompilerThreads)
+				LOG_INFO << "Parallel shader compilation is supported";
+			else
+				LOG_INFO << "Parallel shader compilation is not supported, shader status checks may block";
+		}
+	}
+
+	bool hasParallelShaderCompile()
+	{
+		init();
+		return pfnMaxShaderCompilerThreads != NULL;
+	}
+
+	void setMaxShaderCompilerThreads(unsigned int uCount)
+	{
+		if (hasParallelShaderCompile())
+			pfnMaxShaderCompilerThreads(uCount);
+	}
+
+	bool isShaderCompileComplete(unsigned int uShaderID)
+	{
+		if (!hasParallelShaderCompile())
+			return true;
+
+		int iComplete = GL_TRUE;
+		glGetShaderiv(uShaderID, GL_COMPLETION_STATUS_KHR, &iComplete);
+		return iComplete == GL_TRUE;
+	}
+
+	bool isProgramLinkComplete(unsigned int uProgramID)
+	{
+		if (!hasParallelShaderCompile())
+			return true;
+
+		int iComplete = GL_TRUE;
+		glGetProgramiv(uProgramID, GL_COMPLETION_STATUS_KHR, &iComplete);
+		return iComplete == GL_TRUE;
+	}
+
+} }
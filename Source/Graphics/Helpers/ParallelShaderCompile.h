@@ -0,0 +1,23 @@
+#pragma once
+
+namespace baselib 
+{
+	namespace graphics
+	{
+		/*! @brief Is GL_KHR_parallel_shader_compile (or the equivalent ARB extension) supported by the current context?
+		 *
+		 *  The extension isn't part of the bundled GLEW, so its entry point is loaded by hand on first use. Without it
+		 *  the driver may still compile in the background, but completion can't be polled without blocking.
+		 */
+		bool hasParallelShaderCompile();
+
+		//! Set the number of threads the driver may use to compile shaders. 0xFFFFFFFF selects the driver's maximum. No-op without the extension.
+		void setMaxShaderCompilerThreads(unsigned int uCount);
+
+		//! Has the driver finished compiling a shader object? Doesn't block. Always true without the extension.
+		bool isShaderCompileComplete(unsigned int uShaderID);
+
+		//! Has the driver finished linking a program? Doesn't block. Always true without the extension.
+		bool isProgramLinkComplete(unsigned int uProgramID);
+	}
+}
@@ -2,6 +2,8 @@
 
 #include <Logging/Log.h>
 #include <Graphics/Shader.h>
+#include <Graphics/ShaderPipeline.h>
+#include <Graphics/ShaderPermutations.h>
 #include <Graphics/Texture.h>
 
 namespace baselib { namespace graphics {
@@ -11,6 +13,12 @@ namespace baselib { namespace graphics {
 		return boost::shared_ptr<Material>(new Material(spShader, spTexture, spRenderState));
 	}
 
+	boost::shared_ptr<Material> Material::create(const boost::shared_ptr<ShaderPermutations>& spPermutations, unsigned int uFeatures, const boost::shared_ptr<Texture>& spTexture, const boost::shared_ptr<RenderState>& spRenderState)
+	{
+		assert(spPermutations);
+		return create(spPermutations->getVariant(uFeatures)->createInstance(), spTexture, spRenderState);
+	}
+
 	Material::Material( const boost::shared_ptr<Shader>& spShader, const boost::shared_ptr<Texture>& spTexture, const boost::shared_ptr<RenderState>& spRenderState)
 		: m_spShader(spShader)
 		, m_spTexture(spTexture)
@@ -24,6 +32,11 @@ namespace baselib { namespace graphics {
 		LOG_VERBOSE << "Material destructor";
 	}
 
+	bool Material::isReady() const
+	{
+		return !m_spShader || m_spShader->isReady();
+	}
+
 	void Material::bind()
 	{
 		if (m_spShader)
@@ -7,6 +7,7 @@ namespace baselib
 	namespace graphics
 	{
 		class Shader;
+		class ShaderPermutations;
 		class Texture;
 		class RenderState;
 	}
@@ -24,12 +25,16 @@ namespace baselib
 		public:
 			//! Creates a Material.
 			static boost::shared_ptr<Material> create(const boost::shared_ptr<Shader>& spShader, const boost::shared_ptr<Texture>& spTexture, const boost::shared_ptr<RenderState>& spRenderState);
+			//! Creates a Material using the variant of spPermutations that implements exactly uFeatures, see ShaderPermutations::getFeatures().
+			static boost::shared_ptr<Material> create(const boost::shared_ptr<ShaderPermutations>& spPermutations, unsigned int uFeatures, const boost::shared_ptr<Texture>& spTexture, const boost::shared_ptr<RenderState>& spRenderState);
 
 			//! Destructor.
 			virtual ~Material();
 
 			//! Bind the material.
 			void bind();
+			//! Has the material's shader finished compiling? Doesn't block. Materials that aren't ready are skipped by RenderJob.
+			bool isReady() const;
 
 			//! Getter for setShader().
 			boost::shared_ptr<Shader> getShader() const { return m_spShader; }
@@ -0,0 +1,341 @@
+#include "MeshBVH.h"
+
+#include <Logging/Log.h>
+#include <Math/SIMD.h>
+#include <algorithm>
+
+
+namespace baselib { namespace graphics {
+
+	namespace
+	{
+		const unsigned int MAX_LEAF_TRIANGLES = 4;
+		const unsigned int NUM_BINS = 12;
+
+		//! Slab test with the inverse direction precomputed, returns the entry distance or a negative value on a miss.
+		float intersectBounds(const AABB& bounds, const Vec3& vOrigin, const Vec3& vInvDirection, float fMaxDistance)
+		{
+			Vec3 vNear = (bounds.vMin - vOrigin) * vInvDirection;
+			Vec3 vFar = (bounds.vMax - vOrigin) * vInvDirection;
+			Vec3 vEnter = glm::min(vNear, vFar);
+			Vec3 vExit = glm::max(vNear, vFar);
+			float fEnter = std::max(std::max(vEnter.x, vEnter.y), std::max(vEnter.z, 0.0f));
+			float fExit = std::min(std::min(vExit.x, vExit.y), std::min(vExit.z, fMaxDistance));
+			return fEnter <= fExit ? fEnter : -1.0f;
+		}
+	}
+
+	boost::shared_ptr<MeshBVH> MeshBVH::create(const std::vector<Vec3>& avPositions, const std::vector<unsigned int>& auIndices)
+	{
+		return boost::shared_ptr<MeshBVH>(new MeshBVH(avPositions, auIndices));
+	}
+
+	MeshBVH::MeshBVH(const std::vector<Vec3>& avPositions, const std::vector<unsigned int>& auIndices)
+		: m_uNumTriangles(0)
+	{
+		LOG_VERBOSE << "MeshBVH constructor";
+
+		std::vector<BuildTriangle> aTriangles;
+		aTriangles.reserve(auIndices.size() / 3);
+		for (unsigned int i = 0; i + 2 < auIndices.size(); i += 3)
+		{
+			if (auIndices[i] >= avPositions.size() || auIndices[i + 1] >= avPositions.size() || auIndices[i + 2] >= avPositions.size())
+			{
+				LOG_ERROR << "Triangle " << i / 3 << " indexes past the " << avPositions.size() << " positions";
+				assert(false);
+				continue;
+			}
+
+			BuildTriangle triangle;
+			triangle.bounds.expand(avPositions[auIndices[i]]);
+			triangle.bounds.expand(avPositions[auIndices[i + 1]]);
+			triangle.bounds.expand(avPositions[auIndices[i + 2]]);
+			triangle.vCentroid = triangle.bounds.getCenter();
+			triangle.uTriangle = i / 3;
+			aTriangles.push_back(triangle);
+		}
+
+		m_uNumTriangles = aTriangles.size();
+		if (aTriangles.empty())
+			return;
+
+		m_aNodes.reserve(aTriangles.size());
+		m_aPackets.reserve(aTriangles.size() / 2 + 1);
+		build(aTriangles, 0, aTriangles.size(), avPositions, auIndices);
+	}
+
+	MeshBVH::~MeshBVH()
+	{
+		LOG_VERBOSE << "MeshBVH destructor";
+	}
+
+	unsigned int MeshBVH::build(std::vector<BuildTriangle>& aTriangles, unsigned int uBegin, unsigned int uEnd, const std::vector<Vec3>& avPositions, const std::vector<unsigned int>& auIndices)
+	{
+		unsigned int uNode = m_aNodes.size();
+		m_aNodes.push_back(Node());
+
+		AABB bounds;
+		AABB centroidBounds;
+		for (unsigned int i = uBegin; i < uEnd; ++i)
+		{
+			bounds.expand(aTriangles[i].bounds);
+			centroidBounds.expand(aTriangles[i].vCentroid);
+		}
+		m_aNodes[uNode].bounds = bounds;
+
+		unsigned int uCount = uEnd - uBegin;
+		if (uCount <= MAX_LEAF_TRIANGLES)
+		{
+			TrianglePacket packet;
+			for (unsigned int j = 0; j < MAX_LEAF_TRIANGLES; ++j)
+			{
+				Vec3 v0(0.0f), v1(0.0f), v2(0.0f);
+				unsigned int uTriangle = 0;
+				if (j < uCount)
+				{
+					uTriangle = aTriangles[uBegin + j].uTriangle;
+					v0 = avPositions[auIndices[uTriangle * 3]];
+					v1 = avPositions[auIndices[uTriangle * 3 + 1]];
+					v2 = avPositions[auIndices[uTriangle * 3 + 2]];
+				}
+				for (int k = 0; k < 3; ++k)
+				{
+					packet.afVertex[k][j] = v0[k];
+					packet.afEdge1[k][j] = v1[k] - v0[k];
+					packet.afEdge2[k][j] = v2[k] - v0[k];
+				}
+				packet.auTriangle[j] = uTriangle;
+			}
+
+			m_aNodes[uNode].uOffset = m_aPackets.size();
+			m_aNodes[uNode].uCount = uCount;
+			m_aPackets.push_back(packet);
+			return uNode;
+		}
+
+		// Bin the centroids along the longest axis and split where the surface area heuristic is lowest
+		Vec3 vSize = centroidBounds.vMax - centroidBounds.vMin;
+		int iAxis = (vSize.x > vSize.y && vSize.x > vSize.z) ? 0 : (vSize.y > vSize.z ? 1 : 2);
+		unsigned int uMid = uBegin + uCount / 2;
+
+		if (vSize[iAxis] > EPSILON)
+		{
+			AABB aBinBounds[NUM_BINS];
+			unsigned int auBinCounts[NUM_BINS] = { 0 };
+			float fScale = NUM_BINS / vSize[iAxis];
+			float fMin = centroidBounds.vMin[iAxis];
+			auto getBin = [fScale, fMin, iAxis](const BuildTriangle& triangle) {
+				return std::min(static_cast<unsigned int>((triangle.vCentroid[iAxis] - fMin) * fScale), NUM_BINS - 1);
+			};
+
+			for (unsigned int i = uBegin; i < uEnd; ++i)
+			{
+				unsigned int uBin = getBin(aTriangles[i]);
+				aBinBounds[uBin].expand(aTriangles[i].bounds);
+				auBinCounts[uBin] += 1;
+			}
+
+			// Cost of splitting after each bin, sweeping from the left and then from the right
+			float afLeftCosts[NUM_BINS - 1];
+			AABB leftBounds;
+			unsigned int uLeftCount = 0;
+			for (unsigned int i = 0; i < NUM_BINS - 1; ++i)
+			{
+				leftBounds.expand(aBinBounds[i]);
+				uLeftCount += auBinCounts[i];
+				afLeftCosts[i] = leftBounds.getSurfaceArea() * uLeftCount;
+			}
+
+			float fBestCost = FLT_MAX;
+			unsigned int uBestSplit = 0;
+			AABB rightBounds;
+			unsigned int uRightCount = 0;
+			for (unsigned int i = NUM_BINS - 1; i > 0; --i)
+			{
+				rightBounds.expand(aBinBounds[i]);
+				uRightCount += auBinCounts[i];
+				float fCost = afLeftCosts[i - 1] + rightBounds.getSurfaceArea() * uRightCount;
+				if (uRightCount > 0 && uRightCount < uCount && fCost < fBestCost)
+				{
+					fBestCost = fCost;
+					uBestSplit = i;
+				}
+			}
+
+			if (uBestSplit > 0)
+			{
+				uMid = std::partition(aTriangles.begin() + uBegin, aTriangles.begin() + uEnd, [&getBin, uBestSplit](const BuildTriangle& triangle) {
+					return getBin(triangle) < uBestSplit;
+				}) - aTriangles.begin();
+			}
+		}
+
+		// Coincident centroids can't be binned, split the range in half
+		if (uMid == uBegin || uMid == uEnd)
+		{
+			uMid = uBegin + uCount / 2;
+			std::nth_element(aTriangles.begin() + uBegin, aTriangles.begin() + uMid, aTriangles.begin() + uEnd, [iAxis](const BuildTriangle& lhs, const BuildTriangle& rhs) {
+				return lhs.vCentroid[iAxis] < rhs.vCentroid[iAxis];
+			});
+		}
+
+		build(aTriangles, uBegin, uMid, avPositions, auIndices);
+		unsigned int uRight = build(aTriangles, uMid, uEnd, avPositions, auIndices);
+		m_aNodes[uNode].uOffset = uRight;
+		m_aNodes[uNode].uCount = 0;
+		return uNode;
+	}
+
+	bool MeshBVH::raycast(const Ray& ray, float fMaxDistance, Hit& hit) const
+	{
+		if (m_aNodes.empty())
+			return false;
+
+		Vec3 vInvDirection = Vec3(1.0f) / ray.vDirection;
+		hit.fDistance = fMaxDistance;
+		bool bHit = false;
+
+		// Nodes with the distance the ray enters them, skipped once a nearer triangle is found
+		std::vector<std::pair<unsigned int, float>> aStack;
+		aStack.reserve(64);
+		float fRootDistance = intersectBounds(m_aNodes[0].bounds, ray.vOrigin, vInvDirection, fMaxDistance);
+		if (fRootDistance >= 0.0f)
+			aStack.push_back(std::make_pair(0u, fRootDistance));
+
+		while (!aStack.empty())
+		{
+			unsigned int uNode = aStack.back().first;
+			float fEnter = aStack.back().second;
+			aStack.pop_back();
+			if (fEnter > hit.fDistance)
+				continue;
+
+			const Node& node = m_aNodes[uNode];
+			if (node.uCount > 0)
+			{
+				bHit |= intersect(m_aPackets[node.uOffset], ray, hit);
+				continue;
+			}
+
+			unsigned int uLeft = uNode + 1;
+			unsigned int uRight = node.uOffset;
+			float fLeft = intersectBounds(m_aNodes[uLeft].bounds, ray.vOrigin, vInvDirection, hit.fDistance);
+			float fRight = intersectBounds(m_aNodes[uRight].bounds, ray.vOrigin, vInvDirection, hit.fDistance);
+
+			// Push the farther child first so the nearer one is visited next
+			if (fLeft >= 0.0f && fRight >= 0.0f)
+			{
+				if (fLeft < fRight)
+				{
+					aStack.push_back(std::make_pair(uRight, fRight));
+					aStack.push_back(std::make_pair(uLeft, fLeft));
+				}
+				else
+				{
+					aStack.push_back(std::make_pair(uLeft, fLeft));
+					aStack.push_back(std::make_pair(uRight, fRight));
+				}
+			}
+			else if (fLeft >= 0.0f)
+			{
+				aStack.push_back(std::make_pair(uLeft, fLeft));
+			}
+			else if (fRight >= 0.0f)
+			{
+				aStack.push_back(std::make_pair(uRight, fRight));
+			}
+		}
+
+		return bHit;
+	}
+
+	bool MeshBVH::intersect(const TrianglePacket& packet, const Ray& ray, Hit& hit) const
+	{
+		// Moller-Trumbore for four triangles. A zero determinant, as for the unused slots, yields infinities and NaNs that fail the tests.
+		float afDistances[4];
+		float afU[4];
+		float afV[4];
+		int iMask = 0;
+
+#ifdef BASELIB_SSE2
+		const __m128 vZero = _mm_setzero_ps();
+		const __m128 vOne = _mm_set1_ps(1.0f);
+		__m128 vDirX = _mm_set1_ps(ray.vDirection.x);
+		__m128 vDirY = _mm_set1_ps(ray.vDirection.y);
+		__m128 vDirZ = _mm_set1_ps(ray.vDirection.z);
+
+		__m128 vEdge1X = _mm_loadu_ps(packet.afEdge1[0]);
+		__m128 vEdge1Y = _mm_loadu_ps(packet.afEdge1[1]);
+		__m128 vEdge1Z = _mm_loadu_ps(packet.afEdge1[2]);
+		__m128 vEdge2X = _mm_loadu_ps(packet.afEdge2[0]);
+		__m128 vEdge2Y = _mm_loadu_ps(packet.afEdge2[1]);
+		__m128 vEdge2Z = _mm_loadu_ps(packet.afEdge2[2]);
+
+		// P = D x E2, det = E1 . P
+		__m128 vPX = _mm_sub_ps(_mm_mul_ps(vDirY, vEdge2Z), _mm_mul_ps(vDirZ, vEdge2Y));
+		__m128 vPY = _mm_sub_ps(_mm_mul_ps(vDirZ, vEdge2X), _mm_mul_ps(vDirX, vEdge2Z));
+		__m128 vPZ = _mm_sub_ps(_mm_mul_ps(vDirX, vEdge2Y), _mm_mul_ps(vDirY, vEdge2X));
+		__m128 vDet = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vEdge1X, vPX), _mm_mul_ps(vEdge1Y, vPY)), _mm_mul_ps(vEdge1Z, vPZ));
+		__m128 vInvDet = _mm_div_ps(vOne, vDet);
+
+		// T = O - V0, u = T . P / det
+		__m128 vTX = _mm_sub_ps(_mm_set1_ps(ray.vOrigin.x), _mm_loadu_ps(packet.afVertex[0]));
+		__m128 vTY = _mm_sub_ps(_mm_set1_ps(ray.vOrigin.y), _mm_loadu_ps(packet.afVertex[1]));
+		__m128 vTZ = _mm_sub_ps(_mm_set1_ps(ray.vOrigin.z), _mm_loadu_ps(packet.afVertex[2]));
+		__m128 vU = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vTX, vPX), _mm_mul_ps(vTY, vPY)), _mm_mul_ps(vTZ, vPZ)), vInvDet);
+
+		// Q = T x E1, v = D . Q / det, t = E2 . Q / det
+		__m128 vQX = _mm_sub_ps(_mm_mul_ps(vTY, vEdge1Z), _mm_mul_ps(vTZ, vEdge1Y));
+		__m128 vQY = _mm_sub_ps(_mm_mul_ps(vTZ, vEdge1X), _mm_mul_ps(vTX, vEdge1Z));
+		__m128 vQZ = _mm_sub_ps(_mm_mul_ps(vTX, vEdge1Y), _mm_mul_ps(vTY, vEdge1X));
+		__m128 vV = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vDirX, vQX), _mm_mul_ps(vDirY, vQY)), _mm_mul_ps(vDirZ, vQZ)), vInvDet);
+		__m128 vT = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vEdge2X, vQX), _mm_mul_ps(vEdge2Y, vQY)), _mm_mul_ps(vEdge2Z, vQZ)), vInvDet);
+
+		__m128 vHit = _mm_and_ps(_mm_cmpge_ps(vU, vZero), _mm_cmpge_ps(vV, vZero));
+		vHit = _mm_and_ps(vHit, _mm_cmple_ps(_mm_add_ps(vU, vV), vOne));
+		vHit = _mm_and_ps(vHit, _mm_cmpge_ps(vT, vZero));
+		vHit = _mm_and_ps(vHit, _mm_cmplt_ps(vT, _mm_set1_ps(hit.fDistance)));
+		iMask = _mm_movemask_ps(vHit);
+		if (iMask == 0)
+			return false;
+
+		_mm_storeu_ps(afDistances, vT);
+		_mm_storeu_ps(afU, vU);
+		_mm_storeu_ps(afV, vV);
+#else
+		for (int j = 0; j < 4; ++j)
+		{
+			Vec3 vEdge1(packet.afEdge1[0][j], packet.afEdge1[1][j], packet.afEdge1[2][j]);
+			Vec3 vEdge2(packet.afEdge2[0][j], packet.afEdge2[1][j], packet.afEdge2[2][j]);
+			Vec3 vP = glm::cross(ray.vDirection, vEdge2);
+			float fInvDet = 1.0f / glm::dot(vEdge1, vP);
+
+			Vec3 vT = ray.vOrigin - Vec3(packet.afVertex[0][j], packet.afVertex[1][j], packet.afVertex[2][j]);
+			afU[j] = glm::dot(vT, vP) * fInvDet;
+			Vec3 vQ = glm::cross(vT, vEdge1);
+			afV[j] = glm::dot(ray.vDirection, vQ) * fInvDet;
+			afDistances[j] = glm::dot(vEdge2, vQ) * fInvDet;
+
+			if (afU[j] >= 0.0f && afV[j] >= 0.0f && afU[j] + afV[j] <= 1.0f && afDistances[j] >= 0.0f && afDistances[j] < hit.fDistance)
+				iMask |= 1 << j;
+		}
+		if (iMask == 0)
+			return false;
+#endif
+
+		bool bHit = false;
+		for (int j = 0; j < 4; ++j)
+		{
+			if ((iMask & (1 << j)) && afDistances[j] < hit.fDistance)
+			{
+				hit.fDistance = afDistances[j];
+				hit.uTriangle = packet.auTriangle[j];
+				hit.fU = afU[j];
+				hit.fV = afV[j];
+				bHit = true;
+			}
+		}
+		return bHit;
+	}
+
+} }
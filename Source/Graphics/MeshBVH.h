@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <Math/AABB.h>
+#include <Math/Ray.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		/*! @brief Bounding volume hierarchy over the triangles of a mesh, for exact ray hits.
+		 *
+		 *  Built once with a binned surface area heuristic, so it suits static meshes; rebuild it after the vertices change.
+		 *  Each leaf holds up to four triangles stored as a structure of arrays, which raycast() tests against the ray at
+		 *  once with SSE2 where available and one at a time otherwise. Children are visited nearest first and subtrees
+		 *  behind the nearest hit so far are skipped. Triangles are double sided.
+		 */
+		class MeshBVH
+		{
+		public:
+			//! Nearest triangle hit by a ray.
+			struct Hit
+			{
+				float fDistance;		//!< Distance along the ray.
+				unsigned int uTriangle;	//!< Index of the triangle, i.e. its first index divided by 3.
+				float fU;				//!< Barycentric weight of the triangle's second vertex.
+				float fV;				//!< Barycentric weight of the triangle's third vertex.
+			};
+
+			//! Creates a MeshBVH over indexed triangles, three indices per triangle.
+			static boost::shared_ptr<MeshBVH> create(const std::vector<Vec3>& avPositions, const std::vector<unsigned int>& auIndices);
+
+			//! Destructor.
+			~MeshBVH();
+
+			//! Find the nearest triangle the ray hits before fMaxDistance. The ray is in the space of the positions.
+			bool raycast(const Ray& ray, float fMaxDistance, Hit& hit) const;
+
+			//! Get the bounds of the mesh.
+			const AABB& getBounds() const { return m_aNodes.empty() ? m_EmptyBounds : m_aNodes[0].bounds; }
+			//! Get the number of triangles.
+			unsigned int getNumTriangles() const { return m_uNumTriangles; }
+			//! Get the number of nodes.
+			unsigned int getNumNodes() const { return m_aNodes.size(); }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			MeshBVH(const std::vector<Vec3>& avPositions, const std::vector<unsigned int>& auIndices);
+
+		private:
+			//! Triangle bounds and centroid used while building.
+			struct BuildTriangle
+			{
+				AABB bounds;			//!< Bounds of the triangle.
+				Vec3 vCentroid;			//!< Centre of the bounds.
+				unsigned int uTriangle;	//!< Index of the triangle.
+			};
+
+			//! Node of the hierarchy. The first child of an internal node directly follows it.
+			struct Node
+			{
+				AABB bounds;			//!< Bounds of the triangles below.
+				unsigned int uOffset;	//!< Second child of an internal node, packet of a leaf.
+				unsigned int uCount;	//!< Number of triangles in a leaf, 0 for internal nodes.
+			};
+
+			//! Four triangles as a structure of arrays: first vertex and the two edges leaving it. Unused slots have zero edges.
+			struct TrianglePacket
+			{
+				float afVertex[3][4];		//!< First vertices, x y and z of each triangle.
+				float afEdge1[3][4];		//!< Second vertex minus first vertex.
+				float afEdge2[3][4];		//!< Third vertex minus first vertex.
+				unsigned int auTriangle[4];	//!< Triangle indices.
+			};
+
+			//! Build the subtree over a range of triangles and return its node.
+			unsigned int build(std::vector<BuildTriangle>& aTriangles, unsigned int uBegin, unsigned int uEnd, const std::vector<Vec3>& avPositions, const std::vector<unsigned int>& auIndices);
+			//! Test the ray against a leaf's triangles, updating hit if one is nearer than hit.fDistance.
+			bool intersect(const TrianglePacket& packet, const Ray& ray, Hit& hit) const;
+
+			std::vector<Node> m_aNodes;					//!< Nodes in depth first order, the root first.
+			std::vector<TrianglePacket> m_aPackets;		//!< Triangles of the leaves.
+			unsigned int m_uNumTriangles;				//!< Number of triangles.
+			AABB m_EmptyBounds;							//!< Bounds returned when there are no triangles.
+		};
+	}
+}
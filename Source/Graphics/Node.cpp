@@ -47,10 +47,11 @@ namespace baselib { namespace graphics {
 		});
 	}
 
-	void Node::onUpdate(const Mat4& mParent)
+	void Node::onUpdate(const Transform& parent)
 	{
-		boost::for_each(m_aChildren, [&mParent](const boost::shared_ptr<Spatial>& spSpatial) {
-			spSpatial->update(mParent);
+		const Transform& world = getWorld();
+		boost::for_each(m_aChildren, [&world](const boost::shared_ptr<Spatial>& spSpatial) {
+			spSpatial->update(world);
 		});
 	}
 
@@ -45,7 +45,7 @@ namespace baselib
 
 		private:
 			//! Recursively update children Nodes.
-			virtual void onUpdate(const Mat4& mParent);
+			virtual void onUpdate(const Transform& parent);
 
 			std::vector<boost::shared_ptr<Spatial>> m_aChildren; //!< List of children Nodes.
 		};
@@ -0,0 +1,302 @@
+#include "OcclusionBuffer.h"
+
+#include <Logging/Log.h>
+#include <Math/SIMD.h>
+#include <Graphics/Geometry.h>
+#include <Graphics/VertexList.h>
+#include <algorithm>
+#include <cmath>
+
+namespace baselib { namespace graphics {
+
+	namespace
+	{
+		//! Edge function of the edge from a to b, positive on the left of the edge: E(p) = fA * p.x + fB * p.y + fC.
+		struct Edge
+		{
+			Edge(const Vec3& a, const Vec3& b)
+				: fA(b.y - a.y)
+				, fB(a.x - b.x)
+				, fC(a.y * (b.x - a.x) - a.x * (b.y - a.y)) {}
+
+			float evaluate(float fX, float fY) const { return fA * fX + fB * fY + fC; }
+
+			float fA;
+			float fB;
+			float fC;
+		};
+	}
+
+	boost::shared_ptr<OcclusionBuffer> OcclusionBuffer::create(int iWidth, int iHeight)
+	{
+		assert(iWidth > 0 && iHeight > 0);
+		return boost::shared_ptr<OcclusionBuffer>(new OcclusionBuffer((iWidth + 3) & ~3, iHeight));
+	}
+
+	OcclusionBuffer::OcclusionBuffer(int iWidth, int iHeight)
+		: m_iWidth(iWidth)
+		, m_iHeight(iHeight)
+		, m_mViewProjection(1.0f)
+		, m_uNumTriangles(0)
+	{
+		LOG_VERBOSE << "OcclusionBuffer constructor";
+
+		// Levels halve, rounding up, until a single texel covers the screen
+		for (int iLevel = 0; ; ++iLevel)
+		{
+			m_aafLevels.push_back(std::vector<float>(getLevelWidth(iLevel) * getLevelHeight(iLevel), 1.0f));
+			if (getLevelWidth(iLevel) == 1 && getLevelHeight(iLevel) == 1)
+				break;
+		}
+	}
+
+	OcclusionBuffer::~OcclusionBuffer()
+	{
+		LOG_VERBOSE << "OcclusionBuffer destructor";
+	}
+
+	void OcclusionBuffer::begin(const Mat4& mViewProjection)
+	{
+		m_mViewProjection = mViewProjection;
+		m_uNumTriangles = 0;
+		std::fill(m_aafLevels[0].begin(), m_aafLevels[0].end(), 1.0f);
+	}
+
+	void OcclusionBuffer::addOccluder(const Geometry& geometry, const Mat4& mWorld)
+	{
+		if (geometry.getPrimitiveType() != Geometry::TRIANGLES)
+			return;
+		if (!geometry.getPositions(m_avPositions) || m_avPositions.empty())
+			return;
+
+		const boost::shared_ptr<VertexListInterface>& spVertexList = geometry.getVertexList();
+		const unsigned int* puIndices = reinterpret_cast<const unsigned int*>(spVertexList->getIndexBufferData());
+		if (!puIndices)
+			return;
+		rasterize(&m_avPositions[0], m_avPositions.size(), puIndices, spVertexList->getNumIndices(), mWorld);
+	}
+
+	void OcclusionBuffer::addTriangles(const std::vector<Vec3>& avPositions, const std::vector<unsigned int>& auIndices, const Mat4& mWorld)
+	{
+		if (avPositions.empty() || auIndices.empty())
+			return;
+		rasterize(&avPositions[0], avPositions.size(), &auIndices[0], auIndices.size(), mWorld);
+	}
+
+	void OcclusionBuffer::rasterize(const Vec3* pPositions, unsigned int uNumPositions, const unsigned int* puIndices, unsigned int uNumIndices, const Mat4& mWorld)
+	{
+		Mat4 mWorldViewProjection;
+		multiplyMat4(m_mViewProjection, mWorld, mWorldViewProjection);
+		m_avClip.resize(uNumPositions);
+		transformPoints(mWorldViewProjection, pPositions, &m_avClip[0], uNumPositions);
+
+		float fHalfWidth = m_iWidth * 0.5f;
+		float fHalfHeight = m_iHeight * 0.5f;
+		for (unsigned int i = 0; i + 2 < uNumIndices; i += 3)
+		{
+			Vec3 avScreen[3];
+			bool bClipped = false;
+			for (unsigned int j = 0; j < 3; ++j)
+			{
+				unsigned int uIndex = puIndices[i + j];
+				if (uIndex >= uNumPositions)
+				{
+					bClipped = true;
+					break;
+				}
+
+				// Clipping to the near plane would add vertices, dropping the triangle only loses occlusion
+				const Vec4& vClip = m_avClip[uIndex];
+				if (vClip.w <= EPSILON || vClip.z < -vClip.w)
+				{
+					bClipped = true;
+					break;
+				}
+
+				float fInvW = 1.0f / vClip.w;
+				avScreen[j] = Vec3((vClip.x * fInvW + 1.0f) * fHalfWidth, (vClip.y * fInvW + 1.0f) * fHalfHeight, vClip.z * fInvW * 0.5f + 0.5f);
+			}
+
+			if (!bClipped)
+				rasterizeTriangle(avScreen[0], avScreen[1], avScreen[2]);
+		}
+	}
+
+	void OcclusionBuffer::rasterizeTriangle(const Vec3& v0, const Vec3& v1In, const Vec3& v2In)
+	{
+		// Wind counter clockwise so the inside of every edge is positive, occluders are treated as double sided
+		Vec3 v1 = v1In;
+		Vec3 v2 = v2In;
+		float fArea = Edge(v0, v1).evaluate(v2.x, v2.y);
+		if (fArea < 0.0f)
+		{
+			std::swap(v1, v2);
+			fArea = -fArea;
+		}
+		if (fArea <= EPSILON)
+			return;
+
+		// Pixels whose centre lies in the triangle's bounds
+		int iMinX = std::max(int(std::ceil(std::min(v0.x, std::min(v1.x, v2.x)) - 0.5f)), 0);
+		int iMaxX = std::min(int(std::floor(std::max(v0.x, std::max(v1.x, v2.x)) - 0.5f)), m_iWidth - 1);
+		int iMinY = std::max(int(std::ceil(std::min(v0.y, std::min(v1.y, v2.y)) - 0.5f)), 0);
+		int iMaxY = std::min(int(std::floor(std::max(v0.y, std::max(v1.y, v2.y)) - 0.5f)), m_iHeight - 1);
+		if (iMinX > iMaxX || iMinY > iMaxY)
+			return;
+
+		++m_uNumTriangles;
+
+		// Barycentric weights are the edge functions opposite each vertex over the area, depth is interpolated linearly in screen space
+		Edge e12(v1, v2);
+		Edge e20(v2, v0);
+		Edge e01(v0, v1);
+		float fInvArea = 1.0f / fArea;
+		float fZA = (e12.fA * v0.z + e20.fA * v1.z + e01.fA * v2.z) * fInvArea;
+		float fZB = (e12.fB * v0.z + e20.fB * v1.z + e01.fB * v2.z) * fInvArea;
+		float fZC = (e12.fC * v0.z + e20.fC * v1.z + e01.fC * v2.z) * fInvArea;
+
+		// Rows are walked four pixels at a time from a multiple of 4, the width being one too
+		int iStartX = iMinX & ~3;
+		std::vector<float>& afDepth = m_aafLevels[0];
+
+#ifdef BASELIB_SSE2
+		const __m128 vPixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 vZero = _mm_setzero_ps();
+		const __m128 vA12 = _mm_set1_ps(e12.fA);
+		const __m128 vA20 = _mm_set1_ps(e20.fA);
+		const __m128 vA01 = _mm_set1_ps(e01.fA);
+		const __m128 vZA = _mm_set1_ps(fZA);
+
+		for (int iY = iMinY; iY <= iMaxY; ++iY)
+		{
+			float fY = float(iY) + 0.5f;
+			__m128 vRow12 = _mm_set1_ps(e12.fB * fY + e12.fC);
+			__m128 vRow20 = _mm_set1_ps(e20.fB * fY + e20.fC);
+			__m128 vRow01 = _mm_set1_ps(e01.fB * fY + e01.fC);
+			__m128 vRowZ = _mm_set1_ps(fZB * fY + fZC);
+
+			float* pfRow = &afDepth[iY * m_iWidth];
+			for (int iX = iStartX; iX <= iMaxX; iX += 4)
+			{
+				__m128 vX = _mm_add_ps(_mm_set1_ps(float(iX)), vPixelOffsets);
+				__m128 vE12 = _mm_add_ps(_mm_mul_ps(vA12, vX), vRow12);
+				__m128 vE20 = _mm_add_ps(_mm_mul_ps(vA20, vX), vRow20);
+				__m128 vE01 = _mm_add_ps(_mm_mul_ps(vA01, vX), vRow01);
+				__m128 vInside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(vE12, vZero), _mm_cmpge_ps(vE20, vZero)), _mm_cmpge_ps(vE01, vZero));
+				if (_mm_movemask_ps(vInside) == 0)
+					continue;
+
+				__m128 vZ = _mm_add_ps(_mm_mul_ps(vZA, vX), vRowZ);
+				__m128 vDepth = _mm_loadu_ps(pfRow + iX);
+				__m128 vNearest = _mm_min_ps(vDepth, vZ);
+				_mm_storeu_ps(pfRow + iX, _mm_or_ps(_mm_and_ps(vInside, vNearest), _mm_andnot_ps(vInside, vDepth)));
+			}
+		}
+#else
+		const float afPixelOffsets[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+
+		for (int iY = iMinY; iY <= iMaxY; ++iY)
+		{
+			float fY = float(iY) + 0.5f;
+			float fRow12 = e12.fB * fY + e12.fC;
+			float fRow20 = e20.fB * fY + e20.fC;
+			float fRow01 = e01.fB * fY + e01.fC;
+			float fRowZ = fZB * fY + fZC;
+
+			float* pfRow = &afDepth[iY * m_iWidth];
+			for (int iX = iStartX; iX <= iMaxX; iX += 4)
+			{
+				for (int i = 0; i < 4; ++i)
+				{
+					float fX = float(iX) + afPixelOffsets[i];
+					if (e12.fA * fX + fRow12 < 0.0f || e20.fA * fX + fRow20 < 0.0f || e01.fA * fX + fRow01 < 0.0f)
+						continue;
+
+					float fZ = fZA * fX + fRowZ;
+					pfRow[iX + i] = std::min(pfRow[iX + i], fZ);
+				}
+			}
+		}
+#endif
+	}
+
+	void OcclusionBuffer::buildPyramid()
+	{
+		// Each texel keeps the farthest depth of the 2x2 texels below it, edge texels of odd sized levels repeat
+		for (unsigned int uLevel = 1; uLevel < m_aafLevels.size(); ++uLevel)
+		{
+			const std::vector<float>& afSource = m_aafLevels[uLevel - 1];
+			std::vector<float>& afDest = m_aafLevels[uLevel];
+			int iSourceWidth = getLevelWidth(uLevel - 1);
+			int iSourceHeight = getLevelHeight(uLevel - 1);
+			int iWidth = getLevelWidth(uLevel);
+			int iHeight = getLevelHeight(uLevel);
+
+			for (int iY = 0; iY < iHeight; ++iY)
+			{
+				const float* pfRow0 = &afSource[(iY * 2) * iSourceWidth];
+				const float* pfRow1 = &afSource[std::min(iY * 2 + 1, iSourceHeight - 1) * iSourceWidth];
+				for (int iX = 0; iX < iWidth; ++iX)
+				{
+					int iX0 = iX * 2;
+					int iX1 = std::min(iX0 + 1, iSourceWidth - 1);
+					afDest[iY * iWidth + iX] = std::max(std::max(pfRow0[iX0], pfRow0[iX1]), std::max(pfRow1[iX0], pfRow1[iX1]));
+				}
+			}
+		}
+	}
+
+	bool OcclusionBuffer::isOccluded(const AABB& bounds) const
+	{
+		if (bounds.isEmpty())
+			return false;
+
+		// Screen rectangle and nearest depth of the projected corners
+		Vec3 avCorners[8];
+		Vec4 avClip[8];
+		for (int i = 0; i < 8; ++i)
+			avCorners[i] = Vec3((i & 1) ? bounds.vMax.x : bounds.vMin.x, (i & 2) ? bounds.vMax.y : bounds.vMin.y, (i & 4) ? bounds.vMax.z : bounds.vMin.z);
+		transformPoints(m_mViewProjection, avCorners, avClip, 8);
+
+		Vec3 vMin(FLT_MAX);
+		Vec3 vMax(-FLT_MAX);
+		for (int i = 0; i < 8; ++i)
+		{
+			const Vec4& vClip = avClip[i];
+			if (vClip.w <= EPSILON || vClip.z < -vClip.w)
+				return false;
+
+			float fInvW = 1.0f / vClip.w;
+			Vec3 vScreen((vClip.x * fInvW + 1.0f) * m_iWidth * 0.5f, (vClip.y * fInvW + 1.0f) * m_iHeight * 0.5f, vClip.z * fInvW * 0.5f + 0.5f);
+			vMin = glm::min(vMin, vScreen);
+			vMax = glm::max(vMax, vScreen);
+		}
+
+		// Leave boxes off screen to frustum culling
+		if (vMax.x < 0.0f || vMax.y < 0.0f || vMin.x >= float(m_iWidth) || vMin.y >= float(m_iHeight))
+			return false;
+
+		int iMinX = std::max(int(vMin.x), 0);
+		int iMaxX = std::min(int(vMax.x), m_iWidth - 1);
+		int iMinY = std::max(int(vMin.y), 0);
+		int iMaxY = std::min(int(vMax.y), m_iHeight - 1);
+
+		// Coarsest level at which the rectangle covers at most 2x2 texels
+		unsigned int uLevel = 0;
+		while (uLevel + 1 < m_aafLevels.size() && ((iMaxX >> uLevel) - (iMinX >> uLevel) > 1 || (iMaxY >> uLevel) - (iMinY >> uLevel) > 1))
+			++uLevel;
+
+		const std::vector<float>& afLevel = m_aafLevels[uLevel];
+		int iLevelWidth = getLevelWidth(uLevel);
+		for (int iY = iMinY >> uLevel; iY <= (iMaxY >> uLevel); ++iY)
+		{
+			for (int iX = iMinX >> uLevel; iX <= (iMaxX >> uLevel); ++iX)
+			{
+				if (vMin.z <= afLevel[iY * iLevelWidth + iX])
+					return false;
+			}
+		}
+		return true;
+	}
+
+} }
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <Math/AABB.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		class Geometry;
+	}
+}
+
+namespace baselib
+{
+	namespace graphics
+	{
+		/*! @brief Low resolution depth buffer that occluders are rasterized into on the CPU, for occlusion culling.
+		 *
+		 *  Each frame: begin() with the camera's view projection, addOccluder() for the large solid visuals in view, then
+		 *  buildPyramid(). isOccluded() then tests world space boxes against a hierarchical Z pyramid whose texels hold the
+		 *  farthest depth of the area they cover, so a box is tested against at most 2x2 texels whatever its size on screen.
+		 *  A box is occluded if its nearest point is behind the farthest occluder depth everywhere it covers.
+		 *
+		 *  Triangles are rasterized four pixels at a time with SSE2 where available and with plain C++ otherwise, using
+		 *  the same coverage and depth rules. Triangles crossing the near plane are skipped, which only ever makes culling less effective.
+		 *  Coverage is sampled at pixel centres, so occluders should not be thinner than a few pixels at this resolution.
+		 *  No GPU is involved, so culling results can be tested anywhere.
+		 */
+		class OcclusionBuffer
+		{
+		public:
+			//! Creates an OcclusionBuffer. The width is rounded up to a multiple of 4.
+			static boost::shared_ptr<OcclusionBuffer> create(int iWidth = 256, int iHeight = 128);
+
+			//! Destructor.
+			~OcclusionBuffer();
+
+			//! Clear the buffer to the far plane and set the view projection occluders and boxes are projected with.
+			void begin(const Mat4& mViewProjection);
+			//! Rasterize the triangles of a geometry. Only TRIANGLES geometry with a float "position" attribute is rasterized.
+			void addOccluder(const Geometry& geometry, const Mat4& mWorld);
+			//! Rasterize world space triangles, three indices per triangle.
+			void addTriangles(const std::vector<Vec3>& avPositions, const std::vector<unsigned int>& auIndices, const Mat4& mWorld);
+			//! Build the depth pyramid from the rasterized occluders. Call after the last addOccluder() and before isOccluded().
+			void buildPyramid();
+
+			//! Is a world space box completely hidden behind the occluders? Boxes crossing the near plane are never occluded.
+			bool isOccluded(const AABB& bounds) const;
+
+			//! Get the width in pixels.
+			int getWidth() const { return m_iWidth; }
+			//! Get the height in pixels.
+			int getHeight() const { return m_iHeight; }
+			//! Get the depth of a pixel in [0, 1], 1 being the far plane. Row 0 is the bottom of the screen.
+			float getDepth(int iX, int iY) const { return m_aafLevels[0][iY * m_iWidth + iX]; }
+			//! Get the number of triangles rasterized since begin().
+			unsigned int getNumTriangles() const { return m_uNumTriangles; }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			OcclusionBuffer(int iWidth, int iHeight);
+
+		private:
+			//! Transform and rasterize indexed triangles.
+			void rasterize(const Vec3* pPositions, unsigned int uNumPositions, const unsigned int* puIndices, unsigned int uNumIndices, const Mat4& mWorld);
+			//! Rasterize one triangle given in screen space, x and y in pixels and z the depth in [0, 1].
+			void rasterizeTriangle(const Vec3& v0, const Vec3& v1, const Vec3& v2);
+			//! Get the width of a pyramid level.
+			int getLevelWidth(int iLevel) const { return ((m_iWidth - 1) >> iLevel) + 1; }
+			//! Get the height of a pyramid level.
+			int getLevelHeight(int iLevel) const { return ((m_iHeight - 1) >> iLevel) + 1; }
+
+			int m_iWidth;								//!< Width of level 0 in pixels, a multiple of 4.
+			int m_iHeight;								//!< Height of level 0 in pixels.
+			Mat4 m_mViewProjection;						//!< View projection set by begin().
+			std::vector<std::vector<float>> m_aafLevels;	//!< Depth pyramid, level 0 is the rasterized depth buffer.
+			std::vector<Vec4> m_avClip;					//!< Scratch clip space positions.
+			std::vector<Vec3> m_avPositions;			//!< Scratch object space positions.
+			unsigned int m_uNumTriangles;				//!< Triangles rasterized since begin().
+		};
+	}
+}
@@ -8,6 +8,9 @@
 #include <Graphics/VertexList.h>
 #include <Graphics/Renderer.h>
 #include <Graphics/Material.h>
+#include <Graphics/Camera.h>
+#include <Graphics/ComputeCuller.h>
+#include <Animation/Animator.h>
 #include <boost/range/algorithm/for_each.hpp>
 
 namespace baselib { namespace graphics {
@@ -33,10 +36,6 @@ namespace baselib { namespace graphics {
 							const boost::shared_ptr<FrameBuffer>& spFrameBuffer, 
 							const boost::shared_ptr<Camera>& spCamera)
 	{
-		// Collect and sort visible visuals
-		spVisualCollector->collect(spNode);
-		const auto& apVisuals = spVisualCollector->getVisuals();
-
 		// Bind FrameBuffer
 		spFrameBuffer->bind();
 
@@ -45,10 +44,26 @@ namespace baselib { namespace graphics {
 		// TODO: Check if frame buffer should be cleared
 		m_spRenderer->clear();
 
-		// Render visible, sorted list of visuals
+		if (m_spComputeCuller)
+		{
+			m_spComputeCuller->cull(spCamera->getFrustum());
+			m_spComputeCuller->render();
+			return;
+		}
+
+		// Collect and sort visible visuals
+		spVisualCollector->collect(spNode, spCamera->getFrustum());
+		const auto& apVisuals = spVisualCollector->getVisuals();
+
+		// Render visible, sorted list of visuals. Visuals are skipped until their shaders have finished compiling.
 		boost::shared_ptr<Geometry> spGeometry = null_ptr;
 		boost::for_each(apVisuals, [this, &spGeometry](const Visual* pVisual) {
+			if (!pVisual->getMaterial()->isReady())
+				return;
+
 			pVisual->getMaterial()->bind();
+			if (pVisual->getAnimator())
+				pVisual->getAnimator()->bindPalette();
 			spGeometry = pVisual->getGeometry();
 			spGeometry->bind();
 			m_spRenderer->drawIndexed(spGeometry->getPrimitiveType(), spGeometry->getVertexList()->getNumIndices(), 0);
@@ -11,6 +11,7 @@ namespace baselib
 		class VisualCollector;
 		class FrameBuffer;
 		class Camera;
+		class ComputeCuller;
 	}
 }
 
@@ -24,6 +25,9 @@ namespace baselib
 		 *  A VisualCollector is used to cull visuals in this hierarchy and determine their rendering order.
 		 *  A Camera is used to determine where the scene is rendered from (i.e. Camera provides view and projection matrices).
 		 *  The scene is rendered into a FrameBuffer which can be the default back buffer or a set of textures setup as render targets.
+		 *
+		 *  With a ComputeCuller set, culling and draw submission move to the GPU. The culler's visuals are drawn instead of
+		 *  collecting them from the Node hierarchy, see ComputeCuller::setVisuals().
 		 */
 		class RenderJob
 		{
@@ -39,12 +43,19 @@ namespace baselib
 						 const boost::shared_ptr<VisualCollector>& spVisualCollector,
 						 const boost::shared_ptr<FrameBuffer>& spFrameBuffer,
 						 const boost::shared_ptr<Camera>& spCamera);
+
+			//! Cull and draw with a ComputeCuller instead of the VisualCollector. Null switches back to CPU culling.
+			void setComputeCuller(const boost::shared_ptr<ComputeCuller>& spComputeCuller) { m_spComputeCuller = spComputeCuller; }
+			//! Get the ComputeCuller, null if culling on the CPU.
+			const boost::shared_ptr<ComputeCuller>& getComputeCuller() const { return m_spComputeCuller; }
+
 		protected:
 			//! Protected constructor - must be created by static create().
 			RenderJob(const boost::shared_ptr<Renderer>& spRenderer);
 
 		private:
 			boost::shared_ptr<Renderer> m_spRenderer;
+			boost::shared_ptr<ComputeCuller> m_spComputeCuller;	//!< GPU culling, null to cull on the CPU.
 
 		};
 	}
@@ -4,12 +4,14 @@
 #include <Logging/Log.h>
 #include <Graphics/VertexList.h>
 #include <Graphics/StaticGeometry.h>
+#include <Graphics/DynamicGeometry.h>
 #include <Graphics/Material.h>
 #include <Graphics/FrameBuffer.h>
 #include <Graphics/Shader.h>
 #include <Graphics/Texture.h>
 
 #include <boost/range/algorithm/for_each.hpp>
+#include <algorithm>
 
 namespace baselib { namespace graphics {
 
@@ -38,6 +40,24 @@ namespace baselib { namespace graphics {
 		m_aeState[STATE_BLEND_DST] = ONE;
 		m_aeState[STATE_BLEND_SRC] = ONE;
 
+		m_bComputeShaders = GLEW_VERSION_4_3 || GLEW_ARB_compute_shader;
+		m_bIndirectDrawCount = GLEW_ARB_indirect_parameters == GL_TRUE;
+		for (unsigned int i = 0; i < 3; ++i)
+		{
+			int iMaxWorkGroups = 0;
+			if (m_bComputeShaders)
+				glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, i, &iMaxWorkGroups);
+			m_auMaxWorkGroups[i] = iMaxWorkGroups;
+		}
+
+		int iMaxTextureBufferSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &iMaxTextureBufferSize);
+		m_uMaxTextureBufferSize = iMaxTextureBufferSize;
+
+		int iUniformBufferOffsetAlignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &iUniformBufferOffsetAlignment);
+		m_uUniformAlignment = std::max(1, iUniformBufferOffsetAlignment);
+
 		//////////////////////////////////////////////////////////////////////////
 		// Temp settings for testing - these will be encapsulated elsewhere
 		setClearColour(Vec4(0.0f, 0.0f, 0.0f, 0.0f));
@@ -77,7 +97,71 @@ namespace baselib { namespace graphics {
 
 	void Renderer::drawIndexed(Geometry::PrimitiveType ePrimitiveType, unsigned int uIndexCount, unsigned int uIndexOffset)
 	{
-		glDrawElements(getGLPrimitive(ePrimitiveType), uIndexCount, GL_UNSIGNED_INT, (const GLvoid*) uIndexOffset);
+		glDrawElements(getGLPrimitive(ePrimitiveType), uIndexCount, GL_UNSIGNED_INT, (const GLvoid*) (uIndexOffset * sizeof(unsigned int)));
+	}
+
+	void Renderer::drawIndexedInstanced(Geometry::PrimitiveType ePrimitiveType, unsigned int uIndexCount, unsigned int uIndexOffset, unsigned int uInstanceCount)
+	{
+		if (uInstanceCount == 0)
+			return;
+
+		glDrawElementsInstanced(getGLPrimitive(ePrimitiveType), uIndexCount, GL_UNSIGNED_INT, (const GLvoid*) (uIndexOffset * sizeof(unsigned int)), uInstanceCount);
+	}
+
+	void Renderer::drawIndexedIndirect(Geometry::PrimitiveType ePrimitiveType, const boost::shared_ptr<Buffer>& spCommands, unsigned int uFirstCommand, unsigned int uMaxDraws,
+									   const boost::shared_ptr<Buffer>& spCount, unsigned int uCountOffset)
+	{
+		assert(spCommands && (uFirstCommand + uMaxDraws) * sizeof(DrawIndexedIndirectCommand) <= spCommands->getSize());
+		if (uMaxDraws == 0)
+			return;
+
+		spCommands->bindBase(Buffer::DRAW_INDIRECT, 0);
+		const GLvoid* pOffset = (const GLvoid*)(uFirstCommand * sizeof(DrawIndexedIndirectCommand));
+		if (spCount)
+		{
+			assert(m_bIndirectDrawCount);
+			spCount->bindBase(Buffer::PARAMETER, 0);
+			glMultiDrawElementsIndirectCountARB(getGLPrimitive(ePrimitiveType), GL_UNSIGNED_INT, pOffset, uCountOffset, uMaxDraws, sizeof(DrawIndexedIndirectCommand));
+		}
+		else
+		{
+			glMultiDrawElementsIndirect(getGLPrimitive(ePrimitiveType), GL_UNSIGNED_INT, pOffset, uMaxDraws, sizeof(DrawIndexedIndirectCommand));
+		}
+	}
+
+	void Renderer::dispatch(unsigned int uGroupsX, unsigned int uGroupsY, unsigned int uGroupsZ)
+	{
+		assert(m_bComputeShaders);
+		assert(uGroupsX <= m_auMaxWorkGroups[0] && uGroupsY <= m_auMaxWorkGroups[1] && uGroupsZ <= m_auMaxWorkGroups[2]);
+		if (uGroupsX == 0 || uGroupsY == 0 || uGroupsZ == 0)
+			return;
+		glDispatchCompute(uGroupsX, uGroupsY, uGroupsZ);
+	}
+
+	void Renderer::dispatchIndirect(const boost::shared_ptr<Buffer>& spBuffer, unsigned int uOffset)
+	{
+		assert(m_bComputeShaders);
+		assert(spBuffer && uOffset % 4 == 0 && uOffset + 3 * sizeof(unsigned int) <= spBuffer->getSize());
+		spBuffer->bindBase(Buffer::DISPATCH_INDIRECT, 0);
+		glDispatchComputeIndirect(uOffset);
+	}
+
+	void Renderer::memoryBarrier(BarrierMask eMask)
+	{
+		unsigned int uGLMask = 0;
+		uGLMask |= (eMask & BARRIER_VERTEX_ATTRIB) ? GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT : 0;
+		uGLMask |= (eMask & BARRIER_ELEMENT_ARRAY) ? GL_ELEMENT_ARRAY_BARRIER_BIT : 0;
+		uGLMask |= (eMask & BARRIER_UNIFORM) ? GL_UNIFORM_BARRIER_BIT : 0;
+		uGLMask |= (eMask & BARRIER_TEXTURE_FETCH) ? GL_TEXTURE_FETCH_BARRIER_BIT : 0;
+		uGLMask |= (eMask & BARRIER_SHADER_IMAGE_ACCESS) ? GL_SHADER_IMAGE_ACCESS_BARRIER_BIT : 0;
+		uGLMask |= (eMask & BARRIER_COMMAND) ? GL_COMMAND_BARRIER_BIT : 0;
+		uGLMask |= (eMask & BARRIER_BUFFER_UPDATE) ? GL_BUFFER_UPDATE_BARRIER_BIT : 0;
+		uGLMask |= (eMask & BARRIER_TEXTURE_UPDATE) ? GL_TEXTURE_UPDATE_BARRIER_BIT : 0;
+		uGLMask |= (eMask & BARRIER_SHADER_STORAGE) ? GL_SHADER_STORAGE_BARRIER_BIT : 0;
+		uGLMask |= (eMask & BARRIER_ATOMIC_COUNTER) ? GL_ATOMIC_COUNTER_BARRIER_BIT : 0;
+
+		if (uGLMask != 0)
+			glMemoryBarrier(uGLMask);
 	}
 
 	void Renderer::flush()
@@ -141,16 +225,38 @@ namespace baselib { namespace graphics {
 			case TYPE_FLOAT: return GL_FLOAT; break;
 			case TYPE_INT: return GL_INT; break;
 			case TYPE_BOOL: return GL_BOOL; break;
+			case TYPE_UNSIGNED_BYTE: return GL_UNSIGNED_BYTE; break;
 			default: LOG_ERROR << "Invalid vertex attribute type."; assert(false); return 0; break;
 			}
 		}
 
+		// Is the attribute read by the shader as integers rather than converted to floats?
+		bool isIntegerAttribute(const VertexAttribute& va)
+		{
+			return (va.eType == TYPE_INT || va.eType == TYPE_UNSIGNED_BYTE) && !va.bNormalized;
+		}
+
 		GLboolean getGLBool(bool bValue)
 		{
 			if (bValue) 
 				return GL_TRUE;
 			return GL_FALSE;
 		}
+
+		// Set the vertex attribute layout of the vertex list for the currently bound VAO and VBO.
+		void setVertexAttributes(const boost::shared_ptr<VertexListInterface>& spVertexList)
+		{
+			auto spVertexLayout = spVertexList->getVertexLayout();
+			int iVertexSize = spVertexList->getVertexSize();
+			auto aAttributes = spVertexLayout->getAttributes();
+			boost::for_each(aAttributes, [iVertexSize](const VertexAttribute& va) {
+				if (isIntegerAttribute(va))
+					glVertexAttribIPointer(va.iIndex, va.iNumElements, getGLType(va.eType), iVertexSize, (const GLvoid*)va.iOffset);
+				else
+					glVertexAttribPointer(va.iIndex, va.iNumElements, getGLType(va.eType), getGLBool(va.bNormalized), iVertexSize, (const GLvoid*)va.iOffset);
+				glEnableVertexAttribArray(va.iIndex);
+			});
+		}
 	}
 
 	boost::shared_ptr<StaticGeometry> Renderer::createStaticGeometry(const boost::shared_ptr<VertexListInterface>& spVertexList, Geometry::PrimitiveType ePrimitiveType)
@@ -169,13 +275,7 @@ namespace baselib { namespace graphics {
 		glBufferData(GL_ARRAY_BUFFER, spVertexList->getVertexBufferSize(), spVertexList->getVertexBufferData(), GL_STATIC_DRAW);
 
 		// Set vertex attribute layouts
-		auto spVertexLayout = spVertexList->getVertexLayout();
-		int iVertexSize = spVertexList->getVertexSize();
-		auto aAttributes = spVertexLayout->getAttributes();
-		boost::for_each(aAttributes, [iVertexSize](const VertexAttribute& va) {
-			glVertexAttribPointer(va.iIndex, va.iNumElements, getGLType(va.eType), getGLBool(va.bNormalized), iVertexSize, (const GLvoid*)va.iOffset);
-			glEnableVertexAttribArray(va.iIndex);
-		});
+		setVertexAttributes(spVertexList);
 
 		// Create index buffer
 		unsigned int uIB = ~0;
@@ -190,6 +290,50 @@ namespace baselib { namespace graphics {
 		return boost::shared_ptr<StaticGeometry>(new StaticGeometry(uVAO, uVBO, uIB, ePrimitiveType, spVertexList));
 	}
 
+	boost::shared_ptr<DynamicGeometry> Renderer::createDynamicGeometry(const boost::shared_ptr<VertexListInterface>& spVertexList, Geometry::PrimitiveType ePrimitiveType)
+	{
+		LOG_VERBOSE << "Creating dynamic geometry hardware buffers";
+
+		// Create VAO
+		unsigned int uVAO = ~0;
+		glGenVertexArrays(1, &uVAO);
+		glBindVertexArray(uVAO);
+
+		// Create vertex buffer (VBO) - storage is allocated by DynamicGeometry::update()
+		unsigned int uVBO = ~0;
+		glGenBuffers(1, &uVBO);
+		glBindBuffer(GL_ARRAY_BUFFER, uVBO);
+
+		// Set vertex attribute layouts
+		setVertexAttributes(spVertexList);
+
+		// Create index buffer
+		unsigned int uIB = ~0;
+		glGenBuffers(1, &uIB);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, uIB);
+
+		// Unbind VAO
+		glBindVertexArray(0);
+
+		auto spGeometry = boost::shared_ptr<DynamicGeometry>(new DynamicGeometry(uVAO, uVBO, uIB, ePrimitiveType, spVertexList));
+		spGeometry->update();
+		return spGeometry;
+	}
+
+	boost::shared_ptr<Buffer> Renderer::createBuffer(unsigned int uSize, Buffer::Usage eUsage, const void* pData)
+	{
+		LOG_VERBOSE << "Creating buffer";
+
+		unsigned int uID = ~0;
+		glGenBuffers(1, &uID);
+
+		auto spBuffer = boost::shared_ptr<Buffer>(new Buffer(uID, uSize, eUsage));
+		spBuffer->resize(uSize);
+		if (pData)
+			spBuffer->update(0, uSize, pData);
+		return spBuffer;
+	}
+
 	namespace
 	{
 		void enableGLState(unsigned int uGLState, Renderer::RenderStateValue eValue)
@@ -215,6 +359,8 @@ namespace baselib { namespace graphics {
 			case Renderer::ONE_MINUS_SRC_ALPHA: return GL_ONE_MINUS_SRC_ALPHA; break;
 			case Renderer::ONE_MINUS_DST: return GL_ONE_MINUS_DST_COLOR; break;
 			case Renderer::ONE_MINUS_DST_ALPHA: return GL_ONE_MINUS_DST_ALPHA; break;
+			case Renderer::SRC1: return GL_SRC1_COLOR; break;
+			case Renderer::ONE_MINUS_SRC1: return GL_ONE_MINUS_SRC1_COLOR; break;
 			default: LOG_ERROR << "Invalid render state value - expected blend factor value"; assert(false); return 0; break;
 			}
 		}
@@ -4,12 +4,14 @@
 #include <Math/Math.h>
 
 #include <Graphics/Geometry.h>
+#include <Graphics/Buffer.h>
 
 namespace baselib 
 {
 	namespace graphics
 	{
 		class StaticGeometry;
+		class DynamicGeometry;
 		class VertexListInterface;
 		class Material;
 		class FrameBuffer;
@@ -20,6 +22,16 @@ namespace baselib
 {
 	namespace graphics
 	{
+		//! Arguments of one draw of Renderer::drawIndexedIndirect(), laid out as OpenGL expects them.
+		struct DrawIndexedIndirectCommand
+		{
+			unsigned int uCount;			//!< Number of indices.
+			unsigned int uInstanceCount;	//!< Number of instances, 0 skips the draw.
+			unsigned int uFirstIndex;		//!< First index.
+			int iBaseVertex;				//!< Added to every index.
+			unsigned int uBaseInstance;		//!< First instance, visible to shaders through instanced attributes or gl_BaseInstanceARB.
+		};
+
 		/*! @brief Renderer interface. Wrapper for OpenGL API.
 		 *
 		 */
@@ -78,6 +90,8 @@ namespace baselib
 				ONE_MINUS_SRC_ALPHA,
 				ONE_MINUS_DST,
 				ONE_MINUS_DST_ALPHA,
+				SRC1,					// Second fragment shader output (dual source blending)
+				ONE_MINUS_SRC1,
 
 				// Blend operation values
 				FUNC_ADD,
@@ -107,14 +121,59 @@ namespace baselib
 				STENCIL_BUFFER = 4
 			};
 
+			//! Which kinds of access must see shader writes made before a memoryBarrier().
+			enum BarrierMask
+			{
+				BARRIER_VERTEX_ATTRIB = 1,			//!< Vertex attributes sourced from buffers.
+				BARRIER_ELEMENT_ARRAY = 2,			//!< Index buffers.
+				BARRIER_UNIFORM = 4,				//!< Uniform buffers.
+				BARRIER_TEXTURE_FETCH = 8,			//!< Texture sampling.
+				BARRIER_SHADER_IMAGE_ACCESS = 16,	//!< Image loads and stores.
+				BARRIER_COMMAND = 32,				//!< Indirect draw and dispatch arguments.
+				BARRIER_BUFFER_UPDATE = 64,			//!< Buffer uploads and reads, see Buffer::read().
+				BARRIER_TEXTURE_UPDATE = 128,		//!< Texture uploads and reads.
+				BARRIER_SHADER_STORAGE = 256,		//!< Shader storage buffer loads and stores.
+				BARRIER_ATOMIC_COUNTER = 512,		//!< Atomic counters.
+				BARRIER_ALL = 1023
+			};
+
 			//! Creates a Renderer.
 			static boost::shared_ptr<Renderer> create();
 
 			//! Destructor.
 			virtual ~Renderer();
 		
-			//! Draw indexed geometry defined by the buffers in the currently bound VAO.
+			//! Draw indexed geometry defined by the buffers in the currently bound VAO. uIndexOffset is the first index to draw.
 			void drawIndexed(Geometry::PrimitiveType ePrimitiveType, unsigned int uIndexCount, unsigned int uIndexOffset);
+			//! Draw uInstanceCount instances of indexed geometry in the bound VAO. Shaders tell the instances apart by gl_InstanceID.
+			void drawIndexedInstanced(Geometry::PrimitiveType ePrimitiveType, unsigned int uIndexCount, unsigned int uIndexOffset, unsigned int uInstanceCount);
+			//! Get the largest number of texels a buffer texture can address, see Texture::create(const boost::shared_ptr<Buffer>&, Format).
+			unsigned int getMaxTextureBufferSize() const { return m_uMaxTextureBufferSize; }
+			//! Get the alignment of offsets Buffer::bindRange() takes for uniform buffers (GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT).
+			unsigned int getUniformBufferOffsetAlignment() const { return m_uUniformAlignment; }
+
+			//! Does the context support compute shaders (GL 4.3 or GL_ARB_compute_shader)?
+			bool hasComputeShaders() const { return m_bComputeShaders; }
+			/*! @brief Run the bound compute shader for a grid of work groups.
+			 *
+			 *  Bind a Shader whose pipeline contains a compute shader first. Storage buffers and images are bound with
+			 *  Buffer::bindBase() and Texture::bindImage(). Call memoryBarrier() before using the results.
+			 */
+			void dispatch(unsigned int uGroupsX, unsigned int uGroupsY = 1, unsigned int uGroupsZ = 1);
+			//! Run the bound compute shader with the work group counts read from three uints in spBuffer at uOffset, e.g. written by an earlier dispatch.
+			void dispatchIndirect(const boost::shared_ptr<Buffer>& spBuffer, unsigned int uOffset = 0);
+			//! Make shader writes visible to the kinds of access in eMask that follow.
+			void memoryBarrier(BarrierMask eMask);
+
+			//! Can the number of indirect draws be read from a buffer (GL_ARB_indirect_parameters)?
+			bool hasIndirectDrawCount() const { return m_bIndirectDrawCount; }
+			/*! @brief Draw indexed geometry in the bound VAO with DrawIndexedIndirectCommands read from a buffer.
+			 *
+			 *  uMaxDraws commands are read from spCommands starting at uFirstCommand. If spCount is set the number of draws
+			 *  is read from the uint at uCountOffset bytes in it instead, up to uMaxDraws. That requires hasIndirectDrawCount().
+			 */
+			void drawIndexedIndirect(Geometry::PrimitiveType ePrimitiveType, const boost::shared_ptr<Buffer>& spCommands, unsigned int uFirstCommand, unsigned int uMaxDraws,
+									 const boost::shared_ptr<Buffer>& spCount = boost::shared_ptr<Buffer>(), unsigned int uCountOffset = 0);
 
 			//! Flush the pipeline.
 			void flush();
@@ -141,6 +200,10 @@ namespace baselib
 
 			//! Create a static geometry.
 			boost::shared_ptr<StaticGeometry> createStaticGeometry(const boost::shared_ptr<VertexListInterface>& spVertexList, Geometry::PrimitiveType ePrimitiveType);
+			//! Create a dynamic geometry. The vertex list contents are uploaded by DynamicGeometry::update().
+			boost::shared_ptr<DynamicGeometry> createDynamicGeometry(const boost::shared_ptr<VertexListInterface>& spVertexList, Geometry::PrimitiveType ePrimitiveType);
+			//! Create a buffer of uSize bytes, initialized from pData if it isn't NULL.
+			boost::shared_ptr<Buffer> createBuffer(unsigned int uSize, Buffer::Usage eUsage, const void* pData = NULL);
 
 		protected:
 			//! Protected constructor - must be created by static create().
@@ -157,6 +220,11 @@ namespace baselib
 			Vec4 m_vClearColour;					  //!< Current clear colour. Current render target will be cleared to this colour when calling clear().
 			Vec4 m_vViewportSize;					  //!< Current viewport size.
 			RenderStateValue m_aeState[STATE_COUNT];  //!< Current render state values.
+			bool m_bComputeShaders;					  //!< Are compute shaders supported?
+			bool m_bIndirectDrawCount;				  //!< Is GL_ARB_indirect_parameters supported?
+			unsigned int m_auMaxWorkGroups[3];		  //!< Largest number of work groups per dispatch in each dimension.
+			unsigned int m_uMaxTextureBufferSize;	  //!< Largest number of texels in a buffer texture.
+			unsigned int m_uUniformAlignment;		  //!< Alignment of uniform buffer range offsets.
 		};
 	}
 }
\ No newline at end of file
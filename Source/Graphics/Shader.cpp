@@ -1,14 +1,16 @@
 #include "Shader.h"
 
 #include <Logging/Log.h>
+#include <Graphics/ShaderPipeline.h>
 #include <GL/glew.h>
+#include <boost/range/algorithm/for_each.hpp>
 
 namespace baselib { namespace graphics {
 
 	unsigned int Shader::m_uCurrentlyBound = ~0;
 
-	Shader::Shader(unsigned int uID)
-		: m_uID(uID)
+	Shader::Shader(const boost::shared_ptr<ShaderPipeline>& spPipeline)
+		: m_spPipeline(spPipeline)
 	{
 		LOG_VERBOSE << "Shader constructor";
 	}
@@ -18,19 +20,44 @@ namespace baselib { namespace graphics {
 		LOG_VERBOSE << "Shader destructor";
 	}
 
+	unsigned int Shader::getID() const
+	{
+		return m_spPipeline->getID();
+	}
+
 	void Shader::bind()
 	{
-		if (m_uID == m_uCurrentlyBound)
+		if (m_spPipeline->isSeparable())
+		{
+			// A program in use takes precedence over the bound program pipeline object
+			if (m_uCurrentlyBound != 0)
+			{
+				glUseProgram(0);
+				m_uCurrentlyBound = 0;
+			}
+			glBindProgramPipeline(m_spPipeline->getID());
+			return;
+		}
+
+		unsigned int uID = m_spPipeline->getID();
+		if (uID == m_uCurrentlyBound)
 			return;
 
-		glUseProgram(m_uID);
-		m_uCurrentlyBound = m_uID;
+		m_spPipeline->finish();
+		glUseProgram(uID);
+		m_uCurrentlyBound = uID;
+	}
+
+	bool Shader::isReady() const
+	{
+		return m_spPipeline->isReady();
 	}
 
 	int Shader::getAttribute(const std::string& sName) const
 	{
 		assert(!sName.empty());
-		int iAtrribute = glGetAttribLocation(m_uID, sName.c_str());
+		m_spPipeline->finish();
+		int iAtrribute = glGetAttribLocation(m_spPipeline->getVertexProgram(), sName.c_str());
 		assert(iAtrribute != -1);
 		return iAtrribute;
 	}
@@ -38,35 +65,83 @@ namespace baselib { namespace graphics {
 	int Shader::getUniform(const std::string& sName) const
 	{
 		assert(!sName.empty());
+		m_spPipeline->finish();
+		if (m_spPipeline->isSeparable())
+		{
+			int iUniform = m_spPipeline->getSeparableUniform(sName);
+			assert(iUniform != -1);
+			return iUniform;
+		}
+
 		const GLchar* szName = sName.c_str();
-		int iUniform = glGetUniformLocation(m_uID, szName);
+		int iUniform = glGetUniformLocation(getID(), szName);
 		assert(iUniform != -1);
 		return iUniform;
 	}
 
 	void Shader::setUniform(int iIndex, float f)
 	{
-		glUniform1f(iIndex, f);
+		if (!m_spPipeline->isSeparable())
+		{
+			glUniform1f(iIndex, f);
+			return;
+		}
+
+		boost::for_each(m_spPipeline->getUniformLocations(iIndex), [&f](const ShaderPipeline::UniformLocation& location) {
+			glProgramUniform1f(location.uProgram, location.iLocation, f);
+		});
 	}
 
 	void Shader::setUniform(int iIndex, Vec2 v)
 	{
-		glUniform2f(iIndex, v.x, v.y);
+		if (!m_spPipeline->isSeparable())
+		{
+			glUniform2f(iIndex, v.x, v.y);
+			return;
+		}
+
+		boost::for_each(m_spPipeline->getUniformLocations(iIndex), [&v](const ShaderPipeline::UniformLocation& location) {
+			glProgramUniform2f(location.uProgram, location.iLocation, v.x, v.y);
+		});
 	}
 
 	void Shader::setUniform(int iIndex, Vec3 v)
 	{
-		glUniform3f(iIndex, v.x, v.y, v.z);
+		if (!m_spPipeline->isSeparable())
+		{
+			glUniform3f(iIndex, v.x, v.y, v.z);
+			return;
+		}
+
+		boost::for_each(m_spPipeline->getUniformLocations(iIndex), [&v](const ShaderPipeline::UniformLocation& location) {
+			glProgramUniform3f(location.uProgram, location.iLocation, v.x, v.y, v.z);
+		});
 	}
 
 	void Shader::setUniform(int iIndex, Vec4 v)
 	{
-		glUniform4f(iIndex, v.x, v.y, v.z, v.w);
+		if (!m_spPipeline->isSeparable())
+		{
+			glUniform4f(iIndex, v.x, v.y, v.z, v.w);
+			return;
+		}
+
+		boost::for_each(m_spPipeline->getUniformLocations(iIndex), [&v](const ShaderPipeline::UniformLocation& location) {
+			glProgramUniform4f(location.uProgram, location.iLocation, v.x, v.y, v.z, v.w);
+		});
 	}
 
 	void Shader::setUniform( int iIndex, int i )
 	{
-		glUniform1i(iIndex, i);
+		if (!m_spPipeline->isSeparable())
+		{
+			glUniform1i(iIndex, i);
+			return;
+		}
+
+		boost::for_each(m_spPipeline->getUniformLocations(iIndex), [&i](const ShaderPipeline::UniformLocation& location) {
+			glProgramUniform1i(location.uProgram, location.iLocation, i);
+		});
 	}
 
 } }
\ No newline at end of file
@@ -2,6 +2,15 @@
 
 #include <string>
 #include <Math/Math.h>
+#include <boost/shared_ptr.hpp>
+
+namespace baselib 
+{
+	namespace graphics
+	{
+		class ShaderPipeline;
+	}
+}
 
 namespace baselib 
 {
@@ -11,6 +20,7 @@ namespace baselib
 		 *
 		 *  A Shader has unique uniforms, textures etc. but can be an instance 
 		 *  of the same pipeline as other Shaders (i.e. share the shader program ID).
+		 *  Binding or querying a Shader whose pipeline is still compiling waits for the pipeline to finish.
 		 */
 		class Shader
 		{
@@ -23,12 +33,16 @@ namespace baselib
 			//! Bind shader.
 			void bind();
 
-			//! Get shader ID.
-			unsigned int getID() const { return m_uID; }
+			//! Get shader ID. Changes when the pipeline is relinked.
+			unsigned int getID() const;
+			//! Get the pipeline this shader is an instance of.
+			const boost::shared_ptr<ShaderPipeline>& getPipeline() const { return m_spPipeline; }
+			//! Has the pipeline finished compiling and linking? Doesn't block, see ShaderPipeline::isReady().
+			bool isReady() const;
 
 			//! Get attribute index from name.
 			int getAttribute(const std::string& sName) const;
-			//! Get uniform index from name.
+			//! Get uniform index from name. For separable pipelines this indexes the uniform's locations in every stage.
 			int getUniform(const std::string& sName) const;
 		
 			//! Set float uniform variable.
@@ -45,12 +59,12 @@ namespace baselib
 
 		protected:
 			//! Protected constructor - must be created by ShaderPipeline.
-			Shader(unsigned int uID);
+			Shader(const boost::shared_ptr<ShaderPipeline>& spPipeline);
 
 		private:
 			static unsigned int m_uCurrentlyBound; //!< Currently bound shader.
 
-			unsigned int m_uID; //!< Shader program ID.
+			boost::shared_ptr<ShaderPipeline> m_spPipeline; //!< Pipeline that owns the shader program.
 			
 		};
 	}
@@ -2,11 +2,14 @@
 
 #include <GL/glew.h>
 #include <Logging/Log.h>
+#include <Graphics/ShaderPipeline.h>
 #include <Helpers/ResourceCache.h>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/range/algorithm/for_each.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/assign/list_of.hpp>
+#include <algorithm>
+#include <sstream>
 
 namespace baselib { namespace graphics {
 
@@ -36,25 +39,175 @@ namespace baselib { namespace graphics {
 		unsigned int getGLShaderType(ShaderObject::ShaderType eType) { return aShaderTypeMap[eType].second;	}
 		std::string getShaderTypeString(ShaderObject::ShaderType eType) { return aShaderTypeMap[eType].first; }
 
-		// Loads source code from a text file into sSource string.
-		std::string loadSourceFromFile(const fs::path& fsPath)
+		// Read a whole file. Returns false if it can't be opened.
+		bool readFile(const fs::path& fsPath, std::string& sContents)
 		{
 			fs::ifstream inFile(fsPath);
 			if (!inFile.is_open())
 			{
 				LOG_ERROR << "Failed to open file " << fsPath;
-				assert(false);
+				return false;
 			}
 
-			std::string sSource;
-			sSource.assign(std::istreambuf_iterator<char>(inFile), std::istreambuf_iterator<char>());
+			sContents.assign(std::istreambuf_iterator<char>(inFile), std::istreambuf_iterator<char>());
+			return true;
+		}
+
+		// Get the file name of an #include "file" directive. Returns false if the line isn't an include.
+		bool parseInclude(const std::string& sLine, std::string& sInclude)
+		{
+			size_t uPos = sLine.find_first_not_of(" \t");
+			if (uPos == std::string::npos || sLine[uPos] != '#')
+				return false;
+
+			uPos = sLine.find_first_not_of(" \t", uPos + 1);
+			if (uPos == std::string::npos || sLine.compare(uPos, 7, "include") != 0)
+				return false;
+
+			size_t uBegin = sLine.find('"', uPos + 7);
+			size_t uEnd = uBegin == std::string::npos ? std::string::npos : sLine.find('"', uBegin + 1);
+			if (uEnd == std::string::npos)
+				return false;
+
+			sInclude = sLine.substr(uBegin + 1, uEnd - uBegin - 1);
+			return true;
+		}
+
+		// Loads source code from a text file into sSource, expanding #include "file" directives relative to the including
+		// file. Every file is included once, which also breaks include cycles. The canonical path of every file read is
+		// added to afsFiles and its index is the GLSL source string number used in #line directives, so compiler
+		// messages refer to the right file and line.
+		bool loadSourceFromFile(const fs::path& fsPath, std::vector<fs::path>& afsFiles, std::string& sSource)
+		{
+			boost::system::error_code ec;
+			fs::path fsCanonical = fs::canonical(fsPath, ec);
+			if (ec)
+			{
+				LOG_ERROR << "Cannot find shader source file " << fsPath;
+				return false;
+			}
 
-			inFile.close();
-			return sSource;
+			if (std::find(afsFiles.begin(), afsFiles.end(), fsCanonical) != afsFiles.end())
+				return true;
+
+			unsigned int uFile = afsFiles.size();
+			afsFiles.push_back(fsCanonical);
+
+			std::string sContents;
+			if (!readFile(fsCanonical, sContents))
+				return false;
+
+			std::stringstream ssContents(sContents);
+			std::string sLine;
+			std::string sInclude;
+			for (int iLine = 1; std::getline(ssContents, sLine); ++iLine)
+			{
+				if (!parseInclude(sLine, sInclude))
+				{
+					sSource += sLine;
+					sSource += '\n';
+					continue;
+				}
+
+				// Files that were included before add nothing, not even the #line directive
+				size_t uMark = sSource.length();
+				unsigned int uNumFiles = afsFiles.size();
+				std::stringstream ss;
+				ss << "#line 1 " << uNumFiles << "\n";
+				sSource += ss.str();
+				if (!loadSourceFromFile(fsCanonical.parent_path() / sInclude, afsFiles, sSource))
+				{
+					LOG_ERROR << "Included from " << fsCanonical << " line " << iLine;
+					return false;
+				}
+				if (afsFiles.size() == uNumFiles)
+					sSource.resize(uMark);
+
+				ss.str("");
+				ss << "#line " << iLine + 1 << " " << uFile << "\n";
+				sSource += ss.str();
+			}
+
+			return true;
+		}
+
+		// Get the compile status and log the compiler output.
+		bool getCompileStatus(unsigned int uShaderObjectID, const std::string& sShaderType, const std::string& sName, const std::vector<fs::path>& afsFiles)
+		{
+			int iCompileStatus = 0;
+			glGetShaderiv(uShaderObjectID, GL_COMPILE_STATUS, &iCompileStatus);
+			if (iCompileStatus == GL_TRUE)
+				LOG_VERBOSE << "Successfully compiled " << sShaderType << " shader";
+			else
+				LOG_ERROR << "Failed to compile " << sShaderType << " shader " << sName;
+
+			// Get GLSL compiler log
+			int iLogLength = 0;
+			glGetShaderiv(uShaderObjectID, GL_INFO_LOG_LENGTH, &iLogLength);
+			char *szLog = new char[iLogLength + 1];
+			glGetShaderInfoLog(uShaderObjectID, iLogLength, NULL, szLog);
+			szLog[iLogLength] = 0;
+			std::string sCompilerLog(szLog);
+			delete[] szLog;
+
+			if (!sCompilerLog.empty())
+			{
+				LOG_INFO << sCompilerLog;
+
+				// Messages refer to files by source string number
+				for (unsigned int i = 1; i < afsFiles.size(); ++i)
+					LOG_INFO << "Source string " << i << ": " << afsFiles[i];
+			}
+
+			return iCompileStatus == GL_TRUE;
+		}
+
+		// Shader objects loaded from files, for reloading
+		std::vector<boost::weak_ptr<ShaderObject>> awpLoadedShaders;
+
+		// Insert #defines after the #version directive, which has to come first. The #line directive restores the line numbering.
+		std::string injectDefines(const std::string& sSource, const std::vector<std::string>& aDefines)
+		{
+			if (aDefines.empty())
+				return sSource;
+
+			size_t uInsert = 0;
+			int iNextLine = 1;
+			size_t uVersion = sSource.find("#version");
+			if (uVersion != std::string::npos)
+			{
+				uInsert = sSource.find('\n', uVersion);
+				uInsert = uInsert == std::string::npos ? sSource.length() : uInsert + 1;
+				iNextLine = 2 + std::count(sSource.begin(), sSource.begin() + uVersion, '\n');
+			}
+
+			std::stringstream ss;
+			if (uInsert == sSource.length() && uInsert > 0 && sSource[uInsert - 1] != '\n')
+				ss << "\n";
+			boost::for_each(aDefines, [&ss](const std::string& sDefine) {
+				ss << "#define " << sDefine << "\n";
+			});
+			ss << "#line " << iNextLine << "\n";
+
+			std::string sResult = sSource;
+			sResult.insert(uInsert, ss.str());
+			return sResult;
+		}
+
+		// Cache key and name suffix for a set of defines, e.g. " [SKINNED FOG]".
+		std::string getDefinesString(const std::vector<std::string>& aDefines)
+		{
+			if (aDefines.empty())
+				return "";
+
+			std::string sDefines = " [";
+			for (unsigned int i = 0; i < aDefines.size(); ++i)
+				sDefines += (i > 0 ? " " : "") + aDefines[i];
+			return sDefines + "]";
 		}
 	}
 
-	boost::shared_ptr<ShaderObject> ShaderObject::load(const fs::path& fsPath)
+	boost::shared_ptr<ShaderObject> ShaderObject::load(const fs::path& fsPath, const std::vector<std::string>& aDefines)
 	{
 		// Check if file exists
 		if (!fs::exists(fsPath))
@@ -66,8 +219,9 @@ namespace baselib { namespace graphics {
 		// Get canonical path
 		std::string sCanonicalPath = fs::canonical(fsPath).string();
 
-		// Check shader cache
-		if (auto sp = m_ShaderCache.get(sCanonicalPath))
+		// Check shader cache. Every set of defines is a separate shader object.
+		std::string sDefines = getDefinesString(aDefines);
+		if (auto sp = m_ShaderCache.get(sCanonicalPath + sDefines))
 			return sp;
 
 		// Check if file has an extension
@@ -90,80 +244,159 @@ namespace baselib { namespace graphics {
 
 		// Load the shader source from file and create the shader object
 		LOG_INFO << "Loading: " << sCanonicalPath;
-		std::string sSource = loadSourceFromFile(sCanonicalPath);
-		auto spShaderObject = ShaderObject::create(sSource, eType);
-		spShaderObject->setName(fsPath.string());
+		std::vector<fs::path> afsFiles;
+		std::string sSource;
+		if (!loadSourceFromFile(sCanonicalPath, afsFiles, sSource))
+		{
+			LOG_ERROR << "Failed to load shader source file " << sCanonicalPath;
+			assert(false);
+		}
+
+		auto spShaderObject = ShaderObject::create(sSource, eType, aDefines);
+		spShaderObject->setName(fsPath.string() + sDefines);
+		spShaderObject->m_fsPath = sCanonicalPath;
+		spShaderObject->m_aDefines = aDefines;
+		spShaderObject->m_afsDependencies = afsFiles;
 
 		// Cache the shader object
-		m_ShaderCache.add(sCanonicalPath, spShaderObject);
+		m_ShaderCache.add(sCanonicalPath + sDefines, spShaderObject);
+		awpLoadedShaders.push_back(spShaderObject);
 
 		return spShaderObject;
 	}
 
-	boost::shared_ptr<ShaderObject> ShaderObject::create(const std::string& sShaderSource, ShaderType eType)
+	boost::shared_ptr<ShaderObject> ShaderObject::create(const std::string& sShaderSource, ShaderType eType, const std::vector<std::string>& aDefines)
 	{
-		// Get GL shader type
-		unsigned int uGLShaderType = getGLShaderType(eType);
+		return boost::shared_ptr<ShaderObject>(new ShaderObject("", eType, injectDefines(sShaderSource, aDefines)));
+	}
 
-		// Get shader type as a string
-		std::string sShaderType = getShaderTypeString(eType);
+	ShaderObject::ShaderObject(const std::string& sName, ShaderType eType, const std::string& sSource) 
+		: m_sName(sName)
+		, m_sSource(sSource)
+		, m_eType(eType)
+		, m_uID(0)
+		, m_uSeparableProgram(0)
+		, m_bCompiled(false)
+		, m_bValid(false)
+	{
+		LOG_VERBOSE << "ShaderObject constructor";
+	}
+
+	void ShaderObject::submit()
+	{
+		if (m_uID != 0)
+			return;
 
 		// Create the shader
-		LOG_VERBOSE << "Creating " << sShaderType << " shader";
-		unsigned int uShaderObjectID = glCreateShader(uGLShaderType);
-		assert(uShaderObjectID);
+		LOG_VERBOSE << "Creating " << getShaderTypeString(m_eType) << " shader";
+		m_uID = glCreateShader(getGLShaderType(m_eType));
+		assert(m_uID);
 
 		// Commit the shader source to compiler
-		const char* szShaderSource = sShaderSource.c_str();
-		glShaderSource(uShaderObjectID, 1, (const char**)&szShaderSource, NULL);
+		const char* szShaderSource = m_sSource.c_str();
+		glShaderSource(m_uID, 1, (const char**)&szShaderSource, NULL);
 
-		// Compile the shader
-		LOG_INFO << "Compiling " << sShaderType << " shader";
-		glCompileShader(uShaderObjectID);
+		// Compile the shader. Querying anything but the completion status would wait for the compiler.
+		LOG_INFO << "Compiling " << getShaderTypeString(m_eType) << " shader " << m_sName;
+		glCompileShader(m_uID);
+	}
 
-		// Get GLSL compiler status
-		int iCompileStatus = 0;
-		glGetShaderiv(uShaderObjectID, GL_COMPILE_STATUS, &iCompileStatus);
-		if (iCompileStatus == GL_TRUE)
-		{
-			LOG_VERBOSE << "Successfully compiled " << sShaderType << " shader";
-		}
-		else
+	bool ShaderObject::compile()
+	{
+		if (m_bCompiled)
+			return m_bValid;
+
+		submit();
+		m_bCompiled = true;
+		m_bValid = getCompileStatus(m_uID, getShaderTypeString(m_eType), m_sName, m_afsDependencies);
+
+		// Assert after logging GLSL compiler errors
+		assert(m_bValid);
+		return m_bValid;
+	}
+
+	bool ShaderObject::dependsOn(const fs::path& fsCanonicalPath) const
+	{
+		return std::find(m_afsDependencies.begin(), m_afsDependencies.end(), fsCanonicalPath) != m_afsDependencies.end();
+	}
+
+	bool ShaderObject::reload()
+	{
+		if (m_fsPath.empty())
+			return false;
+
+		std::vector<fs::path> afsFiles;
+		std::string sSource;
+		if (!loadSourceFromFile(m_fsPath, afsFiles, sSource))
+			return false;
+
+		// Includes may have changed even if the result is the same
+		m_afsDependencies = afsFiles;
+		sSource = injectDefines(sSource, m_aDefines);
+		if (sSource == m_sSource)
+			return false;
+
+		// Compile the new source next to the current shader, which is kept if compilation fails
+		LOG_INFO << "Reloading " << getShaderTypeString(m_eType) << " shader " << m_sName;
+		unsigned int uShaderObjectID = glCreateShader(getGLShaderType(m_eType));
+		const char* szShaderSource = sSource.c_str();
+		glShaderSource(uShaderObjectID, 1, (const char**)&szShaderSource, NULL);
+		glCompileShader(uShaderObjectID);
+		if (!getCompileStatus(uShaderObjectID, getShaderTypeString(m_eType), m_sName, afsFiles))
 		{
-			LOG_ERROR << "Failed to compile " << sShaderType << " shader";
+			LOG_ERROR << "Keeping the previous version of " << m_sName;
 			glDeleteShader(uShaderObjectID);
-			uShaderObjectID = ~0;
-			// Assert after logging GLSL compiler errors
+			return false;
 		}
 
-		// Get GLSL compiler log
-		int iLogLength = 0;
-		glGetShaderiv(uShaderObjectID, GL_INFO_LOG_LENGTH, &iLogLength);
-		char *szLog = new char[iLogLength + 1];
-		glGetShaderInfoLog(uShaderObjectID, iLogLength, NULL, szLog);
-		std::string sCompilerLog(szLog);
-		delete[] szLog;
-
-		if (!sCompilerLog.empty())
-			LOG_INFO << sCompilerLog;
+		// Programs the old shader is attached to keep it alive until they are relinked
+		if (m_uID != 0)
+			glDeleteShader(m_uID);
+		m_uID = uShaderObjectID;
+		m_sSource = sSource;
 
-		assert(iCompileStatus == GL_TRUE);
-
-		return boost::shared_ptr<ShaderObject>(new ShaderObject("", eType, uShaderObjectID, sShaderSource));;
+		// The separable program is linked again by the next separable pipeline relinked with this shader
+		if (m_uSeparableProgram != 0)
+		{
+			ShaderPipeline::releaseSeparableProgram(m_uSeparableProgram);
+			m_uSeparableProgram = 0;
+		}
+		m_bCompiled = true;
+		m_bValid = true;
+		return true;
 	}
 
-	ShaderObject::ShaderObject(const std::string& sName, ShaderType eType, unsigned int iID, const std::string& sSource) : m_sName(sName)
-		, m_eType(eType)
-		, m_uID(iID)
-		, m_sSource(sSource)
+	std::vector<boost::shared_ptr<ShaderObject>> ShaderObject::reloadFiles(const std::vector<fs::path>& afsChanged)
 	{
-		LOG_VERBOSE << "ShaderObject constructor";
+		std::vector<boost::shared_ptr<ShaderObject>> aspReloaded;
+		for (auto it = awpLoadedShaders.begin(); it != awpLoadedShaders.end(); )
+		{
+			auto spShaderObject = it->lock();
+			if (!spShaderObject)
+			{
+				it = awpLoadedShaders.erase(it);
+				continue;
+			}
+			++it;
+
+			bool bAffected = false;
+			boost::for_each(afsChanged, [&](const fs::path& fsPath) {
+				bAffected = bAffected || spShaderObject->dependsOn(fsPath);
+			});
+
+			if (bAffected && spShaderObject->reload())
+				aspReloaded.push_back(spShaderObject);
+		}
+		return aspReloaded;
 	}
 
 	ShaderObject::~ShaderObject()
 	{
 		LOG_VERBOSE << "ShaderObject destructor";
-		glDeleteShader(m_uID);
+		if (m_uSeparableProgram != 0)
+			ShaderPipeline::releaseSeparableProgram(m_uSeparableProgram);
+		if (m_uID != 0)
+			glDeleteShader(m_uID);
 	}
 
 } }
\ No newline at end of file
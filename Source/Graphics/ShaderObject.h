@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include <boost/filesystem.hpp>
 
@@ -12,10 +13,20 @@ namespace baselib
 	{
 		/*! @brief A ShaderObject represents a single programmable stage in a render pipeline.
 		 *
+		 *  The source is compiled on first use, so a ShaderPipeline that is restored from the program binary
+		 *  cache never invokes the GLSL compiler for its shader objects. Compilation is split into submit(), which
+		 *  hands the source to the driver, and compile(), which waits for the result. Pipelines submit all of their
+		 *  shaders before checking any of them so the driver can compile them in parallel.
+		 *
+		 *  Shader files may #include "file" other files, relative to the including file. The files a shader object
+		 *  was loaded from are its dependencies; reloadFiles() recompiles the shader objects that depend on changed
+		 *  files, see ShaderWatcher.
 		 */
 		class ShaderObject
 		{
 		public:
+			friend class ShaderPipeline;
+
 			//! All possible types of shader objects
 			enum ShaderType
 			{
@@ -29,11 +40,15 @@ namespace baselib
 				NUM_SHADER_TYPES
 			};
 
-			//! Load and creates a shader object from file. File extension determines shader type.
-			static boost::shared_ptr<ShaderObject> load(const fs::path& fsPath);
+			//! Load and creates a shader object from file. File extension determines shader type. See create() for aDefines.
+			static boost::shared_ptr<ShaderObject> load(const fs::path& fsPath, const std::vector<std::string>& aDefines = std::vector<std::string>());
 
-			//! Creates, compiles and returns a shader object from source.
-			static boost::shared_ptr<ShaderObject> create(const std::string& sShaderSource, ShaderType eType);
+			/*! @brief Creates a shader object from source. It is compiled by submit(), compile() or the first getID().
+			 *
+			 *  Each entry of aDefines is injected as "#define <entry>" straight after the #version directive, followed
+			 *  by a #line directive so compiler messages still refer to lines in the original source.
+			 */
+			static boost::shared_ptr<ShaderObject> create(const std::string& sShaderSource, ShaderType eType, const std::vector<std::string>& aDefines = std::vector<std::string>());
 
 			//! Destructor.
 			virtual ~ShaderObject();
@@ -46,18 +61,47 @@ namespace baselib
 			std::string getSource() const { return m_sSource; }
 			//! Get the shader type.
 			ShaderType getType() const { return m_eType; }
-			//! Get shader ID.
-			unsigned int getID() const { return m_uID; }
+			//! Get shader ID. Submits the shader for compilation if that hasn't happened yet, without waiting for it.
+			unsigned int getID() { submit(); return m_uID; }
+			//! Get the separable program containing only this shader, 0 if no separable pipeline has used it yet. See ShaderPipeline::createSeparable().
+			unsigned int getSeparableProgram() const { return m_uSeparableProgram; }
+
+			//! Start compiling the shader if it hasn't been submitted yet. Doesn't check the result.
+			void submit();
+			//! Wait for the shader to compile, then check and log the result. Returns false if compilation failed.
+			bool compile();
+			//! Has the result of the compilation been checked?
+			bool isCompiled() const { return m_bCompiled; }
+
+			//! Get the canonical paths of the files the shader was loaded from, starting with the shader file itself. Empty if it was created from source.
+			const std::vector<fs::path>& getDependencies() const { return m_afsDependencies; }
+			//! Was the shader loaded from a file, or does it include it?
+			bool dependsOn(const fs::path& fsCanonicalPath) const;
+			/*! @brief Load the shader's files again and recompile it if the source changed.
+			 *
+			 *  The shader is compiled immediately. If compilation fails the error is logged and the previous
+			 *  version is kept. Returns true if the shader changed and programs using it have to be relinked.
+			 */
+			bool reload();
+
+			//! Reload every loaded shader object that depends on one of the changed files. Returns the shader objects that changed.
+			static std::vector<boost::shared_ptr<ShaderObject>> reloadFiles(const std::vector<fs::path>& afsChanged);
 
 		protected:
 			//! Protected constructor - must be created by static create().
-			ShaderObject(const std::string& sName, ShaderType eType, unsigned int iID, const std::string& sSource);
+			ShaderObject(const std::string& sName, ShaderType eType, const std::string& sSource);
 
 		private:
 			std::string m_sName;	//!< Shader name.
 			std::string m_sSource;	//!< The shader object source code.
 			ShaderType m_eType;	//!< Type of shader object.
-			unsigned int m_uID;		//!< Shader object ID.
+			unsigned int m_uID;		//!< Shader object ID, 0 until submitted.
+			unsigned int m_uSeparableProgram;	//!< Separable program linked from this shader alone, owned by the shader object. Created by ShaderPipeline.
+			bool m_bCompiled;		//!< Has the compile status been checked?
+			bool m_bValid;			//!< Did the shader compile?
+			fs::path m_fsPath;		//!< Canonical path of the shader file, empty if created from source.
+			std::vector<std::string> m_aDefines;		//!< Defines the shader was loaded with.
+			std::vector<fs::path> m_afsDependencies;	//!< Files the source was loaded from, indexed by GLSL source string number.
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "ShaderPermutations.h"
+
+#include <Logging/Log.h>
+#include <Graphics/ShaderObject.h>
+#include <Graphics/ShaderPipeline.h>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/range/algorithm/for_each.hpp>
+#include <sstream>
+
+namespace baselib { namespace graphics {
+
+	boost::shared_ptr<ShaderPermutations> ShaderPermutations::create(const std::string& sName, const std::vector<fs::path>& afsPaths, const std::vector<std::string>& aKeywords)
+	{
+		if (aKeywords.size() > MAX_KEYWORDS)
+		{
+			LOG_ERROR << "Shader permutations " << sName << " have " << aKeywords.size() << " keywords, the maximum is " << MAX_KEYWORDS;
+			assert(false);
+		}
+
+		return boost::shared_ptr<ShaderPermutations>(new ShaderPermutations(sName, afsPaths, aKeywords));
+	}
+
+	ShaderPermutations::ShaderPermutations(const std::string& sName, const std::vector<fs::path>& afsPaths, const std::vector<std::string>& aKeywords)
+		: m_sName(sName)
+		, m_afsPaths(afsPaths)
+		, m_aKeywords(aKeywords)
+		, m_uValidFeatures(aKeywords.size() >= MAX_KEYWORDS ? ~0u : (1u << aKeywords.size()) - 1)
+	{
+		LOG_VERBOSE << "ShaderPermutations constructor";
+	}
+
+	ShaderPermutations::~ShaderPermutations()
+	{
+		LOG_VERBOSE << "ShaderPermutations destructor";
+	}
+
+	unsigned int ShaderPermutations::getFeature(const std::string& sKeyword) const
+	{
+		for (unsigned int i = 0; i < m_aKeywords.size(); ++i)
+		{
+			if (m_aKeywords[i] == sKeyword)
+				return 1u << i;
+		}
+		return 0;
+	}
+
+	unsigned int ShaderPermutations::getFeatures(const std::string& sKeywords) const
+	{
+		unsigned int uFeatures = 0;
+		std::stringstream ss(sKeywords);
+		std::string sKeyword;
+		while (ss >> sKeyword)
+		{
+			unsigned int uFeature = getFeature(sKeyword);
+			if (uFeature == 0)
+				LOG_WARNING << "Unknown keyword " << sKeyword << " for shader permutations " << m_sName;
+			uFeatures |= uFeature;
+		}
+		return uFeatures;
+	}
+
+	const boost::shared_ptr<ShaderPipeline>& ShaderPermutations::getVariant(unsigned int uFeatures)
+	{
+		uFeatures &= m_uValidFeatures;
+
+		boost::shared_ptr<ShaderPipeline>& spVariant = m_Variants[uFeatures];
+		if (spVariant)
+			return spVariant;
+
+		// Define the keyword of every enabled feature and name the variant after them
+		std::vector<std::string> aDefines;
+		std::string sName = m_sName;
+		for (unsigned int i = 0; i < m_aKeywords.size(); ++i)
+		{
+			if (uFeatures & (1u << i))
+			{
+				aDefines.push_back(m_aKeywords[i]);
+				sName += " " + m_aKeywords[i];
+			}
+		}
+
+		std::vector<boost::shared_ptr<ShaderObject>> aspShaderObjects;
+		boost::for_each(m_afsPaths, [&aspShaderObjects, &aDefines](const fs::path& fsPath) {
+			aspShaderObjects.push_back(ShaderObject::load(fsPath, aDefines));
+		});
+
+		spVariant = ShaderPipeline::createAsync(sName, aspShaderObjects);
+		return spVariant;
+	}
+
+	bool ShaderPermutations::precompile(const fs::path& fsManifest)
+	{
+		fs::ifstream file(fsManifest);
+		if (!file.is_open())
+		{
+			LOG_WARNING << "Failed to open shader manifest " << fsManifest;
+			return false;
+		}
+
+		LOG_INFO << "Precompiling shader permutations " << m_sName << " from " << fsManifest;
+		std::string sLine;
+		while (std::getline(file, sLine))
+		{
+			size_t uComment = sLine.find('#');
+			if (uComment != std::string::npos)
+			{
+				// A line that only holds a comment isn't the variant without features
+				if (sLine.find_first_not_of(" \t") == uComment)
+					continue;
+				sLine.erase(uComment);
+			}
+
+			getVariant(getFeatures(sLine));
+		}
+
+		return true;
+	}
+
+} }
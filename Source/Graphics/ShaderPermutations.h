@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace baselib 
+{
+	namespace graphics
+	{
+		class ShaderPipeline;
+	}
+}
+
+namespace baselib 
+{
+	namespace graphics
+	{
+		/*! @brief Generates ShaderPipeline variants of a set of shader files from feature keywords.
+		 *
+		 *  Each keyword is a feature the shader sources implement under #ifdef <keyword>. A variant is identified by a
+		 *  bitmask of enabled features, where bit i is the i-th keyword, and is built by loading the shader files with
+		 *  those keywords defined. Variants are created on demand with ShaderPipeline::createAsync() and cached, so
+		 *  a material only pays for the features it uses instead of branching in an uber-shader.
+		 *
+		 *  precompile() creates the variants listed in a manifest up front, e.g. at load time, so the first frame that
+		 *  needs them doesn't have to wait for the compiler. Manifests list one variant per line as its keywords
+		 *  separated by spaces. An empty line is the variant without features, # starts a comment.
+		 */
+		class ShaderPermutations
+		{
+		public:
+			//! Maximum number of feature keywords.
+			static const unsigned int MAX_KEYWORDS = 32;
+
+			//! Creates a ShaderPermutations for the shader files in afsPaths and up to MAX_KEYWORDS feature keywords.
+			static boost::shared_ptr<ShaderPermutations> create(const std::string& sName, const std::vector<fs::path>& afsPaths, const std::vector<std::string>& aKeywords);
+
+			//! Destructor.
+			~ShaderPermutations();
+
+			//! Get the feature bit for a keyword, 0 if the keyword is unknown.
+			unsigned int getFeature(const std::string& sKeyword) const;
+			//! Get the feature mask for a space separated list of keywords. Unknown keywords are logged and ignored.
+			unsigned int getFeatures(const std::string& sKeywords) const;
+
+			//! Get the variant for a feature mask, creating it if it hasn't been created yet. Unknown feature bits are ignored.
+			const boost::shared_ptr<ShaderPipeline>& getVariant(unsigned int uFeatures);
+			//! Create every variant listed in a manifest file. Returns false if the manifest can't be read.
+			bool precompile(const fs::path& fsManifest);
+
+			//! Get the name.
+			const std::string& getName() const { return m_sName; }
+			//! Get the feature keywords.
+			const std::vector<std::string>& getKeywords() const { return m_aKeywords; }
+			//! Get the number of variants created so far.
+			unsigned int getNumVariants() const { return m_Variants.size(); }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			ShaderPermutations(const std::string& sName, const std::vector<fs::path>& afsPaths, const std::vector<std::string>& aKeywords);
+
+		private:
+			std::string m_sName;																//!< Name, variant pipelines are named after it.
+			std::vector<fs::path> m_afsPaths;													//!< Shader files, one per stage.
+			std::vector<std::string> m_aKeywords;												//!< Feature keywords, bit i is m_aKeywords[i].
+			unsigned int m_uValidFeatures;														//!< Mask of all known feature bits.
+			boost::unordered_map<unsigned int, boost::shared_ptr<ShaderPipeline>> m_Variants;	//!< Variants by feature mask.
+		};
+	}
+}
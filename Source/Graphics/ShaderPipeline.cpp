@@ -4,7 +4,14 @@
 #include <Logging/Log.h>
 #include <Graphics/Shader.h>
 #include <Graphics/ShaderObject.h>
+#include <Graphics/Helpers/ParallelShaderCompile.h>
+#include <Helpers/Hash.h>
+#include <boost/filesystem/fstream.hpp>
 #include <boost/range/algorithm/for_each.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/weak_ptr.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace baselib { namespace graphics {
 
@@ -45,9 +52,288 @@ namespace baselib { namespace graphics {
 
 			return bValid;
 		}
+
+		// Program binary cache file layout: BinaryHeader followed by uLength bytes of program binary.
+		// Bump the version when the layout changes.
+		const char BINARY_MAGIC[4] = { 'G', 'L', 'P', 'B' };
+		const unsigned int BINARY_VERSION = 1;
+
+		struct BinaryHeader
+		{
+			char acMagic[4];
+			unsigned int uVersion;
+			unsigned __int64 uKey;
+			unsigned int uFormat;
+			unsigned int uLength;
+		};
+
+		fs::path fsCacheDirectory;
+
+		// Separable program support, checked the first time a separable pipeline is created
+		bool bSeparableChecked = false;
+		bool bSeparablePrograms = false;
+
+		// Every pipeline, for relinking
+		std::vector<boost::weak_ptr<ShaderPipeline>> awpPipelines;
+
+		// Program pipeline objects shared by separable pipelines, keyed by the separable program of each shader type (0 if unused)
+		typedef std::vector<unsigned int> StagePrograms;
+		boost::unordered_map<StagePrograms, unsigned int> ProgramPipelines;
+
+		// Hash everything a program binary depends on. Binaries are only valid for the driver that created them.
+		unsigned __int64 getProgramKey(const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects)
+		{
+			unsigned __int64 uKey = FNV1A_OFFSET_BASIS;
+			const GLenum aeDriverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+			for (unsigned int i = 0; i < sizeof(aeDriverStrings) / sizeof(aeDriverStrings[0]); ++i)
+			{
+				const char* szString = reinterpret_cast<const char*>(glGetString(aeDriverStrings[i]));
+				uKey = hashFNV1a(std::string(szString ? szString : ""), uKey);
+			}
+
+			boost::for_each(aspShaderObjects, [&uKey](const boost::shared_ptr<ShaderObject>& spShaderObject) {
+				int iType = spShaderObject->getType();
+				uKey = hashFNV1a(&iType, sizeof(iType), uKey);
+				uKey = hashFNV1a(spShaderObject->getSource(), uKey);
+			});
+
+			return uKey;
+		}
+
+		// Get the link status and log the linker output.
+		bool getLinkStatus(unsigned int uShaderProgramID)
+		{
+			int iLinkStatus = 0;
+			glGetProgramiv(uShaderProgramID, GL_LINK_STATUS, &iLinkStatus);
+
+			int iLogLength = 0;
+			glGetProgramiv(uShaderProgramID, GL_INFO_LOG_LENGTH, &iLogLength);
+			char *szLog = new char[iLogLength + 1];
+			glGetProgramInfoLog(uShaderProgramID, iLogLength, NULL, szLog);
+			szLog[iLogLength] = 0;
+			std::string sLinkerLog(szLog);
+			delete[] szLog;
+
+			if (!sLinkerLog.empty())
+				LOG_INFO << sLinkerLog;
+
+			return iLinkStatus == GL_TRUE;
+		}
+
+		// Restore a program from a cached binary. Returns false if there is no matching binary or the driver rejects it.
+		bool loadBinary(unsigned int uShaderProgramID, const fs::path& fsPath, unsigned __int64 uKey)
+		{
+			boost::system::error_code ec;
+			if (!fs::exists(fsPath, ec))
+				return false;
+
+			boost::uintmax_t uFileSize = fs::file_size(fsPath, ec);
+			if (ec)
+				return false;
+
+			// The length is checked against the file before allocating, a corrupt header mustn't allocate gigabytes
+			fs::ifstream file(fsPath, std::ios::in | std::ios::binary);
+			BinaryHeader header;
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+				memcmp(header.acMagic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 ||
+				header.uVersion != BINARY_VERSION ||
+				header.uKey != uKey ||
+				header.uLength == 0 ||
+				header.uLength > uFileSize - sizeof(header))
+			{
+				LOG_INFO << "Program binary doesn't match, ignoring " << fsPath;
+				return false;
+			}
+
+			std::vector<char> aBinary(header.uLength);
+			if (!file.read(&aBinary[0], aBinary.size()))
+			{
+				LOG_WARNING << "Program binary is truncated: " << fsPath;
+				return false;
+			}
+
+			glProgramBinary(uShaderProgramID, header.uFormat, &aBinary[0], aBinary.size());
+
+			int iLinkStatus = 0;
+			glGetProgramiv(uShaderProgramID, GL_LINK_STATUS, &iLinkStatus);
+			if (iLinkStatus != GL_TRUE)
+			{
+				LOG_INFO << "Driver rejected program binary " << fsPath;
+				return false;
+			}
+
+			return true;
+		}
+
+		// Save a linked program's binary. Failing to save is not an error, the program is just compiled again next time.
+		void saveBinary(unsigned int uShaderProgramID, const fs::path& fsPath, unsigned __int64 uKey)
+		{
+			int iLength = 0;
+			glGetProgramiv(uShaderProgramID, GL_PROGRAM_BINARY_LENGTH, &iLength);
+			if (iLength <= 0)
+				return;
+
+			std::vector<char> aBinary(iLength);
+			GLenum eFormat = 0;
+			glGetProgramBinary(uShaderProgramID, iLength, &iLength, &eFormat, &aBinary[0]);
+
+			boost::system::error_code ec;
+			fs::create_directories(fsPath.parent_path(), ec);
+
+			// Write to a temporary file and rename it so that a crash never leaves a half written binary behind
+			fs::path fsTempPath = fsPath;
+			fsTempPath += ".tmp";
+			bool bWritten = false;
+			{
+				fs::ofstream file(fsTempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+
+				BinaryHeader header;
+				memcpy(header.acMagic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+				header.uVersion = BINARY_VERSION;
+				header.uKey = uKey;
+				header.uFormat = eFormat;
+				header.uLength = iLength;
+				file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				file.write(&aBinary[0], iLength);
+
+				file.close();
+				bWritten = !file.fail();
+			}
+
+			// Don't leave temporary files behind when writing or renaming fails
+			if (!bWritten)
+			{
+				LOG_WARNING << "Failed to write program binary " << fsTempPath;
+				fs::remove(fsTempPath, ec);
+				return;
+			}
+
+			fs::rename(fsTempPath, fsPath, ec);
+			if (ec)
+			{
+				LOG_WARNING << "Failed to write program binary " << fsPath << ": " << ec.message();
+				fs::remove(fsTempPath, ec);
+			}
+		}
+	}
+
+	namespace
+	{
+		// Can linked programs be saved to the cache directory?
+		bool isBinaryCacheEnabled()
+		{
+			if (fsCacheDirectory.empty() || !(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary))
+				return false;
+
+			// Drivers without any binary formats can't save programs
+			int iNumFormats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &iNumFormats);
+			return iNumFormats > 0;
+		}
+
+		// Link a program containing only one shader object, to be combined with others in program pipeline objects.
+		// Returns 0 if linking fails.
+		unsigned int linkSeparableProgram(const boost::shared_ptr<ShaderObject>& spShaderObject)
+		{
+			unsigned int uProgramID = glCreateProgram();
+			assert(uProgramID);
+			glProgramParameteri(uProgramID, GL_PROGRAM_SEPARABLE, GL_TRUE);
+
+			// Salt the key so a separable program never matches a pipeline linked from the same single shader object
+			fs::path fsBinaryPath;
+			unsigned __int64 uKey = 0;
+			if (isBinaryCacheEnabled())
+			{
+				uKey = hashFNV1a(std::string("separable"), getProgramKey(std::vector<boost::shared_ptr<ShaderObject>>(1, spShaderObject)));
+				fsBinaryPath = fsCacheDirectory / (hashToString(uKey) + ".glprogram");
+				if (loadBinary(uProgramID, fsBinaryPath, uKey))
+				{
+					LOG_VERBOSE << "Restored separable program from program binary";
+					return uProgramID;
+				}
+				glProgramParameteri(uProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			}
+
+			LOG_VERBOSE << "Linking separable program for " << spShaderObject->getName();
+			glAttachShader(uProgramID, spShaderObject->getID());
+			glLinkProgram(uProgramID);
+			glDetachShader(uProgramID, spShaderObject->getID());
+			spShaderObject->compile();
+
+			if (!getLinkStatus(uProgramID))
+			{
+				glDeleteProgram(uProgramID);
+				return 0;
+			}
+
+			if (!fsBinaryPath.empty())
+				saveBinary(uProgramID, fsBinaryPath, uKey);
+
+			return uProgramID;
+		}
+
+		// Get the stage bit glUseProgramStages uses for a shader type.
+		GLbitfield getStageBit(int iType)
+		{
+			switch (iType)
+			{
+			case ShaderObject::VERTEX_SHADER:			return GL_VERTEX_SHADER_BIT;
+			case ShaderObject::TESS_CONTROL_SHADER:		return GL_TESS_CONTROL_SHADER_BIT;
+			case ShaderObject::TESS_EVALUATION_SHADER:	return GL_TESS_EVALUATION_SHADER_BIT;
+			case ShaderObject::GEOMETRY_SHADER:			return GL_GEOMETRY_SHADER_BIT;
+			case ShaderObject::FRAGMENT_SHADER:			return GL_FRAGMENT_SHADER_BIT;
+			case ShaderObject::COMPUTE_SHADER:			return GL_COMPUTE_SHADER_BIT;
+			default:
+				LOG_ERROR << "Invalid shader type";
+				assert(false);
+				return 0;
+			}
+		}
+
+		// Get the program pipeline object for a combination of separable programs, creating it the first time it is needed.
+		unsigned int getProgramPipeline(const StagePrograms& auPrograms)
+		{
+			auto it = ProgramPipelines.find(auPrograms);
+			if (it != ProgramPipelines.end())
+				return it->second;
+
+			LOG_VERBOSE << "Creating program pipeline object";
+			unsigned int uPipelineID = 0;
+			glGenProgramPipelines(1, &uPipelineID);
+			assert(uPipelineID);
+			for (unsigned int i = 0; i < auPrograms.size(); ++i)
+			{
+				if (auPrograms[i] != 0)
+					glUseProgramStages(uPipelineID, getStageBit(i), auPrograms[i]);
+			}
+
+			ProgramPipelines[auPrograms] = uPipelineID;
+			return uPipelineID;
+		}
+
+		// Find a uniform in the separable program of every shader object.
+		std::vector<ShaderPipeline::UniformLocation> findUniformLocations(const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects, const std::string& sName)
+		{
+			std::vector<ShaderPipeline::UniformLocation> aLocations;
+			boost::for_each(aspShaderObjects, [&](const boost::shared_ptr<ShaderObject>& spShaderObject) {
+				ShaderPipeline::UniformLocation location;
+				location.uProgram = spShaderObject->getSeparableProgram();
+				location.iLocation = glGetUniformLocation(location.uProgram, sName.c_str());
+				if (location.iLocation != -1)
+					aLocations.push_back(location);
+			});
+			return aLocations;
+		}
 	}
 
 	boost::shared_ptr<ShaderPipeline> ShaderPipeline::create(const std::string& sName, const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects)
+	{
+		auto spPipeline = createAsync(sName, aspShaderObjects);
+		spPipeline->finish();
+		return spPipeline;
+	}
+
+	boost::shared_ptr<ShaderPipeline> ShaderPipeline::createAsync(const std::string& sName, const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects)
 	{
 		if (!isValidPipeline(aspShaderObjects))
 		{
@@ -59,83 +345,332 @@ namespace baselib { namespace graphics {
 		LOG_INFO << "Creating shader pipeline: " << sName;
 		unsigned int uShaderProgramID = glCreateProgram();
 		assert(uShaderProgramID);
+		auto spPipeline = boost::shared_ptr<ShaderPipeline>(new ShaderPipeline(sName, uShaderProgramID, aspShaderObjects));
+
+		if (isBinaryCacheEnabled())
+		{
+			spPipeline->m_uBinaryKey = getProgramKey(aspShaderObjects);
+			spPipeline->m_fsBinaryPath = fsCacheDirectory / (hashToString(spPipeline->m_uBinaryKey) + ".glprogram");
+		}
 
-		// Attach shader objects
+		if (!spPipeline->m_fsBinaryPath.empty() && loadBinary(uShaderProgramID, spPipeline->m_fsBinaryPath, spPipeline->m_uBinaryKey))
+		{
+			LOG_VERBOSE << "Restored shader pipeline from program binary";
+			spPipeline->m_bFinished = true;
+			spPipeline->m_bLinked = true;
+			awpPipelines.push_back(spPipeline);
+			return spPipeline;
+		}
+
+		// Submit every shader object before attaching any so they can compile in parallel
 		LOG_VERBOSE << "Attaching shader objects to pipeline";
+		boost::for_each(aspShaderObjects, [](const boost::shared_ptr<ShaderObject>& spShaderObject) {
+			spShaderObject->submit();
+		});
 		boost::for_each(aspShaderObjects, [&uShaderProgramID](const boost::shared_ptr<ShaderObject>& spShaderObject) {
 			glAttachShader(uShaderProgramID, spShaderObject->getID());
 		});
 
-		// Link shader program
+		// Link shader program. The status is checked by finish().
 		LOG_VERBOSE << "Linking shader pipeline";
+		if (!spPipeline->m_fsBinaryPath.empty())
+			glProgramParameteri(uShaderProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 		glLinkProgram(uShaderProgramID);
 
-		// Detach shader objects for release build only.
-		// After linking a shader program the shader objects can be detached and are no longer needed.
-		// Keeping them attached, and alive, is useful for debugging purposes though.
-		// gDEBugger can, for example, rebuild and relink programs on the fly if they remain attached.
-		#ifndef _DEBUG
-		boost::for_each(aspShaderObjects, [&uShaderProgramID](const boost::shared_ptr<ShaderObject>& spShaderObject) {
-			glDetachShader(uShaderProgramID, spShaderObject->getID());
-		});
-		#endif
+		awpPipelines.push_back(spPipeline);
+		return spPipeline;
+	}
+
+	boost::shared_ptr<ShaderPipeline> ShaderPipeline::createSeparable(const std::string& sName, const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects)
+	{
+		if (!hasSeparablePrograms())
+			return create(sName, aspShaderObjects);
 
-		// Get linker status
-		int iLinkStatus = 0;
-		glGetProgramiv(uShaderProgramID, GL_LINK_STATUS, &iLinkStatus);
+		if (!isValidPipeline(aspShaderObjects))
+		{
+			LOG_ERROR << "Trying to create shader pipeline with invalid combination of shader objects";
+			assert(false);
+		}
 
-		// Get linker log
-		int iLogLength = 0;
-		glGetProgramiv(uShaderProgramID, GL_INFO_LOG_LENGTH, &iLogLength);
-		char *szLog = new char[iLogLength + 1];
-		glGetProgramInfoLog(uShaderProgramID, iLogLength, NULL, szLog);
-		std::string sLinkerLog(szLog);
-		delete[] szLog;
+		LOG_INFO << "Creating separable shader pipeline: " << sName;
+		auto spPipeline = boost::shared_ptr<ShaderPipeline>(new ShaderPipeline(sName, 0, aspShaderObjects));
+		spPipeline->m_bSeparable = true;
 
-		if (!sLinkerLog.empty())
-			LOG_INFO << sLinkerLog;
+		// Submit every shader object before linking any so they can compile in parallel
+		boost::for_each(aspShaderObjects, [](const boost::shared_ptr<ShaderObject>& spShaderObject) {
+			spShaderObject->submit();
+		});
 
-		// Check linker status
-		if (iLinkStatus == GL_FALSE)
+		spPipeline->m_bFinished = true;
+		spPipeline->m_bLinked = spPipeline->linkSeparable();
+		if (!spPipeline->m_bLinked)
 		{
-			LOG_ERROR << "Failed to link shader pipeline";
-			glDeleteProgram(uShaderProgramID);
+			LOG_ERROR << "Failed to link separable shader pipeline " << sName;
 			assert(false);
 		}
 
-		// Let the ShaderPipeline keep the shader objects alive for debug configurations. For release
-		// configurations let them go out of scope and destroy the hardware buffers which are no longer required.
-		#ifdef _DEBUG
-		return boost::shared_ptr<ShaderPipeline>(new ShaderPipeline(sName, uShaderProgramID, aspShaderObjects));
-		#else
-		return boost::shared_ptr<ShaderPipeline>(new ShaderPipeline(sName, uShaderProgramID));
-		#endif
+		awpPipelines.push_back(spPipeline);
+		return spPipeline;
 	}
 
-	ShaderPipeline::ShaderPipeline(const std::string& sName, unsigned int uID)
-		: m_sName(sName)
-		, m_uID(uID)
+	bool ShaderPipeline::hasSeparablePrograms()
 	{
-		LOG_VERBOSE << "ShaderPipeline constructor";
+		if (!bSeparableChecked)
+		{
+			bSeparableChecked = true;
+			bSeparablePrograms = GLEW_VERSION_4_1 || GLEW_ARB_separate_shader_objects;
+			if (!bSeparablePrograms)
+				LOG_INFO << "Separable programs are not supported, separable shader pipelines are linked as single programs";
+		}
+		return bSeparablePrograms;
 	}
 
 	ShaderPipeline::ShaderPipeline(const std::string& sName, unsigned int uID, const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects)
 		: m_sName(sName)
 		, m_uID(uID)
 		, m_aspShaderObjects(aspShaderObjects)
+		, m_uBinaryKey(0)
+		, m_bFinished(false)
+		, m_bLinked(false)
+		, m_bSeparable(false)
 	{
-		LOG_VERBOSE << "ShaderPipeline debug constructor";
+		LOG_VERBOSE << "ShaderPipeline constructor";
 	}
 
 	ShaderPipeline::~ShaderPipeline()
 	{
 		LOG_VERBOSE << "ShaderPipeline destructor";
+
+		// Program pipeline objects are shared and stay cached
+		if (!m_bSeparable)
+			glDeleteProgram(m_uID);
+	}
+
+	bool ShaderPipeline::isReady()
+	{
+		if (m_bFinished)
+			return true;
+
+		if (!isProgramLinkComplete(m_uID))
+			return false;
+
+		finish();
+		return true;
+	}
+
+	bool ShaderPipeline::finish()
+	{
+		if (m_bFinished)
+			return m_bLinked;
+		m_bFinished = true;
+
+		// Check the shader objects first, their logs explain most link failures
+		boost::for_each(m_aspShaderObjects, [](const boost::shared_ptr<ShaderObject>& spShaderObject) {
+			spShaderObject->compile();
+		});
+
+		// Check linker status
+		m_bLinked = getLinkStatus(m_uID);
+		if (!m_bLinked)
+		{
+			LOG_ERROR << "Failed to link shader pipeline " << m_sName;
+			assert(false);
+		}
+		else if (!m_fsBinaryPath.empty())
+		{
+			saveBinary(m_uID, m_fsBinaryPath, m_uBinaryKey);
+		}
+
+		detachShaderObjects();
+		return m_bLinked;
+	}
+
+	void ShaderPipeline::detachShaderObjects()
+	{
+		// Detach shader objects for release build only.
+		// After linking a shader program the shader objects can be detached and are no longer needed by the program.
+		// Keeping them attached is useful for debugging purposes though.
+		// gDEBugger can, for example, rebuild and relink programs on the fly if they remain attached.
+		#ifndef _DEBUG
+		boost::for_each(m_aspShaderObjects, [this](const boost::shared_ptr<ShaderObject>& spShaderObject) {
+			glDetachShader(m_uID, spShaderObject->getID());
+		});
+		#endif
+	}
+
+	bool ShaderPipeline::linkSeparable()
+	{
+		bool bLinked = true;
+		StagePrograms auPrograms(ShaderObject::NUM_SHADER_TYPES, 0);
+		boost::for_each(m_aspShaderObjects, [&](const boost::shared_ptr<ShaderObject>& spShaderObject) {
+			if (spShaderObject->m_uSeparableProgram == 0)
+				spShaderObject->m_uSeparableProgram = linkSeparableProgram(spShaderObject);
+
+			if (spShaderObject->m_uSeparableProgram == 0)
+			{
+				LOG_ERROR << "Failed to link separable program for " << spShaderObject->getName();
+				bLinked = false;
+			}
+			auPrograms[spShaderObject->getType()] = spShaderObject->m_uSeparableProgram;
+		});
+
+		if (!bLinked)
+			return false;
+
+		m_uID = getProgramPipeline(auPrograms);
+
+		// The programs may have changed, look the uniforms up again without changing their indices
+		boost::for_each(m_aUniforms, [this](SeparableUniform& uniform) {
+			uniform.aLocations = findUniformLocations(m_aspShaderObjects, uniform.sName);
+		});
+		return true;
+	}
+
+	int ShaderPipeline::getSeparableUniform(const std::string& sName)
+	{
+		assert(m_bSeparable);
+		for (unsigned int i = 0; i < m_aUniforms.size(); ++i)
+		{
+			if (m_aUniforms[i].sName == sName)
+				return i;
+		}
+
+		SeparableUniform uniform;
+		uniform.sName = sName;
+		uniform.aLocations = findUniformLocations(m_aspShaderObjects, sName);
+
+		if (uniform.aLocations.empty())
+			return -1;
+
+		m_aUniforms.push_back(uniform);
+		return m_aUniforms.size() - 1;
+	}
+
+	unsigned int ShaderPipeline::getVertexProgram() const
+	{
+		if (!m_bSeparable)
+			return m_uID;
+
+		for (unsigned int i = 0; i < m_aspShaderObjects.size(); ++i)
+		{
+			if (m_aspShaderObjects[i]->getType() == ShaderObject::VERTEX_SHADER)
+				return m_aspShaderObjects[i]->m_uSeparableProgram;
+		}
+		return 0;
+	}
+
+	void ShaderPipeline::releaseSeparableProgram(unsigned int uProgram)
+	{
+		for (auto it = ProgramPipelines.begin(); it != ProgramPipelines.end(); )
+		{
+			if (std::find(it->first.begin(), it->first.end(), uProgram) != it->first.end())
+			{
+				glDeleteProgramPipelines(1, &it->second);
+				it = ProgramPipelines.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		glDeleteProgram(uProgram);
+	}
+
+	unsigned int ShaderPipeline::getNumProgramPipelines()
+	{
+		return ProgramPipelines.size();
+	}
+
+	bool ShaderPipeline::relink()
+	{
+		// Reloaded shader objects dropped their separable program and the program pipeline objects using it
+		if (m_bSeparable)
+		{
+			LOG_INFO << "Relinking separable shader pipeline: " << m_sName;
+			if (!linkSeparable())
+			{
+				LOG_ERROR << "Failed to relink separable shader pipeline " << m_sName;
+				return false;
+			}
+			return true;
+		}
+
+		LOG_INFO << "Relinking shader pipeline: " << m_sName;
+		unsigned int uShaderProgramID = glCreateProgram();
+		assert(uShaderProgramID);
+
+		boost::for_each(m_aspShaderObjects, [&uShaderProgramID](const boost::shared_ptr<ShaderObject>& spShaderObject) {
+			glAttachShader(uShaderProgramID, spShaderObject->getID());
+		});
+
+		// The sources changed, so does the binary's key
+		if (!m_fsBinaryPath.empty())
+		{
+			m_uBinaryKey = getProgramKey(m_aspShaderObjects);
+			m_fsBinaryPath = fsCacheDirectory / (hashToString(m_uBinaryKey) + ".glprogram");
+			glProgramParameteri(uShaderProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glLinkProgram(uShaderProgramID);
+
+		if (!getLinkStatus(uShaderProgramID))
+		{
+			LOG_ERROR << "Failed to relink shader pipeline " << m_sName << ", keeping the previous program";
+			glDeleteProgram(uShaderProgramID);
+			return false;
+		}
+
+		if (!m_fsBinaryPath.empty())
+			saveBinary(uShaderProgramID, m_fsBinaryPath, m_uBinaryKey);
+
+		// Swap the program, Shader instances pick the new ID up the next time they are bound.
+		// The old ID may be reused by the driver, so it must not be considered bound anymore.
+		if (Shader::m_uCurrentlyBound == m_uID)
+			Shader::m_uCurrentlyBound = ~0;
 		glDeleteProgram(m_uID);
+		m_uID = uShaderProgramID;
+		m_bFinished = true;
+		m_bLinked = true;
+		detachShaderObjects();
+		return true;
+	}
+
+	unsigned int ShaderPipeline::relinkPipelines(const std::vector<boost::shared_ptr<ShaderObject>>& aspChanged)
+	{
+		unsigned int uNumRelinked = 0;
+		for (auto it = awpPipelines.begin(); it != awpPipelines.end(); )
+		{
+			auto spPipeline = it->lock();
+			if (!spPipeline)
+			{
+				it = awpPipelines.erase(it);
+				continue;
+			}
+			++it;
+
+			bool bAffected = false;
+			boost::for_each(aspChanged, [&](const boost::shared_ptr<ShaderObject>& spShaderObject) {
+				bAffected = bAffected || std::find(spPipeline->m_aspShaderObjects.begin(), spPipeline->m_aspShaderObjects.end(), spShaderObject) != spPipeline->m_aspShaderObjects.end();
+			});
+
+			if (bAffected && spPipeline->relink())
+				++uNumRelinked;
+		}
+		return uNumRelinked;
+	}
+
+	void ShaderPipeline::setCacheDirectory(const fs::path& fsDirectory)
+	{
+		fsCacheDirectory = fsDirectory;
+	}
+
+	const fs::path& ShaderPipeline::getCacheDirectory()
+	{
+		return fsCacheDirectory;
 	}
 
 	boost::shared_ptr<Shader> ShaderPipeline::createInstance()
 	{
-		return boost::shared_ptr<Shader>(new Shader(m_uID));
+		return boost::shared_ptr<Shader>(new Shader(shared_from_this()));
 	}
 
 } }
\ No newline at end of file
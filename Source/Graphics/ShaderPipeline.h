@@ -3,6 +3,10 @@
 #include <string>
 #include <vector>
 #include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
 
 namespace baselib 
 {
@@ -21,42 +25,116 @@ namespace baselib
 		 *
 		 *  Shader instances created from the same pipeline share the same ID
 		 *  but have different uniforms, textures etc.
+		 *
+		 *  If a cache directory is set, linked programs are saved there with glGetProgramBinary and restored with
+		 *  glProgramBinary the next time a pipeline with the same shader sources is created, skipping the GLSL
+		 *  compiler entirely. Binaries are keyed by the driver strings and the type and complete source of every
+		 *  shader object, so a driver update or an edited shader falls back to compiling and replaces the binary.
+		 *
+		 *  createAsync() submits the compiles and the link without waiting for them. Create every pipeline that is
+		 *  needed up front so the driver can work on them in parallel, see hasParallelShaderCompile(). The compile and
+		 *  link status are checked by finish(), which is called when a Shader instance is first bound or queried.
+		 *  isReady() polls for completion without blocking when the driver supports it.
+		 *
+		 *  A pipeline keeps its shader objects so it can be relinked in place when they are reloaded, see ShaderWatcher.
+		 *  Relinking swaps the program ID, Shader instances use the new program the next time they are bound but
+		 *  uniform values set on the old program are lost.
+		 *
+		 *  createSeparable() creates a pipeline from separable programs (GL_ARB_separate_shader_objects) instead.
+		 *  Each shader object is linked into a program of its own once, the first time any separable pipeline uses
+		 *  it, and combinations are bound through program pipeline objects that are created on demand and shared
+		 *  by every pipeline with the same stages. Mixing N vertex with M fragment shaders then links N + M
+		 *  programs instead of N * M. Separable programs go through the same binary cache.
+		 *  Uniforms are set with glProgramUniform on every stage that declares them, see getUniform().
+		 *  Without separable program support, see hasSeparablePrograms(), createSeparable() falls back to create().
 		 */
-		class ShaderPipeline
+		class ShaderPipeline : public boost::enable_shared_from_this<ShaderPipeline>
 		{
 		public:
 			//! Creates and links a shader pipeline with the given shader objects.
 			static boost::shared_ptr<ShaderPipeline> create(const std::string& sName, const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects);
+			//! Creates a shader pipeline and starts compiling and linking it without waiting for the result.
+			static boost::shared_ptr<ShaderPipeline> createAsync(const std::string& sName, const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects);
+			//! Creates a shader pipeline from separable programs, linking the shader objects that have no separable program yet.
+			static boost::shared_ptr<ShaderPipeline> createSeparable(const std::string& sName, const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects);
+			//! Does the context support separable programs (GL 4.1 or GL_ARB_separate_shader_objects)? Checked once, needs a current context.
+			static bool hasSeparablePrograms();
 
 			//! Destructor.
 			virtual ~ShaderPipeline();
 
-			//! Create a Shader instance based on this pipeline.
+			//! Set the directory program binaries are cached in. Pipelines created afterwards use it. Empty disables caching.
+			static void setCacheDirectory(const fs::path& fsDirectory);
+			//! Get the program binary cache directory.
+			static const fs::path& getCacheDirectory();
+
+			//! Create a Shader instance based on this pipeline. The pipeline doesn't have to be ready.
 			boost::shared_ptr<Shader> createInstance();
 
+			//! Has the driver finished compiling and linking? Doesn't block if parallel shader compilation is supported.
+			bool isReady();
+			//! Wait for the driver to finish, then check and log the compile and link status. Returns false if linking failed.
+			bool finish();
+
+			//! Link a new program from the shader objects and replace the current one. Keeps the current program and returns false if linking fails.
+			bool relink();
+			//! Relink every pipeline using one of the changed shader objects. Returns the number of pipelines relinked.
+			static unsigned int relinkPipelines(const std::vector<boost::shared_ptr<ShaderObject>>& aspChanged);
+
 			//! Get pipeline name.
 			std::string getName() const { return m_sName; }
-			//! Get pipeline ID.
+			//! Get pipeline ID. This is a program pipeline object for separable pipelines and a program otherwise.
 			unsigned int getID() const { return m_uID; }
+			//! Is the pipeline made of separable programs?
+			bool isSeparable() const { return m_bSeparable; }
+
+			//! Get the program containing the vertex shader. Same as getID() unless the pipeline is separable.
+			unsigned int getVertexProgram() const;
+			//! Get the index of a uniform of a separable pipeline, -1 if no stage declares it. Indices stay valid when relinking.
+			int getSeparableUniform(const std::string& sName);
+
+			//! Location of a uniform in one stage of a separable pipeline.
+			struct UniformLocation
+			{
+				unsigned int uProgram;	//!< Separable program of the stage.
+				int iLocation;			//!< Uniform location in the program.
+			};
+			//! Get the locations of a separable pipeline's uniform in every stage that declares it.
+			const std::vector<UniformLocation>& getUniformLocations(int iIndex) const { return m_aUniforms[iIndex].aLocations; }
+
+			//! Get the number of program pipeline objects shared by separable pipelines.
+			static unsigned int getNumProgramPipelines();
 
 		protected:
-			//! Protected constructors - must be created by static create().
-			ShaderPipeline(const std::string& sName, unsigned int uID);
-
-			/*! @brief Alternative constructor that takes list of of ShaderObjects and keeps them alive along with the pipeline.
-			 *
-			 *  It is not necessary to keep the shader objects alive to have a working pipeline
-			 *  but it's useful for debugging purposes. This constructor should, therefore, only 
-			 *  be used in debug configurations. See ShaderLoader::createShaderPipeline() 
-			 *  for additional info.
-			 */
+			//! Protected constructor - must be created by static create() or createAsync().
 			ShaderPipeline(const std::string& sName, unsigned int uID, const std::vector<boost::shared_ptr<ShaderObject>>& aspShaderObjects);
 
 		private:
-			std::string m_sName;  //!< Pipeline name.
-			unsigned int m_uID;	  //!< Shader pipeline ID.
-			std::vector<boost::shared_ptr<ShaderObject>> m_aspShaderObjects; //!< The shader objects used to create this pipeline. Only used for debugging.
+			friend class ShaderObject;
+
+			//! A uniform of a separable pipeline.
+			struct SeparableUniform
+			{
+				std::string sName;							//!< Uniform name.
+				std::vector<UniformLocation> aLocations;	//!< Location in every stage that declares it.
+			};
+
+			//! Detach the shader objects from the linked program in release configurations.
+			void detachShaderObjects();
+			//! Link the missing separable programs, then look up the program pipeline object and uniform locations.
+			bool linkSeparable();
+			//! Delete a shader object's separable program along with the program pipeline objects using it.
+			static void releaseSeparableProgram(unsigned int uProgram);
 
+			std::string m_sName;	//!< Pipeline name.
+			unsigned int m_uID;		//!< Shader pipeline ID.
+			std::vector<boost::shared_ptr<ShaderObject>> m_aspShaderObjects; //!< The shader objects used to create this pipeline. Kept attached in debug configurations.
+			fs::path m_fsBinaryPath;			//!< Where to save the program binary after linking, empty if it isn't cached.
+			unsigned __int64 m_uBinaryKey;		//!< Key of the program binary.
+			bool m_bFinished;					//!< Has the link status been checked?
+			bool m_bLinked;						//!< Did the pipeline link?
+			bool m_bSeparable;					//!< Is m_uID a program pipeline object?
+			std::vector<SeparableUniform> m_aUniforms;	//!< Uniforms of a separable pipeline, indexed by getSeparableUniform().
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "ShaderWatcher.h"
+
+#include <Logging/Log.h>
+#include <Graphics/ShaderObject.h>
+#include <Graphics/ShaderPipeline.h>
+#include <boost/range/algorithm/for_each.hpp>
+#include <boost/unordered_map.hpp>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace baselib { namespace graphics {
+
+	#ifdef _WIN32
+
+	struct ShaderWatcher::State
+	{
+		HANDLE hDirectory;			//!< Watched directory.
+		OVERLAPPED overlapped;		//!< Pending read.
+		DWORD adwBuffer[16384];		//!< FILE_NOTIFY_INFORMATION records, DWORD aligned as required.
+
+		State() : hDirectory(INVALID_HANDLE_VALUE) { memset(&overlapped, 0, sizeof(overlapped)); }
+		~State()
+		{
+			if (hDirectory != INVALID_HANDLE_VALUE)
+			{
+				CancelIo(hDirectory);
+				CloseHandle(hDirectory);
+			}
+			if (overlapped.hEvent)
+				CloseHandle(overlapped.hEvent);
+		}
+
+		// Queue an asynchronous read of the next batch of changes
+		bool read()
+		{
+			return ReadDirectoryChangesW(hDirectory, adwBuffer, sizeof(adwBuffer), TRUE,
+				FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, NULL, &overlapped, NULL) != 0;
+		}
+	};
+
+	bool ShaderWatcher::init()
+	{
+		auto spState = boost::shared_ptr<State>(new State());
+		spState->hDirectory = CreateFileW(m_fsDirectory.wstring().c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+		spState->overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		if (spState->hDirectory == INVALID_HANDLE_VALUE || !spState->overlapped.hEvent || !spState->read())
+			return false;
+
+		m_spState = spState;
+		return true;
+	}
+
+	void ShaderWatcher::readChanges(std::vector<fs::path>& afsChanged)
+	{
+		DWORD dwBytes = 0;
+		if (!HasOverlappedIoCompleted(&m_spState->overlapped) || !GetOverlappedResult(m_spState->hDirectory, &m_spState->overlapped, &dwBytes, FALSE))
+			return;
+
+		// Zero bytes means the buffer overflowed and the changes are lost. Editors save a file at a time so that's unlikely.
+		if (dwBytes == 0)
+			LOG_WARNING << "Too many changes in " << m_fsDirectory << ", some shaders may not be reloaded";
+
+		const char* pRecord = reinterpret_cast<const char*>(m_spState->adwBuffer);
+		while (dwBytes > 0)
+		{
+			const FILE_NOTIFY_INFORMATION* pInfo = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(pRecord);
+			if (pInfo->Action != FILE_ACTION_REMOVED && pInfo->Action != FILE_ACTION_RENAMED_OLD_NAME)
+				afsChanged.push_back(m_fsDirectory / std::wstring(pInfo->FileName, pInfo->FileNameLength / sizeof(WCHAR)));
+
+			if (pInfo->NextEntryOffset == 0)
+				break;
+			pRecord += pInfo->NextEntryOffset;
+		}
+
+		ResetEvent(m_spState->overlapped.hEvent);
+		if (!m_spState->read())
+		{
+			LOG_ERROR << "Failed to keep watching " << m_fsDirectory;
+			m_spState.reset();
+		}
+	}
+
+	#else
+
+	struct ShaderWatcher::State
+	{
+		int iFile;										//!< inotify instance.
+		boost::unordered_map<int, fs::path> Watches;	//!< Watched directories by watch descriptor.
+
+		State() : iFile(-1) {}
+		~State()
+		{
+			if (iFile >= 0)
+				close(iFile);
+		}
+
+		// Watch a directory, but not its subdirectories
+		bool watch(const fs::path& fsDirectory)
+		{
+			int iWatch = inotify_add_watch(iFile, fsDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+			if (iWatch < 0)
+				return false;
+			Watches[iWatch] = fsDirectory;
+			return true;
+		}
+	};
+
+	bool ShaderWatcher::init()
+	{
+		auto spState = boost::shared_ptr<State>(new State());
+		spState->iFile = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (spState->iFile < 0 || !spState->watch(m_fsDirectory))
+			return false;
+
+		// inotify isn't recursive, so every subdirectory needs its own watch
+		boost::system::error_code ec;
+		for (fs::recursive_directory_iterator it(m_fsDirectory, ec), end; it != end && !ec; it.increment(ec))
+		{
+			if (fs::is_directory(it->status()))
+				spState->watch(it->path());
+		}
+
+		m_spState = spState;
+		return true;
+	}
+
+	void ShaderWatcher::readChanges(std::vector<fs::path>& afsChanged)
+	{
+		char acBuffer[4096] __attribute__((aligned(__alignof__(inotify_event))));
+		for (;;)
+		{
+			ssize_t iBytes = read(m_spState->iFile, acBuffer, sizeof(acBuffer));
+			if (iBytes <= 0)
+			{
+				if (iBytes < 0 && errno != EAGAIN && errno != EINTR)
+					LOG_WARNING << "Failed to read changes in " << m_fsDirectory;
+				return;
+			}
+
+			for (const char* pEvent = acBuffer; pEvent < acBuffer + iBytes; )
+			{
+				const inotify_event* pInfo = reinterpret_cast<const inotify_event*>(pEvent);
+				pEvent += sizeof(inotify_event) + pInfo->len;
+
+				auto it = m_spState->Watches.find(pInfo->wd);
+				if (it == m_spState->Watches.end() || pInfo->len == 0)
+					continue;
+
+				fs::path fsPath = it->second / pInfo->name;
+				if (pInfo->mask & IN_ISDIR)
+				{
+					if (pInfo->mask & (IN_CREATE | IN_MOVED_TO))
+						m_spState->watch(fsPath);
+					continue;
+				}
+
+				// Files are reported when they are closed after writing, creation alone doesn't change them
+				if (pInfo->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+					afsChanged.push_back(fsPath);
+			}
+		}
+	}
+
+	#endif
+
+	boost::shared_ptr<ShaderWatcher> ShaderWatcher::create(const fs::path& fsDirectory)
+	{
+		return boost::shared_ptr<ShaderWatcher>(new ShaderWatcher(fsDirectory));
+	}
+
+	ShaderWatcher::ShaderWatcher(const fs::path& fsDirectory)
+	{
+		LOG_VERBOSE << "ShaderWatcher constructor";
+
+		boost::system::error_code ec;
+		m_fsDirectory = fs::canonical(fsDirectory, ec);
+		if (ec || !init())
+		{
+			LOG_WARNING << "Failed to watch shader directory " << fsDirectory << ", shaders won't be reloaded";
+			return;
+		}
+
+		LOG_INFO << "Watching shader directory " << m_fsDirectory;
+	}
+
+	ShaderWatcher::~ShaderWatcher()
+	{
+		LOG_VERBOSE << "ShaderWatcher destructor";
+	}
+
+	bool ShaderWatcher::isWatching() const
+	{
+		return m_spState.get() != NULL;
+	}
+
+	unsigned int ShaderWatcher::update()
+	{
+		if (!m_spState)
+			return 0;
+
+		std::vector<fs::path> afsChanged;
+		readChanges(afsChanged);
+		if (afsChanged.empty())
+			return 0;
+
+		// Editors often write a file several times when saving, and dependencies are stored as canonical paths
+		std::vector<fs::path> afsCanonical;
+		boost::for_each(afsChanged, [&afsCanonical](const fs::path& fsPath) {
+			boost::system::error_code ec;
+			fs::path fsCanonical = fs::canonical(fsPath, ec);
+			if (!ec && std::find(afsCanonical.begin(), afsCanonical.end(), fsCanonical) == afsCanonical.end())
+				afsCanonical.push_back(fsCanonical);
+		});
+
+		auto aspReloaded = ShaderObject::reloadFiles(afsCanonical);
+		if (aspReloaded.empty())
+			return 0;
+
+		unsigned int uNumRelinked = ShaderPipeline::relinkPipelines(aspReloaded);
+		LOG_INFO << "Reloaded " << aspReloaded.size() << " shader objects and relinked " << uNumRelinked << " shader pipelines";
+		return uNumRelinked;
+	}
+
+} }
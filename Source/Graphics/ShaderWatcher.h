@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace baselib 
+{
+	namespace graphics
+	{
+		/*! @brief Reloads shaders when their files change on disk.
+		 *
+		 *  Watches a directory tree for written, created and renamed files with ReadDirectoryChangesW on Windows and
+		 *  inotify elsewhere. update() collects the notifications without blocking, recompiles the shader objects
+		 *  that load or include a changed file and relinks only the pipelines that use them, in place. Idle updates
+		 *  cost a single non-blocking check, the file system isn't polled.
+		 *
+		 *  Reloading compiles synchronously and is meant for development. A shader that fails to compile or a
+		 *  pipeline that fails to link logs the error and keeps its previous version.
+		 */
+		class ShaderWatcher
+		{
+		public:
+			//! Creates a ShaderWatcher for a directory and its subdirectories.
+			static boost::shared_ptr<ShaderWatcher> create(const fs::path& fsDirectory);
+
+			//! Destructor.
+			~ShaderWatcher();
+
+			//! Reload the shaders affected by file changes since the last update. Returns the number of pipelines relinked.
+			unsigned int update();
+
+			//! Get the watched directory.
+			const fs::path& getDirectory() const { return m_fsDirectory; }
+			//! Is the directory being watched? False if the watch couldn't be set up.
+			bool isWatching() const;
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			ShaderWatcher(const fs::path& fsDirectory);
+
+		private:
+			struct State;
+
+			//! Start watching the directory.
+			bool init();
+			//! Add the canonical paths of changed files to afsChanged. Doesn't block.
+			void readChanges(std::vector<fs::path>& afsChanged);
+
+			fs::path m_fsDirectory;				//!< Watched directory.
+			boost::shared_ptr<State> m_spState;	//!< Platform specific watch state, null if watching failed.
+		};
+	}
+}
@@ -1,13 +1,14 @@
 #include "Spatial.h"
 
 #include <Logging/Log.h>
+#include <Math/SIMD.h>
 
 namespace baselib { namespace graphics {
 
 	Spatial::Spatial()
 		: m_sName("Spatial")
-		, m_mLocal(Mat4())
-		, m_mWorld(Mat4())
+		, m_Local()
+		, m_World()
 		, m_bUseLocalAsWorld(false)
 	{
 		LOG_VERBOSE << "Spatial constructor";
@@ -18,14 +19,14 @@ namespace baselib { namespace graphics {
 		LOG_VERBOSE << "Spatial destructor";
 	}
 
-	void Spatial::update(const Mat4& mParent)
+	void Spatial::update(const Transform& parent)
 	{
 		if (m_bUseLocalAsWorld)
-			m_mWorld = m_mLocal;
+			m_World = m_Local;
 		else
-			m_mWorld = mParent * m_mLocal;
+			multiplyTransform(parent, m_Local, m_World);
 
-		onUpdate(mParent);
+		onUpdate(parent);
 	}
 
 	void Spatial::apply(const boost::function<void(const boost::shared_ptr<Spatial>&)>& f)
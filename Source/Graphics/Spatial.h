@@ -2,6 +2,7 @@
 
 #include <string>
 #include <Math/Math.h>
+#include <Math/Transform.h>
 #include <boost/function.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
@@ -11,7 +12,8 @@ namespace baselib
 	{
 		/*! @brief Base class for any object that has spatial information (i.e. any object that has a position and orientation).
 		 *
-		 *  Spatials have local and world transformations so they can be organized into a spatial hierarchy.
+		 *  Spatials have local and world transformations so they can be organized into a spatial hierarchy. Both are affine
+		 *  Transforms, a full Mat4 is only built with getWorldMatrix() where one is needed, e.g. for upload.
 		 */
 		class Spatial : public boost::enable_shared_from_this<Spatial>
 		{
@@ -22,7 +24,7 @@ namespace baselib
 			virtual ~Spatial();
 
 			//! Update the world transform
-			void update(const Mat4& mParent);
+			void update(const Transform& parent);
 
 			//! Set spatial name.
 			void setName(const std::string& sName) { m_sName = sName; }
@@ -30,14 +32,16 @@ namespace baselib
 			std::string getName() const { return m_sName; }
 
 			//! Modify the world transform
-			Mat4& modifyWorld() { return m_mWorld; }
+			Transform& modifyWorld() { return m_World; }
 			//! Get the world transform
-			const Mat4& getWorld() const { return m_mWorld; }
+			const Transform& getWorld() const { return m_World; }
+			//! Get the world transform as a 4x4 matrix.
+			Mat4 getWorldMatrix() const { return m_World.toMat4(); }
 			
 			//! Modify the local transform
-			Mat4& modifyLocal() { return m_mLocal; }
+			Transform& modifyLocal() { return m_Local; }
 			//! Get the local transform
-			const Mat4& getLocal() const { return m_mWorld; }
+			const Transform& getLocal() const { return m_Local; }
 
 			//! Set spatial to ignore parent and use local transform as world transform.
 			void setUseLocalAsWorld(bool b) { m_bUseLocalAsWorld = b; }
@@ -49,11 +53,11 @@ namespace baselib
 
 		private:
 			//! Called from update().
-			virtual void onUpdate(const Mat4& mParent) {}
+			virtual void onUpdate(const Transform& parent) {}
 
 			std::string m_sName;		//!< Spatial name.
-			Mat4 m_mLocal;				//!< Local space transform.
-			Mat4 m_mWorld;				//!< World space transform.
+			Transform m_Local;			//!< Local space transform.
+			Transform m_World;			//!< World space transform.
 			bool m_bUseLocalAsWorld;	//!< If true the local transform is assigned directly to the world transform during update.
 		};
 	}
@@ -0,0 +1,488 @@
+#include "SpatialIndex.h"
+
+#include <Logging/Log.h>
+#include <Graphics/Node.h>
+#include <Graphics/Visual.h>
+#include <Graphics/Camera.h>
+#include <Graphics/Geometry.h>
+#include <Graphics/MeshBVH.h>
+#include <algorithm>
+
+namespace baselib { namespace graphics {
+
+	namespace
+	{
+		AABB merge(const AABB& a, const AABB& b)
+		{
+			AABB bounds = a;
+			bounds.expand(b);
+			return bounds;
+		}
+	}
+
+	boost::shared_ptr<SpatialIndex> SpatialIndex::create(float fMargin)
+	{
+		return boost::shared_ptr<SpatialIndex>(new SpatialIndex(fMargin));
+	}
+
+	SpatialIndex::SpatialIndex(float fMargin)
+		: m_fMargin(fMargin)
+		, m_iRoot(NULL_NODE)
+		, m_iFreeList(NULL_NODE)
+		, m_uNumVisuals(0)
+	{
+		LOG_VERBOSE << "SpatialIndex constructor";
+	}
+
+	SpatialIndex::~SpatialIndex()
+	{
+		LOG_VERBOSE << "SpatialIndex destructor";
+		clear();
+	}
+
+	void SpatialIndex::insert(Visual* pVisual)
+	{
+		assert(pVisual);
+		if (pVisual->m_pSpatialIndex)
+		{
+			LOG_ERROR << "Visual " << pVisual->getName() << " is already in a spatial index";
+			assert(false);
+			return;
+		}
+
+		int iLeaf = allocateNode();
+		TreeNode& leaf = m_aNodes[iLeaf];
+		leaf.pVisual = pVisual;
+		leaf.iHeight = 0;
+		leaf.tight = pVisual->getWorldBounds();
+		leaf.bounds = leaf.tight.isEmpty() ? leaf.tight : AABB(leaf.tight.vMin - Vec3(m_fMargin), leaf.tight.vMax + Vec3(m_fMargin));
+		insertLeaf(iLeaf);
+
+		pVisual->m_pSpatialIndex = this;
+		pVisual->m_iSpatialProxy = iLeaf;
+		++m_uNumVisuals;
+	}
+
+	void SpatialIndex::insert(const boost::shared_ptr<Node>& spNode)
+	{
+		spNode->apply([this](const boost::shared_ptr<Spatial>& spSpatial) {
+			if (auto spVisual = boost::dynamic_pointer_cast<Visual>(spSpatial))
+				insert(spVisual.get());
+		});
+	}
+
+	void SpatialIndex::remove(Visual* pVisual)
+	{
+		assert(pVisual);
+		if (pVisual->m_pSpatialIndex != this)
+		{
+			LOG_ERROR << "Visual " << pVisual->getName() << " isn't in this spatial index";
+			assert(false);
+			return;
+		}
+
+		removeLeaf(pVisual->m_iSpatialProxy);
+		freeNode(pVisual->m_iSpatialProxy);
+
+		pVisual->m_pSpatialIndex = NULL;
+		pVisual->m_iSpatialProxy = NULL_NODE;
+		--m_uNumVisuals;
+	}
+
+	void SpatialIndex::clear()
+	{
+		for (unsigned int i = 0; i < m_aNodes.size(); ++i)
+		{
+			if (m_aNodes[i].iHeight == 0 && m_aNodes[i].pVisual)
+			{
+				m_aNodes[i].pVisual->m_pSpatialIndex = NULL;
+				m_aNodes[i].pVisual->m_iSpatialProxy = NULL_NODE;
+			}
+		}
+
+		m_aNodes.clear();
+		m_iRoot = NULL_NODE;
+		m_iFreeList = NULL_NODE;
+		m_uNumVisuals = 0;
+	}
+
+	void SpatialIndex::update(Visual* pVisual)
+	{
+		assert(pVisual && pVisual->m_pSpatialIndex == this);
+		int iLeaf = pVisual->m_iSpatialProxy;
+		TreeNode& leaf = m_aNodes[iLeaf];
+		leaf.tight = pVisual->getWorldBounds();
+
+		// Still inside the grown bounds, the tree doesn't change
+		if (!leaf.tight.isEmpty() && !leaf.bounds.isEmpty() && leaf.bounds.contains(leaf.tight))
+			return;
+
+		removeLeaf(iLeaf);
+		leaf.bounds = leaf.tight.isEmpty() ? leaf.tight : AABB(leaf.tight.vMin - Vec3(m_fMargin), leaf.tight.vMax + Vec3(m_fMargin));
+		insertLeaf(iLeaf);
+	}
+
+	void SpatialIndex::query(const Frustum& frustum, std::vector<Visual*>& apVisuals) const
+	{
+		apVisuals.clear();
+		if (m_iRoot == NULL_NODE)
+			return;
+
+		m_aiStack.clear();
+		m_aiStack.push_back(m_iRoot);
+		while (!m_aiStack.empty())
+		{
+			const TreeNode& node = m_aNodes[m_aiStack.back()];
+			m_aiStack.pop_back();
+
+			if (node.isLeaf())
+			{
+				if (frustum.intersects(node.tight))
+					apVisuals.push_back(node.pVisual);
+			}
+			else if (frustum.contains(node.bounds))
+			{
+				// Everything below is inside as well, no more plane tests
+				addLeaves(node.iLeft, apVisuals);
+				addLeaves(node.iRight, apVisuals);
+			}
+			else if (frustum.intersects(node.bounds))
+			{
+				m_aiStack.push_back(node.iLeft);
+				m_aiStack.push_back(node.iRight);
+			}
+		}
+	}
+
+	void SpatialIndex::query(const AABB& bounds, std::vector<Visual*>& apVisuals) const
+	{
+		apVisuals.clear();
+		if (m_iRoot == NULL_NODE || bounds.isEmpty())
+			return;
+
+		m_aiStack.clear();
+		m_aiStack.push_back(m_iRoot);
+		while (!m_aiStack.empty())
+		{
+			const TreeNode& node = m_aNodes[m_aiStack.back()];
+			m_aiStack.pop_back();
+
+			if (node.isLeaf())
+			{
+				if (!node.tight.isEmpty() && node.tight.intersects(bounds))
+					apVisuals.push_back(node.pVisual);
+			}
+			else if (node.bounds.intersects(bounds))
+			{
+				m_aiStack.push_back(node.iLeft);
+				m_aiStack.push_back(node.iRight);
+			}
+		}
+	}
+
+	void SpatialIndex::query(const Vec3& vCenter, float fRadius, std::vector<Visual*>& apVisuals) const
+	{
+		apVisuals.clear();
+		if (m_iRoot == NULL_NODE)
+			return;
+
+		float fRadiusSquared = fRadius * fRadius;
+		m_aiStack.clear();
+		m_aiStack.push_back(m_iRoot);
+		while (!m_aiStack.empty())
+		{
+			const TreeNode& node = m_aNodes[m_aiStack.back()];
+			m_aiStack.pop_back();
+
+			if (node.isLeaf())
+			{
+				if (!node.tight.isEmpty() && node.tight.getDistanceSquared(vCenter) <= fRadiusSquared)
+					apVisuals.push_back(node.pVisual);
+			}
+			else if (node.bounds.getDistanceSquared(vCenter) <= fRadiusSquared)
+			{
+				m_aiStack.push_back(node.iLeft);
+				m_aiStack.push_back(node.iRight);
+			}
+		}
+	}
+
+	void SpatialIndex::raycast(const Ray& ray, float fMaxDistance, std::vector<RayHit>& aHits) const
+	{
+		aHits.clear();
+		if (m_iRoot == NULL_NODE)
+			return;
+
+		m_aiStack.clear();
+		m_aiStack.push_back(m_iRoot);
+		while (!m_aiStack.empty())
+		{
+			const TreeNode& node = m_aNodes[m_aiStack.back()];
+			m_aiStack.pop_back();
+
+			float fDistance;
+			if (node.isLeaf())
+			{
+				if (ray.intersects(node.tight, fMaxDistance, fDistance))
+				{
+					RayHit hit;
+					hit.pVisual = node.pVisual;
+					hit.fDistance = fDistance;
+					aHits.push_back(hit);
+				}
+			}
+			else if (ray.intersects(node.bounds, fMaxDistance, fDistance))
+			{
+				m_aiStack.push_back(node.iLeft);
+				m_aiStack.push_back(node.iRight);
+			}
+		}
+
+		std::sort(aHits.begin(), aHits.end(), [](const RayHit& lhs, const RayHit& rhs) { return lhs.fDistance < rhs.fDistance; });
+	}
+
+	bool SpatialIndex::pick(const Ray& ray, float fMaxDistance, PickResult& result, bool bTriangles) const
+	{
+		std::vector<RayHit> aHits;
+		raycast(ray, fMaxDistance, aHits);
+
+		// Candidates come nearest bounds first, none further than the nearest hit can be nearer
+		bool bPicked = false;
+		result.pVisual = NULL;
+		result.fDistance = fMaxDistance;
+		for (unsigned int i = 0; i < aHits.size() && aHits[i].fDistance < result.fDistance; ++i)
+		{
+			Visual* pVisual = aHits[i].pVisual;
+			boost::shared_ptr<MeshBVH> spBVH = bTriangles && pVisual->getGeometry() ? pVisual->getGeometry()->getTriangleBVH() : boost::shared_ptr<MeshBVH>();
+			if (!spBVH)
+			{
+				result.pVisual = pVisual;
+				result.fDistance = aHits[i].fDistance;
+				result.uTriangle = 0;
+				bPicked = true;
+				continue;
+			}
+
+			// Distances along the ray are the same in object space when the direction is transformed along with the origin
+			Transform inverse = pVisual->getWorld().inverse();
+			Ray localRay(inverse.transformPoint(ray.vOrigin), inverse.transformVector(ray.vDirection));
+			MeshBVH::Hit hit;
+			if (spBVH->raycast(localRay, result.fDistance, hit))
+			{
+				result.pVisual = pVisual;
+				result.fDistance = hit.fDistance;
+				result.uTriangle = hit.uTriangle;
+				bPicked = true;
+			}
+		}
+
+		if (bPicked)
+			result.vPosition = ray.getPoint(result.fDistance);
+		return bPicked;
+	}
+
+	int SpatialIndex::getHeight() const
+	{
+		return m_iRoot == NULL_NODE ? 0 : m_aNodes[m_iRoot].iHeight + 1;
+	}
+
+	int SpatialIndex::allocateNode()
+	{
+		int iNode;
+		if (m_iFreeList == NULL_NODE)
+		{
+			iNode = m_aNodes.size();
+			m_aNodes.push_back(TreeNode());
+		}
+		else
+		{
+			iNode = m_iFreeList;
+			m_iFreeList = m_aNodes[iNode].iParent;
+		}
+
+		TreeNode& node = m_aNodes[iNode];
+		node.bounds = AABB();
+		node.tight = AABB();
+		node.pVisual = NULL;
+		node.iParent = NULL_NODE;
+		node.iLeft = NULL_NODE;
+		node.iRight = NULL_NODE;
+		node.iHeight = 0;
+		return iNode;
+	}
+
+	void SpatialIndex::freeNode(int iNode)
+	{
+		m_aNodes[iNode].pVisual = NULL;
+		m_aNodes[iNode].iParent = m_iFreeList;
+		m_aNodes[iNode].iHeight = -1;
+		m_iFreeList = iNode;
+	}
+
+	void SpatialIndex::insertLeaf(int iLeaf)
+	{
+		if (m_iRoot == NULL_NODE)
+		{
+			m_iRoot = iLeaf;
+			m_aNodes[iLeaf].iParent = NULL_NODE;
+			return;
+		}
+
+		// Descend towards the sibling with the lowest cost: the surface area the new parent adds plus what every
+		// ancestor grows by. Stop where pairing with the current node is cheaper than going further down.
+		AABB leafBounds = m_aNodes[iLeaf].bounds;
+		int iIndex = m_iRoot;
+		while (!m_aNodes[iIndex].isLeaf())
+		{
+			const TreeNode& node = m_aNodes[iIndex];
+			float fArea = node.bounds.getSurfaceArea();
+			float fCombinedArea = merge(node.bounds, leafBounds).getSurfaceArea();
+			float fCost = 2.0f * fCombinedArea;
+			float fInheritedCost = 2.0f * (fCombinedArea - fArea);
+
+			const TreeNode& left = m_aNodes[node.iLeft];
+			float fLeftCost = merge(left.bounds, leafBounds).getSurfaceArea() + fInheritedCost;
+			if (!left.isLeaf())
+				fLeftCost -= left.bounds.getSurfaceArea();
+
+			const TreeNode& right = m_aNodes[node.iRight];
+			float fRightCost = merge(right.bounds, leafBounds).getSurfaceArea() + fInheritedCost;
+			if (!right.isLeaf())
+				fRightCost -= right.bounds.getSurfaceArea();
+
+			if (fCost < fLeftCost && fCost < fRightCost)
+				break;
+			iIndex = fLeftCost < fRightCost ? node.iLeft : node.iRight;
+		}
+
+		// Allocating may move the nodes, take no references across it
+		int iSibling = iIndex;
+		int iOldParent = m_aNodes[iSibling].iParent;
+		int iNewParent = allocateNode();
+		TreeNode& newParent = m_aNodes[iNewParent];
+		newParent.iParent = iOldParent;
+		newParent.bounds = merge(leafBounds, m_aNodes[iSibling].bounds);
+		newParent.iHeight = m_aNodes[iSibling].iHeight + 1;
+		newParent.iLeft = iSibling;
+		newParent.iRight = iLeaf;
+
+		if (iOldParent == NULL_NODE)
+			m_iRoot = iNewParent;
+		else if (m_aNodes[iOldParent].iLeft == iSibling)
+			m_aNodes[iOldParent].iLeft = iNewParent;
+		else
+			m_aNodes[iOldParent].iRight = iNewParent;
+
+		m_aNodes[iSibling].iParent = iNewParent;
+		m_aNodes[iLeaf].iParent = iNewParent;
+
+		refit(iNewParent);
+	}
+
+	void SpatialIndex::removeLeaf(int iLeaf)
+	{
+		if (iLeaf == m_iRoot)
+		{
+			m_iRoot = NULL_NODE;
+			return;
+		}
+
+		// The sibling takes the parent's place
+		int iParent = m_aNodes[iLeaf].iParent;
+		int iGrandParent = m_aNodes[iParent].iParent;
+		int iSibling = m_aNodes[iParent].iLeft == iLeaf ? m_aNodes[iParent].iRight : m_aNodes[iParent].iLeft;
+
+		if (iGrandParent == NULL_NODE)
+			m_iRoot = iSibling;
+		else if (m_aNodes[iGrandParent].iLeft == iParent)
+			m_aNodes[iGrandParent].iLeft = iSibling;
+		else
+			m_aNodes[iGrandParent].iRight = iSibling;
+
+		m_aNodes[iSibling].iParent = iGrandParent;
+		freeNode(iParent);
+		m_aNodes[iLeaf].iParent = NULL_NODE;
+
+		refit(iGrandParent);
+	}
+
+	void SpatialIndex::refit(int iNode)
+	{
+		while (iNode != NULL_NODE)
+		{
+			iNode = balance(iNode);
+
+			TreeNode& node = m_aNodes[iNode];
+			const TreeNode& left = m_aNodes[node.iLeft];
+			const TreeNode& right = m_aNodes[node.iRight];
+			node.bounds = merge(left.bounds, right.bounds);
+			node.iHeight = 1 + std::max(left.iHeight, right.iHeight);
+
+			iNode = node.iParent;
+		}
+	}
+
+	int SpatialIndex::balance(int iA)
+	{
+		TreeNode& a = m_aNodes[iA];
+		if (a.isLeaf() || a.iHeight < 2)
+			return iA;
+
+		int iB = a.iLeft;
+		int iC = a.iRight;
+		TreeNode& b = m_aNodes[iB];
+		TreeNode& c = m_aNodes[iC];
+		int iBalance = c.iHeight - b.iHeight;
+		if (iBalance >= -1 && iBalance <= 1)
+			return iA;
+
+		// Rotate the higher child up into A's place. A keeps the other child and the lower of the higher child's children.
+		int iUp = iBalance > 1 ? iC : iB;
+		TreeNode& up = m_aNodes[iUp];
+		const TreeNode& other = m_aNodes[iBalance > 1 ? iB : iC];
+		int iF = up.iLeft;
+		int iG = up.iRight;
+		TreeNode& f = m_aNodes[iF];
+		TreeNode& g = m_aNodes[iG];
+
+		up.iLeft = iA;
+		up.iParent = a.iParent;
+		a.iParent = iUp;
+
+		if (up.iParent == NULL_NODE)
+			m_iRoot = iUp;
+		else if (m_aNodes[up.iParent].iLeft == iA)
+			m_aNodes[up.iParent].iLeft = iUp;
+		else
+			m_aNodes[up.iParent].iRight = iUp;
+
+		int iKeep = f.iHeight > g.iHeight ? iF : iG;
+		int iMove = f.iHeight > g.iHeight ? iG : iF;
+		up.iRight = iKeep;
+		if (iBalance > 1)
+			a.iRight = iMove;
+		else
+			a.iLeft = iMove;
+		m_aNodes[iMove].iParent = iA;
+
+		a.bounds = merge(other.bounds, m_aNodes[iMove].bounds);
+		a.iHeight = 1 + std::max(other.iHeight, m_aNodes[iMove].iHeight);
+		up.bounds = merge(a.bounds, m_aNodes[iKeep].bounds);
+		up.iHeight = 1 + std::max(a.iHeight, m_aNodes[iKeep].iHeight);
+		return iUp;
+	}
+
+	void SpatialIndex::addLeaves(int iNode, std::vector<Visual*>& apVisuals) const
+	{
+		const TreeNode& node = m_aNodes[iNode];
+		if (node.isLeaf())
+		{
+			if (!node.tight.isEmpty())
+				apVisuals.push_back(node.pVisual);
+			return;
+		}
+		addLeaves(node.iLeft, apVisuals);
+		addLeaves(node.iRight, apVisuals);
+	}
+
+} }
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Math/Math.h>
+#include <Math/AABB.h>
+#include <Math/Ray.h>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace baselib
+{
+	namespace graphics
+	{
+		class Node;
+		class Visual;
+		class Frustum;
+	}
+}
+
+namespace baselib
+{
+	namespace graphics
+	{
+		/*! @brief Dynamic AABB tree over the world bounds of visuals, for culling and proximity queries without walking the scene.
+		 *
+		 *  Each visual is a leaf holding its world bounds grown by a margin, internal nodes hold the union of their children.
+		 *  Leaves are inserted next to the sibling that grows the tree's surface area the least and the path back to the root
+		 *  is refit and rebalanced with tree rotations, so the height stays O(log n). A visual that moves within its margin
+		 *  costs nothing, otherwise it is removed and reinserted in O(log n).
+		 *
+		 *  Inserted visuals keep the index up to date from Visual::onUpdate(), i.e. when their Node hierarchy is updated, and
+		 *  remove themselves when destroyed. Queries test the exact world bounds at the leaves, so results don't depend on the
+		 *  margin. Queries share a traversal stack and must not run concurrently. Visuals are referenced by raw pointer, as in VisualCollector.
+		 */
+		class SpatialIndex
+		{
+		public:
+			//! A visual hit by raycast().
+			struct RayHit
+			{
+				Visual* pVisual;	//!< Visual whose world bounds the ray hits.
+				float fDistance;	//!< Distance along the ray at which it enters the bounds.
+			};
+
+			//! The visual picked by pick().
+			struct PickResult
+			{
+				Visual* pVisual;		//!< Picked visual.
+				float fDistance;		//!< Distance along the ray to the hit.
+				Vec3 vPosition;			//!< World space position of the hit.
+				unsigned int uTriangle;	//!< Index of the triangle hit, 0 if the visual was hit by its bounds.
+			};
+
+			//! Creates a SpatialIndex. Leaf bounds are grown by fMargin in world units on every side.
+			static boost::shared_ptr<SpatialIndex> create(float fMargin = 0.1f);
+
+			//! Destructor.
+			~SpatialIndex();
+
+			//! Add a visual. A visual can be in one index at a time.
+			void insert(Visual* pVisual);
+			//! Add every visual in a Node hierarchy.
+			void insert(const boost::shared_ptr<Node>& spNode);
+			//! Remove a visual.
+			void remove(Visual* pVisual);
+			//! Remove all visuals.
+			void clear();
+			//! Update the bounds of a visual after its world transform or geometry changed.
+			void update(Visual* pVisual);
+
+			//! Get the visuals whose world bounds intersect the frustum, as Frustum::intersects() decides.
+			void query(const Frustum& frustum, std::vector<Visual*>& apVisuals) const;
+			//! Get the visuals whose world bounds overlap a box.
+			void query(const AABB& bounds, std::vector<Visual*>& apVisuals) const;
+			//! Get the visuals whose world bounds overlap a sphere.
+			void query(const Vec3& vCenter, float fRadius, std::vector<Visual*>& apVisuals) const;
+			//! Get the visuals whose world bounds a ray hits before fMaxDistance, nearest first.
+			void raycast(const Ray& ray, float fMaxDistance, std::vector<RayHit>& aHits) const;
+			//! Find the nearest visual a ray hits before fMaxDistance. With bTriangles the triangles of visuals that have a
+			//! Geometry::getTriangleBVH() are tested, other visuals are hit by their world bounds.
+			bool pick(const Ray& ray, float fMaxDistance, PickResult& result, bool bTriangles = true) const;
+
+			//! Get the number of visuals.
+			unsigned int getNumVisuals() const { return m_uNumVisuals; }
+			//! Get the height of the tree, 0 if empty.
+			int getHeight() const;
+			//! Get the margin leaf bounds are grown by.
+			float getMargin() const { return m_fMargin; }
+
+		protected:
+			//! Protected constructor - must be created by static create().
+			SpatialIndex(float fMargin);
+
+		private:
+			static const int NULL_NODE = -1;
+
+			//! Node of the tree. Free nodes are chained through iParent.
+			struct TreeNode
+			{
+				AABB bounds;		//!< Bounds grown by the margin for leaves, union of the children otherwise.
+				AABB tight;			//!< Exact world bounds of a leaf's visual.
+				Visual* pVisual;	//!< Visual of a leaf, NULL for internal nodes.
+				int iParent;		//!< Parent node, or next free node.
+				int iLeft;			//!< First child, NULL_NODE for leaves.
+				int iRight;			//!< Second child, NULL_NODE for leaves.
+				int iHeight;		//!< 0 for leaves, -1 for free nodes.
+
+				bool isLeaf() const { return iLeft == NULL_NODE; }
+			};
+
+			//! Take a node from the free list.
+			int allocateNode();
+			//! Return a node to the free list.
+			void freeNode(int iNode);
+			//! Link a leaf into the tree.
+			void insertLeaf(int iLeaf);
+			//! Unlink a leaf from the tree, the node stays allocated.
+			void removeLeaf(int iLeaf);
+			//! Refit and rebalance from a node up to the root.
+			void refit(int iNode);
+			//! Rotate the higher child of a node up if the children's heights differ by more than one. Returns the subtree's new root.
+			int balance(int iNode);
+			//! Add the visuals of every leaf below a node.
+			void addLeaves(int iNode, std::vector<Visual*>& apVisuals) const;
+
+			float m_fMargin;					//!< Margin leaf bounds are grown by.
+			std::vector<TreeNode> m_aNodes;		//!< Node pool.
+			int m_iRoot;						//!< Root node.
+			int m_iFreeList;					//!< First free node.
+			unsigned int m_uNumVisuals;			//!< Number of leaves.
+			mutable std::vector<int> m_aiStack;	//!< Traversal stack shared by the queries.
+		};
+	}
+}
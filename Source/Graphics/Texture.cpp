@@ -1,6 +1,7 @@
 #include "Texture.h"
 
 #include <Graphics/Image.h>
+#include <Graphics/Buffer.h>
 #include <Logging/Log.h>
 #include <Helpers/ResourceCache.h>
 #include <GL/glew.h>
@@ -15,6 +16,59 @@ namespace baselib { namespace graphics {
 	namespace
 	{
 		ResourceCache<Texture> m_TextureCache;
+
+		unsigned int getGLInternalFormat(Texture::Format eFormat)
+		{
+			switch (eFormat)
+			{
+			case Texture::FORMAT_R8: return GL_R8; break;
+			case Texture::FORMAT_RGB8: return GL_RGB8; break;
+			case Texture::FORMAT_RGBA8: return GL_RGBA8; break;
+			case Texture::FORMAT_R32F: return GL_R32F; break;
+			case Texture::FORMAT_RG32F: return GL_RG32F; break;
+			case Texture::FORMAT_RGBA16F: return GL_RGBA16F; break;
+			case Texture::FORMAT_RGBA32F: return GL_RGBA32F; break;
+			case Texture::FORMAT_R32UI: return GL_R32UI; break;
+			default: LOG_ERROR << "Invalid texture format."; assert(false); return 0; break;
+			}
+		}
+
+		int getBitsPerPixel(Texture::Format eFormat)
+		{
+			switch (eFormat)
+			{
+			case Texture::FORMAT_R8: return 8; break;
+			case Texture::FORMAT_RGB8: return 24; break;
+			case Texture::FORMAT_RGBA8: return 32; break;
+			case Texture::FORMAT_R32F: return 32; break;
+			case Texture::FORMAT_RG32F: return 64; break;
+			case Texture::FORMAT_RGBA16F: return 64; break;
+			case Texture::FORMAT_RGBA32F: return 128; break;
+			case Texture::FORMAT_R32UI: return 32; break;
+			default: LOG_ERROR << "Invalid texture format."; assert(false); return 0; break;
+			}
+		}
+
+		unsigned int getGLTarget(Texture::TextureType eType)
+		{
+			switch (eType)
+			{
+			case Texture::TEXTURE_2D: return GL_TEXTURE_2D; break;
+			case Texture::TEXTURE_BUFFER: return GL_TEXTURE_BUFFER; break;
+			default: LOG_ERROR << "Unsupported texture type."; assert(false); return 0; break;
+			}
+		}
+
+		unsigned int getGLImageAccess(Texture::ImageAccess eAccess)
+		{
+			switch (eAccess)
+			{
+			case Texture::READ_ONLY: return GL_READ_ONLY; break;
+			case Texture::WRITE_ONLY: return GL_WRITE_ONLY; break;
+			case Texture::READ_WRITE: return GL_READ_WRITE; break;
+			default: LOG_ERROR << "Invalid image access."; assert(false); return 0; break;
+			}
+		}
 	}
 
 	boost::shared_ptr<Texture> Texture::load(const fs::path& fsPath)
@@ -77,15 +131,66 @@ namespace baselib { namespace graphics {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-		return boost::shared_ptr<Texture>(new Texture(uID, Texture::TEXTURE_2D, spImage->getWidth(), spImage->getHeight(), spImage->getBPP()));
+		// Keep the bind cache in sync with the binding made above
+		m_uCurrentlyBound = uID;
+		m_uActiveUnit = GL_TEXTURE0;
+
+		Format eFormat = spImage->getBPP() == 32 ? FORMAT_RGBA8 : spImage->getBPP() == 24 ? FORMAT_RGB8 : FORMAT_R8;
+		return boost::shared_ptr<Texture>(new Texture(uID, Texture::TEXTURE_2D, spImage->getWidth(), spImage->getHeight(), spImage->getBPP(), eFormat));
+	}
+
+	boost::shared_ptr<Texture> Texture::create(int iWidth, int iHeight, Format eFormat)
+	{
+		assert(iWidth > 0 && iHeight > 0);
+		glActiveTexture(GL_TEXTURE0);
+
+		unsigned int uID;
+		glGenTextures(1, &uID);
+		glBindTexture(GL_TEXTURE_2D, uID);
+
+		// Image load/store needs immutable storage to bind the texture as an image
+		glTexStorage2D(GL_TEXTURE_2D, 1, getGLInternalFormat(eFormat), iWidth, iHeight);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		// Keep the bind cache in sync with the binding made above
+		m_uCurrentlyBound = uID;
+		m_uActiveUnit = GL_TEXTURE0;
+
+		return boost::shared_ptr<Texture>(new Texture(uID, Texture::TEXTURE_2D, iWidth, iHeight, getBitsPerPixel(eFormat), eFormat));
 	}
 
-	Texture::Texture(unsigned int uID, TextureType eType, int iWidth, int iHeight, int iBPP)
+	boost::shared_ptr<Texture> Texture::create(const boost::shared_ptr<Buffer>& spBuffer, Format eFormat)
+	{
+		assert(spBuffer);
+		assert(eFormat != FORMAT_RGB8);
+		glActiveTexture(GL_TEXTURE0);
+		m_uActiveUnit = GL_TEXTURE0;
+
+		unsigned int uID;
+		glGenTextures(1, &uID);
+		glBindTexture(GL_TEXTURE_BUFFER, uID);
+		glTexBuffer(GL_TEXTURE_BUFFER, getGLInternalFormat(eFormat), spBuffer->getID());
+
+		// Buffer textures have their own target, unbind so the 2D binding the bind cache tracks is left alone
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+		int iBPP = getBitsPerPixel(eFormat);
+		auto spTexture = boost::shared_ptr<Texture>(new Texture(uID, Texture::TEXTURE_BUFFER, spBuffer->getSize() * 8 / iBPP, 1, iBPP, eFormat));
+		spTexture->m_spBuffer = spBuffer;
+		return spTexture;
+	}
+
+	Texture::Texture(unsigned int uID, TextureType eType, int iWidth, int iHeight, int iBPP, Format eFormat)
 		: m_uID(uID)
 		, m_eType(eType)
 		, m_iWidth(iWidth)
 		, m_iHeight(iHeight)
 		, m_iBPP(iBPP)
+		, m_eFormat(eFormat)
 	{
 		LOG_VERBOSE << "Texture constructor";
 	}
@@ -99,17 +204,63 @@ namespace baselib { namespace graphics {
 
 	void Texture::bind()
 	{
-		if (m_uID == m_uCurrentlyBound)
-			return;
+		bind(0);
+	}
 
-		if (m_uActiveUnit != GL_TEXTURE0)
+	void Texture::bind(unsigned int uUnit)
+	{
+		unsigned int uGLUnit = GL_TEXTURE0 + uUnit;
+		if (m_uActiveUnit != uGLUnit)
 		{
-			glActiveTexture(GL_TEXTURE0);
-			m_uActiveUnit = GL_TEXTURE0;
+			glActiveTexture(uGLUnit);
+			m_uActiveUnit = uGLUnit;
 		}
 
-		glBindTexture(GL_TEXTURE_2D, m_uID);
-		m_uCurrentlyBound = m_uID;
+		// Only unit 0 is cached, the other units are bound by the few shaders that use them
+		if (uUnit == 0 && m_uID == m_uCurrentlyBound)
+			return;
+
+		glBindTexture(getGLTarget(m_eType), m_uID);
+		if (uUnit == 0)
+			m_uCurrentlyBound = m_uID;
+	}
+
+	void Texture::bindImage(unsigned int uUnit, ImageAccess eAccess, int iLevel)
+	{
+		assert(m_eFormat != FORMAT_RGB8);
+		glBindImageTexture(uUnit, m_uID, iLevel, GL_FALSE, 0, getGLImageAccess(eAccess), getGLInternalFormat(m_eFormat));
+	}
+
+	void Texture::setFilter(FilterMode eFilter)
+	{
+		GLint iFilter = eFilter == FILTER_LINEAR ? GL_LINEAR : GL_NEAREST;
+		bind();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, iFilter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, iFilter);
+	}
+
+	void Texture::updateRegion(int iX, int iY, int iWidth, int iHeight, int iRowLength, const unsigned char* pData)
+	{
+		assert(pData);
+		assert(iX >= 0 && iY >= 0 && iX + iWidth <= m_iWidth && iY + iHeight <= m_iHeight);
+
+		assert(m_eFormat == FORMAT_R8 || m_eFormat == FORMAT_RGB8 || m_eFormat == FORMAT_RGBA8);
+		if (iWidth <= 0 || iHeight <= 0)
+			return;
+
+		GLenum eFormat = GL_RED;
+		if (m_iBPP == 32)
+			eFormat = GL_RGBA;
+		else if (m_iBPP == 24)
+			eFormat = GL_RGB;
+		else if (m_iBPP != 8)
+			assert(false);
+
+		bind();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, iRowLength);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, iX, iY, iWidth, iHeight, eFormat, GL_UNSIGNED_BYTE, (const GLvoid*)pData);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 	}
 
 } }
\ No newline at end of file
@@ -10,6 +10,7 @@ namespace baselib
 	namespace graphics
 	{
 		class Image;
+		class Buffer;
 	}
 }
 
@@ -38,33 +39,90 @@ namespace baselib
 				TEXTURE_2D_MULTISAMPLE
 			};
 
+			//! Texture filtering modes.
+			enum FilterMode
+			{
+				FILTER_NEAREST,
+				FILTER_LINEAR
+			};
+
+			//! Texel formats.
+			enum Format
+			{
+				FORMAT_R8,
+				FORMAT_RGB8,		//!< Can't be bound as an image.
+				FORMAT_RGBA8,
+				FORMAT_R32F,
+				FORMAT_RG32F,
+				FORMAT_RGBA16F,
+				FORMAT_RGBA32F,
+				FORMAT_R32UI
+			};
+
+			//! Image access for shader image load/store.
+			enum ImageAccess
+			{
+				READ_ONLY,
+				WRITE_ONLY,
+				READ_WRITE
+			};
+
 			//! Loads a texture object from file.
 			static boost::shared_ptr<Texture> load(const fs::path& fsPath);
 
 			//! Creates and returns a texture from an image.
 			static boost::shared_ptr<Texture> create(const boost::shared_ptr<Image>& spImage);
+			//! Creates a texture with uninitialized immutable storage, e.g. for compute shaders to write with image stores.
+			static boost::shared_ptr<Texture> create(int iWidth, int iHeight, Format eFormat);
+			/*! @brief Creates a buffer texture reading the contents of spBuffer as texels of eFormat.
+			 *
+			 *  Shaders read it as a samplerBuffer with texelFetch(). The width is the number of texels, which must not exceed
+			 *  Renderer::getMaxTextureBufferSize(). The texture keeps the buffer alive and sees updates to it straight away.
+			 */
+			static boost::shared_ptr<Texture> create(const boost::shared_ptr<Buffer>& spBuffer, Format eFormat);
 			
 			//! Destructor.
 			virtual ~Texture();
 		
 			//! Bind texture.
 			void bind();
+			//! Bind texture to texture unit uUnit, for shaders sampling more than one texture.
+			void bind(unsigned int uUnit);
+
+			/*! @brief Upload a sub region of mip level 0 from client memory.
+			 *
+			 *  pData points to the first pixel of the region and iRowLength is the width, in pixels, 
+			 *  of the image pData is part of. This allows a dirty rectangle to be uploaded straight 
+			 *  from a larger staging image without copying it out first.
+			 */
+			void updateRegion(int iX, int iY, int iWidth, int iHeight, int iRowLength, const unsigned char* pData);
+
+			/*! @brief Bind mip level iLevel to an image unit for image load/store in shaders.
+			 *
+			 *  The GLSL image uniform must be declared with the matching format layout qualifier, e.g. rgba8 or r32f.
+			 *  Shader writes are only visible to texture fetches after Renderer::memoryBarrier().
+			 */
+			void bindImage(unsigned int uUnit, ImageAccess eAccess, int iLevel = 0);
+
+			//! Set the minification and magnification filter. Textures are created with FILTER_NEAREST.
+			void setFilter(FilterMode eFilter);
 
 			//! Get the texture object ID.
 			unsigned int getID() { return m_uID; }
-			//! Get the texture type. TODO: This should be an abstract function and implementations should return appropriate type - just returning TEXTURE_2D now for testing
-			//virtual TextureType getType() const = 0;
-			virtual TextureType getType() const { return TEXTURE_2D; }
+			//! Get the texture type.
+			virtual TextureType getType() const { return m_eType; }
 			//! Get texture width.
 			int getWidth() const { return m_iWidth; }
 			//! Get texture height.
 			int getHeight() const { return m_iHeight; }
 			//! Get texture depth.
 			int getBPP() const { return m_iBPP; }
+			//! Get the texel format.
+			Format getFormat() const { return m_eFormat; }
 
 		protected:
 			//! Protected constructor - must be constructed by static Create().
-			Texture(unsigned int uID, TextureType eType, int iWidth, int iHeight, int iBPP);
+			Texture(unsigned int uID, TextureType eType, int iWidth, int iHeight, int iBPP, Format eFormat);
 
 		private:
 			static unsigned int m_uCurrentlyBound; //!< Currently bound texture.
@@ -75,6 +133,8 @@ namespace baselib
 			int m_iWidth;		 //!< Texture width.
 			int m_iHeight;		 //!< Texture height.
 			int m_iBPP;			 //!< Texture bits per pixel.
+			Format m_eFormat;	 //!< Texel format.
+			boost::shared_ptr<Buffer> m_spBuffer; //!< Buffer read by buffer textures, null otherwise.
 
 		};
 	}
@@ -8,11 +8,17 @@ namespace baselib
 {
 	namespace graphics
 	{
+		/*! @brief Types of vertex attribute elements.
+		 *
+		 *  Integer types are read by the shader as integers (ivec or uvec) unless the attribute is normalized, which converts
+		 *  them to floats in [0, 1]. Skinned vertices use both, see animation::addSkinAttributes().
+		 */
 		enum VertexAttributeType
 		{
 			TYPE_FLOAT,
 			TYPE_INT,
 			TYPE_BOOL,
+			TYPE_UNSIGNED_BYTE,
 		};
 
 		/*! @brief Defines a single vertex attribute.
@@ -103,10 +109,10 @@ namespace baselib
 				LOG_VERBOSE << "VertexList destructor"; 
 			}
 
-			virtual const void* getVertexBufferData() const { return reinterpret_cast<const void*>(&m_aVertices[0]); }
+			virtual const void* getVertexBufferData() const { return m_aVertices.empty() ? NULL : reinterpret_cast<const void*>(&m_aVertices[0]); }
 			virtual unsigned int getVertexBufferSize() const { return m_aVertices.size() * sizeof(VertexType); }
 			virtual unsigned int getNumVertices() const { return m_aVertices.size(); }
-			virtual const void* getIndexBufferData() const { return reinterpret_cast<const void*>(&m_aIndices[0]); }
+			virtual const void* getIndexBufferData() const { return m_aIndices.empty() ? NULL : reinterpret_cast<const void*>(&m_aIndices[0]); }
 			virtual unsigned int getIndexBufferSize() const { return m_aIndices.size() * sizeof(unsigned int); }
 			virtual unsigned int getNumIndices() const { return m_aIndices.size(); }
 			virtual boost::shared_ptr<VertexLayout> getVertexLayout() const { return m_spVertexLayout; }
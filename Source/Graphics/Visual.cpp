@@ -1,6 +1,9 @@
 #include "Visual.h"
 
 #include <Logging/Log.h>
+#include <Graphics/Geometry.h>
+#include <Graphics/SpatialIndex.h>
+#include <Math/SIMD.h>
 
 namespace baselib { namespace graphics {
 
@@ -12,6 +15,9 @@ namespace baselib { namespace graphics {
 	Visual::Visual(const boost::shared_ptr<Geometry>& spGeometry, const boost::shared_ptr<Material>& spMaterial)
 		: m_spGeometry(spGeometry)
 		, m_spMaterial(spMaterial)
+		, m_bOccluder(false)
+		, m_pSpatialIndex(NULL)
+		, m_iSpatialProxy(-1)
 	{
 		LOG_VERBOSE << "Visual constructor";
 	}
@@ -19,11 +25,22 @@ namespace baselib { namespace graphics {
 	Visual::~Visual()
 	{
 		LOG_VERBOSE << "Visual destructor";
+
+		if (m_pSpatialIndex)
+			m_pSpatialIndex->remove(this);
 	}
 
-	void Visual::onUpdate(const Mat4& mParent)
+	AABB Visual::getWorldBounds() const
+	{
+		return transformAABB(m_spGeometry->getBounds(), getWorld());
+	}
+
+	void Visual::onUpdate(const Transform& parent)
 	{
 		// TODO
+
+		if (m_pSpatialIndex)
+			m_pSpatialIndex->update(this);
 	}
 
 } }
\ No newline at end of file
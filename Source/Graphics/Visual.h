@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Graphics/Spatial.h>
+#include <Math/AABB.h>
 #include <boost/shared_ptr.hpp>
 
 namespace baselib 
@@ -9,6 +10,12 @@ namespace baselib
 	{
 		class Material;
 		class Geometry;
+		class SpatialIndex;
+	}
+
+	namespace animation
+	{
+		class Animator;
 	}
 }
 
@@ -23,6 +30,8 @@ namespace baselib
 		class Visual : public Spatial
 		{
 		public:
+			friend class SpatialIndex;
+
 			//! Creates a Visual.
 			static boost::shared_ptr<Visual> create(const boost::shared_ptr<Geometry>& spGeometry, const boost::shared_ptr<Material>& spMaterial);
 
@@ -34,16 +43,36 @@ namespace baselib
 			//! Getter for setGeometry().
 			boost::shared_ptr<Geometry> getGeometry() const { return m_spGeometry; }
 
+			//! Get the geometry bounds transformed by the world transform.
+			AABB getWorldBounds() const;
+
+			//! Mark the visual as an occluder, i.e. large and solid enough to hide others. See OcclusionBuffer.
+			void setOccluder(bool b) { m_bOccluder = b; }
+			//! Getter for setOccluder().
+			bool isOccluder() const { return m_bOccluder; }
+
+			//! Set the animator whose skinning palette is bound when the visual is drawn. Null for rigid geometry.
+			void setAnimator(const boost::shared_ptr<animation::Animator>& spAnimator) { m_spAnimator = spAnimator; }
+			//! Getter for setAnimator().
+			const boost::shared_ptr<animation::Animator>& getAnimator() const { return m_spAnimator; }
+
+			//! Get the spatial index the visual is in, NULL if none. See SpatialIndex::insert().
+			SpatialIndex* getSpatialIndex() const { return m_pSpatialIndex; }
+
 		protected:
 			//! Protected constructor - must be created by static create().
 			Visual(const boost::shared_ptr<Geometry>& spGeometry, const boost::shared_ptr<Material>& spMaterial);
 
 		private:
 			//! Update the visual - material parameters, dynamic geometry etc.
-			virtual void onUpdate(const Mat4& mParent);
+			virtual void onUpdate(const Transform& parent);
 
 			boost::shared_ptr<Material> m_spMaterial;  //!< The material associated with this visual.
 			boost::shared_ptr<Geometry> m_spGeometry;  //!< The geometry associated with this visual.
+			boost::shared_ptr<animation::Animator> m_spAnimator; //!< Skins the geometry, null if rigid.
+			bool m_bOccluder;						   //!< Is the visual rasterized into the occlusion buffer?
+			SpatialIndex* m_pSpatialIndex;			   //!< Spatial index the visual is in, updated with the world transform.
+			int m_iSpatialProxy;					   //!< Leaf of the visual in m_pSpatialIndex.
 
 		};
 	}
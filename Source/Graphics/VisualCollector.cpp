@@ -3,7 +3,12 @@
 #include <Logging/Log.h>
 #include <Graphics/Node.h>
 #include <Graphics/Visual.h>
+#include <Graphics/Camera.h>
+#include <Graphics/Geometry.h>
+#include <Graphics/OcclusionBuffer.h>
+#include <Graphics/SpatialIndex.h>
 #include <boost/range/algorithm/sort.hpp>
+#include <algorithm>
 
 namespace baselib { namespace graphics {
 
@@ -13,6 +18,7 @@ namespace baselib { namespace graphics {
 	}
 
 	VisualCollector::VisualCollector()
+		: m_uNumOccluded(0)
 	{
 		LOG_VERBOSE << "VisualCollector constructor";
 	}
@@ -25,6 +31,7 @@ namespace baselib { namespace graphics {
 	void VisualCollector::collect(const boost::shared_ptr<Node>& spNode)
 	{
 		m_apVisuals.clear();
+		m_uNumOccluded = 0;
 
 		// Traverse Node hierarchy and selectively add visuals
 		std::vector<Visual*>& apVisuals = m_apVisuals;
@@ -37,4 +44,48 @@ namespace baselib { namespace graphics {
 		//boost::sort(m_apVisuals, [](const Visual* pLHS, const Visual* pRHS) { return true; /*TODO: Write visual sorting predicate*/ });
 	}
 
+	void VisualCollector::collect(const boost::shared_ptr<Node>& spNode, const Frustum& frustum)
+	{
+		m_apVisuals.clear();
+		m_uNumOccluded = 0;
+
+		// Both paths are the reference ComputeCuller is validated against
+		if (m_spSpatialIndex)
+		{
+			m_spSpatialIndex->query(frustum, m_apVisuals);
+		}
+		else
+		{
+			std::vector<Visual*>& apVisuals = m_apVisuals;
+			spNode->apply([&apVisuals, &frustum](const boost::shared_ptr<Spatial>& spSpatial) {
+				if (auto spVisual = boost::dynamic_pointer_cast<Visual>(spSpatial))
+				{
+					if (frustum.intersects(spVisual->getWorldBounds()))
+						apVisuals.push_back(spVisual.get());
+				}
+			});
+		}
+
+		if (!m_spOcclusionBuffer)
+			return;
+
+		// Only occluders in view can hide anything
+		m_spOcclusionBuffer->begin(frustum.getViewProjection());
+		for (unsigned int i = 0; i < m_apVisuals.size(); ++i)
+		{
+			const Visual* pVisual = m_apVisuals[i];
+			if (pVisual->isOccluder() && pVisual->getGeometry())
+				m_spOcclusionBuffer->addOccluder(*pVisual->getGeometry(), pVisual->getWorldMatrix());
+		}
+		m_spOcclusionBuffer->buildPyramid();
+
+		// An occluder's box is never behind its own surface, so occluders are only dropped when hidden by others
+		const boost::shared_ptr<OcclusionBuffer>& spOcclusionBuffer = m_spOcclusionBuffer;
+		std::vector<Visual*>::iterator itEnd = std::remove_if(m_apVisuals.begin(), m_apVisuals.end(), [&spOcclusionBuffer](const Visual* pVisual) {
+			return spOcclusionBuffer->isOccluded(pVisual->getWorldBounds());
+		});
+		m_uNumOccluded = m_apVisuals.end() - itEnd;
+		m_apVisuals.erase(itEnd, m_apVisuals.end());
+	}
+
 } }
\ No newline at end of file
@@ -9,6 +9,9 @@ namespace baselib
 	{
 		class Node;
 		class Visual;
+		class Frustum;
+		class OcclusionBuffer;
+		class SpatialIndex;
 	}
 }
 
@@ -30,6 +33,19 @@ namespace baselib
 
 			//! Collect visuals from Node hierarchy 
 			void collect(const boost::shared_ptr<Node>& spNode);
+			//! Collect the visuals from a Node hierarchy whose world bounds intersect the frustum and, with an occlusion buffer set, aren't hidden behind occluders.
+			void collect(const boost::shared_ptr<Node>& spNode, const Frustum& frustum);
+
+			//! Set the index frustum culling queries instead of walking the Node hierarchy. It must hold the hierarchy's visuals.
+			void setSpatialIndex(const boost::shared_ptr<SpatialIndex>& spSpatialIndex) { m_spSpatialIndex = spSpatialIndex; }
+			//! Get the spatial index.
+			boost::shared_ptr<SpatialIndex> getSpatialIndex() const { return m_spSpatialIndex; }
+			//! Set the buffer the occluders in view are rasterized into when collecting with a frustum. Occlusion culling is off without one.
+			void setOcclusionBuffer(const boost::shared_ptr<OcclusionBuffer>& spOcclusionBuffer) { m_spOcclusionBuffer = spOcclusionBuffer; }
+			//! Get the occlusion buffer.
+			boost::shared_ptr<OcclusionBuffer> getOcclusionBuffer() const { return m_spOcclusionBuffer; }
+			//! Get the number of visuals in the frustum that the last collect() dropped as occluded.
+			unsigned int getNumOccluded() const { return m_uNumOccluded; }
 
 			//! Get the sorted list of visuals.
 			const std::vector<Visual*>& getVisuals() const { return m_apVisuals; }
@@ -41,6 +57,9 @@ namespace baselib
 		private:
 			//! List of Visuals sorted according to rendering order
 			std::vector<Visual*> m_apVisuals; // Using a normal pointer to avoid overhead of locking a weak_ptr for every draw call - look at boost::intrusive as alternative
+			boost::shared_ptr<SpatialIndex> m_spSpatialIndex; //!< Spatial index, NULL to walk the Node hierarchy.
+			boost::shared_ptr<OcclusionBuffer> m_spOcclusionBuffer; //!< Occlusion buffer, NULL if occlusion culling is off.
+			unsigned int m_uNumOccluded; //!< Visuals dropped as occluded by the last collect().
 
 		};
 	}
@@ -0,0 +1,39 @@
+#include "Hash.h"
+
+namespace baselib {
+
+	namespace
+	{
+		const unsigned __int64 FNV1A_PRIME = 1099511628211ULL;
+	}
+
+	unsigned __int64 hashFNV1a(const void* pData, size_t uSize, unsigned __int64 uSeed)
+	{
+		const unsigned char* p = static_cast<const unsigned char*>(pData);
+		unsigned __int64 uHash = uSeed;
+		for (size_t i = 0; i < uSize; ++i)
+		{
+			uHash ^= p[i];
+			uHash *= FNV1A_PRIME;
+		}
+		return uHash;
+	}
+
+	unsigned __int64 hashFNV1a(const std::string& s, unsigned __int64 uSeed)
+	{
+		return hashFNV1a(s.data(), s.size(), uSeed);
+	}
+
+	std::string hashToString(unsigned __int64 uHash)
+	{
+		char acBuffer[17];
+		for (int i = 15; i >= 0; --i)
+		{
+			acBuffer[i] = "0123456789abcdef"[uHash & 0xF];
+			uHash >>= 4;
+		}
+		acBuffer[16] = '\0';
+		return acBuffer;
+	}
+
+}
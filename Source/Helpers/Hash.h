@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+namespace baselib
+{
+	//! FNV-1a 64 bit offset basis. Use as the seed for the first block of data.
+	const unsigned __int64 FNV1A_OFFSET_BASIS = 14695981039346656037ULL;
+
+	/*! @brief 64 bit FNV-1a hash of a block of memory.
+	 *
+	 *  Pass the result of a previous call as uSeed to hash data that is split over several blocks.
+	 *  Fast and well distributed but not cryptographic - only use it to detect changed content.
+	 */
+	unsigned __int64 hashFNV1a(const void* pData, size_t uSize, unsigned __int64 uSeed = FNV1A_OFFSET_BASIS);
+	//! 64 bit FNV-1a hash of a string.
+	unsigned __int64 hashFNV1a(const std::string& s, unsigned __int64 uSeed = FNV1A_OFFSET_BASIS);
+
+	//! Format a hash as 16 hex digits, e.g. for use in file names.
+	std::string hashToString(unsigned __int64 uHash);
+}
@@ -0,0 +1,74 @@
+#include "Utf8.h"
+
+#include <assert.h>
+
+namespace baselib {
+
+	unsigned int decodeUtf8(const std::string& s, unsigned int& uPos)
+	{
+		assert(uPos < s.length());
+
+		unsigned char uLead = s[uPos];
+		if (uLead < 0x80)
+		{
+			++uPos;
+			return uLead;
+		}
+
+		// Number of continuation bytes and smallest codepoint that may use this length
+		unsigned int uNumTrail = 0;
+		unsigned int uCodepoint = 0;
+		unsigned int uMin = 0;
+		if ((uLead & 0xE0) == 0xC0)
+		{
+			uNumTrail = 1;
+			uCodepoint = uLead & 0x1F;
+			uMin = 0x80;
+		}
+		else if ((uLead & 0xF0) == 0xE0)
+		{
+			uNumTrail = 2;
+			uCodepoint = uLead & 0x0F;
+			uMin = 0x800;
+		}
+		else if ((uLead & 0xF8) == 0xF0)
+		{
+			uNumTrail = 3;
+			uCodepoint = uLead & 0x07;
+			uMin = 0x10000;
+		}
+		else
+		{
+			++uPos;
+			return UTF8_REPLACEMENT_CHARACTER;
+		}
+
+		// Truncated sequence at the end of the string
+		if (uPos + uNumTrail >= s.length())
+		{
+			++uPos;
+			return UTF8_REPLACEMENT_CHARACTER;
+		}
+
+		for (unsigned int i = 1; i <= uNumTrail; ++i)
+		{
+			unsigned char uTrail = s[uPos + i];
+			if ((uTrail & 0xC0) != 0x80)
+			{
+				++uPos;
+				return UTF8_REPLACEMENT_CHARACTER;
+			}
+			uCodepoint = (uCodepoint << 6) | (uTrail & 0x3F);
+		}
+
+		if (uCodepoint < uMin || uCodepoint > 0x10FFFF || (uCodepoint >= 0xD800 && uCodepoint <= 0xDFFF))
+		{
+			++uPos;
+			return UTF8_REPLACEMENT_CHARACTER;
+		}
+
+		uPos += uNumTrail + 1;
+		return uCodepoint;
+	}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace baselib
+{
+	//! Codepoint returned for malformed UTF-8 (U+FFFD REPLACEMENT CHARACTER).
+	const unsigned int UTF8_REPLACEMENT_CHARACTER = 0xFFFD;
+
+	/*! @brief Decode the UTF-8 sequence starting at uPos and advance uPos past it.
+	 *
+	 *  Malformed, overlong and surrogate sequences decode to UTF8_REPLACEMENT_CHARACTER and 
+	 *  uPos advances by a single byte so decoding resynchronizes on the next lead byte.
+	 */
+	unsigned int decodeUtf8(const std::string& s, unsigned int& uPos);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Math.h"
+#include <float.h>
+
+namespace baselib
+{
+	/*! @brief Axis aligned bounding box.
+	 *
+	 *  A default constructed box is empty (vMin > vMax) and becomes valid once a point is added with expand().
+	 */
+	struct AABB
+	{
+		//! Constructs an empty box.
+		AABB()
+			: vMin(FLT_MAX, FLT_MAX, FLT_MAX)
+			, vMax(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+
+		//! Constructs a box from its corners.
+		AABB(const Vec3& _vMin, const Vec3& _vMax)
+			: vMin(_vMin)
+			, vMax(_vMax) {}
+
+		//! Is the box empty?
+		bool isEmpty() const { return vMin.x > vMax.x || vMin.y > vMax.y || vMin.z > vMax.z; }
+
+		//! Grow the box to contain a point.
+		void expand(const Vec3& v) { vMin = glm::min(vMin, v); vMax = glm::max(vMax, v); }
+		//! Grow the box to contain another box.
+		void expand(const AABB& b) { vMin = glm::min(vMin, b.vMin); vMax = glm::max(vMax, b.vMax); }
+
+		//! Get the centre of the box.
+		Vec3 getCenter() const { return (vMin + vMax) * 0.5f; }
+		//! Get the half size of the box.
+		Vec3 getExtents() const { return (vMax - vMin) * 0.5f; }
+		//! Get the surface area of the box, 0 if empty.
+		float getSurfaceArea() const { Vec3 v = vMax - vMin; return isEmpty() ? 0.0f : 2.0f * (v.x * v.y + v.y * v.z + v.z * v.x); }
+		//! Get the squared distance from a point to the box, 0 if the point is inside.
+		float getDistanceSquared(const Vec3& v) const { Vec3 vDelta = v - glm::clamp(v, vMin, vMax); return glm::dot(vDelta, vDelta); }
+
+		//! Do the boxes overlap? Touching boxes overlap.
+		bool intersects(const AABB& b) const
+		{
+			return vMin.x <= b.vMax.x && vMax.x >= b.vMin.x && vMin.y <= b.vMax.y && vMax.y >= b.vMin.y && vMin.z <= b.vMax.z && vMax.z >= b.vMin.z;
+		}
+		//! Is the other box completely inside this box?
+		bool contains(const AABB& b) const
+		{
+			return vMin.x <= b.vMin.x && vMin.y <= b.vMin.y && vMin.z <= b.vMin.z && vMax.x >= b.vMax.x && vMax.y >= b.vMax.y && vMax.z >= b.vMax.z;
+		}
+
+		//! Get the box containing this box transformed by m. Larger than the transformed box itself if m rotates.
+		AABB transform(const Mat4& m) const
+		{
+			if (isEmpty())
+				return *this;
+
+			// The extents of the transformed box are the extents projected onto each world axis
+			Vec3 vCenter = Vec3(m * Vec4(getCenter(), 1.0f));
+			Vec3 vExtents = getExtents();
+			Vec3 vWorldExtents(
+				glm::abs(m[0][0]) * vExtents.x + glm::abs(m[1][0]) * vExtents.y + glm::abs(m[2][0]) * vExtents.z,
+				glm::abs(m[0][1]) * vExtents.x + glm::abs(m[1][1]) * vExtents.y + glm::abs(m[2][1]) * vExtents.z,
+				glm::abs(m[0][2]) * vExtents.x + glm::abs(m[1][2]) * vExtents.y + glm::abs(m[2][2]) * vExtents.z);
+			return AABB(vCenter - vWorldExtents, vCenter + vWorldExtents);
+		}
+
+		Vec3 vMin;	//!< Minimum corner.
+		Vec3 vMax;	//!< Maximum corner.
+	};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Math.h"
+#include "AABB.h"
+#include <algorithm>
+
+namespace baselib
+{
+	/*! @brief Half line from an origin along a direction.
+	 *
+	 *  Distances along the ray are measured in multiples of the direction, which is usually normalized.
+	 */
+	struct Ray
+	{
+		//! Constructs a ray from its origin and direction.
+		Ray(const Vec3& _vOrigin, const Vec3& _vDirection)
+			: vOrigin(_vOrigin)
+			, vDirection(_vDirection) {}
+
+		//! Get the point at a distance along the ray.
+		Vec3 getPoint(float fDistance) const { return vOrigin + vDirection * fDistance; }
+
+		//! Does the ray hit the box before fMaxDistance? fDistance is where it enters the box, 0 if the origin is inside.
+		bool intersects(const AABB& bounds, float fMaxDistance, float& fDistance) const
+		{
+			if (bounds.isEmpty())
+				return false;
+
+			// Slab test, a zero direction component gives infinite distances which compare correctly
+			Vec3 vInvDirection = Vec3(1.0f) / vDirection;
+			Vec3 vNear = (bounds.vMin - vOrigin) * vInvDirection;
+			Vec3 vFar = (bounds.vMax - vOrigin) * vInvDirection;
+			Vec3 vEnter = glm::min(vNear, vFar);
+			Vec3 vExit = glm::max(vNear, vFar);
+			float fEnter = std::max(std::max(vEnter.x, vEnter.y), std::max(vEnter.z, 0.0f));
+			float fExit = std::min(std::min(vExit.x, vExit.y), std::min(vExit.z, fMaxDistance));
+			if (fEnter > fExit)
+				return false;
+
+			fDistance = fEnter;
+			return true;
+		}
+
+		Vec3 vOrigin;		//!< Start of the ray.
+		Vec3 vDirection;	//!< Direction of the ray.
+	};
+}
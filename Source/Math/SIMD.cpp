@@ -0,0 +1,399 @@
+#include "SIMD.h"
+
+#include "MathHelpers.h"
+
+namespace baselib {
+
+	namespace
+	{
+		//! Rotation part of a unit quaternion's matrix, written to the first three columns of m.
+		void quatToMat4(const glm::quat& q, Mat4& m)
+		{
+			float fXX = 2.0f * q.x * q.x, fYY = 2.0f * q.y * q.y, fZZ = 2.0f * q.z * q.z;
+			float fXY = 2.0f * q.x * q.y, fXZ = 2.0f * q.x * q.z, fYZ = 2.0f * q.y * q.z;
+			float fWX = 2.0f * q.w * q.x, fWY = 2.0f * q.w * q.y, fWZ = 2.0f * q.w * q.z;
+			m[0] = Vec4(1.0f - (fYY + fZZ), fXY + fWZ, fXZ - fWY, 0.0f);
+			m[1] = Vec4(fXY - fWZ, 1.0f - (fXX + fZZ), fYZ + fWX, 0.0f);
+			m[2] = Vec4(fXZ + fWY, fYZ - fWX, 1.0f - (fXX + fYY), 0.0f);
+		}
+
+#ifdef BASELIB_SSE2
+		//! Broadcast one lane of v to all four lanes.
+		template <int LANE>
+		__m128 splat(__m128 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(LANE, LANE, LANE, LANE)); }
+
+		//! c0 * v.x + c1 * v.y + c2 * v.z + c3 * v.w, the columns of a matrix applied to a vector.
+		__m128 combineColumns(__m128 vC0, __m128 vC1, __m128 vC2, __m128 vC3, __m128 v)
+		{
+			__m128 vResult = _mm_add_ps(_mm_mul_ps(vC0, splat<0>(v)), _mm_mul_ps(vC1, splat<1>(v)));
+			return _mm_add_ps(vResult, _mm_add_ps(_mm_mul_ps(vC2, splat<2>(v)), _mm_mul_ps(vC3, splat<3>(v))));
+		}
+
+		//! Sum of the four lanes, in every lane.
+		__m128 horizontalSum(__m128 v)
+		{
+			v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		}
+
+		//! Clear the sign bits.
+		__m128 absolute(__m128 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+
+		Vec3 storeVec3(__m128 v)
+		{
+			float af[4];
+			_mm_storeu_ps(af, v);
+			return Vec3(af[0], af[1], af[2]);
+		}
+
+		//! c0 * x + c1 * y + c2 * z + c3, the columns of a matrix applied to a point.
+		__m128 transformPoint(const __m128 avColumns[4], const Vec3& v)
+		{
+			__m128 vResult = _mm_add_ps(_mm_mul_ps(avColumns[0], _mm_set1_ps(v.x)), _mm_mul_ps(avColumns[1], _mm_set1_ps(v.y)));
+			return _mm_add_ps(vResult, _mm_add_ps(_mm_mul_ps(avColumns[2], _mm_set1_ps(v.z)), avColumns[3]));
+		}
+
+		void loadColumns(const Mat4& m, __m128 avColumns[4])
+		{
+			const float* pf = glm::value_ptr(m);
+			avColumns[0] = _mm_loadu_ps(pf);
+			avColumns[1] = _mm_loadu_ps(pf + 4);
+			avColumns[2] = _mm_loadu_ps(pf + 8);
+			avColumns[3] = _mm_loadu_ps(pf + 12);
+		}
+
+		void loadColumns(const Transform& t, __m128 avColumns[4])
+		{
+			avColumns[0] = _mm_loadu_ps(glm::value_ptr(t.avRows[0]));
+			avColumns[1] = _mm_loadu_ps(glm::value_ptr(t.avRows[1]));
+			avColumns[2] = _mm_loadu_ps(glm::value_ptr(t.avRows[2]));
+			avColumns[3] = _mm_setzero_ps();
+			_MM_TRANSPOSE4_PS(avColumns[0], avColumns[1], avColumns[2], avColumns[3]);
+		}
+
+		//! Shared by both transformAABB() overloads once the matrix is in columns.
+		AABB transformAABBColumns(const AABB& bounds, const __m128 avColumns[4])
+		{
+			// The extents of the transformed box are the extents projected onto each world axis, as in AABB::transform()
+			Vec3 vExtents = bounds.getExtents();
+			__m128 vCenter = transformPoint(avColumns, bounds.getCenter());
+			__m128 vWorldExtents = _mm_add_ps(_mm_mul_ps(absolute(avColumns[0]), _mm_set1_ps(vExtents.x)), _mm_mul_ps(absolute(avColumns[1]), _mm_set1_ps(vExtents.y)));
+			vWorldExtents = _mm_add_ps(vWorldExtents, _mm_mul_ps(absolute(avColumns[2]), _mm_set1_ps(vExtents.z)));
+			return AABB(storeVec3(_mm_sub_ps(vCenter, vWorldExtents)), storeVec3(_mm_add_ps(vCenter, vWorldExtents)));
+		}
+#endif
+	}
+
+	void multiplyMat4(const Mat4& a, const Mat4& b, Mat4& result)
+	{
+#ifdef BASELIB_SSE2
+		// Column j of the result is a's columns weighted by column j of b. Both inputs are loaded before anything is stored.
+		const float* pfA = glm::value_ptr(a);
+		const float* pfB = glm::value_ptr(b);
+		__m128 vA0 = _mm_loadu_ps(pfA), vA1 = _mm_loadu_ps(pfA + 4), vA2 = _mm_loadu_ps(pfA + 8), vA3 = _mm_loadu_ps(pfA + 12);
+		__m128 vB0 = _mm_loadu_ps(pfB), vB1 = _mm_loadu_ps(pfB + 4), vB2 = _mm_loadu_ps(pfB + 8), vB3 = _mm_loadu_ps(pfB + 12);
+
+		float* pfResult = glm::value_ptr(result);
+		_mm_storeu_ps(pfResult, combineColumns(vA0, vA1, vA2, vA3, vB0));
+		_mm_storeu_ps(pfResult + 4, combineColumns(vA0, vA1, vA2, vA3, vB1));
+		_mm_storeu_ps(pfResult + 8, combineColumns(vA0, vA1, vA2, vA3, vB2));
+		_mm_storeu_ps(pfResult + 12, combineColumns(vA0, vA1, vA2, vA3, vB3));
+#else
+		result = a * b;
+#endif
+	}
+
+	void multiplyTransform(const Transform& a, const Transform& b, Transform& result)
+	{
+#ifdef BASELIB_SSE2
+		// Row i of the result is b's rows weighted by the rotation part of a's row i, plus a's translation. The implicit
+		// bottom rows, (0, 0, 0, 1), are what save the fourth multiply of multiplyMat4().
+		__m128 avA[3] = { _mm_loadu_ps(glm::value_ptr(a.avRows[0])), _mm_loadu_ps(glm::value_ptr(a.avRows[1])), _mm_loadu_ps(glm::value_ptr(a.avRows[2])) };
+		__m128 vB0 = _mm_loadu_ps(glm::value_ptr(b.avRows[0]));
+		__m128 vB1 = _mm_loadu_ps(glm::value_ptr(b.avRows[1]));
+		__m128 vB2 = _mm_loadu_ps(glm::value_ptr(b.avRows[2]));
+		const __m128 vTranslationMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+		__m128 avResult[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			__m128 vRow = _mm_add_ps(_mm_mul_ps(vB0, splat<0>(avA[i])), _mm_mul_ps(vB1, splat<1>(avA[i])));
+			avResult[i] = _mm_add_ps(vRow, _mm_add_ps(_mm_mul_ps(vB2, splat<2>(avA[i])), _mm_and_ps(avA[i], vTranslationMask)));
+		}
+		_mm_storeu_ps(glm::value_ptr(result.avRows[0]), avResult[0]);
+		_mm_storeu_ps(glm::value_ptr(result.avRows[1]), avResult[1]);
+		_mm_storeu_ps(glm::value_ptr(result.avRows[2]), avResult[2]);
+#else
+		result = a * b;
+#endif
+	}
+
+	void transformPoints(const Mat4& m, const Vec3* pvPoints, Vec4* pvResults, unsigned int uCount)
+	{
+#ifdef BASELIB_SSE2
+		__m128 avColumns[4];
+		loadColumns(m, avColumns);
+		for (unsigned int i = 0; i < uCount; ++i)
+			_mm_storeu_ps(glm::value_ptr(pvResults[i]), transformPoint(avColumns, pvPoints[i]));
+#else
+		for (unsigned int i = 0; i < uCount; ++i)
+			pvResults[i] = m * Vec4(pvPoints[i], 1.0f);
+#endif
+	}
+
+	void transformPoints(const Mat4& m, const Vec3* pvPoints, Vec3* pvResults, unsigned int uCount)
+	{
+#ifdef BASELIB_SSE2
+		__m128 avColumns[4];
+		loadColumns(m, avColumns);
+		for (unsigned int i = 0; i < uCount; ++i)
+			pvResults[i] = storeVec3(transformPoint(avColumns, pvPoints[i]));
+#else
+		for (unsigned int i = 0; i < uCount; ++i)
+			pvResults[i] = Vec3(m * Vec4(pvPoints[i], 1.0f));
+#endif
+	}
+
+	AABB transformAABB(const AABB& bounds, const Mat4& m)
+	{
+#ifdef BASELIB_SSE2
+		if (bounds.isEmpty())
+			return bounds;
+
+		__m128 avColumns[4];
+		loadColumns(m, avColumns);
+		return transformAABBColumns(bounds, avColumns);
+#else
+		return bounds.transform(m);
+#endif
+	}
+
+	AABB transformAABB(const AABB& bounds, const Transform& t)
+	{
+#ifdef BASELIB_SSE2
+		if (bounds.isEmpty())
+			return bounds;
+
+		__m128 avColumns[4];
+		loadColumns(t, avColumns);
+		return transformAABBColumns(bounds, avColumns);
+#else
+		return bounds.transform(t.toMat4());
+#endif
+	}
+
+	void transformAABBs(const AABB* pBounds, const Mat4* pmMatrices, AABB* pResults, unsigned int uCount)
+	{
+		for (unsigned int i = 0; i < uCount; ++i)
+			pResults[i] = transformAABB(pBounds[i], pmMatrices[i]);
+	}
+
+	void slerpQuats(const glm::quat* pqFrom, const glm::quat* pqTo, float fWeight, glm::quat* pqResults, unsigned int uCount)
+	{
+#ifdef BASELIB_SSE2
+		// glm::quat is laid out x, y, z, w. Only the weights of each pair need scalar trigonometry.
+		const __m128 vSignMask = _mm_set1_ps(-0.0f);
+		for (unsigned int i = 0; i < uCount; ++i)
+		{
+			__m128 vFrom = _mm_loadu_ps(&pqFrom[i].x);
+			__m128 vTo = _mm_loadu_ps(&pqTo[i].x);
+			float fCosOmega = _mm_cvtss_f32(horizontalSum(_mm_mul_ps(vFrom, vTo)));
+
+			// Take the shorter arc
+			if (fCosOmega < 0.0f)
+			{
+				vTo = _mm_xor_ps(vTo, vSignMask);
+				fCosOmega = -fCosOmega;
+			}
+
+			float fFromWeight = 1.0f - fWeight;
+			float fToWeight = fWeight;
+			if (fCosOmega <= 0.99999f)
+			{
+				float fSinOmega = sqrt(1.0f - fCosOmega * fCosOmega);
+				float fOmega = atan2(fSinOmega, fCosOmega);
+				float fInvSinOmega = 1.0f / fSinOmega;
+				fFromWeight = sin((1.0f - fWeight) * fOmega) * fInvSinOmega;
+				fToWeight = sin(fWeight * fOmega) * fInvSinOmega;
+			}
+
+			__m128 vResult = _mm_add_ps(_mm_mul_ps(vFrom, _mm_set1_ps(fFromWeight)), _mm_mul_ps(vTo, _mm_set1_ps(fToWeight)));
+			vResult = _mm_div_ps(vResult, _mm_sqrt_ps(horizontalSum(_mm_mul_ps(vResult, vResult))));
+			_mm_storeu_ps(&pqResults[i].x, vResult);
+		}
+#else
+		for (unsigned int i = 0; i < uCount; ++i)
+			pqResults[i] = slerpQuat(pqFrom[i], pqTo[i], fWeight);
+#endif
+	}
+
+	void quatsToMat4s(const glm::quat* pqRotations, const Vec3* pvTranslations, Mat4* pmResults, unsigned int uCount)
+	{
+		unsigned int i = 0;
+
+#ifdef BASELIB_SSE2
+		// Four quaternions at a time: transpose to one register per component, compute each matrix element for all four
+		// and transpose back so every register holds one column of one matrix
+		const __m128 vOne = _mm_set1_ps(1.0f);
+		const __m128 vTwo = _mm_set1_ps(2.0f);
+		for (; i + 4 <= uCount; i += 4)
+		{
+			__m128 vX = _mm_loadu_ps(&pqRotations[i].x);
+			__m128 vY = _mm_loadu_ps(&pqRotations[i + 1].x);
+			__m128 vZ = _mm_loadu_ps(&pqRotations[i + 2].x);
+			__m128 vW = _mm_loadu_ps(&pqRotations[i + 3].x);
+			_MM_TRANSPOSE4_PS(vX, vY, vZ, vW);
+
+			__m128 vX2 = _mm_mul_ps(vX, vTwo);
+			__m128 vY2 = _mm_mul_ps(vY, vTwo);
+			__m128 vZ2 = _mm_mul_ps(vZ, vTwo);
+			__m128 vXX = _mm_mul_ps(vX2, vX), vYY = _mm_mul_ps(vY2, vY), vZZ = _mm_mul_ps(vZ2, vZ);
+			__m128 vXY = _mm_mul_ps(vX2, vY), vXZ = _mm_mul_ps(vX2, vZ), vYZ = _mm_mul_ps(vY2, vZ);
+			__m128 vWX = _mm_mul_ps(vX2, vW), vWY = _mm_mul_ps(vY2, vW), vWZ = _mm_mul_ps(vZ2, vW);
+
+			__m128 avColumns[3][4] =
+			{
+				{ _mm_sub_ps(vOne, _mm_add_ps(vYY, vZZ)), _mm_add_ps(vXY, vWZ), _mm_sub_ps(vXZ, vWY), _mm_setzero_ps() },
+				{ _mm_sub_ps(vXY, vWZ), _mm_sub_ps(vOne, _mm_add_ps(vXX, vZZ)), _mm_add_ps(vYZ, vWX), _mm_setzero_ps() },
+				{ _mm_add_ps(vXZ, vWY), _mm_sub_ps(vYZ, vWX), _mm_sub_ps(vOne, _mm_add_ps(vXX, vYY)), _mm_setzero_ps() }
+			};
+
+			for (int c = 0; c < 3; ++c)
+			{
+				_MM_TRANSPOSE4_PS(avColumns[c][0], avColumns[c][1], avColumns[c][2], avColumns[c][3]);
+				for (int j = 0; j < 4; ++j)
+					_mm_storeu_ps(glm::value_ptr(pmResults[i + j]) + c * 4, avColumns[c][j]);
+			}
+			for (int j = 0; j < 4; ++j)
+				pmResults[i + j][3] = pvTranslations ? Vec4(pvTranslations[i + j], 1.0f) : Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+#endif
+
+		for (; i < uCount; ++i)
+		{
+			quatToMat4(pqRotations[i], pmResults[i]);
+			pmResults[i][3] = pvTranslations ? Vec4(pvTranslations[i], 1.0f) : Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	void quatsToTransforms(const glm::quat* pqRotations, const Vec3* pvTranslations, const Vec3* pvScales, Transform* pResults, unsigned int uCount)
+	{
+		unsigned int i = 0;
+
+#ifdef BASELIB_SSE2
+		// As quatsToMat4s() but each register ends up holding one row of one transform, the scales applied to its first
+		// three lanes and the translation in its fourth
+		const __m128 vOne = _mm_set1_ps(1.0f);
+		const __m128 vTwo = _mm_set1_ps(2.0f);
+		for (; i + 4 <= uCount; i += 4)
+		{
+			__m128 vX = _mm_loadu_ps(&pqRotations[i].x);
+			__m128 vY = _mm_loadu_ps(&pqRotations[i + 1].x);
+			__m128 vZ = _mm_loadu_ps(&pqRotations[i + 2].x);
+			__m128 vW = _mm_loadu_ps(&pqRotations[i + 3].x);
+			_MM_TRANSPOSE4_PS(vX, vY, vZ, vW);
+
+			__m128 vX2 = _mm_mul_ps(vX, vTwo);
+			__m128 vY2 = _mm_mul_ps(vY, vTwo);
+			__m128 vZ2 = _mm_mul_ps(vZ, vTwo);
+			__m128 vXX = _mm_mul_ps(vX2, vX), vYY = _mm_mul_ps(vY2, vY), vZZ = _mm_mul_ps(vZ2, vZ);
+			__m128 vXY = _mm_mul_ps(vX2, vY), vXZ = _mm_mul_ps(vX2, vZ), vYZ = _mm_mul_ps(vY2, vZ);
+			__m128 vWX = _mm_mul_ps(vX2, vW), vWY = _mm_mul_ps(vY2, vW), vWZ = _mm_mul_ps(vZ2, vW);
+
+			__m128 vScaleX = vOne, vScaleY = vOne, vScaleZ = vOne;
+			if (pvScales)
+			{
+				const Vec3* pv = pvScales + i;
+				vScaleX = _mm_set_ps(pv[3].x, pv[2].x, pv[1].x, pv[0].x);
+				vScaleY = _mm_set_ps(pv[3].y, pv[2].y, pv[1].y, pv[0].y);
+				vScaleZ = _mm_set_ps(pv[3].z, pv[2].z, pv[1].z, pv[0].z);
+			}
+			__m128 avTranslation[3] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+			if (pvTranslations)
+			{
+				const Vec3* pv = pvTranslations + i;
+				avTranslation[0] = _mm_set_ps(pv[3].x, pv[2].x, pv[1].x, pv[0].x);
+				avTranslation[1] = _mm_set_ps(pv[3].y, pv[2].y, pv[1].y, pv[0].y);
+				avTranslation[2] = _mm_set_ps(pv[3].z, pv[2].z, pv[1].z, pv[0].z);
+			}
+
+			__m128 avRows[3][4] =
+			{
+				{ _mm_mul_ps(_mm_sub_ps(vOne, _mm_add_ps(vYY, vZZ)), vScaleX), _mm_mul_ps(_mm_sub_ps(vXY, vWZ), vScaleY), _mm_mul_ps(_mm_add_ps(vXZ, vWY), vScaleZ), avTranslation[0] },
+				{ _mm_mul_ps(_mm_add_ps(vXY, vWZ), vScaleX), _mm_mul_ps(_mm_sub_ps(vOne, _mm_add_ps(vXX, vZZ)), vScaleY), _mm_mul_ps(_mm_sub_ps(vYZ, vWX), vScaleZ), avTranslation[1] },
+				{ _mm_mul_ps(_mm_sub_ps(vXZ, vWY), vScaleX), _mm_mul_ps(_mm_add_ps(vYZ, vWX), vScaleY), _mm_mul_ps(_mm_sub_ps(vOne, _mm_add_ps(vXX, vYY)), vScaleZ), avTranslation[2] }
+			};
+
+			for (int r = 0; r < 3; ++r)
+			{
+				_MM_TRANSPOSE4_PS(avRows[r][0], avRows[r][1], avRows[r][2], avRows[r][3]);
+				for (int j = 0; j < 4; ++j)
+					_mm_storeu_ps(glm::value_ptr(pResults[i + j].avRows[r]), avRows[r][j]);
+			}
+		}
+#endif
+
+		for (; i < uCount; ++i)
+			pResults[i] = Transform::fromTRS(pvTranslations ? pvTranslations[i] : Vec3(0.0f), pqRotations[i], pvScales ? pvScales[i] : Vec3(1.0f));
+	}
+
+	void accumulateQuats(const glm::quat* pqQuats, float fWeight, glm::quat* pqSums, unsigned int uCount)
+	{
+#ifdef BASELIB_SSE2
+		const __m128 vWeight = _mm_set1_ps(fWeight);
+		const __m128 vSignMask = _mm_set1_ps(-0.0f);
+		for (unsigned int i = 0; i < uCount; ++i)
+		{
+			__m128 vQuat = _mm_loadu_ps(&pqQuats[i].x);
+			__m128 vSum = _mm_loadu_ps(&pqSums[i].x);
+
+			// Flip to the hemisphere of the sum without a branch, the sign of the dot product is the sign to apply
+			__m128 vSign = _mm_and_ps(horizontalSum(_mm_mul_ps(vSum, vQuat)), vSignMask);
+			vQuat = _mm_xor_ps(vQuat, vSign);
+			_mm_storeu_ps(&pqSums[i].x, _mm_add_ps(vSum, _mm_mul_ps(vQuat, vWeight)));
+		}
+#else
+		for (unsigned int i = 0; i < uCount; ++i)
+		{
+			float fSignedWeight = glm::dot(pqSums[i], pqQuats[i]) < 0.0f ? -fWeight : fWeight;
+			pqSums[i] = pqSums[i] + pqQuats[i] * fSignedWeight;
+		}
+#endif
+	}
+
+	void normalizeQuats(glm::quat* pqQuats, unsigned int uCount)
+	{
+#ifdef BASELIB_SSE2
+		const __m128 vIdentity = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+		const __m128 vMinLengthSquared = _mm_set1_ps(EPSILON * EPSILON);
+		for (unsigned int i = 0; i < uCount; ++i)
+		{
+			__m128 vQuat = _mm_loadu_ps(&pqQuats[i].x);
+			__m128 vLengthSquared = horizontalSum(_mm_mul_ps(vQuat, vQuat));
+			__m128 vValid = _mm_cmpgt_ps(vLengthSquared, vMinLengthSquared);
+			vQuat = _mm_div_ps(vQuat, _mm_sqrt_ps(vLengthSquared));
+			_mm_storeu_ps(&pqQuats[i].x, _mm_or_ps(_mm_and_ps(vValid, vQuat), _mm_andnot_ps(vValid, vIdentity)));
+		}
+#else
+		for (unsigned int i = 0; i < uCount; ++i)
+		{
+			float fLength = glm::length(pqQuats[i]);
+			pqQuats[i] = fLength > EPSILON ? pqQuats[i] * (1.0f / fLength) : glm::quat();
+		}
+#endif
+	}
+
+	void accumulateFloats(const float* pfValues, float fWeight, float* pfSums, unsigned int uCount)
+	{
+		unsigned int i = 0;
+
+#ifdef BASELIB_SSE2
+		const __m128 vWeight = _mm_set1_ps(fWeight);
+		for (; i + 4 <= uCount; i += 4)
+			_mm_storeu_ps(pfSums + i, _mm_add_ps(_mm_loadu_ps(pfSums + i), _mm_mul_ps(_mm_loadu_ps(pfValues + i), vWeight)));
+#endif
+
+		for (; i < uCount; ++i)
+			pfSums[i] += pfValues[i] * fWeight;
+	}
+}
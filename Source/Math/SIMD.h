@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Math.h"
+#include "AABB.h"
+#include "Transform.h"
+
+// SSE2 is the baseline of x64 and the default of 32 bit MSVC 2012 and later, anything else uses the scalar fallback
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define BASELIB_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace baselib
+{
+	//! Multiply two matrices, result = a * b. The result may alias either input.
+	void multiplyMat4(const Mat4& a, const Mat4& b, Mat4& result);
+	//! Compose two affine transforms, result = a * b. The result may alias either input.
+	void multiplyTransform(const Transform& a, const Transform& b, Transform& result);
+
+	//! Transform uCount points by m, keeping w, e.g. to clip space.
+	void transformPoints(const Mat4& m, const Vec3* pvPoints, Vec4* pvResults, unsigned int uCount);
+	//! Transform uCount points by an affine matrix.
+	void transformPoints(const Mat4& m, const Vec3* pvPoints, Vec3* pvResults, unsigned int uCount);
+
+	//! Get the box containing a box transformed by an affine matrix. Same result as AABB::transform().
+	AABB transformAABB(const AABB& bounds, const Mat4& m);
+	//! Get the box containing a box transformed by an affine transform.
+	AABB transformAABB(const AABB& bounds, const Transform& t);
+	//! Transform uCount boxes, each by its own affine matrix.
+	void transformAABBs(const AABB* pBounds, const Mat4* pmMatrices, AABB* pResults, unsigned int uCount);
+
+	//! Spherical linear interpolation of uCount pairs of unit quaternions by the same weight. Same result as slerpQuat().
+	void slerpQuats(const glm::quat* pqFrom, const glm::quat* pqTo, float fWeight, glm::quat* pqResults, unsigned int uCount);
+	//! Convert uCount unit quaternions to rotation matrices, translated by pvTranslations if it isn't NULL.
+	void quatsToMat4s(const glm::quat* pqRotations, const Vec3* pvTranslations, Mat4* pmResults, unsigned int uCount);
+	//! Build uCount transforms that scale, then rotate by unit quaternions, then translate. Same result as Transform::fromTRS().
+	void quatsToTransforms(const glm::quat* pqRotations, const Vec3* pvTranslations, const Vec3* pvScales, Transform* pResults, unsigned int uCount);
+
+	/*! @brief Add fWeight times uCount quaternions to pqSums.
+	 *
+	 *  Each quaternion is negated first if it lies in the opposite hemisphere of its sum, so that blending takes the
+	 *  shorter arc. Normalize the sums with normalizeQuats() once everything has been added, i.e. blending is nlerp.
+	 */
+	void accumulateQuats(const glm::quat* pqQuats, float fWeight, glm::quat* pqSums, unsigned int uCount);
+	//! Normalize uCount quaternions. Quaternions with zero length become the identity.
+	void normalizeQuats(glm::quat* pqQuats, unsigned int uCount);
+	//! Add fWeight times uCount floats to pfSums.
+	void accumulateFloats(const float* pfValues, float fWeight, float* pfSums, unsigned int uCount);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Math.h"
+
+namespace baselib
+{
+	/*! @brief Affine transform stored as the top three rows of a 4x4 matrix.
+	 *
+	 *  The bottom row of an affine matrix is always (0, 0, 0, 1), so leaving it out saves a quarter of the memory and,
+	 *  when composing, the multiplications by it. Rows rather than columns keep each 16 byte aligned for SIMD, see
+	 *  multiplyTransform(). Convert to a Mat4 with toMat4() only where a full matrix is needed, e.g. for upload.
+	 */
+	struct Transform
+	{
+		//! Constructs the identity transform.
+		Transform()
+		{
+			avRows[0] = Vec4(1.0f, 0.0f, 0.0f, 0.0f);
+			avRows[1] = Vec4(0.0f, 1.0f, 0.0f, 0.0f);
+			avRows[2] = Vec4(0.0f, 0.0f, 1.0f, 0.0f);
+		}
+
+		//! Constructs a transform from the top three rows of an affine matrix.
+		explicit Transform(const Mat4& m)
+		{
+			for (int i = 0; i < 3; ++i)
+				avRows[i] = Vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+		}
+
+		//! Constructs a transform that scales, then rotates, then translates.
+		static Transform fromTRS(const Vec3& vTranslation, const glm::quat& qRotation, const Vec3& vScale)
+		{
+			glm::mat3 mRotation = glm::mat3_cast(qRotation);
+			Transform t;
+			for (int i = 0; i < 3; ++i)
+				t.avRows[i] = Vec4(mRotation[0][i] * vScale.x, mRotation[1][i] * vScale.y, mRotation[2][i] * vScale.z, vTranslation[i]);
+			return t;
+		}
+
+		//! Get the equivalent 4x4 matrix.
+		Mat4 toMat4() const
+		{
+			return Mat4(
+				avRows[0].x, avRows[1].x, avRows[2].x, 0.0f,
+				avRows[0].y, avRows[1].y, avRows[2].y, 0.0f,
+				avRows[0].z, avRows[1].z, avRows[2].z, 0.0f,
+				avRows[0].w, avRows[1].w, avRows[2].w, 1.0f);
+		}
+
+		//! Get the translation.
+		Vec3 getTranslation() const { return Vec3(avRows[0].w, avRows[1].w, avRows[2].w); }
+		//! Set the translation.
+		void setTranslation(const Vec3& v) { avRows[0].w = v.x; avRows[1].w = v.y; avRows[2].w = v.z; }
+
+		//! Transform a point.
+		Vec3 transformPoint(const Vec3& v) const
+		{
+			Vec4 vPoint(v, 1.0f);
+			return Vec3(glm::dot(avRows[0], vPoint), glm::dot(avRows[1], vPoint), glm::dot(avRows[2], vPoint));
+		}
+		//! Transform a direction, ignoring the translation.
+		Vec3 transformVector(const Vec3& v) const
+		{
+			return Vec3(glm::dot(Vec3(avRows[0]), v), glm::dot(Vec3(avRows[1]), v), glm::dot(Vec3(avRows[2]), v));
+		}
+
+		//! Get the inverse of any invertible affine transform.
+		Transform inverse() const
+		{
+			glm::mat3 mLinear(Vec3(avRows[0].x, avRows[1].x, avRows[2].x), Vec3(avRows[0].y, avRows[1].y, avRows[2].y), Vec3(avRows[0].z, avRows[1].z, avRows[2].z));
+			glm::mat3 mInverse = glm::inverse(mLinear);
+			Vec3 vTranslation = -(mInverse * getTranslation());
+			Transform t;
+			for (int i = 0; i < 3; ++i)
+				t.avRows[i] = Vec4(mInverse[0][i], mInverse[1][i], mInverse[2][i], vTranslation[i]);
+			return t;
+		}
+		//! Get the inverse of a rotation and translation, without scale or shear. Cheaper than inverse(), the rotation is transposed.
+		Transform inverseRigid() const
+		{
+			Vec3 vTranslation = getTranslation();
+			Transform t;
+			for (int i = 0; i < 3; ++i)
+			{
+				Vec3 vColumn(avRows[0][i], avRows[1][i], avRows[2][i]);
+				t.avRows[i] = Vec4(vColumn, -glm::dot(vColumn, vTranslation));
+			}
+			return t;
+		}
+
+		//! Compose two transforms, b is applied first. See multiplyTransform() for the SIMD version.
+		Transform operator*(const Transform& b) const
+		{
+			Transform t;
+			for (int i = 0; i < 3; ++i)
+			{
+				const Vec4& vRow = avRows[i];
+				t.avRows[i] = b.avRows[0] * vRow.x + b.avRows[1] * vRow.y + b.avRows[2] * vRow.z + Vec4(0.0f, 0.0f, 0.0f, vRow.w);
+			}
+			return t;
+		}
+
+		Vec4 avRows[3];	//!< Top three rows, translation in w.
+	};
+}